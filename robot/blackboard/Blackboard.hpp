@@ -13,6 +13,7 @@
 #include <vector>
 #include <deque>
 
+#include "blackboard/Snapshot.hpp"
 #include "utils/body.hpp"
 #include "utils/boostSerializationVariablesMap.hpp"
 #include "perception/kinematics/Parameters.hpp"
@@ -45,6 +46,7 @@
 #include "types/FieldFeatureInfo.hpp"
 #include "types/Odometry.hpp"
 #include "types/CameraSettings.hpp"
+#include "types/FrameHandle.hpp"
 
 #include "perception/vision/Region/Region.hpp"
 #include "soccer.hpp"
@@ -186,7 +188,7 @@ struct StateEstimationBlackboard {
     std::vector<bool> havePendingIncomingSharedBundle;
 
     /** filtered positions of visual robots */
-    std::vector<RobotObstacle> robotObstacles;
+    Snapshot<std::vector<RobotObstacle> > robotObstacles;
 
     // Whether we have had a recent team ball update
     bool hadTeamBallUpdate;
@@ -201,7 +203,7 @@ struct VisionBlackboard {
     int64_t timestamp;
 
     /* Detected features */
-    std::vector<BallInfo> balls;
+    Snapshot<std::vector<BallInfo> > balls;
     std::vector<RobotVisionInfo> robots;
     std::vector<FieldBoundaryInfo> fieldBoundaries;
     std::vector<FieldFeatureInfo> fieldFeatures;
@@ -215,6 +217,14 @@ struct VisionBlackboard {
     uint8_t const* topFrame;
     uint8_t const* botFrame;
 
+    /**
+     * The same frames, held so that they stay valid for whoever copies the
+     * handle out, e.g. for serialisation, after Vision has moved on.
+     * Not serialised.
+     */
+    FrameHandle topFrameHandle;
+    FrameHandle botFrameHandle;
+
     /** JPEG compression for serialization */
     int8_t topFrameJPEGQuality;
     int8_t botFrameJPEGQuality;
@@ -254,7 +264,7 @@ struct GameControllerBlackboard {
 
 struct MotionBlackboard {
     explicit MotionBlackboard();
-    SensorValues sensors;
+    Snapshot<SensorValues> sensors;
     float uptime;
     ActionCommand::All active;
     Odometry odometry;
@@ -315,9 +325,13 @@ class Blackboard : ProtobufSerialisable {
 
         /* Function to read a component from the Blackboard */
         template<class T> const T& read(const T *component);
+        template<class T, int N> T read(const Snapshot<T, N> *component);
+        template<class T> boost::shared_ptr<T> read(const boost::shared_ptr<T> *component);
 
         /* Write a component to the Blackboard */
         template<class T> void write(T *component, const T& value);
+        template<class T, int N> void write(Snapshot<T, N> *component, const T& value);
+        template<class T> void write(boost::shared_ptr<T> *component, const boost::shared_ptr<T>& value);
 
         /**
          * helper for serialization
@@ -22,6 +22,28 @@ void Blackboard::write(T *component, const T& value) {
     *component = value;
 }
 
+template<class T, int N>
+T Blackboard::read(const Snapshot<T, N> *component) {
+    return component->read();
+}
+
+template<class T, int N>
+void Blackboard::write(Snapshot<T, N> *component, const T& value) {
+    component->write(value);
+}
+
+/* Pointers are swapped atomically, so a reader always gets a reference to
+ * either the old or the new object and keeps it alive. */
+template<class T>
+boost::shared_ptr<T> Blackboard::read(const boost::shared_ptr<T> *component) {
+    return boost::atomic_load(component);
+}
+
+template<class T>
+void Blackboard::write(boost::shared_ptr<T> *component, const boost::shared_ptr<T>& value) {
+    boost::atomic_store(component, value);
+}
+
 /* ============================================================================
  *                     BACKWARDS-COMPATIBLE SERIALISATION
  * ============================================================================
@@ -227,9 +249,16 @@ template<class Archive>
 void Blackboard::save(Archive & ar, const unsigned int version) const {
     // note, version is always the latest when saving
     OffNaoMask_t mask = this->mask;
+    // Hold the frames so the camera can't reuse them while they're written.
+    FrameHandle topFrameHandle = boost::atomic_load(&vision.topFrameHandle);
+    FrameHandle botFrameHandle = boost::atomic_load(&vision.botFrameHandle);
+    const uint8_t *topFrame =
+        topFrameHandle ? topFrameHandle.get() : vision.topFrame;
+    const uint8_t *botFrame =
+        botFrameHandle ? botFrameHandle.get() : vision.botFrame;
     if ((mask & SALIENCY_MASK) && (!vision.topSaliency || !vision.botSaliency))
         mask &= (~SALIENCY_MASK);
-    if ((mask & RAW_IMAGE_MASK) && (!vision.topFrame || !vision.botFrame))
+    if ((mask & RAW_IMAGE_MASK) && (!topFrame || !botFrame))
         mask &= (~RAW_IMAGE_MASK);
     ar & boost::serialization::make_nvp("Mask", mask);
 
@@ -271,12 +300,12 @@ void Blackboard::save(Archive & ar, const unsigned int version) const {
         // TODO(jayen): zlib
         ar & boost::serialization::make_nvp(
             "Top Raw Image",
-            boost::serialization:: make_binary_object((void *)vision.topFrame,
+            boost::serialization:: make_binary_object((void *)topFrame,
             sizeof(uint8_t[TOP_IMAGE_ROWS * TOP_IMAGE_COLS * 2]))
         );
         ar & boost::serialization::make_nvp(
             "Bot Raw Image",
-            boost::serialization:: make_binary_object((void *)vision.botFrame,
+            boost::serialization:: make_binary_object((void *)botFrame,
             sizeof(uint8_t[BOT_IMAGE_ROWS * BOT_IMAGE_COLS * 2]))
         );
     }
@@ -0,0 +1,171 @@
+#pragma once
+
+#ifndef Q_MOC_RUN
+#include <boost/serialization/level.hpp>
+#include <boost/serialization/split_free.hpp>
+#include <boost/serialization/tracking.hpp>
+#endif
+#include <sched.h>
+#include <cstddef>
+
+/**
+ * A Blackboard component that one thread writes and any number of threads
+ * read without locks and without ever seeing a half written value.
+ *
+ * Values live in N slots. The writer fills a slot that no reader is using
+ * and then publishes it as the latest. A reader pins the latest slot with a
+ * reference count and copies out of it, retrying only if the writer
+ * published in between, so readers never block, even on the real-time
+ * Motion thread. Unlike a plain seqlock this is safe for types that own
+ * memory, e.g. std::vector, because a slot is never rewritten while a
+ * reader is copying it.
+ *
+ * The writer only waits if every slot other than the latest is pinned,
+ * which takes N - 1 readers each still copying a value that has since been
+ * replaced. With the default N this does not happen in practice.
+ *
+ * readFrom returns a copy of the latest value and writeTo publishes a new
+ * one, so code using the macros does not change.
+ */
+template <class T, int N = 4>
+class Snapshot {
+   public:
+      Snapshot() : latest(0) {
+         for (int i = 0; i < N; ++i) {
+            readers[i] = 0;
+         }
+      }
+
+      Snapshot(const Snapshot &other) : latest(0) {
+         for (int i = 0; i < N; ++i) {
+            readers[i] = 0;
+         }
+         other.read(slots[0]);
+      }
+
+      Snapshot &operator=(const Snapshot &other) {
+         if (this != &other) {
+            write(other.read());
+         }
+         return *this;
+      }
+
+      /**
+       * Copies the latest value into value, reusing its storage.
+       */
+      void read(T &value) const {
+         int slot = pin();
+         value = slots[slot];
+         __sync_fetch_and_sub(&readers[slot], 1);
+      }
+
+      T read() const {
+         int slot = pin();
+         T value = slots[slot];
+         __sync_fetch_and_sub(&readers[slot], 1);
+         return value;
+      }
+
+      operator T() const {
+         return read();
+      }
+
+      /**
+       * Publishes a new value. Only one thread may write a given component.
+       */
+      void write(const T &value) {
+         int slot = freeSlot();
+         slots[slot] = value;
+         // The value must be complete before readers can find it.
+         __sync_synchronize();
+         latest = slot;
+         __sync_synchronize();
+      }
+
+      /**
+       * Reserves capacity in every slot, so that writing a vector component
+       * no larger than n never allocates.
+       */
+      void reserve(std::size_t n) {
+         for (int i = 0; i < N; ++i) {
+            slots[i].reserve(n);
+         }
+      }
+
+   private:
+      /**
+       * Returns the latest slot, pinned against the writer reusing it.
+       */
+      int pin() const {
+         while (true) {
+            int slot = latest;
+            // A full barrier, so latest is reloaded after the pin is visible.
+            __sync_fetch_and_add(&readers[slot], 1);
+            if (slot == latest) {
+               return slot;
+            }
+            // Published over before the pin took; try the new latest.
+            __sync_fetch_and_sub(&readers[slot], 1);
+         }
+      }
+
+      /**
+       * Finds a slot that is neither the latest nor pinned. A reader can
+       * only pin the latest slot, so once found it stays free until
+       * published.
+       */
+      int freeSlot() const {
+         while (true) {
+            for (int i = 0; i < N; ++i) {
+               if (i != latest && readers[i] == 0) {
+                  return i;
+               }
+            }
+            sched_yield();
+         }
+      }
+
+      T slots[N];
+      mutable volatile int readers[N];
+      volatile int latest;
+};
+
+#ifndef Q_MOC_RUN
+/* Serialise as the bare value, so dumps are the same as before a component
+ * became a Snapshot. */
+namespace boost {
+   namespace serialization {
+      template <class T, int N>
+      struct implementation_level<Snapshot<T, N> > {
+         typedef mpl::integral_c_tag tag;
+         typedef mpl::int_<object_serializable> type;
+         BOOST_STATIC_CONSTANT(int, value = implementation_level::type::value);
+      };
+
+      template <class T, int N>
+      struct tracking_level<Snapshot<T, N> > {
+         typedef mpl::integral_c_tag tag;
+         typedef mpl::int_<track_never> type;
+         BOOST_STATIC_CONSTANT(int, value = tracking_level::type::value);
+      };
+
+      template <class Archive, class T, int N>
+      void save(Archive &ar, const Snapshot<T, N> &snapshot, const unsigned int) {
+         const T value = snapshot.read();
+         ar & value;
+      }
+
+      template <class Archive, class T, int N>
+      void load(Archive &ar, Snapshot<T, N> &snapshot, const unsigned int) {
+         T value;
+         ar & value;
+         snapshot.write(value);
+      }
+
+      template <class Archive, class T, int N>
+      void serialize(Archive &ar, Snapshot<T, N> &snapshot, const unsigned int version) {
+         split_free(ar, snapshot, version);
+      }
+   }
+}
+#endif
@@ -559,7 +559,7 @@ void Blackboard::serialise(const Blackboard &cpp, offnao::Blackboard &pb) {
       pb.mutable_gamecontroller()->set_player_number(cpp.gameController.player_number);
       pb.mutable_gamecontroller()->mutable_our_team()->set_teamnumber(cpp.gameController.our_team.teamNumber);
 
-      ::serialise(cpp.motion.sensors, *pb.mutable_motion()->mutable_sensors());
+      ::serialise(cpp.motion.sensors.read(), *pb.mutable_motion()->mutable_sensors());
       ::serialise(cpp.motion.pose, *pb.mutable_motion()->mutable_pose());
       ::serialise(cpp.motion.com, *pb.mutable_motion()->mutable_com());
       ::serialise(cpp.motion.odometry, *pb.mutable_motion()->mutable_odometry());
@@ -579,7 +579,7 @@ void Blackboard::serialise(const Blackboard &cpp, offnao::Blackboard &pb) {
       ::serialise(cpp.kinematics.parameters, *pb.mutable_kinematics()->mutable_parameters());
 
       if (cpp.mask & ROBOT_FILTER_MASK) {
-         ::serialise(cpp.stateEstimation.robotObstacles, *pb.mutable_stateestimation()->mutable_robotobstacles());
+         ::serialise(cpp.stateEstimation.robotObstacles.read(), *pb.mutable_stateestimation()->mutable_robotobstacles());
       }
 
       /* Only serialise the things below if WHITEBOARD_MASK is not set.
@@ -589,7 +589,7 @@ void Blackboard::serialise(const Blackboard &cpp, offnao::Blackboard &pb) {
        */
       if (!(cpp.mask & WHITEBOARD_MASK)) {
          pb.mutable_vision()->set_timestamp(cpp.vision.timestamp);
-         ::serialise(cpp.vision.balls, *pb.mutable_vision()->mutable_balls());
+         ::serialise(cpp.vision.balls.read(), *pb.mutable_vision()->mutable_balls());
          ::serialise(cpp.vision.robots, *pb.mutable_vision()->mutable_robots());
          ::serialise(cpp.vision.fieldBoundaries, *pb.mutable_vision()->mutable_fieldboundaries());
          ::serialise(cpp.vision.fieldFeatures, *pb.mutable_vision()->mutable_fieldfeatures());
@@ -643,10 +643,13 @@ void Blackboard::serialise(const Blackboard &cpp, offnao::Blackboard &pb) {
       }
    }
    if (cpp.mask & RAW_IMAGE_MASK) {
+      // Hold the frames so the camera can't reuse them while they're copied.
+      FrameHandle topFrameHandle = boost::atomic_load(&cpp.vision.topFrameHandle);
+      FrameHandle botFrameHandle = boost::atomic_load(&cpp.vision.botFrameHandle);
       // NULL in simulation
       ::serialise(pb,
                   2,
-                  cpp.vision.topFrame,
+                  topFrameHandle ? topFrameHandle.get() : cpp.vision.topFrame,
                   cpp.vision.topFrameJPEGQuality,
                   TOP_IMAGE_ROWS,
                   TOP_IMAGE_COLS,
@@ -654,7 +657,7 @@ void Blackboard::serialise(const Blackboard &cpp, offnao::Blackboard &pb) {
                   &::offnao::Vision::set_topframe);
       ::serialise(pb,
                   2,
-                  cpp.vision.botFrame,
+                  botFrameHandle ? botFrameHandle.get() : cpp.vision.botFrame,
                   cpp.vision.botFrameJPEGQuality,
                   BOT_IMAGE_ROWS,
                   BOT_IMAGE_COLS,
@@ -927,6 +930,8 @@ void deserialise(Pose &cpp, const offnao::Motion_Pose &pb) {
    deserialiseWithImplicitCast(cpp.botExclusionArray, pb.botexclusionarray());
    if (pb.has_necktoworldtransform())
       cpp.makeConstants();
+   else
+      cpp.makeProjections();
 }
 
 void deserialise(Odometry &cpp, const offnao::Motion_Odometry &pb) {
@@ -1237,7 +1242,9 @@ void Blackboard::deserialise(Blackboard &cpp, const offnao::Blackboard &pb) {
       if (pb.gamecontroller().has_our_team())
          cpp.gameController.our_team.teamNumber = pb.gamecontroller().our_team().teamnumber();
 
-      ::deserialise(cpp.motion.sensors, pb.motion().sensors());
+      SensorValues sensors;
+      ::deserialise(sensors, pb.motion().sensors());
+      cpp.motion.sensors.write(sensors);
       ::deserialise(cpp.motion.pose, pb.motion().pose());
       ::deserialise(cpp.motion.com, pb.motion().com());
       ::deserialise(cpp.motion.odometry, pb.motion().odometry());
@@ -1257,7 +1264,9 @@ void Blackboard::deserialise(Blackboard &cpp, const offnao::Blackboard &pb) {
       ::deserialise(cpp.kinematics.parameters, pb.kinematics().parameters());
 
       if (cpp.mask & ROBOT_FILTER_MASK) {
-         ::deserialise(cpp.stateEstimation.robotObstacles, pb.stateestimation().robotobstacles());
+         vector<RobotObstacle> robotObstacles;
+         ::deserialise(robotObstacles, pb.stateestimation().robotobstacles());
+         cpp.stateEstimation.robotObstacles.write(robotObstacles);
       }
 
       /* Only serialise the things below if WHITEBOARD_MASK is not set.
@@ -1267,7 +1276,9 @@ void Blackboard::deserialise(Blackboard &cpp, const offnao::Blackboard &pb) {
        */
       if (!(cpp.mask & WHITEBOARD_MASK)) {
          cpp.vision.timestamp = pb.vision().timestamp();
-         ::deserialise(cpp.vision.balls, pb.vision().balls());
+         vector<BallInfo> balls;
+         ::deserialise(balls, pb.vision().balls());
+         cpp.vision.balls.write(balls);
          ::deserialise(cpp.vision.robots, pb.vision().robots());
          ::deserialise(cpp.vision.fieldBoundaries, pb.vision().fieldboundaries());
          ::deserialise(cpp.vision.fieldFeatures, pb.vision().fieldfeatures());
@@ -2,6 +2,7 @@
 
 #include <pthread.h>
 #include <ctime>
+#include <sys/time.h>
 #include <utility>
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/classification.hpp>
@@ -34,8 +35,13 @@ PerceptionThread::PerceptionThread(Blackboard *bb)
 
     releaseLock(serialization);
     if (!simulation) {
-       uint8_t const *topFrame = readFrom(vision, topFrame);
-       uint8_t const *botFrame = readFrom(vision, botFrame);
+       // Held while written, in case the camera is still streaming.
+       FrameHandle topHandle = readFrom(vision, topFrameHandle);
+       FrameHandle botHandle = readFrom(vision, botFrameHandle);
+       uint8_t const *topFrame =
+          topHandle ? topHandle.get() : readFrom(vision, topFrame);
+       uint8_t const *botFrame =
+          botHandle ? botHandle.get() : readFrom(vision, botFrame);
 
        if (topFrame != NULL && botFrame != NULL) {
           string file = "/home/nao/crashframe-" +
@@ -51,6 +57,24 @@ PerceptionThread::PerceptionThread(Blackboard *bb)
     }
 
     readOptions(bb->config);
+
+    visionThread = NULL;
+    visionFrames = NULL;
+    stopVision = false;
+    droppedFrames = 0;
+    visionExceptions = 0;
+    // The vision thread is not run by a ThreadManager, which builds its own
+    // module from the blackboard and rebuilds it after a crash, as it shares
+    // visionAdapter and visionFrames with this thread. So it is started and
+    // joined here, at Perception's priority. It is not under Perception's
+    // watchdog; a stalled vision thread shows up as tick's "No vision frame"
+    // warnings instead, and exceptions are caught and counted in visionLoop.
+    if (visionAdapter && bb->config["vision.pipelined"].as<bool>()) {
+       visionFrames = new SPSCQueue<PerceptionFrame>(PIPELINE_DEPTH);
+       visionThread = new boost::thread(
+          boost::bind(&PerceptionThread::visionLoop, this));
+    }
+
     writeTo(thread, configCallbacks[Thread::name],
             boost::function<void(const boost::program_options::variables_map &)>(boost::bind(&PerceptionThread::readOptions, this, _1)));
 }
@@ -59,6 +83,12 @@ PerceptionThread::~PerceptionThread()
 {
     llog(INFO) << __PRETTY_FUNCTION__ << endl;
     writeTo(thread, configCallbacks[Thread::name], boost::function<void(const boost::program_options::variables_map &)>());
+    if (visionThread) {
+       stopVision = true;
+       visionThread->join();
+       delete visionThread;
+       delete visionFrames;
+    }
     delete visionAdapter;
 }
 
@@ -74,13 +104,63 @@ void PerceptionThread::tick()
     llog_open(VERBOSE) << "Perception Thread" << endl;
 
     Timer timer_thread;
-    Timer timer_tick;
 
+    uint32_t vision_time = 0;
+    uint32_t state_estimation_time;
+    if (visionFrames) {
+        state_estimation_time = consumeVisionFrames(vision_time);
+    } else {
+        vision_time = tickVision();
+        state_estimation_time = tickStateEstimation();
+    }
+    uint32_t behaviour_time = tickBehaviour();
+
+    /*
+    * Finishing Perception
+    */
+    uint32_t perception_time = timer_thread.elapsed_us();
+    if (perception_time < THREAD_MAX_TIME)
+    {
+        llog_close(VERBOSE) << "Perception Thread: OK " << perception_time << endl;
+    }
+    else
+    {
+        llog_close(ERROR) << "Perception Thread: TOO LONG " << perception_time << endl;
+    }
+
+    writeTo(perception, vision, vision_time);
+    writeTo(perception, stateEstimation, state_estimation_time);
+    writeTo(perception, behaviour, behaviour_time);
+    writeTo(perception, total, perception_time);
+
+    if (dumper)
+    {
+        if (dump_timer.elapsed_us() > dump_rate)
+        {
+            dump_timer.restart();
+            // Pipelined vision publishes saliency under the same lock.
+            acquireLock(serialization);
+            try
+            {
+                dumper->dump(bb_);
+            }
+            catch (const std::exception &e)
+            {
+                attemptingShutdown = true;
+                cout << "Error: " << e.what() << endl;
+            }
+            releaseLock(serialization);
+        }
+    }
+}
+
+uint32_t PerceptionThread::tickVision()
+{
     /*
     * Vision Tick
     */
     llog_open(VERBOSE) << "Vision Tick" << endl;
-    timer_tick.restart();
+    Timer timer_tick;
     if (visionAdapter)
         visionAdapter->tick();
 
@@ -93,12 +173,16 @@ void PerceptionThread::tick()
     {
         llog_close(ERROR) << "Vision Tick: TOO LONG " << vision_time << endl;
     }
+    return vision_time;
+}
 
+uint32_t PerceptionThread::tickStateEstimation()
+{
     /*
     * State Estimation Tick
     */
     llog_open(VERBOSE) << "State Estimation Tick" << endl;
-    timer_tick.restart();
+    Timer timer_tick;
 
     stateEstimationAdapter.tick();
     
@@ -111,12 +195,16 @@ void PerceptionThread::tick()
     {
         llog_close(ERROR) << "State Estimation Tick: TOO LONG " << state_estimation_time << endl;
     }
+    return state_estimation_time;
+}
 
+uint32_t PerceptionThread::tickBehaviour()
+{
     /*
     * Behaviour Tick
     */
     llog_open(VERBOSE) << "Behaviour Tick" << endl;
-    timer_tick.restart();
+    Timer timer_tick;
     pthread_yield();
 
     if (time(NULL) - readFrom(remoteControl, time_received) < 60)
@@ -140,41 +228,90 @@ void PerceptionThread::tick()
     {
         llog_close(ERROR) << "Behaviour Tick (and perception yield): TOO LONG " << behaviour_time << endl;
     }
+    return behaviour_time;
+}
 
-    /*
-    * Finishing Perception
-    */
-    uint32_t perception_time = timer_thread.elapsed_us();
-    if (perception_time < THREAD_MAX_TIME)
+uint32_t PerceptionThread::consumeVisionFrames(uint32_t &vision_time)
+{
+    // Wait for vision as the sequential tick would wait for the camera, but
+    // keep behaviour running if the camera stops.
+    uint32_t state_estimation_time = 0;
+    if (!visionFrames->waitPop(frame, PIPELINE_WAIT_TIME))
     {
-        llog_close(VERBOSE) << "Perception Thread: OK " << perception_time << endl;
+        llog(WARNING) << "No vision frame in " << PIPELINE_WAIT_TIME
+                      << " us" << endl;
+        return state_estimation_time;
     }
-    else
+
+    // Estimate on every frame, in order, so no observations are lost when
+    // behaviour falls behind. Behaviour then only sees the latest.
+    do
     {
-        llog_close(ERROR) << "Perception Thread: TOO LONG " << perception_time << endl;
+        visionAdapter->publish(frame.vision);
+        vision_time = frame.visionTime;
+        state_estimation_time += tickStateEstimation();
     }
+    while (visionFrames->tryPop(frame));
 
-    writeTo(perception, vision, vision_time);
-    writeTo(perception, stateEstimation, state_estimation_time);
-    writeTo(perception, behaviour, behaviour_time);
-    writeTo(perception, total, perception_time);
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    int64_t latency = tv.tv_sec * 1e6 + tv.tv_usec - frame.vision.timestamp;
+    llog(VERBOSE) << "Vision to state estimation latency: " << latency
+                  << " us" << endl;
+    return state_estimation_time;
+}
 
-    if (dumper)
+void PerceptionThread::visionLoop()
+{
+    Thread::name = "Vision";
+    llog(INFO) << "Pipelined vision thread started" << endl;
+    PerceptionFrame produced;
+    while (!stopVision && !attemptingShutdown)
     {
-        if (dump_timer.elapsed_us() > dump_rate)
+        if (!readFrom(motion, isStiff))
         {
-            dump_timer.restart();
-            try
-            {
-                dumper->dump(bb_);
-            }
-            catch (const std::exception &e)
+            usleep(10000);
+            continue;
+        }
+
+        try
+        {
+            Timer timer_tick;
+            visionAdapter->tickCamera();
+            visionAdapter->process(produced.vision);
+            produced.visionTime = timer_tick.elapsed_us();
+            if (produced.visionTime >= TICK_MAX_TIME_VISION)
             {
-                attemptingShutdown = true;
-                cout << "Error: " << e.what() << endl;
+                llog(ERROR) << "Vision Tick: TOO LONG " << produced.visionTime << endl;
             }
         }
+        catch (const std::exception &e)
+        {
+            ++visionExceptions;
+            llog(ERROR) << "Vision thread caught exception " << visionExceptions
+                        << ": " << e.what() << endl;
+            usleep(VISION_EXCEPTION_BACKOFF);
+            continue;
+        }
+        catch (...)
+        {
+            ++visionExceptions;
+            llog(ERROR) << "Something was thrown from the vision thread, "
+                        << visionExceptions << " exceptions so far" << endl;
+            usleep(VISION_EXCEPTION_BACKOFF);
+            continue;
+        }
+
+        if (!visionFrames->tryPush(produced))
+        {
+            // State estimation has stalled; drop the newest frame rather
+            // than stall the camera.
+            ++droppedFrames;
+            llog(WARNING) << "Perception pipeline full, dropped "
+                          << droppedFrames << " frames" << endl;
+        }
     }
+    llog(INFO) << "Pipelined vision thread stopped" << endl;
 }
 
 void PerceptionThread::readOptions(const boost::program_options::variables_map &config)
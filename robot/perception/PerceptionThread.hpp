@@ -1,13 +1,16 @@
 #pragma once
 
 #include <Python.h>
+#include <atomic>
 #include <string>
+#include <boost/thread/thread.hpp>
 #include "perception/vision/VisionAdapter.hpp"
 #include "perception/behaviour/BehaviourAdapter.hpp"
 #include "perception/stateestimation/StateEstimationAdapter.hpp"
 #include "perception/dumper/PerceptionDumper.hpp"
 #include "perception/vision/camera/CombinedCamera.hpp"
 #include "blackboard/Adapter.hpp"
+#include "utils/SPSCQueue.hpp"
 
 #define THREAD_MAX_TIME 33666
 
@@ -15,6 +18,19 @@
 #define TICK_MAX_TIME_STATE_ESTIMATION 30000
 #define TICK_MAX_TIME_BEHAVIOUR 30000
 
+/* Frames vision may run ahead of state estimation when pipelined */
+#define PIPELINE_DEPTH 4
+/* How long a pipelined tick waits for vision before running behaviour anyway */
+#define PIPELINE_WAIT_TIME 100000
+/* How long the vision thread waits after an exception before the next frame */
+#define VISION_EXCEPTION_BACKOFF 10000
+
+/* A frame handed from the vision thread to the perception thread */
+struct PerceptionFrame {
+   VisionResult vision;
+   uint32_t visionTime;
+};
+
 
 /* Wrapper class for vision, stateestimation and behaviour threads */
 class PerceptionThread : Adapter {
@@ -31,6 +47,18 @@ class PerceptionThread : Adapter {
       void tick();
 
    private:
+      /* The stages of one tick, each returning how long it took in us */
+      uint32_t tickVision();
+      uint32_t tickStateEstimation();
+      uint32_t tickBehaviour();
+
+      /* Publish every frame vision has finished, running state estimation
+       * on each, and return the combined state estimation time */
+      uint32_t consumeVisionFrames(uint32_t &vision_time);
+
+      /* Body of the vision thread when pipelined */
+      void visionLoop();
+
       VisionAdapter *visionAdapter;
       StateEstimationAdapter stateEstimationAdapter;
       BehaviourAdapter behaviourAdapter;
@@ -40,5 +68,16 @@ class PerceptionThread : Adapter {
       PerceptionDumper *dumper;
       Timer dump_timer;
       unsigned int dump_rate;
+
+      /* When pipelined (vision.pipelined), vision runs on visionThread and
+       * hands its results over through visionFrames, so throughput is
+       * bounded by the slowest stage rather than the sum of all of them.
+       * Both are NULL otherwise. visionThread is joined by the destructor */
+      boost::thread *visionThread;
+      SPSCQueue<PerceptionFrame> *visionFrames;
+      std::atomic<bool> stopVision;
+      unsigned int droppedFrames;
+      unsigned int visionExceptions;
+      PerceptionFrame frame;
 };
 
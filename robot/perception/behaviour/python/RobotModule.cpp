@@ -36,6 +36,10 @@ typedef float (AbsCoord::*abs_get_v_const_type)() const;
 
 void py_say(const std::string &text) { SAY(text); }
 
+/* Snapshot components are exposed to Python as a copy of their latest value */
+template <class Owner, class T, Snapshot<T> Owner::*member>
+T snapshot_get(const Owner &owner) { return (owner.*member).read(); }
+
 BOOST_PYTHON_MODULE(robot)
 {
    register_python_converters();
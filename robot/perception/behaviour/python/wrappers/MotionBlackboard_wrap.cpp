@@ -1,4 +1,4 @@
 class_<MotionBlackboard>("MotionBlackboard")
-   .add_property("sensors", &MotionBlackboard::sensors) 
+   .add_property("sensors", &snapshot_get<MotionBlackboard, SensorValues, &MotionBlackboard::sensors>)
    .add_property("active", &MotionBlackboard::active)
    .def_readonly("isStiff", &MotionBlackboard::isStiff);
@@ -11,5 +11,5 @@ class_<StateEstimationBlackboard>("StateEstimationBlackboard")
    .def_readonly("teamBallPos", &StateEstimationBlackboard::teamBallPos)
    .def_readonly("teamBallVel", &StateEstimationBlackboard::teamBallVel)
    .def_readonly("teamBallPosUncertainty", &StateEstimationBlackboard::teamBallPosUncertainty)
-   .def_readonly("robotObstacles", &StateEstimationBlackboard::robotObstacles)
+   .add_property("robotObstacles", &snapshot_get<StateEstimationBlackboard, std::vector<RobotObstacle>, &StateEstimationBlackboard::robotObstacles>)
    .def_readonly("hadTeamBallUpdate", &StateEstimationBlackboard::hadTeamBallUpdate);
@@ -1,3 +1,3 @@
 class_<VisionBlackboard>("VisionBlackboard")
-   .add_property("balls"    , &VisionBlackboard::balls    )
+   .add_property("balls"    , &snapshot_get<VisionBlackboard, std::vector<BallInfo>, &VisionBlackboard::balls>)
    .add_property("timestamp", &VisionBlackboard::timestamp);
@@ -5,7 +5,6 @@
 #include <utils/matrix_helpers.hpp>
 
 Pose::Pose()
-    : lOrigin(4, 1), lOrigin2(4, 1), cdir(4, 1)
 {
    for (int i = 0; i < EXCLUSION_RESOLUTION; i++) {
       topExclusionArray[i] = TOP_IMAGE_ROWS;
@@ -27,14 +26,15 @@ Pose::Pose()
    worldToNeckTransform = boost::numeric::ublas::identity_matrix<float>(4);
 
    horizon = std::pair<int, int>(0, 0);
+
+   makeProjections();
 }
 
 Pose::Pose(boost::numeric::ublas::matrix<float> topCameraToWorldTransform,
            boost::numeric::ublas::matrix<float> botCameraToWorldTransform,
            boost::numeric::ublas::matrix<float> neckToWorldTransform,
            std::pair<int, int> horizon)
-   : topWorldToCameraTransform(4, 4), botWorldToCameraTransform(4, 4), worldToNeckTransform(4, 4),
-    lOrigin(4, 1), lOrigin2(4, 1), cdir(4, 1)
+   : topWorldToCameraTransform(4, 4), botWorldToCameraTransform(4, 4), worldToNeckTransform(4, 4)
 {
    this->topCameraToWorldTransform = topCameraToWorldTransform;
    this->botCameraToWorldTransform = botCameraToWorldTransform;
@@ -75,41 +75,33 @@ Point Pose::imageToRobotXY(const Point &image, int h) const
         return(imageToRobotXYSlow(image, h));
 
     // determine which camera
-    bool top = true;
-    if (image.y() >= TOP_IMAGE_ROWS)
-        top = false;
+    const bool top = image.y() < TOP_IMAGE_ROWS;
 
     // Variations depending on which image we are looking at
     const int COLS = (top) ? TOP_IMAGE_COLS : BOT_IMAGE_COLS;
     const int ROWS = (top) ? TOP_IMAGE_ROWS : BOT_IMAGE_ROWS;
     const float PIXEL = (top) ? TOP_PIXEL_SIZE : BOT_PIXEL_SIZE;
-
-    // calculate vector to pixel in camera space
-    lOrigin2(0, 0) = (((COLS) / 2.0 - image.x()) * PIXEL);
-    lOrigin2(1, 0) = (((ROWS) / 2.0 - (image.y() - (!top)*TOP_IMAGE_ROWS))
-                                                                       * PIXEL);
-    lOrigin2(2, 0) = 0;
-    lOrigin2(3, 0) = 1;
-
-    if (top)
-    {
-        noalias(lOrigin) = prod(
-            topCameraToWorldTransform,
-            lOrigin2);
-        noalias(cdir) = (topToFocus - lOrigin);
-    }
-    else
-    {
-        noalias(lOrigin) = prod(
-            botCameraToWorldTransform,
-            lOrigin2);
-        noalias(cdir) = (botToFocus - lOrigin);
+    const Projection &projection = (top) ? topProjection : botProjection;
+
+    // The pixel in camera space, and then in world space, as the matrix
+    // chain in imageToRobotXYSlow finds it
+    const float u = ((COLS) / 2.0 - image.x()) * PIXEL;
+    const float v = ((ROWS) / 2.0 - (image.y() - (!top)*TOP_IMAGE_ROWS)) * PIXEL;
+    float origin[3];
+    for (int i = 0; i < 3; ++i) {
+        origin[i] = projection.toWorld[i][0] * u + projection.toWorld[i][1] * v
+                                                   + projection.toWorld[i][2];
     }
 
-    float lambda = (h - lOrigin(2, 0)) / (1.0 * cdir(2, 0));
+    // Follow the ray from the pixel through the focal point to height h
+    const float cdir[3] = {
+        projection.focus[0] - origin[0],
+        projection.focus[1] - origin[1],
+        projection.focus[2] - origin[2]
+    };
+    float lambda = (h - origin[2]) / (1.0 * cdir[2]);
 
-    return Point(lOrigin(0, 0) + lambda * cdir(0, 0),
-                                           lOrigin(1, 0) + lambda * cdir(1, 0));
+    return Point(origin[0] + lambda * cdir[0], origin[1] + lambda * cdir[1]);
 }
 
 Point Pose::imageToRobotXYSlow(const Point &image, int h) const
@@ -124,6 +116,9 @@ Point Pose::imageToRobotXYSlow(const Point &image, int h) const
     const int ROWS = (top) ? TOP_IMAGE_ROWS : BOT_IMAGE_ROWS;
     const float PIXEL = (top) ? TOP_PIXEL_SIZE : BOT_PIXEL_SIZE;
 
+    // Fixed size, so on the stack rather than shared scratch
+    boost::numeric::ublas::bounded_matrix<float, 4, 1> lOrigin, lOrigin2, cdir;
+
     // calculate vector to pixel in camera space
     lOrigin2(0, 0) = (((COLS) / 2.0 - image.x()) * PIXEL);
     lOrigin2(1, 0) = (((ROWS) / 2.0 - (image.y() - (!top)*TOP_IMAGE_ROWS))
@@ -158,29 +153,61 @@ Point Pose::imageToRobotXYSlow(const Point &image, int h) const
  * 99.9% sure its right, it works after testing */
 Point Pose::robotToImageXY(Point robot, int h) const
 {
-   boost::numeric::ublas::matrix<float> p = vec4<float>(robot.x(), robot.y(), h, 1);
-
-   boost::numeric::ublas::matrix<float> pixel = prod(botWorldToCameraTransformT,p);
+   const float p[4] = {(float)robot.x(), (float)robot.y(), (float)h, 1};
+   float pixel[3];
+
+   for (int i = 0; i < 3; ++i) {
+      pixel[i] = botProjection.toImage[i][0] * p[0] +
+                 botProjection.toImage[i][1] * p[1] +
+                 botProjection.toImage[i][2] * p[2] +
+                 botProjection.toImage[i][3];
+   }
 
-   pixel(0, 0) /= ABS(pixel(3, 0));
-   pixel(1, 0) /= ABS(pixel(3, 0));
+   pixel[0] /= ABS(pixel[2]);
+   pixel[1] /= ABS(pixel[2]);
 
-   pixel(0, 0) = (pixel(0, 0) * (BOT_IMAGE_COLS / 2))+(BOT_IMAGE_COLS / 2);
-   pixel(1, 0) = (pixel(1, 0) * (BOT_IMAGE_COLS / 2))+(BOT_IMAGE_ROWS / 2);
+   pixel[0] = (pixel[0] * (BOT_IMAGE_COLS / 2))+(BOT_IMAGE_COLS / 2);
+   pixel[1] = (pixel[1] * (BOT_IMAGE_COLS / 2))+(BOT_IMAGE_ROWS / 2);
 
-   if (pixel(1 , 0) < 0) {
-      pixel = prod(topWorldToCameraTransformT,p);
+   if (pixel[1] < 0) {
+      for (int i = 0; i < 3; ++i) {
+         pixel[i] = topProjection.toImage[i][0] * p[0] +
+                    topProjection.toImage[i][1] * p[1] +
+                    topProjection.toImage[i][2] * p[2] +
+                    topProjection.toImage[i][3];
+      }
 
-      pixel(0, 0) /= ABS(pixel(3, 0));
-      pixel(1, 0) /= ABS(pixel(3, 0));
+      pixel[0] /= ABS(pixel[2]);
+      pixel[1] /= ABS(pixel[2]);
 
-      pixel(0, 0) = (pixel(0, 0) * (TOP_IMAGE_COLS / 2)) + (TOP_IMAGE_COLS / 2);
-      pixel(1, 0) = (pixel(1, 0) * (TOP_IMAGE_COLS / 2)) + (TOP_IMAGE_ROWS / 2);
+      pixel[0] = (pixel[0] * (TOP_IMAGE_COLS / 2)) + (TOP_IMAGE_COLS / 2);
+      pixel[1] = (pixel[1] * (TOP_IMAGE_COLS / 2)) + (TOP_IMAGE_ROWS / 2);
    } else {
-      pixel(1, 0) += TOP_IMAGE_ROWS;
+      pixel[1] += TOP_IMAGE_ROWS;
    }
 
-   return Point(pixel(0, 0), pixel(1, 0));
+   return Point(pixel[0], pixel[1]);
+}
+
+float Pose::projectionError(int h) const
+{
+   float error = 0;
+   for (int camera = 0; camera < 2; ++camera) {
+      const bool top = camera == 0;
+      const int COLS = (top) ? TOP_IMAGE_COLS : BOT_IMAGE_COLS;
+      const int ROWS = (top) ? TOP_IMAGE_ROWS : BOT_IMAGE_ROWS;
+      for (int y = 0; y < ROWS; y += ROWS / 8) {
+         for (int x = 0; x < COLS; x += COLS / 8) {
+            const Point image(x, y + (!top) * TOP_IMAGE_ROWS);
+            const Point slow = imageToRobotXYSlow(image, h);
+            if (slow.x() <= 0 || hypotf(slow.x(), slow.y()) > 10000)
+               continue;
+            const Point fast = imageToRobotXY(image, h);
+            error = std::max(error, hypotf(fast.x() - slow.x(), fast.y() - slow.y()));
+         }
+      }
+   }
+   return error;
 }
 
 std::pair<int, int> Pose::getHorizon() const {
@@ -280,4 +307,32 @@ void Pose::makeConstants()
    botCOrigin = prod(botCameraToWorldTransform, origin);
    topToFocus = prod(topCameraToWorldTransform, vec4<float>(0, 0,FOCAL_LENGTH, 1));
    botToFocus = prod(botCameraToWorldTransform, vec4<float>(0, 0,FOCAL_LENGTH, 1));
+
+   makeProjections();
+}
+
+void Pose::makeProjections()
+{
+   for (int camera = 0; camera < 2; ++camera) {
+      const bool top = camera == 0;
+      Projection &projection = top ? topProjection : botProjection;
+      const boost::numeric::ublas::matrix<float> &toWorld =
+         top ? topCameraToWorldTransform : botCameraToWorldTransform;
+      const boost::numeric::ublas::matrix<float> &focus =
+         top ? topToFocus : botToFocus;
+      const boost::numeric::ublas::matrix<float> &toImage =
+         top ? topWorldToCameraTransformT : botWorldToCameraTransformT;
+
+      for (int i = 0; i < 3; ++i) {
+         projection.toWorld[i][0] = toWorld(i, 0);
+         projection.toWorld[i][1] = toWorld(i, 1);
+         projection.toWorld[i][2] = toWorld(i, 3);
+         projection.focus[i] = focus(i, 0);
+      }
+      for (int j = 0; j < 4; ++j) {
+         projection.toImage[0][j] = toImage(0, j);
+         projection.toImage[1][j] = toImage(1, j);
+         projection.toImage[2][j] = toImage(3, j);
+      }
+   }
 }
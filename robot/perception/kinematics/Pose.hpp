@@ -67,10 +67,25 @@ class Pose {
        */
       RRCoord imageToRobotRelative(Point p, int h = 0) const;
 
+      /**
+       * Projects between the image and the plane at height h, in closed form
+       * from coefficients cached with the transforms. Thread safe.
+       */
       Point imageToRobotXY(const Point &image, int h = 0) const;
-      Point imageToRobotXYSlow(const Point &image, int h = 0) const;
       Point robotToImageXY(Point robot, int h = 0) const;
 
+      /**
+       * imageToRobotXY through the full matrix chain. Thread safe.
+       */
+      Point imageToRobotXYSlow(const Point &image, int h = 0) const;
+
+      /**
+       * The largest distance in mm between imageToRobotXY and
+       * imageToRobotXYSlow over a grid of each image's pixels that project
+       * onto the field within 10 m. Thread safe.
+       */
+      float projectionError(int h = 0) const;
+
       /* Returns a pointer to the exclusion arrays used by vision */
       const int16_t *getTopExclusionArray() const;
       int16_t *getTopExclusionArray();
@@ -98,13 +113,27 @@ class Pose {
 
       void makeConstants();
 
+      /**
+       * One camera's projections as plain coefficients, so projecting needs
+       * no matrix temporaries.
+       */
+      struct Projection {
+         // Rows x, y and z, columns x, y and translation, of the camera to
+         // world transform
+         float toWorld[3][3];
+         // The focal point in world space
+         float focus[3];
+         // Rows 0, 1 and 3 of the world to image projection
+         float toImage[3][4];
+      };
+      Projection topProjection, botProjection;
+
+      void makeProjections();
+
       std::pair<int, int> horizon;
       int16_t topExclusionArray[EXCLUSION_RESOLUTION];
       int16_t botExclusionArray[EXCLUSION_RESOLUTION];
 
-      // Storage for use in calculations - needed to avoid memory reallocation.
-      mutable boost::numeric::ublas::matrix<float> lOrigin, lOrigin2, cdir;
-
 #ifndef SWIG
       BOOST_SERIALIZATION_SPLIT_MEMBER();
 #endif
@@ -17,7 +17,8 @@
 #include <boost/math/constants/constants.hpp>
 
 // Chooses between multiballtracker and egoballtracker (single ball)
-// When using Multiball you'll want to comment out `#define EARLY_EXIT 1` in BallDetector.cpp
+// When using Multiball you'll want to comment out `#define EARLY_EXIT 1` in BallDetector.cpp,
+// and vision.ballthreads makes searching every region affordable
 // #define USE_MULTIBALL 1
 
 StateEstimationAdapter::StateEstimationAdapter(Blackboard *bb)
@@ -2,8 +2,13 @@
 #include <algorithm>
 #include <vector>
 #include <utility>
+#include <new>
 
 #include "perception/vision/Fovea.hpp"
+#include "perception/vision/other/AdaptiveThreshold.hpp"
+#include "perception/vision/other/FrameArena.hpp"
+#include "perception/vision/other/ImagePlanes.hpp"
+#include "perception/vision/other/ImagePyramid.hpp"
 
 
 //#define FOVEA_TIMINGS
@@ -11,6 +16,17 @@
 #include "utils/Timer.hpp"
 #endif // FOVEA_TIMINGS
 
+/**
+ * Creates a child fovea whose colour array is allocated from arena.
+ */
+Fovea::Fovea(BBox bb, int density, bool top, bool colour, FrameArena& arena) :
+    bb(bb), density(density), top(top), hasColour(colour),
+    _colour(colour ? arena.allocateArray<Colour>(bb.width() * bb.height())
+                                                                       : NULL),
+    width(bb.b[0]-bb.a[0]), _planes(NULL), _pyramid(NULL), _yImage(NULL),
+    arena_(&arena),
+    colourInArena_(true) {}
+
 /**
  * Free the _colour arrays.
  */
@@ -22,7 +38,7 @@ Fovea::~Fovea()
     child_fovea_.clear();
 
     // Clear data array.
-    if(hasColour)
+    if(hasColour && !colourInArena_)
         delete[] _colour;
 }
 
@@ -78,13 +94,24 @@ void Fovea::generate(const CombinedFrame& combined_frame,
 
     // Record the frame.
     if(top)
+    {
         _rawImage = combined_frame.top_frame_;
+        _planes = combined_frame.top_planes_;
+        _pyramid = combined_frame.top_pyramid_;
+    }
     else
+    {
         _rawImage = combined_frame.bot_frame_;
+        _planes = combined_frame.bot_planes_;
+        _pyramid = combined_frame.bot_pyramid_;
+    }
+    _yImage = _planes ? _planes->y() : NULL;
 
     // Translate the y axis stop coordinates into linear stop start coordinates.
-    std::pair<std::vector<int>*, std::vector<const uint8_t*>* > startStop =
-                                                                getStartStop_();
+    // These are only used to mark body parts.
+    startStop_.clear();
+    if(hasColour && do_body_part)
+        getStartStop_(startStop_);
 
 #ifdef FOVEA_TIMINGS
     if(bb.width() == TOP_SALIENCY_COLS)
@@ -95,7 +122,7 @@ void Fovea::generate(const CombinedFrame& combined_frame,
     // Generate colour image if needed.
     if(hasColour)
     {
-        makeBinary_(*startStop.first, do_body_part);
+        makeBinary_(startStop_, do_body_part);
     }
 
 #ifdef FOVEA_TIMINGS
@@ -115,10 +142,6 @@ void Fovea::generate(const CombinedFrame& combined_frame,
         edgeTime += timer.elapsed_us();
 #endif // FOVEA_TIMINGS
 
-    // Clean up x start stop.
-    delete startStop.first;
-    delete startStop.second;
-
 #ifdef FOVEA_TIMINGS
     if(frameCount == 1000)
     {
@@ -139,17 +162,10 @@ void Fovea::generate(const CombinedFrame& combined_frame,
 /*
  * Translates the y axis robot part stop array to a linear start stop array.
  */
-std::pair<std::vector<int>*, std::vector<const uint8_t*>* >
-                                                    Fovea::getStartStop_() const
+void Fovea::getStartStop_(std::vector<int>& startStop)
 {
-    // The number of columns in the image.
-    const int doubleCols = 2*(top*TOP_IMAGE_COLS+(!top)*BOT_IMAGE_COLS);
-
-    // Create a startStop array.
-    std::vector<int>* startStop = new std::vector<int>();
-    std::vector<const uint8_t*>* startStopRaw =
-                                              new std::vector<const uint8_t*>();
-    startStop->reserve(bb.height()*4);
+    // Fill the startStop array.
+    startStop.reserve(bb.height()*4);
 
     // The number of x and y axis rows covered by this fovea.
     int xAxisCols = bb.width();
@@ -157,18 +173,16 @@ std::pair<std::vector<int>*, std::vector<const uint8_t*>* >
 
     // The y axis stopping points relevant to this fovea, sorted by height.
     // Stored as y, x, in descending order.
-    std::vector<std::pair<int, int> > sortedStops;
+    std::vector<std::pair<int, int> >& sortedStops = sortedStops_;
+    sortedStops.clear();
 
     // The set of starts and stops relevant at this y value.
-    std::vector<int> relevantStartStops;
+    std::vector<int>& relevantStartStops = relevantStartStops_;
+    relevantStartStops.clear();
 
     // Iterator to the next y value to include.
     std::vector<std::pair<int, int> >::iterator highestY;
 
-    // The first pixel in the fovea in the raw image.
-    const uint8_t* firstPixel = _rawImage + bb.a.x()*density*2 +
-                                                    bb.a.y()*density*doubleCols;
-
     // Create the sorted y axis stop array.
     sortedStops.reserve(xAxisCols);
     if(top)
@@ -204,7 +218,6 @@ std::pair<std::vector<int>*, std::vector<const uint8_t*>* >
     {
         // The linear location of the start of this row.
         int startVal = y*bb.width();
-        const uint8_t* startValRaw = firstPixel+y*density*doubleCols;
 
         // Firstly, check for new y stops to include.
         while(highestY < sortedStops.end() && (*highestY).first <= y)
@@ -298,15 +311,8 @@ std::pair<std::vector<int>*, std::vector<const uint8_t*>* >
 
         // Now that relevantStartStops is up to date, make use of it.
         for(unsigned int xVal=0; xVal<relevantStartStops.size(); ++xVal)
-        {
-            startStop->push_back(startVal+relevantStartStops[xVal]);
-            startStopRaw->push_back(startValRaw +
-                                            relevantStartStops[xVal]*density*2);
-        }
+            startStop.push_back(startVal+relevantStartStops[xVal]);
     }
-
-    // Return the result.
-    return(std::make_pair(startStop, startStopRaw));
 }
 
 /**
@@ -359,47 +365,50 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
     * http://citeseerx.ist.psu.edu/viewdoc/download?doi=10.1.1.420.7883&rep=rep1&type=pdf
     */
 
-    // Create _intImg
-    int *const _intImg = new int[width * height];
-
-    // The distance between two saliency density y values, as the raw array is
-    // in the YUV422 format (YUYVYUYV...).
-    const int double_density = density*2;
-
-    // The distance between two saliency density rows.
-    const int row_size = density*2*(TOP_IMAGE_COLS*top + BOT_IMAGE_COLS*(!top));
+    // Create _intImg, from the arena if there is one as it is only needed
+    // until the end of this function.
+    const size_t arenaMarker = arena_ ? arena_->mark() : 0;
+    int *const _intImg = arena_ ? arena_->allocateArray<int>(width * height)
+                                : new int[width * height];
+
+    // The distance between two fovea density y values (step) and rows
+    // (row_size), and the y value of the first pixel of this fovea. Read from
+    // the pyramid's box filtered Y plane at this density if it has one and
+    // vision.pyramidfoveae gave it the pyramid, otherwise every density'th
+    // pixel of the full resolution plane,
+    // otherwise the raw YUV422 image (YUYVYUYV...).
+    const int image_cols = top ? TOP_IMAGE_COLS : BOT_IMAGE_COLS;
+    int step;
+    int row_size;
+    const uint8_t* start_raw;
+    if (_planes && _pyramid && ImagePyramid::hasDensity(density))
+    {
+        step = 1;
+        row_size = _pyramid->cols(density);
+        start_raw = _pyramid->y(density) + bb.a.x() + bb.a.y()*row_size;
+    }
+    else if (_planes)
+    {
+        step = density;
+        row_size = density*image_cols;
+        start_raw = _planes->y() + bb.a.x()*step + bb.a.y()*row_size;
+    }
+    else
+    {
+        step = density*2;
+        row_size = density*2*image_cols;
+        start_raw = _rawImage + bb.a.x()*step + bb.a.y()*row_size;
+    }
 
     // Create pointers
     const uint8_t* curr_raw;
-    int* curr_intImg;
-    int* upper_intImg; // the pixel just on the top of current pixel
 
-    // Initialise pointers
-    curr_pixel = _colour;
-    curr_raw = _rawImage + bb.a.x()*double_density + bb.a.y()*row_size;
-    curr_intImg = _intImg;
-    upper_intImg = _intImg;
+    // Build the integral image with the fastest kernel the CPU supports.
+    AdaptiveThreshold::integralImage(start_raw, step, row_size,
+                                     width, height, _intImg);
 
     int sum;
 
-    for(int i=0; i < height; ++i)
-    {
-        sum = 0;
-        for(int j=0; j < width; ++j)
-        {
-            sum += (*curr_raw);
-            if (i == 0){
-                *curr_intImg = sum;
-            } else {
-                *curr_intImg = *upper_intImg + sum;
-                ++upper_intImg;
-            }
-            curr_raw += double_density;
-            ++curr_intImg;
-        }
-        curr_raw += row_size - width * double_density;
-    }
-
     // Initialise variables for second part
     int x1, x2, y1, y2;
     int count;
@@ -457,10 +466,6 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
 
 
     // Following code is an optimized version
-    // raw image of the first pixel of this fovea
-    const uint8_t * start_raw = _rawImage + bb.a.x()*double_density + bb.a.y()*row_size;
-
-
     // loop 1 for x1, y1 outside image
     // Reset pointers and variables that were used
     x1 = 1;
@@ -489,13 +494,13 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
             {
                 *curr_pixel = cWHITE;
             }
-            curr_raw += double_density;
+            curr_raw += step;
             ++curr_pixel;
             ++x2y2_intImg;
             ++jumpLeft;
             ++y2;
         }
-        curr_raw += row_size - (s_half + 1) * double_density;
+        curr_raw += row_size - (s_half + 1) * step;
         jumpUp += width;
         ++x2;
         y2-=(s_half+1);
@@ -532,13 +537,13 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
             {
                 *curr_pixel = cWHITE;
             }
-            curr_raw += double_density;
+            curr_raw += step;
             ++curr_pixel;
             ++x2y2_intImg;
             ++jumpLeft;
             ++y2;
         }
-        curr_raw += row_size - (s_half + 1) * double_density;
+        curr_raw += row_size - (s_half + 1) * step;
         jumpUp -= width;
         ++x1;
         y2-=(s_half+1);
@@ -553,7 +558,7 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
     x2 = s_half;
     y1 = width - 2 * s_half;
     y2 = width - 1;
-    curr_raw = start_raw + (width - s_half) * double_density;// pointer to raw image data of (0,width-s_half)
+    curr_raw = start_raw + (width - s_half) * step;// pointer to raw image data of (0,width-s_half)
     //curr_intImg = _intImg + width - s_half;// pointer to integral image data of (0,width-s_half)
     sum = 0;
     x2y2_intImg = _intImg + width * s_half + width - 1;
@@ -575,12 +580,12 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
             {
                 *curr_pixel = cWHITE;
             }
-            curr_raw += double_density;
+            curr_raw += step;
             ++curr_pixel;
             --jumpLeft;
             ++y1;
         }
-        curr_raw += row_size - s_half * double_density;
+        curr_raw += row_size - s_half * step;
         jumpUp += width;
         ++x2;
         y1-=s_half;
@@ -595,7 +600,7 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
     x2 = height - 1;
     y1 = width - 2 * s_half;
     y2 = width - 1;
-    curr_raw = start_raw + row_size * (height - s_half) + double_density * (width - s_half);// pointer to raw image data of (height-s_half,width-s_half)
+    curr_raw = start_raw + row_size * (height - s_half) + step * (width - s_half);// pointer to raw image data of (height-s_half,width-s_half)
     //curr_intImg = _intImg + width * (height - s_half) + width -s_half;// pointer to integral image data of (geight-s_half,width-s_half)
     sum = 0;
     x2y2_intImg = _intImg + width * (height - 1) + width - 1;
@@ -617,12 +622,12 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
             {
                 *curr_pixel = cWHITE;
             }
-            curr_raw += double_density;
+            curr_raw += step;
             ++curr_pixel;
             --jumpLeft;
             ++y1;
         }
-        curr_raw += row_size - s_half * double_density;
+        curr_raw += row_size - s_half * step;
         jumpUp -= width;
         ++x1;
         y1-=s_half;
@@ -636,7 +641,7 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
     x2 = s_half;
     y1 = 1;
     y2 = 2 * s_half + 1;
-    curr_raw = start_raw + double_density * (s_half + 1);// pointer to raw image data of (0,s_half+1)
+    curr_raw = start_raw + step * (s_half + 1);// pointer to raw image data of (0,s_half+1)
     //curr_intImg = _intImg + s_half + 1;// pointer to integral image data of (0,s_half+1)
     sum = 0;
     x2y2_intImg = _intImg + width * s_half + 2 * s_half + 1;
@@ -658,13 +663,13 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
             {
                 *curr_pixel = cWHITE;
             }
-            curr_raw += double_density;
+            curr_raw += step;
             ++curr_pixel;
             ++x2y2_intImg;
             ++y1;
             ++y2;
         }
-        curr_raw += row_size - (width - 2 * s_half - 1) * double_density;
+        curr_raw += row_size - (width - 2 * s_half - 1) * step;
         jumpUp += width;
         ++x2;
         y1 = 1;
@@ -679,7 +684,7 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
     x2 = height - 1;
     y1 = 1;
     y2 = 2 * s_half + 1;
-    curr_raw = start_raw + row_size * (height - s_half) + double_density * (s_half + 1);// pointer to raw image data of (height-s_half,s_half+1)
+    curr_raw = start_raw + row_size * (height - s_half) + step * (s_half + 1);// pointer to raw image data of (height-s_half,s_half+1)
     //curr_intImg = _intImg + width * (height - s_half) + s_half + 1;// pointer to integral image data of (height-s_half,s_half+1)
     sum = 0;
     x2y2_intImg = _intImg + width * (height - 1) + 2 * s_half + 1;
@@ -701,13 +706,13 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
             {
                 *curr_pixel = cWHITE;
             }
-            curr_raw += double_density;
+            curr_raw += step;
             ++curr_pixel;
             ++x2y2_intImg;
             ++y1;
             ++y2;
         }
-        curr_raw += row_size - (width - 2 * s_half - 1) * double_density;
+        curr_raw += row_size - (width - 2 * s_half - 1) * step;
         jumpUp -= width;
         ++x1;
         y1 = 1;
@@ -744,13 +749,13 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
             {
                 *curr_pixel = cWHITE;
             }
-            curr_raw += double_density;
+            curr_raw += step;
             ++curr_pixel;
             ++x2y2_intImg;
             ++y2;
             ++jumpLeft;
         }
-        curr_raw += row_size - (s_half + 1) * double_density;
+        curr_raw += row_size - (s_half + 1) * step;
         jumpLeft -= s_half + 1;
         ++x1;
         ++x2;
@@ -765,7 +770,7 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
     x2 = 2 * s_half + 1;
     y1 = width - 2 * s_half;
     y2 = width - 1;
-    curr_raw = start_raw + row_size * (s_half + 1) + double_density * (width - s_half);// pointer to raw image data of (s_half+1,width-s_half)
+    curr_raw = start_raw + row_size * (s_half + 1) + step * (width - s_half);// pointer to raw image data of (s_half+1,width-s_half)
     //curr_intImg = _intImg + width * (s_half + 1) + width - s_half;// pointer to integral image data of (s_half+1,width-s_half)
     sum = 0;
     x2y2_intImg = _intImg + width * (2 * s_half + 1) + width - 1;
@@ -787,12 +792,12 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
             {
                 *curr_pixel = cWHITE;
             }
-            curr_raw += double_density;
+            curr_raw += step;
             ++curr_pixel;
             ++y1;
             --jumpLeft;
         }
-        curr_raw += row_size - s_half * double_density;
+        curr_raw += row_size - s_half * step;
         ++x1;
         ++x2;
         y1 = width - 2 * s_half;
@@ -801,50 +806,25 @@ void Fovea::makeBinary_(const std::vector<int>& startStop, bool do_body_part)
         curr_pixel += width - s_half;
     }
 
-    // loop 9 for no-edge case
-    // Reset pointers and variables that were used
-    x1 = 1;
-    x2 = 2 * s_half + 1;
-    y1 = 1;
-    y2 = 2 * s_half + 1;
-    curr_raw = start_raw + row_size * (s_half + 1) + double_density * (s_half + 1);// pointer to raw image data of (s_half+1,s_half+1)
-    //curr_intImg = _intImg + width *(s_half + 1) + s_half + 1;// pointer to integral image data of (s_half+1,width-s_half)
-    sum = 0;
-    x2y2_intImg = _intImg + width * (2 * s_half + 1) + 2 * s_half + 1;
+    // loop 9 for no-edge case, vectorised a row at a time
     jumpUp = (2 * s_half + 1) * width;
     jumpLeft = 2 * s_half + 1;
-    curr_pixel = _colour + width *(s_half + 1) + s_half + 1;
-    count = (x2-x1+1)*(y2-y1+1);
+    count = jumpLeft * jumpLeft;
 
     for(int i=s_half+1; i < height-s_half; ++i)
     {
-        for(int j=s_half+1; j < width-s_half; ++j)
-        {
-            sum = *x2y2_intImg - *(x2y2_intImg - jumpLeft) - *(x2y2_intImg - jumpUp) + *(x2y2_intImg - jumpUp - jumpLeft);
-            if ((*curr_raw * count) * 100 <= (sum * (100-t)))
-            {
-                *curr_pixel = cGREEN;
-            }
-            else
-            {
-                *curr_pixel = cWHITE;
-            }
-            curr_raw += double_density;
-            ++curr_pixel;
-            ++y1;
-            ++y2;
-            ++x2y2_intImg;
-        }
-        curr_raw += row_size - (width - 2 * s_half - 1) * double_density;
-        ++x1;
-        ++x2;
-        y1 = 1;
-        y2 = 2 * s_half + 1;
-        x2y2_intImg += 2 * s_half + 1;
-        curr_pixel += 2 * s_half + 1;
+        x2y2_intImg = _intImg + width * (i + s_half) + 2 * s_half + 1;
+        AdaptiveThreshold::thresholdRow(
+            start_raw + row_size * i + step * (s_half + 1),
+            step, x2y2_intImg, x2y2_intImg - jumpUp, jumpLeft,
+            count, t, width - 2 * s_half - 1,
+            _colour + width * i + s_half + 1);
     }
 
-    delete[] _intImg;
+    if (arena_)
+        arena_->rewind(arenaMarker);
+    else
+        delete[] _intImg;
 
 
     if (do_body_part){
@@ -914,12 +894,26 @@ Fovea* Fovea::getChildFovea(const BBox& bounding_box,
         const int density_to_raw, const bool top,
         const bool generate_fovea_colour, const int window_size, const int percentage)
 {
-    // Create the new fovea.
-    Fovea* new_fovea = new Fovea(bounding_box, density_to_raw, top,
-               generate_fovea_colour);
+    // Create the new fovea. Child fovea from an arena are destructed and freed
+    // when the arena is reset, so only heap allocated ones need recording. A
+    // thread with an arena of its own uses that rather than this fovea's,
+    // which may be in use on other threads.
+    Fovea* new_fovea;
+    FrameArena* arena = FrameArena::current() ? FrameArena::current() : arena_;
+    if (arena)
+    {
+        new_fovea = new (arena->allocate(sizeof(Fovea))) Fovea(bounding_box,
+                           density_to_raw, top, generate_fovea_colour, *arena);
+        arena->destroyOnReset(new_fovea);
+    }
+    else
+    {
+        new_fovea = new Fovea(bounding_box, density_to_raw, top,
+                   generate_fovea_colour);
 
-    // Record it for memory managment.
-    child_fovea_.push_back(new_fovea);
+        // Record it for memory managment.
+        child_fovea_.push_back(new_fovea);
+    }
 
     // Generate its saliency images.
     new_fovea->generate(*combined_frame_, window_size, percentage);
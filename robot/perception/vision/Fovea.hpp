@@ -6,6 +6,9 @@
 #include "types/Point.hpp"
 #include "types/BBox.hpp"
 
+class FrameArena;
+class ImagePlanes;
+class ImagePyramid;
 
 class Fovea {
 
@@ -15,12 +18,17 @@ public:
      * Creates a new fovea. bb is the bounds of the fovea in fovea density
      * pixels, density is the density of the fovea and top is whether this
      * fovea is in the top or bottom image. colour determine
-     * whether the colourimages are generated respectively.
+     * whether the colourimages are generated respectively. If arena is given,
+     * child foveae and per frame scratch memory come from it rather than the
+     * heap; the arena must be reset before each call to generate.
      */
-    Fovea(BBox bb, int density, bool top, bool colour) :
+    Fovea(BBox bb, int density, bool top, bool colour,
+                                                   FrameArena* arena = NULL) :
         bb(bb), density(density), top(top), hasColour(colour),
         _colour(colour  ? new Colour[bb.width() * bb.height()] : NULL),
-                                                       width(bb.b[0]-bb.a[0]) {}
+        width(bb.b[0]-bb.a[0]), _planes(NULL), _pyramid(NULL), _yImage(NULL),
+        arena_(arena),
+        colourInArena_(false) {}
 
     /**
      * Free the _colour arrays.
@@ -61,6 +69,24 @@ public:
         return(_rawImage+linearPos);
     }
 
+    /**
+     * Returns the Y value of the raw pixel at linearPos, as for getRawYUV, but
+     * from the packed Y plane if the frame has one.
+     */
+    inline uint8_t getRawY(int linearPos) const
+    {
+        return _yImage ? _yImage[linearPos >> 1] : _rawImage[linearPos];
+    }
+
+    /**
+     * Returns the packed Y plane of the image this fovea is in, or NULL if the
+     * frame has none. getRawY(linearPos) is getRawYPlane()[linearPos >> 1].
+     */
+    inline const uint8_t* getRawYPlane() const
+    {
+        return _yImage;
+    }
+
     /**
      * Returns the colour classification of the requested pixel, relative to the
      * fovea bounds. Must be inside the fovea bounds.
@@ -204,12 +230,39 @@ private:
     // A pointer to the upper left pixel of the image this fovea is in.
     const uint8_t *     _rawImage;
 
+    // The packed planes of the image this fovea is in, or NULL.
+    const ImagePlanes*  _planes;
+
+    // The pyramid of the image this fovea is in, or NULL, as it is unless
+    // vision.pyramidfoveae is set.
+    const ImagePyramid* _pyramid;
+
+    // The full resolution Y plane of _planes, or NULL.
+    const uint8_t *     _yImage;
+
     // These need to be available for generating child foveas.
     const CombinedFrame* combined_frame_;
 
-    // All this fovea's child fovea.
+    // All this fovea's heap allocated child fovea. Child fovea allocated from
+    // an arena are not recorded, as the arena destructs and frees them.
     std::vector<Fovea*> child_fovea_;
 
+    // Where child fovea and scratch memory come from, NULL for the heap.
+    FrameArena* const   arena_;
+
+    // Whether _colour was allocated from arena_.
+    const bool           colourInArena_;
+
+    // Reused between frames when building the body part start stop array.
+    std::vector<int> startStop_;
+    std::vector<std::pair<int, int> > sortedStops_;
+    std::vector<int> relevantStartStops_;
+
+    /**
+     * Creates a child fovea whose colour array is allocated from arena.
+     */
+    Fovea(BBox bb, int density, bool top, bool colour, FrameArena& arena);
+
     /**
      * Creates a binary image.
      */
@@ -229,8 +282,7 @@ private:
     /*
      * Translates the y axis robot part stop array to a linear start stop array.
      */
-    std::pair<std::vector<int>*, std::vector<const uint8_t*>* > getStartStop_()
-                                                                          const;
+    void getStartStop_(std::vector<int>& startStop);
 };
 
 #endif
@@ -4,6 +4,8 @@
 #include "Region.hpp"
 #endif
 
+#include <algorithm>
+
 #include "soccer.hpp"
 
 /**
@@ -228,6 +230,49 @@ RegionI::iterator_fovea RegionI::begin_fovea() const {
     );
 }
 
+#ifndef REGION_TEST
+/**
+ * Finds the spans of a row that a field mask leaves in, in region-space
+ * @mask the field mask of this region's camera
+ * @y row in the region-space
+ * @spans filled with the spans in region-space columns
+ */
+void RegionI::getFieldSpans(const FieldMask& mask, int y,
+                            std::vector<FieldSpan>& spans) const
+{
+    spans.clear();
+    const int y_raw = y_offset_raw_ + y*density_to_raw_;
+    const int cols = getCols();
+    const FieldSpan* end = mask.rowEnd(y_raw);
+    for (const FieldSpan* span = mask.rowBegin(y_raw); span != end; ++span) {
+        if (span->end <= x_offset_raw_) {
+            continue;
+        }
+
+        // The region columns whose raw column is in the span, rounding up
+        // at both ends
+        FieldSpan clipped;
+        clipped.begin = std::max((span->begin - x_offset_raw_ +
+                                  density_to_raw_ - 1) / density_to_raw_, 0);
+        if (clipped.begin >= cols) {
+            break;
+        }
+        clipped.end = std::min((span->end - x_offset_raw_ +
+                                density_to_raw_ - 1) / density_to_raw_, cols);
+        if (clipped.begin >= clipped.end) {
+            continue;
+        }
+
+        // Spans that round to touching region columns are one span
+        if (!spans.empty() && spans.back().end >= clipped.begin) {
+            spans.back().end = clipped.end;
+        } else {
+            spans.push_back(clipped);
+        }
+    }
+}
+#endif
+
 /**
  * Creates a new region from an existing region. The new region may have
  * a different position and size compared to the old region.
@@ -3,10 +3,12 @@
 
 #include <list>
 #include <map>
+#include <vector>
 
 #ifndef REGION_TEST
 #include "types/BBox.hpp"
 #include "types/CombinedFovea.hpp"
+#include "perception/vision/other/FieldMask.hpp"
 #else
 #define TOP_IMAGE_COLS 1024
 #define BOT_IMAGE_COLS 1024
@@ -58,6 +60,13 @@ public:
     #include "perception/vision/Region/RegionIteratorRaw.tcc"
     #include "perception/vision/Region/RegionIteratorFovea.tcc"
 
+    #ifndef REGION_TEST
+    //////////////////////////////////
+    // Row view sub classes
+    //////////////////////////////////
+    #include "perception/vision/Region/RegionView.tcc"
+    #endif
+
     /**
      * Empty constructor
      *  Used in serialisation.
@@ -321,6 +330,20 @@ public:
         );
     }
 
+    #ifndef REGION_TEST
+    /**
+     * Finds the spans of row y that the field mask leaves in, so scans can
+     *  start an iterator at the beginning of each and skip the pixels
+     *  between them
+     * @mask the field mask of this region's camera
+     * @y row in the region-space
+     * @spans filled with the spans in region-space columns, sorted, none
+     *  empty and none touching
+     */
+    void getFieldSpans(const FieldMask& mask, int y,
+                       std::vector<FieldSpan>& spans) const;
+    #endif
+
     /**
      * Returns a pointer to a underlying fovea. This is used for blackboard to
      * access the colour saliency arrays.
@@ -389,6 +412,22 @@ private:
         return this_fovea_->getRawYUV(linear_pos);
     }
 
+    /**
+     * For a region-relative linear position, as for getPixelRaw_, return
+     *  the Y value of the pixel, from the frame's packed Y plane if it has one
+     * @linear_pos 2d scan position from top left to bottom right
+     * @return the Y value of the pixel
+     */
+    inline
+    #ifdef REGION_TEST
+    int
+    #else
+    uint8_t
+    #endif
+    getPixelY_(int linear_pos) const {
+        return this_fovea_->getRawY(linear_pos);
+    }
+
     /**
      * For a region-relative linear position (2d scan position
      *  from top left to bottom right, return the
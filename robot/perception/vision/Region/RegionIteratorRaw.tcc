@@ -31,7 +31,7 @@ public:
     #else
     inline uint8_t
     #endif
-    getY() {return(*raw());}
+    getY() {return(getRegion_()->getPixelY_(getLinearPos_()));}
 
     #ifdef REGION_TEST
     inline int
@@ -0,0 +1,237 @@
+/**
+ * One row of a region's colour classified pixels, Density fovea pixels apart.
+ *  row[x] is the colour of region column x.
+ */
+template <int Density>
+class row_fovea {
+public:
+    row_fovea(const Colour* first, int cols) : first_(first), cols_(cols) {}
+
+    inline Colour operator[](int x) const { return first_[x * Density]; }
+
+    /**
+     * Get the number of columns in the row
+     * @return the number of columns in the row
+     */
+    inline int size() const { return cols_; }
+
+private:
+    const Colour* first_;
+    int cols_;
+};
+
+/**
+ * One row of a region's raw Y values, Density raw pixels apart.
+ *  row[x] is the Y value of region column x.
+ */
+template <int Density>
+class row_y {
+public:
+    row_y(const uint8_t* first, int cols) : first_(first), cols_(cols) {}
+
+    inline uint8_t operator[](int x) const { return first_[x * Density]; }
+
+    /**
+     * Get the number of columns in the row
+     * @return the number of columns in the row
+     */
+    inline int size() const { return cols_; }
+
+private:
+    const uint8_t* first_;
+    int cols_;
+};
+
+/**
+ * A view of a region's colour classified pixels as rows of its fovea, for a
+ *  region Density fovea pixels apart, that is getDensity() is Density times
+ *  getFoveaDensity(). As Density is known at compile time, loops over a row
+ *  are plain strided loads the compiler can unroll and vectorise.
+ */
+template <int Density>
+class view_fovea {
+public:
+    typedef row_fovea<Density> row_type;
+
+    view_fovea(const Colour* first, int fovea_width, int cols, int rows)
+        : first_(first), stride_(fovea_width * Density), cols_(cols),
+          rows_(rows) {}
+
+    inline int getCols() const { return cols_; }
+    inline int getRows() const { return rows_; }
+
+    /**
+     * Get a row of the view
+     * @y row in the region-space
+     * @return the row
+     */
+    inline row_type row(int y) const {
+        return row_type(first_ + y * stride_, cols_);
+    }
+
+    /**
+     * Calls function(y, row(y)) for each row, top to bottom.
+     */
+    template <class Function>
+    inline void for_each_row(Function& function) const {
+        for (int y = 0; y < rows_; ++y) {
+            function(y, row(y));
+        }
+    }
+
+private:
+    const Colour* first_;
+    int stride_;
+    int cols_;
+    int rows_;
+};
+
+/**
+ * A view of a region's raw Y values as rows of its camera's packed Y plane,
+ *  for a region Density raw pixels apart in the top or bottom camera. Both the
+ *  density and the row stride are known at compile time.
+ */
+template <int Density, bool Top>
+class view_y {
+public:
+    typedef row_y<Density> row_type;
+
+    static const int STRIDE = (Top ? TOP_IMAGE_COLS : BOT_IMAGE_COLS) * Density;
+
+    view_y(const uint8_t* first, int cols, int rows)
+        : first_(first), cols_(cols), rows_(rows) {}
+
+    inline int getCols() const { return cols_; }
+    inline int getRows() const { return rows_; }
+
+    /**
+     * Get a row of the view
+     * @y row in the region-space
+     * @return the row
+     */
+    inline row_type row(int y) const {
+        return row_type(first_ + y * STRIDE, cols_);
+    }
+
+    /**
+     * Calls function(y, row(y)) for each row, top to bottom.
+     */
+    template <class Function>
+    inline void for_each_row(Function& function) const {
+        for (int y = 0; y < rows_; ++y) {
+            function(y, row(y));
+        }
+    }
+
+private:
+    const uint8_t* first_;
+    int cols_;
+    int rows_;
+};
+
+/**
+ * Returns true if this region can be viewed with view_fovea<Density>
+ */
+template <int Density>
+inline bool has_view_fovea() const {
+    return density_to_raw_ == Density * raw_to_fovea_density_;
+}
+
+/**
+ * Returns a view of this region's colour classified pixels. Check
+ *  has_view_fovea<Density>() first.
+ */
+template <int Density>
+inline view_fovea<Density> get_view_fovea() const {
+    return view_fovea<Density>(
+        this_fovea_->getInternalColour() + getLinearPosFromXYFovea_(0, 0),
+        this_fovea_->getBBox().width(), getCols(), getRows());
+}
+
+/**
+ * Returns true if this region can be viewed with view_y<Density, Top>,
+ *  which needs the frame's packed Y plane
+ */
+template <int Density, bool Top>
+inline bool has_view_y() const {
+    return density_to_raw_ == Density && is_top_camera_ == Top &&
+           this_fovea_->getRawYPlane() != NULL;
+}
+
+/**
+ * Returns a view of this region's raw Y values. Check
+ *  has_view_y<Density, Top>() first.
+ */
+template <int Density, bool Top>
+inline view_y<Density, Top> get_view_y() const {
+    return view_y<Density, Top>(
+        this_fovea_->getRawYPlane() + (getLinearPosFromXYRaw_(0, 0) >> 1),
+        getCols(), getRows());
+}
+
+/**
+ * Calls function(y, row) for each row of this region's colour classified
+ *  pixels, top to bottom, where row is a row_fovea<Density> for this region's
+ *  density. function's operator() should be a template on the row type, so
+ *  it is compiled for each density. Densities without a view go through
+ *  iterator_fovea and a row_fovea<1> of a copy of each row.
+ */
+template <class Function>
+void for_each_row_fovea(Function& function) const {
+    if (has_view_fovea<1>()) {
+        get_view_fovea<1>().for_each_row(function);
+    } else if (has_view_fovea<2>()) {
+        get_view_fovea<2>().for_each_row(function);
+    } else if (has_view_fovea<4>()) {
+        get_view_fovea<4>().for_each_row(function);
+    } else {
+        const int rows = getRows();
+        const int cols = getCols();
+        std::vector<Colour> row(cols);
+        iterator_fovea it = begin_fovea();
+        for (int y = 0; y < rows; ++y) {
+            for (int x = 0; x < cols; ++x, ++it) {
+                row[x] = it.colour();
+            }
+            function(y, row_fovea<1>(row.data(), cols));
+        }
+    }
+}
+
+/**
+ * Calls function(y, row) for each row of this region's raw Y values, top to
+ *  bottom, where row is a row_y<Density> for this region's density, as
+ *  for_each_row_fovea. Without the packed Y plane, or at other densities,
+ *  rows go through iterator_raw and a row_y<1> of a copy of each row.
+ */
+template <class Function>
+void for_each_row_y(Function& function) const {
+    if (has_view_y<1, true>()) {
+        get_view_y<1, true>().for_each_row(function);
+    } else if (has_view_y<1, false>()) {
+        get_view_y<1, false>().for_each_row(function);
+    } else if (has_view_y<2, true>()) {
+        get_view_y<2, true>().for_each_row(function);
+    } else if (has_view_y<2, false>()) {
+        get_view_y<2, false>().for_each_row(function);
+    } else if (has_view_y<4, true>()) {
+        get_view_y<4, true>().for_each_row(function);
+    } else if (has_view_y<4, false>()) {
+        get_view_y<4, false>().for_each_row(function);
+    } else if (has_view_y<8, true>()) {
+        get_view_y<8, true>().for_each_row(function);
+    } else if (has_view_y<8, false>()) {
+        get_view_y<8, false>().for_each_row(function);
+    } else {
+        const int rows = getRows();
+        const int cols = getCols();
+        std::vector<uint8_t> row(cols);
+        iterator_raw it = begin_raw();
+        for (int y = 0; y < rows; ++y) {
+            for (int x = 0; x < cols; ++x, ++it) {
+                row[x] = it.getY();
+            }
+            function(y, row_y<1>(row.data(), cols));
+        }
+    }
+}
@@ -1,4 +1,6 @@
 #include <list>
+#include <sstream>
+#include <boost/bind.hpp>
 
 #include "perception/vision/Vision.hpp"
 #include "perception/vision/detector/RegionFieldFeatureDetector.hpp"
@@ -7,6 +9,7 @@
 #include "types/CombinedFrame.hpp"
 #include "utils/Logger.hpp"
 #include "perception/vision/Fovea.hpp"
+#include "perception/vision/other/AdaptiveThreshold.hpp"
 #include "perception/vision/regionfinder/ColourROI.hpp"
 #include "perception/vision/detector/BallDetector.hpp"
 #include "perception/vision/detector/RobotDetector_fwd_decl.hpp"
@@ -41,26 +44,148 @@ void Vision::setupAlgorithms_() {
 #endif
     addDetector_(DETECTOR_FIELD_LINE, new RegionFieldFeatureDetector());
     addDetector_(DETECTOR_BALL, new BallDetector());
+
+    // Stages in sequential order. Each waits only for earlier stages whose
+    // data it conflicts with.
+    MiddleInfoProcessor* boundary = getMiddleInfoProcessor_(MID_PROCESSOR_FIELD_BOUNDARY);
+    MiddleInfoProcessor* colour_roi = getMiddleInfoProcessor_(MID_PROCESSOR_COLOUR_ROI);
+    Detector* robot = getDetector_(DETECTOR_ROBOT);
+    Detector* field_line = getDetector_(DETECTOR_FIELD_LINE);
+    Detector* ball = getDetector_(DETECTOR_BALL);
+
+    addStage_("FieldBoundary", boost::bind(&Vision::runFieldBoundary_, this),
+              boundary->reads(), boundary->writes(), &regionFinderTime);
+    addStage_("ColourROI", boost::bind(&Vision::runColourROI_, this),
+              colour_roi->reads(), colour_roi->writes(), &regionFinderTime);
+    addStage_("Robot", boost::bind(&Vision::runDetector_, this, DETECTOR_ROBOT),
+              robot->reads(), robot->writes(), &robotDetectorTime);
+    addStage_("FieldFeature", boost::bind(&Vision::runDetector_, this, DETECTOR_FIELD_LINE),
+              field_line->reads(), field_line->writes(), &fieldFeaturesTime);
+    addStage_("Ball", boost::bind(&Vision::runDetector_, this, DETECTOR_BALL),
+              ball->reads(), ball->writes(), &ballDetectorTime);
 }
 
 void Vision::runAlgorithms_() {
     Timer t;
     t.restart();
-    runMiddleInfoProcessor_(MID_PROCESSOR_FIELD_BOUNDARY);
-    runMiddleInfoProcessor_(MID_PROCESSOR_COLOUR_ROI);
-    regionFinderTime += t.elapsed_us();
-    t.restart();
-    runDetector_(DETECTOR_ROBOT);
-    robotDetectorTime += t.elapsed_us();
-    t.restart();
-    runDetector_(DETECTOR_FIELD_LINE);
-    fieldFeaturesTime += t.elapsed_us();
-    t.restart();
-    runDetector_(DETECTOR_BALL);
-    ballDetectorTime += t.elapsed_us();
+    stages_.run(stage_pool_);
+    algorithmsTime += t.elapsed_us();
 }
 //////////////////////////////////////////
 
+void Vision::addStage_(const std::string& name, const TaskGraph::Task& stage,
+                       uint32_t reads, uint32_t writes, int* time) {
+    frame_times_.push_back(std::make_pair(name, 0));
+    int index = stages_.add(name,
+        TaskGraph::Task(boost::bind(&Vision::timeStage_, this, stage, time,
+                                    (int)frame_times_.size() - 1)),
+        reads, writes);
+
+    std::stringstream after;
+    const std::vector<int>& dependencies = stages_.dependencies(index);
+    for (size_t i = 0; i < dependencies.size(); ++i) {
+        after << " " << stages_.name(dependencies[i]);
+    }
+    llog(INFO) << "Vision stage " << name << " runs after:" <<
+                  (dependencies.empty() ? " nothing" : after.str()) << std::endl;
+}
+
+void Vision::timeStage_(const TaskGraph::Task& stage, int* time, int slot) {
+    // Stages sharing a counter always depend on each other, so never race.
+    Timer t;
+    t.restart();
+    stage();
+    const int elapsed = t.elapsed_us();
+    *time += elapsed;
+    frame_times_[slot].second = elapsed;
+}
+
+void Vision::runFieldBoundary_() {
+    runMiddleInfoProcessor_(MID_PROCESSOR_FIELD_BOUNDARY);
+
+    // The masks are part of the start scan coordinates the stage writes.
+    const CameraToRR& camera_to_rr = info_middle_.this_frame->camera_to_rr_;
+    field_mask_top_.build(info_out_.topStartScanCoords, 0,
+        camera_to_rr.getTopEndScanCoords(), TOP_SALIENCY_DENSITY);
+    field_mask_bot_.build(info_out_.botStartScanCoords, BOT_IMAGE_ROWS,
+        camera_to_rr.getBotEndScanCoords(), BOT_SALIENCY_DENSITY);
+}
+
+void Vision::runColourROI_() {
+    if (camera_pool_) {
+        runColourROIPerCamera_();
+    } else {
+        runMiddleInfoProcessor_(MID_PROCESSOR_COLOUR_ROI);
+    }
+
+    // The ROIs are part of the stage's writes, and so is their ranking.
+    info_middle_.roi_ranking = schedule_.rank(info_middle_.roi,
+        *info_out_.cameraToRR, info_in_.ballPosRR);
+}
+
+void Vision::generateFoveae_(const CombinedFrame& this_frame) {
+    if (!camera_pool_) {
+        generateCamera_(this_frame, true);
+        generateCamera_(this_frame, false);
+        return;
+    }
+
+    // Each camera only touches its own planes, colour array and arena.
+    camera_jobs_.clear();
+    camera_jobs_.push_back(boost::bind(&Vision::generateCamera_, this,
+        boost::cref(this_frame), true));
+    camera_jobs_.push_back(boost::bind(&Vision::generateCamera_, this,
+        boost::cref(this_frame), false));
+    camera_pool_->run(camera_jobs_);
+}
+
+void Vision::generateCamera_(const CombinedFrame& this_frame, bool top) {
+    if (top) {
+        if (this_frame.top_planes_)
+            planes_top_.build(this_frame.top_frame_);
+        pyramid_top_.reset(this_frame.top_planes_);
+        combined_fovea_.top_->generate(this_frame,
+            ADAPTIVE_THRESHOLDING_WINDOW_SIZE_TOP,
+            ADAPTIVE_THRESHOLDING_WHITE_THRESHOLD_PERCENT_TOP, true);
+    } else {
+        if (this_frame.bot_planes_)
+            planes_bot_.build(this_frame.bot_frame_);
+        pyramid_bot_.reset(this_frame.bot_planes_);
+        combined_fovea_.bot_->generate(this_frame,
+            ADAPTIVE_THRESHOLDING_WINDOW_SIZE_BOT,
+            ADAPTIVE_THRESHOLDING_WHITE_THRESHOLD_PERCENT_BOT, true);
+    }
+}
+
+void Vision::runColourROIPerCamera_() {
+    ColourROI* finders[2] = {
+        static_cast<ColourROI*>(getMiddleInfoProcessor_(MID_PROCESSOR_COLOUR_ROI)),
+        colour_roi_bot_
+    };
+
+    camera_jobs_.clear();
+    for (size_t camera = 0; camera < info_middle_.full_regions.size() &&
+                                                        camera < 2; ++camera) {
+        camera_roi_[camera].clear();
+        camera_regions_[camera].clear();
+        camera_jobs_.push_back(boost::bind(&ColourROI::findInRegion,
+            finders[camera], boost::cref(info_middle_.full_regions[camera]),
+            boost::cref(info_out_), boost::ref(camera_roi_[camera]),
+            boost::ref(camera_regions_[camera]),
+            camera == 0 ? info_middle_.top_field_mask
+                        : info_middle_.bot_field_mask));
+    }
+    camera_pool_->run(camera_jobs_);
+
+    // Merge in camera order, as ColourROI::find would have.
+    for (size_t camera = 0; camera < camera_jobs_.size(); ++camera) {
+        info_middle_.roi.insert(info_middle_.roi.end(),
+            camera_roi_[camera].begin(), camera_roi_[camera].end());
+        info_out_.regions.insert(info_out_.regions.end(),
+            camera_regions_[camera].begin(), camera_regions_[camera].end());
+    }
+}
+
 void Vision::runMiddleInfoProcessor_(uint32_t index) {
     getMiddleInfoProcessor_(index)->find(info_in_, info_middle_, info_out_);
 }
@@ -72,16 +197,27 @@ void Vision::runDetector_(uint32_t index) {
 Vision::Vision()
   : bbox_top_(BBox(Point(0,0), Point(TOP_SALIENCY_COLS, TOP_SALIENCY_ROWS))),
     bbox_bot_(BBox(Point(0,0), Point(BOT_SALIENCY_COLS, BOT_SALIENCY_ROWS))),
+    planes_top_(TOP_IMAGE_COLS, TOP_IMAGE_ROWS),
+    planes_bot_(BOT_IMAGE_COLS, BOT_IMAGE_ROWS),
+    pyramid_top_(TOP_IMAGE_COLS, TOP_IMAGE_ROWS),
+    pyramid_bot_(BOT_IMAGE_COLS, BOT_IMAGE_ROWS),
+    pyramid_foveae_(false),
+    field_mask_top_(TOP_IMAGE_COLS, TOP_IMAGE_ROWS),
+    field_mask_bot_(BOT_IMAGE_COLS, BOT_IMAGE_ROWS),
     combined_fovea_(CombinedFovea(
-        new Fovea(bbox_top_, TOP_SALIENCY_DENSITY, true, true),
-        new Fovea(bbox_bot_, BOT_SALIENCY_DENSITY, false, true)
+        new Fovea(bbox_top_, TOP_SALIENCY_DENSITY, true, true, &arena_top_),
+        new Fovea(bbox_bot_, BOT_SALIENCY_DENSITY, false, true, &arena_bot_)
     )),
     full_region_top_(RegionI(bbox_top_, true, *combined_fovea_.top_, TOP_SALIENCY_DENSITY)),
     full_region_bot_(RegionI(bbox_bot_, false, *combined_fovea_.bot_, BOT_SALIENCY_DENSITY)),
+    camera_pool_(NULL), colour_roi_bot_(NULL), stage_pool_(NULL),
     frameCount(0), foveaTime(0), fieldFeaturesTime(0),
-    regionFinderTime(0), ballDetectorTime(0)
+    regionFinderTime(0), ballDetectorTime(0), robotDetectorTime(0),
+    algorithmsTime(0), roisSkipped(0), framesOverBudget(0)
 {
     llog(INFO) << "Vision Created" << std::endl;
+    llog(INFO) << "Adaptive thresholding kernel: " << AdaptiveThreshold::kernelName(
+                                 AdaptiveThreshold::getKernel()) << std::endl;
 
     detectors_ = new Detector*[DETECTOR_TOTAL];
     middle_info_processors_ = new MiddleInfoProcessor*[MID_PROCESSOR_TOTAL];
@@ -93,11 +229,15 @@ Vision::Vision()
         middle_info_processors_[i] = NULL;
     }
 
+    frame_times_.push_back(std::make_pair(std::string("Fovea"), 0));
     setupAlgorithms_();
+    frame_times_.push_back(std::make_pair(std::string("Total"), 0));
 
 }
 
 Vision::~Vision() {
+    setParallelCameras(false);
+    setParallelStages(false);
     for (size_t i = 0; i < MID_PROCESSOR_TOTAL; ++i) {
         delete middle_info_processors_[i];
     }
@@ -110,6 +250,70 @@ Vision::~Vision() {
     llog(INFO) << "Vision Destroyed" << std::endl;
 }
 
+void Vision::setParallelCameras(bool parallel) {
+    if (parallel && !camera_pool_) {
+        // One extra thread; processFrame's thread takes the other camera.
+        camera_pool_ = new WorkerPool(1, "VisionCamera");
+        colour_roi_bot_ = new ColourROI();
+    } else if (!parallel && camera_pool_) {
+        delete camera_pool_;
+        delete colour_roi_bot_;
+        camera_pool_ = NULL;
+        colour_roi_bot_ = NULL;
+    }
+    llog(INFO) << "Vision parallel cameras: " << (parallel ? "on" : "off")
+               << std::endl;
+}
+
+void Vision::setParallelStages(bool parallel) {
+    if (parallel && !stage_pool_) {
+        // The widest point of the graph is the robot detector alongside the
+        // field boundary, ROI and field feature chain.
+        stage_pool_ = new WorkerPool(1, "VisionStage");
+    } else if (!parallel && stage_pool_) {
+        delete stage_pool_;
+        stage_pool_ = NULL;
+    }
+    llog(INFO) << "Vision parallel stages: " << (parallel ? "on" : "off")
+               << std::endl;
+}
+
+void Vision::setBallThreads(int threads) {
+    static_cast<BallDetector*>(getDetector_(DETECTOR_BALL))->setThreads(threads);
+}
+
+void Vision::setBallTracking(int interval) {
+    static_cast<BallDetector*>(getDetector_(DETECTOR_BALL))->setTracking(interval);
+}
+
+void Vision::setRoiBudget(int budget_us) {
+    schedule_.setBudget(budget_us);
+    llog(INFO) << "Vision ROI budget: " << budget_us << " us" << std::endl;
+}
+
+void Vision::setBoundaryWindow(int rows) {
+    static_cast<FieldBoundaryFinder*>(getMiddleInfoProcessor_(
+        MID_PROCESSOR_FIELD_BOUNDARY))->setSearchWindow(rows);
+}
+
+void Vision::setPyramidFoveae(bool pyramid) {
+    pyramid_foveae_ = pyramid;
+    llog(INFO) << "Vision pyramid foveae: " << (pyramid ? "on" : "off")
+               << std::endl;
+}
+
+void Vision::setRobotEngine(const std::string& engine) {
+#ifndef CTC_2_1
+    setSSRobotDetectorEngine(getDetector_(DETECTOR_ROBOT), engine);
+#endif
+}
+
+void Vision::setRobotForest(bool model) {
+#ifdef CTC_2_1
+    setRobotDetectorForest(getDetector_(DETECTOR_ROBOT), model);
+#endif
+}
+
 void Vision::addMiddleInfoProcessor_(uint32_t index, MiddleInfoProcessor* processor) {
     middle_info_processors_[index] = processor;
 }
@@ -127,12 +331,29 @@ Detector* Vision::getDetector_(uint32_t index) {
 }
 
 
-VisionInfoOut Vision::processFrame(const CombinedFrame& this_frame, const VisionInfoIn& info_in) {
+VisionInfoOut Vision::processFrame(const CombinedFrame& camera_frame, const VisionInfoIn& info_in) {
 
+    // The frame as vision sees it, with the packed planes generateFoveae_
+    // builds, and the pyramids over them if foveae are to read them.
+    CombinedFrame this_frame(camera_frame);
+    this_frame.top_planes_ = this_frame.top_frame_ ? &planes_top_ : NULL;
+    this_frame.bot_planes_ = this_frame.bot_frame_ ? &planes_bot_ : NULL;
+    this_frame.top_pyramid_ = pyramid_foveae_ ? &pyramid_top_ : NULL;
+    this_frame.bot_pyramid_ = pyramid_foveae_ ? &pyramid_bot_ : NULL;
 
     Timer t;
+    Timer total;
     uint32_t time;
 
+    // Stages that do not run this frame took no time.
+    for (size_t i = 0; i < frame_times_.size(); ++i) {
+        frame_times_[i].second = 0;
+    }
+
+    // The budget runs from here, and last frame's balls are favoured.
+    schedule_.remember(info_out_.balls);
+    schedule_.start();
+
     VisionInfoMiddle info_middle;
     VisionInfoOut info_out;
 
@@ -149,15 +370,17 @@ VisionInfoOut Vision::processFrame(const CombinedFrame& this_frame, const Vision
      * Primary Region Creation
      */
     t.restart();
-    combined_fovea_.generate(this_frame,
-                             ADAPTIVE_THRESHOLDING_WINDOW_SIZE_TOP,
-                             ADAPTIVE_THRESHOLDING_WHITE_THRESHOLD_PERCENT_TOP,
-                             ADAPTIVE_THRESHOLDING_WINDOW_SIZE_BOT,
-                             ADAPTIVE_THRESHOLDING_WHITE_THRESHOLD_PERCENT_BOT);
+
+    // Release last frame's child foveae and scratch memory.
+    arena_top_.reset();
+    arena_bot_.reset();
+
+    generateFoveae_(this_frame);
 
     time = t.elapsed_us();
     llog(VERBOSE) << "Fovea generation took " << time << " us" << std::endl;
     foveaTime += time;
+    frame_times_.front().second = time;
     t.restart();
 
     // TODO: Do not copy these, re-generate these? Probably trivial improvement - for later
@@ -170,6 +393,11 @@ VisionInfoOut Vision::processFrame(const CombinedFrame& this_frame, const Vision
     info_middle_.full_regions.push_back(full_region_top_);
     info_middle_.full_regions.push_back(full_region_bot_);
     info_middle_.this_frame = &this_frame;
+    info_middle_.top_pyramid = &pyramid_top_;
+    info_middle_.bot_pyramid = &pyramid_bot_;
+    info_middle_.top_field_mask = &field_mask_top_;
+    info_middle_.bot_field_mask = &field_mask_bot_;
+    info_middle_.schedule = &schedule_;
     if (offNao) {
 
     }
@@ -177,6 +405,16 @@ VisionInfoOut Vision::processFrame(const CombinedFrame& this_frame, const Vision
         runAlgorithms_();
     }
 
+    const int skipped = schedule_.skipped();
+    if (skipped > 0) {
+        llog(VERBOSE) << "Vision skipped ROIs: " << schedule_.skips() << std::endl;
+    }
+    roisSkipped += skipped;
+    if (schedule_.getBudget() > 0 && schedule_.elapsed() > schedule_.getBudget()) {
+        ++framesOverBudget;
+    }
+    frame_times_.back().second = total.elapsed_us();
+
     // Log the 1000 frame average vision timings.
     if(frameCount == 1000)
     {
@@ -195,9 +433,25 @@ VisionInfoOut Vision::processFrame(const CombinedFrame& this_frame, const Vision
                                  ((float)regionFinderTime)/1000.0f << std::endl;
         llog(INFO) << "Average ball detector time: " <<
                                ((float)ballDetectorTime) / 1000.0f << std::endl;
+        llog(INFO) << "Average algorithms wall time: " <<
+                                   ((float)algorithmsTime)/1000.0f << std::endl;
         llog(INFO) << "Average total processFrame time: " << ((float)(DCCTime+
             foveaTime+fieldFeaturesTime+regionFinderTime+ballDetectorTime + robotDetectorTime)) /
                                                            1000.0f << std::endl;
+        llog(INFO) << "Frame arena high water (bytes): top " <<
+                        arena_top_.highWater() << "/" << arena_top_.capacity() <<
+                        ", bot " << arena_bot_.highWater() << "/" <<
+                        arena_bot_.capacity() << std::endl;
+        arena_top_.resetHighWater();
+        arena_bot_.resetHighWater();
+        llog(INFO) << "Image to ground projection error (mm): " <<
+                this_frame.camera_to_rr_.pose.projectionError() << std::endl;
+        if (schedule_.getBudget() > 0) {
+            llog(INFO) << "Average ROIs skipped: " <<
+                                    ((float)roisSkipped)/1000.0f << std::endl;
+            llog(INFO) << "Frames over the " << schedule_.getBudget() <<
+                          " us budget: " << framesOverBudget << std::endl;
+        }
 
         // Reset timers.
         DCCTime = 0;
@@ -206,6 +460,9 @@ VisionInfoOut Vision::processFrame(const CombinedFrame& this_frame, const Vision
         fieldFeaturesTime = 0;
         regionFinderTime = 0;
         ballDetectorTime = 0;
+        algorithmsTime = 0;
+        roisSkipped = 0;
+        framesOverBudget = 0;
     }
 
     return info_out_;
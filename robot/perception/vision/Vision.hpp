@@ -2,6 +2,9 @@
 #define PERCEPTION_VISION_VISION_H_
 
 #include <list>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "perception/vision/VisionDefinitions.hpp"
 #include "perception/vision/detector/DetectorInterface.hpp"
@@ -13,8 +16,17 @@
 #include "types/VisionInfoOut.hpp"
 #include "types/CombinedFovea.hpp"
 #include "types/CombinedFrame.hpp"
+#include "perception/vision/other/FieldMask.hpp"
+#include "perception/vision/other/FrameArena.hpp"
+#include "perception/vision/other/ImagePlanes.hpp"
+#include "perception/vision/other/ImagePyramid.hpp"
+#include "perception/vision/other/RoiSchedule.hpp"
+#include "thread/TaskGraph.hpp"
+#include "thread/WorkerPool.hpp"
 #include "utils/Timer.hpp"
 
+class ColourROI;
+
 class Vision {
 
 public:
@@ -35,6 +47,74 @@ public:
      */
     VisionInfoOut processFrame(const CombinedFrame& pixel_data, const VisionInfoIn& info_in);
 
+    /**
+     * Whether to process the top and bottom cameras on separate threads where
+     * the work is independent: fovea generation and colour ROI finding. The
+     * results are merged in the same order as the sequential path.
+     */
+    void setParallelCameras(bool parallel);
+
+    /**
+     * Whether to run finders and detectors that use disjoint data, as given
+     * by their reads() and writes(), on separate threads. Dependent stages
+     * still run in the order set up in setupAlgorithms_.
+     */
+    void setParallelStages(bool parallel);
+
+    /**
+     * How the robot detector runs its network: "tinydnn", "float", "int8"
+     * or "reference". See SSRobotDetector::setEngine.
+     */
+    void setRobotEngine(const std::string& engine);
+
+    /**
+     * Whether the V5 robot detector classifies with the forest model file
+     * rather than its generated forest. See RobotDetector::setForestModel.
+     */
+    void setRobotForest(bool model);
+
+    /**
+     * How many threads the ball detector searches ROIs on besides its own.
+     * See BallDetector::setThreads.
+     */
+    void setBallThreads(int threads);
+
+    /**
+     * How many frames the ball detector may follow a ball between full
+     * sweeps of the ROIs, or 0 to always sweep. See
+     * BallDetector::setTracking.
+     */
+    void setBallTracking(int interval);
+
+    /**
+     * The microseconds a frame has before detectors skip their least
+     * valuable ROIs, or 0 for no limit. See RoiSchedule.
+     */
+    void setRoiBudget(int budget_us);
+
+    /**
+     * The image rows above the previous frame's field boundary the field
+     * boundary finder starts scanning at while the robot is still, or 0 to
+     * always scan from the horizon. See FieldBoundaryFinder::setSearchWindow.
+     */
+    void setBoundaryWindow(int rows);
+
+    /**
+     * Whether foveae at a pyramid density threshold the pyramid's box
+     * filtered Y plane rather than point samples of the image. Off by
+     * default, as it changes what every detector sees.
+     */
+    void setPyramidFoveae(bool pyramid);
+
+    /**
+     * The microseconds each part of the last processFrame took, by name:
+     * "Fovea", then each stage in the order setupAlgorithms_ adds them, then
+     * "Total". Stages run on other threads are timed on those threads.
+     */
+    const std::vector<std::pair<std::string, int> >& getFrameTimes() const {
+        return frame_times_;
+    }
+
     inline const RegionI& getFullRegionTop() { return full_region_top_; }
     inline const RegionI& getFullRegionBot() { return full_region_bot_; }
 
@@ -47,10 +127,20 @@ private:
     void setupAlgorithms_();
     void runAlgorithms_();
 
+    void addStage_(const std::string& name, const TaskGraph::Task& stage,
+                   uint32_t reads, uint32_t writes, int* time);
+    void timeStage_(const TaskGraph::Task& stage, int* time, int slot);
+    void runColourROI_();
+
     void addMiddleInfoProcessor_(uint32_t, MiddleInfoProcessor*);
     MiddleInfoProcessor* getMiddleInfoProcessor_(uint32_t);
     void runMiddleInfoProcessor_(uint32_t);
 
+    void generateFoveae_(const CombinedFrame& this_frame);
+    void generateCamera_(const CombinedFrame& this_frame, bool top);
+    void runColourROIPerCamera_();
+    void runFieldBoundary_();
+
     void addDetector_(uint32_t, Detector*);
     Detector* getDetector_(uint32_t);
     void runDetector_(uint32_t);
@@ -71,12 +161,49 @@ private:
     BBox bbox_top_;
     BBox bbox_bot_;
 
+    // Per frame memory for each camera's child foveae and scratch buffers.
+    // Must be declared before combined_fovea_, which uses them.
+    FrameArena arena_top_;
+    FrameArena arena_bot_;
+
+    // Each camera's image unpacked into a packed Y plane once per frame.
+    ImagePlanes planes_top_;
+    ImagePlanes planes_bot_;
+
+    // Each camera's image at the densities foveae and detectors read it at,
+    // box filtered from the planes as they are asked for.
+    ImagePyramid pyramid_top_;
+    ImagePyramid pyramid_bot_;
+    // Whether foveae read the pyramids. Detectors may read them regardless.
+    bool pyramid_foveae_;
+
+    // The part of each camera's image scans over full regions need visit,
+    // built with the field boundary.
+    FieldMask field_mask_top_;
+    FieldMask field_mask_bot_;
+
+    // Ranks the ROIs and keeps the frame's time budget.
+    RoiSchedule schedule_;
+
     CombinedFovea combined_fovea_;
 
     // Full Regions
     RegionI full_region_top_;
     RegionI full_region_bot_;
 
+    // Per camera processing. camera_pool_ is NULL unless parallel cameras are
+    // enabled, and the bottom camera then gets its own ColourROI.
+    WorkerPool* camera_pool_;
+    ColourROI* colour_roi_bot_;
+    std::vector<WorkerPool::Job> camera_jobs_;
+    std::vector<RegionI> camera_roi_[2];
+    std::vector<RegionI> camera_regions_[2];
+
+    // The finders and detectors, with dependencies from their reads() and
+    // writes(). stage_pool_ is NULL unless parallel stages are enabled.
+    TaskGraph stages_;
+    WorkerPool* stage_pool_;
+
     // Keeps track of run times for average output.
     int frameCount;
     int DCCTime;
@@ -85,6 +212,12 @@ private:
     int regionFinderTime;
     int ballDetectorTime;
     int robotDetectorTime;
+    int algorithmsTime;
+    int roisSkipped;
+    int framesOverBudget;
+
+    // The last frame's times, see getFrameTimes. Each stage has its own slot.
+    std::vector<std::pair<std::string, int> > frame_times_;
 };
 
 #endif
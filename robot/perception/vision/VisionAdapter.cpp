@@ -5,6 +5,7 @@
 #include <sys/time.h>        /* For gettimeofday */
 #include <pthread.h>
 #include <vector>
+#include <boost/thread/locks.hpp>
 
 #include "blackboard/Blackboard.hpp"
 #include "utils/Logger.hpp"
@@ -35,6 +36,7 @@ VisionAdapter::VisionAdapter(Blackboard *bb)
     );
 
     combined_frame_ = boost::shared_ptr<CombinedFrame>();
+    dropped_frames_ = 0;
 
     RegionI topRegion = vision_.getFullRegionTop();
     RegionI botRegion = vision_.getFullRegionBot();
@@ -46,8 +48,33 @@ VisionAdapter::VisionAdapter(Blackboard *bb)
     ADAPTIVE_THRESHOLDING_WHITE_THRESHOLD_PERCENT_TOP = (blackboard->config)["vision.top.adaptivethresholdingpercent"].as<int>();
     ADAPTIVE_THRESHOLDING_WHITE_THRESHOLD_PERCENT_BOT = (blackboard->config)["vision.top.adaptivethresholdingpercent"].as<int>();
 
-    writeTo(vision, topSaliency, (Colour*)foveaTop->getInternalColour());
-    writeTo(vision, botSaliency, (Colour*)foveaBot->getInternalColour());
+    vision_.setParallelCameras((blackboard->config)["vision.parallelcameras"].as<bool>());
+    vision_.setParallelStages((blackboard->config)["vision.parallelstages"].as<bool>());
+    vision_.setRobotEngine((blackboard->config)["vision.robotengine"].as<string>());
+    vision_.setRobotForest((blackboard->config)["vision.robotforest"].as<bool>());
+    vision_.setBallThreads((blackboard->config)["vision.ballthreads"].as<int>());
+    vision_.setBallTracking((blackboard->config)["vision.balltracking"].as<int>());
+    vision_.setRoiBudget((blackboard->config)["vision.roibudget"].as<int>());
+    vision_.setBoundaryWindow((blackboard->config)["vision.boundarywindow"].as<int>());
+    vision_.setPyramidFoveae((blackboard->config)["vision.pyramidfoveae"].as<bool>());
+
+    if ((blackboard->config)["vision.asynccapture"].as<bool>() &&
+            CombinedCamera::getCameraTop() && CombinedCamera::getCameraBot()) {
+        combined_camera_->startCapture();
+    }
+
+    pipelined_ = (blackboard->config)["vision.pipelined"].as<bool>();
+    fovea_top_colour_ = (Colour*)foveaTop->getInternalColour();
+    fovea_bot_colour_ = (Colour*)foveaBot->getInternalColour();
+    if (pipelined_) {
+        top_saliency_.assign(s_num_saliency_pixels_top, cBACKGROUND);
+        bot_saliency_.assign(s_num_saliency_pixels_bot, cBACKGROUND);
+        writeTo(vision, topSaliency, &top_saliency_[0]);
+        writeTo(vision, botSaliency, &bot_saliency_[0]);
+    } else {
+        writeTo(vision, topSaliency, fovea_top_colour_);
+        writeTo(vision, botSaliency, fovea_bot_colour_);
+    }
 }
 
 void VisionAdapter::tick() {
@@ -86,8 +113,24 @@ void VisionAdapter::tickCamera() {
     if (combined_camera_ == NULL) {
         llog_middle(WARNING) << "No Camera provided to the VisionAdapter" << endl;
     } else {
-         writeTo(vision, topFrame, combined_camera_->getFrameTop());
-         writeTo(vision, botFrame, combined_camera_->getFrameBottom());
+         FrameHandle top;
+         FrameHandle bot;
+         if (combined_camera_->getHandles(top, bot)) {
+             writeTo(vision, topFrameHandle, top);
+             writeTo(vision, botFrameHandle, bot);
+             writeTo(vision, topFrame, top.get());
+             writeTo(vision, botFrame, bot.get());
+         } else {
+             // Vision goes again on the last frames rather than wait.
+             llog(WARNING) << "No new camera frames" << endl;
+         }
+
+         unsigned int dropped = combined_camera_->droppedFrames();
+         if (dropped != dropped_frames_) {
+             llog(VERBOSE) << "Capture has dropped " << dropped
+                           << " frames" << endl;
+             dropped_frames_ = dropped;
+         }
 
          // Write the camera settings to the Blackboard
          // for syncing with OffNao's camera tab
@@ -98,6 +141,12 @@ void VisionAdapter::tickCamera() {
 }
 
 void VisionAdapter::tickProcess() {
+    VisionResult result;
+    process(result);
+    publish(result);
+}
+
+void VisionAdapter::process(VisionResult &result) {
     Timer t;
     VisionInfoIn info_in;
 
@@ -115,6 +164,8 @@ void VisionAdapter::tickProcess() {
     info_in.cameraToRR = conv_rr_;
     info_in.pose = conv_rr_.pose;
     info_in.robotPose = readFrom(stateEstimation, robotPos);
+    info_in.odometry = readFrom(motion, odometry);
+    info_in.ballPosRR = readFrom(stateEstimation, ballPosRR);
 
     // Set latestAngleX.
     info_in.latestAngleX =
@@ -124,9 +175,11 @@ void VisionAdapter::tickProcess() {
     conv_rr_.findEndScanValues();
 
     /*
-     * Acquire blackboard lock
+     * Acquire blackboard lock, released by the guard should anything below
+     * throw, as the pipelined vision thread carries on after exceptions
      */
-    acquireLock(serialization);
+    boost::unique_lock<boost::mutex> serialization_lock(
+        *blackboard->locks.serialization);
     llog_middle(VERBOSE) << "Vision tickProcess acquireLock(serialization) took " << t.elapsed_us()
       << " us" << endl;
     t.restart();
@@ -141,12 +194,30 @@ void VisionAdapter::tickProcess() {
     info_in.bot_camera_settings = readFrom(vision, botCameraSettings);
 
     boost::shared_ptr<CombinedFrame> combined_frame_;
-    combined_frame_ = boost::shared_ptr<CombinedFrame>(new CombinedFrame(
-        readFrom(vision, topFrame),
-        readFrom(vision, botFrame),
-        conv_rr_,
-        combined_frame_
-    ));
+    // The handles keep the images from being reused by the camera until
+    // processFrame is done with them, even if capture has moved on.
+    FrameHandle topHandle = readFrom(vision, topFrameHandle);
+    FrameHandle botHandle = readFrom(vision, botFrameHandle);
+    if (topHandle && botHandle) {
+        combined_frame_ = boost::shared_ptr<CombinedFrame>(new CombinedFrame(
+            topHandle,
+            botHandle,
+            conv_rr_,
+            combined_frame_
+        ));
+    } else {
+        combined_frame_ = boost::shared_ptr<CombinedFrame>(new CombinedFrame(
+            readFrom(vision, topFrame),
+            readFrom(vision, botFrame),
+            conv_rr_,
+            combined_frame_
+        ));
+    }
+
+    // Nothing processFrame uses is read from the blackboard after this, and
+    // the handles keep the images alive, so publish() and state estimation
+    // need not wait for the whole frame.
+    serialization_lock.unlock();
 
     llog_middle(VERBOSE) << "Vision reading images from blackboard took " << t.elapsed_us()
       << " us" << endl;
@@ -156,25 +227,41 @@ void VisionAdapter::tickProcess() {
     /*
      * Running Process Frame
      */
-    llog(VERBOSE) << "Vision reading remaining data from blackboard took " << t.elapsed_us() << " us" << endl;
-    t.restart();
-
     pthread_yield();
     usleep(1); // force sleep incase yield sucks
 
-    VisionInfoOut info_out = vision_.processFrame(*(combined_frame_.get()), info_in);
+    result.timestamp = vision_timestamp;
+    result.info_out = vision_.processFrame(*(combined_frame_.get()), info_in);
+    // Points into the frame, which does not outlive this call.
+    result.info_out.cameraToRR = NULL;
+    if (pipelined_) {
+        // Into storage that circulates through the pipeline, so this only
+        // allocates until the pipeline has warmed up.
+        // Not sized from top/bot_saliency_, which publish() swaps on the
+        // perception thread.
+        result.top_saliency.assign(fovea_top_colour_,
+                                   fovea_top_colour_ + s_num_saliency_pixels_top);
+        result.bot_saliency.assign(fovea_bot_colour_,
+                                   fovea_bot_colour_ + s_num_saliency_pixels_bot);
+    }
 
     llog(VERBOSE) << "Vision processFrame() took " << t.elapsed_us() << " us" << endl;
-    t.restart();
+}
+
+void VisionAdapter::publish(VisionResult &result) {
+    Timer t;
+    const VisionInfoOut &info_out = result.info_out;
 
     /*
      * Writing Results back to blackboard
      */
+    boost::unique_lock<boost::mutex> serialization_lock(
+        *blackboard->locks.serialization);
 
     // NOTE: You can add things back to the blackboard by going
     // NOTE: writeTo(vision, [blackboard var name], info_out.[info_in var name])
 
-    writeTo (vision, timestamp,       vision_timestamp        );
+    writeTo (vision, timestamp,       result.timestamp        );
     // Note that these regions will not be able to access their underlying pixel
     // data.
     writeTo (vision, regions,         info_out.regions        );
@@ -182,7 +269,14 @@ void VisionAdapter::tickProcess() {
     writeTo (vision, robots,          info_out.robots         );
     writeTo (vision, fieldFeatures,   info_out.features       );
     writeTo (vision, fieldBoundaries, info_out.boundaries     );
+    if (pipelined_ && result.top_saliency.size() == s_num_saliency_pixels_top &&
+            result.bot_saliency.size() == s_num_saliency_pixels_bot) {
+        top_saliency_.swap(result.top_saliency);
+        bot_saliency_.swap(result.bot_saliency);
+        writeTo(vision, topSaliency, &top_saliency_[0]);
+        writeTo(vision, botSaliency, &bot_saliency_[0]);
+    }
 
-    releaseLock(serialization);
+    serialization_lock.unlock();
     llog(VERBOSE) << "Vision writing back to blackboard took " << t.elapsed_us() << " us" << endl;
 }
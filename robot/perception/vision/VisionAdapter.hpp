@@ -5,10 +5,27 @@
 #include "perception/vision/camera/CameraToRR.hpp"
 #include "perception/vision/Vision.hpp"
 
+#include <vector>
+
 #include "utils/Timer.hpp"
 #include "blackboard/Adapter.hpp"
 #include "blackboard/Blackboard.hpp"
 
+/**
+ * One processed frame, as written to the blackboard by VisionAdapter::publish.
+ */
+struct VisionResult {
+    // When vision started on the frame, in us since the epoch. Published as
+    // vision.timestamp, and used to measure latency through perception.
+    int64_t timestamp;
+    VisionInfoOut info_out;
+    // When pipelined, the frame's colour classified saliency, copied out of
+    // Vision before it moves on to the next frame and published as
+    // vision.top/botSaliency. Empty otherwise.
+    std::vector<Colour> top_saliency;
+    std::vector<Colour> bot_saliency;
+};
+
 class VisionAdapter : Adapter {
 friend class AppAdaptor;
 public:
@@ -31,14 +48,34 @@ public:
     void tickCamera();
     /* Method for processing what is on the blackboard and writing resuts */
     void tickProcess();
+    /* Process the frame on the blackboard without publishing the results */
+    void process(VisionResult &result);
+    /* Write a processed frame's results to the blackboard. When pipelined,
+     * result is left holding the last frame's saliency buffers */
+    void publish(VisionResult &result);
 
     // TODO: Temporary fix please resolve
 	CombinedCamera *combined_camera_;
 private:
 
     boost::shared_ptr<CombinedFrame> combined_frame_;
+    // As last logged, from combined_camera_->droppedFrames().
+    unsigned int dropped_frames_;
     CameraToRR conv_rr_;
     Vision vision_;
+    // Vision's saliency, overwritten by every frame it processes. Published
+    // as it is unless pipelined, when process() may be on the next frame
+    // before publish() is done with the last.
+    bool pipelined_;
+    Colour *fovea_top_colour_;
+    Colour *fovea_bot_colour_;
+    // When pipelined, the published saliency vision.top/botSaliency point
+    // to, swapped with each published result's under the serialization lock.
+    std::vector<Colour> top_saliency_;
+    std::vector<Colour> bot_saliency_;
+    // The size of the saliency, which is fixed.
+    static const size_t s_num_saliency_pixels_top = sizeof(TopSaliency) / sizeof(Colour);
+    static const size_t s_num_saliency_pixels_bot = sizeof(BotSaliency) / sizeof(Colour);
 };
 
 #endif
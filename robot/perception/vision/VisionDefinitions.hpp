@@ -31,6 +31,27 @@ enum feature_type
    fNUM_FEATURES
 };
 
+/**
+ * The parts of VisionInfoMiddle and VisionInfoOut a vision stage can read or
+ * write, as bit flags. Vision uses these to work out which detectors may run
+ * at the same time.
+ */
+enum VisionData
+{
+   vdFULL_REGIONS       = 1 << 0,  // info_middle.full_regions
+   vdROI                = 1 << 1,  // info_middle.roi
+   vdFIELD_FEATURE_DATA = 1 << 2,  // info_middle line/intersection/circle data
+   vdBASE_POINTS        = 1 << 3,  // info_middle.basePoints(ImageCoords)
+   vdSTART_SCAN_COORDS  = 1 << 4,  // info_out.top/botStartScanCoords
+   vdBOUNDARIES         = 1 << 5,  // info_out.boundaries
+   vdREGIONS            = 1 << 6,  // info_out.regions
+   vdBALLS              = 1 << 7,  // info_out.balls
+   vdFEATURES           = 1 << 8,  // info_out.features
+   vdROBOTS             = 1 << 9,  // info_out.robots
+   vdCHILD_FOVEAE       = 1 << 10, // creating child foveae, e.g. zoomIn
+   vdALL                = (1 << 11) - 1
+};
+
 enum write_image_format
 {
     RAW_FORMAT = 0,
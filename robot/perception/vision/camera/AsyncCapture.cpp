@@ -0,0 +1,152 @@
+#include "perception/vision/camera/AsyncCapture.hpp"
+
+#include <sys/time.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <stdexcept>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "thread/Thread.hpp"
+#include "thread/ThreadManager.hpp"
+#include "utils/Logger.hpp"
+
+using namespace std;
+
+AsyncCapture::AsyncCapture(Camera *top, Camera *bot)
+   : numDropped(0), stopping(false) {
+   streams[0].camera = top;
+   streams[1].camera = bot;
+   for (int s = 0; s < 2; ++s) {
+      streams[s].returned = 0;
+      for (int i = 0; i < CAPTURE_HISTORY; ++i) {
+         streams[s].frames[i].timestamp = 0;
+         streams[s].frames[i].used = true;
+      }
+   }
+   streams[0].thread = new boost::thread(
+      boost::bind(&AsyncCapture::capture, this, &streams[0], "TopCapture"));
+   streams[1].thread = new boost::thread(
+      boost::bind(&AsyncCapture::capture, this, &streams[1], "BotCapture"));
+}
+
+AsyncCapture::~AsyncCapture() {
+   stopping.store(true);
+   for (int s = 0; s < 2; ++s) {
+      streams[s].thread->join();
+      delete streams[s].thread;
+   }
+}
+
+void AsyncCapture::capture(Stream *stream, const char *name) {
+   Thread::name = name;
+   llog(INFO) << "Capture thread started" << endl;
+   while (!stopping.load() && !attemptingShutdown) {
+      struct timeval timestamp;
+      FrameHandle image;
+      try {
+         // Blocks for up to a frame, or returns empty if the driver was slow.
+         image = stream->camera->getHandle(V4L2_PIX_FMT_YUYV, &timestamp);
+      } catch (const std::exception &e) {
+         llog(ERROR) << "Capture thread caught exception: " << e.what() << endl;
+         usleep(10000);
+         continue;
+      }
+      if (!image) {
+         continue;
+      }
+
+      {
+         boost::mutex::scoped_lock lock(mutex);
+         Frame &oldest = stream->frames[CAPTURE_HISTORY - 1];
+         if (oldest.image && !oldest.used) {
+            ++numDropped;
+            llog(DEBUG1) << "Dropped " << numDropped << " frames" << endl;
+         }
+         for (int i = CAPTURE_HISTORY - 1; i > 0; --i) {
+            stream->frames[i] = stream->frames[i - 1];
+         }
+         stream->frames[0].image = image;
+         stream->frames[0].timestamp =
+            (int64_t)timestamp.tv_sec * 1000000 + timestamp.tv_usec;
+         stream->frames[0].used = false;
+      }
+      captured.notify_all();
+   }
+   llog(INFO) << "Capture thread stopped" << endl;
+}
+
+bool AsyncCapture::pick(Frame *&top, Frame *&bot) {
+   // Of the pairs with something new in them, take the one captured
+   // closest together, preferring newer frames on a tie. Pairing a frame
+   // with one older than the other camera's previous is never closer, so
+   // only pairs including a newest frame are considered.
+   top = NULL;
+   bot = NULL;
+   int64_t bestSkew = 0;
+   for (int t = 0; t < CAPTURE_HISTORY; ++t) {
+      for (int b = 0; b < CAPTURE_HISTORY; ++b) {
+         if (t != 0 && b != 0) {
+            continue;
+         }
+         Frame *topFrame = &streams[0].frames[t];
+         Frame *botFrame = &streams[1].frames[b];
+         // Never go back past a frame already returned.
+         if (!topFrame->image || !botFrame->image ||
+             (topFrame->used && botFrame->used) ||
+             topFrame->timestamp < streams[0].returned ||
+             botFrame->timestamp < streams[1].returned) {
+            continue;
+         }
+         int64_t skew = llabs(topFrame->timestamp - botFrame->timestamp);
+         if (top == NULL || skew < bestSkew) {
+            top = topFrame;
+            bot = botFrame;
+            bestSkew = skew;
+         }
+      }
+   }
+   return top != NULL;
+}
+
+bool AsyncCapture::latest(FrameHandle &top, FrameHandle &bot, int timeoutUs) {
+   boost::mutex::scoped_lock lock(mutex);
+   boost::system_time deadline = boost::get_system_time() +
+      boost::posix_time::microseconds(timeoutUs);
+   Frame *bestTop;
+   Frame *bestBot;
+   while (!pick(bestTop, bestBot)) {
+      if (!captured.timed_wait(lock, deadline) && !pick(bestTop, bestBot)) {
+         return false;
+      }
+   }
+
+   // Anything older than what's returned never will be, so is dropped.
+   for (Frame *f = bestTop + 1; f < streams[0].frames + CAPTURE_HISTORY; ++f) {
+      if (f->image && !f->used) {
+         ++numDropped;
+         f->used = true;
+      }
+   }
+   for (Frame *f = bestBot + 1; f < streams[1].frames + CAPTURE_HISTORY; ++f) {
+      if (f->image && !f->used) {
+         ++numDropped;
+         f->used = true;
+      }
+   }
+   bestTop->used = true;
+   bestBot->used = true;
+   streams[0].returned = bestTop->timestamp;
+   streams[1].returned = bestBot->timestamp;
+   top = bestTop->image;
+   bot = bestBot->image;
+   llog(DEBUG2) << "Camera frames "
+                << llabs(bestTop->timestamp - bestBot->timestamp)
+                << " us apart" << endl;
+   return true;
+}
+
+unsigned int AsyncCapture::dropped() const {
+   boost::mutex::scoped_lock lock(mutex);
+   return numDropped;
+}
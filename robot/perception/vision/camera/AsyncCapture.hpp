@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+#ifndef Q_MOC_RUN
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#endif
+
+#include "perception/vision/camera/Camera.hpp"
+#include "types/FrameHandle.hpp"
+
+/**
+ * Captures from the top and bottom cameras on a thread each, so that
+ * waiting on the driver happens off the perception thread.
+ *
+ * Each thread dequeues frames as fast as the camera delivers them and keeps
+ * the last CAPTURE_HISTORY of them with their driver timestamps. Perception
+ * asks for the newest pair, which is matched by timestamp; a frame pushed
+ * out of the history without ever being handed to perception is counted
+ * as dropped.
+ *
+ * Every frame in the history holds its camera buffer, so the cameras need
+ * at least CAPTURE_HISTORY buffers more than perception holds at once.
+ */
+class AsyncCapture {
+   public:
+      /**
+       * Starts capturing. The cameras must be streaming and must outlive
+       * this.
+       */
+      AsyncCapture(Camera *top, Camera *bot);
+
+      /**
+       * Stops and joins the capture threads.
+       */
+      ~AsyncCapture();
+
+      /**
+       * Gets the newest top and bottom frames whose timestamps are closest
+       * together.
+       *
+       * Returns at once if either camera has captured a frame perception
+       * has not yet had, otherwise waits up to timeoutUs for one.
+       *
+       * @return false, leaving top and bot alone, if no new pair arrived
+       */
+      bool latest(FrameHandle &top, FrameHandle &bot, int timeoutUs);
+
+      /**
+       * The number of frames captured but never returned by latest().
+       */
+      unsigned int dropped() const;
+
+   private:
+      AsyncCapture(const AsyncCapture &);
+      AsyncCapture &operator=(const AsyncCapture &);
+
+      static const int CAPTURE_HISTORY = 2;
+
+      struct Frame {
+         FrameHandle image;
+         // The driver's capture time, in us.
+         int64_t timestamp;
+         // Whether latest() has returned this frame.
+         bool used;
+      };
+
+      struct Stream {
+         Camera *camera;
+         // Newest first.
+         Frame frames[CAPTURE_HISTORY];
+         // The timestamp of the frame latest() last returned.
+         int64_t returned;
+         boost::thread *thread;
+      };
+
+      /**
+       * The loop of a capture thread.
+       */
+      void capture(Stream *stream, const char *name);
+
+      /**
+       * Chooses the pair latest() returns, if there is one with a frame it
+       * has not returned before. Must be called with mutex held.
+       */
+      bool pick(Frame *&top, Frame *&bot);
+
+      Stream streams[2];
+
+      mutable boost::mutex mutex;
+      boost::condition_variable captured;
+      unsigned int numDropped;
+
+      std::atomic<bool> stopping;
+};
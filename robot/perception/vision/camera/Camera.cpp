@@ -1,4 +1,5 @@
 #include "perception/vision/camera/Camera.hpp"
+#include <sys/time.h>
 #include "utils/Timer.hpp"
 #include "utils/Logger.hpp"
 
@@ -44,6 +45,21 @@ Camera::Camera() : dumpFile(0) {
   // imageSize = IMAGE_WIDTH * IMAGE_HEIGHT * 2;
 }
 
+/**
+ * Deleter for images a FrameHandle does not own.
+ */
+static void noRelease(const uint8_t *) {
+}
+
+FrameHandle Camera::getHandle(const __u32 colourSpace,
+                              struct timeval *timestamp) {
+   const uint8_t *image = get(colourSpace);
+   if (timestamp) {
+      gettimeofday(timestamp, NULL);
+   }
+   return image ? FrameHandle(image, noRelease) : FrameHandle();
+}
+
 bool Camera::startRecording(const char *filename, uint32_t frequency_ms) {
    this->frequency_ms = frequency_ms;
    if (dumpFile != NULL) {
@@ -10,6 +10,8 @@
 #include <unistd.h>
 #include <linux/videodev2.h>
 
+#include "types/FrameHandle.hpp"
+
 
 // there are 17 controls on the Nao V3+ that we care about setting
 #define NUM_CONTROLS 14
@@ -39,6 +41,27 @@ class Camera {
       virtual const uint8_t *get(const __u32 colourSpace = V4L2_PIX_FMT_YUYV) =
          0;
 
+      /**
+       * As get(), but the image stays valid for as long as the handle (or a
+       * copy of it) is held, rather than only until the next call.
+       *
+       * The default wraps get() for cameras that do not own their buffers,
+       * so its handles are only valid until the next get(), and such a
+       * camera reports false from ownsFrames().
+       *
+       * @param timestamp if not NULL, set to when the image was captured
+       */
+      virtual FrameHandle getHandle(
+         const __u32 colourSpace = V4L2_PIX_FMT_YUYV,
+         struct timeval *timestamp = NULL);
+
+      /**
+       * Whether getHandle()'s images stay valid for as long as the handles
+       * are held, as asynchronous capture needs. Cameras that override
+       * getHandle() to keep their frames alive should return true.
+       */
+      virtual bool ownsFrames() const { return false; }
+
       /**
        * Starts recording to a file.  If there is a recording in progress, will
        * stop recording, first.
@@ -5,9 +5,14 @@
 #include "utils/Logger.hpp"
 #include "utils/basic_maths.hpp"
 
+// The largest change in a head joint between frames, in radians, and the
+// largest body rotation rate, in radians per second, for a robot to be still
+#define MAX_STILL_HEAD_CHANGE 0.01f
+#define MAX_STILL_GYROSCOPE 0.1f
+
 using namespace std;
 
-CameraToRR::CameraToRR()
+CameraToRR::CameraToRR() : moving_(true)
 {
    for (int i = 0; i < TOP_IMAGE_COLS; i++) {
       topEndScanCoords_[i] = TOP_IMAGE_ROWS;
@@ -24,6 +29,15 @@ CameraToRR::~CameraToRR()
 
 void CameraToRR::updateAngles(SensorValues val)
 {
+   // Written so that unknown (NaN) values count as moving
+   moving_ =
+      !(fabs(val.joints.angles[Joints::HeadYaw] -
+             values.joints.angles[Joints::HeadYaw]) < MAX_STILL_HEAD_CHANGE) ||
+      !(fabs(val.joints.angles[Joints::HeadPitch] -
+             values.joints.angles[Joints::HeadPitch]) < MAX_STILL_HEAD_CHANGE) ||
+      !(fabs(val.sensors[Sensors::InertialSensor_GyroscopeX]) < MAX_STILL_GYROSCOPE) ||
+      !(fabs(val.sensors[Sensors::InertialSensor_GyroscopeY]) < MAX_STILL_GYROSCOPE) ||
+      !(fabs(val.sensors[Sensors::InertialSensor_GyroscopeZ]) < MAX_STILL_GYROSCOPE);
    values = val;
 }
 
@@ -65,7 +79,7 @@ float CameraToRR::pixelSeparationToDistance(int pixelSeparation,
 
 bool CameraToRR::isRobotMoving() const
 {
-   return true;
+   return moving_;
 }
 
 void CameraToRR::findEndScanValues() {
@@ -42,6 +42,11 @@ class CameraToRR {
 
       Pose pose;
       float pixelSeparationToDistance(int pixelSeparation, int realSeparation) const;
+
+      /**
+       * Whether the cameras may have moved since the previous call to
+       * updateAngles, from the head joints and the gyroscopes
+       **/
       bool isRobotMoving() const;
 
       /**
@@ -58,7 +63,18 @@ class CameraToRR {
             return botEndScanCoords_[index];
       }
 
+      /**
+       * The end scan coordinates of every column of the top or bottom image
+       **/
+      const int* getTopEndScanCoords() const {
+            return topEndScanCoords_;
+      }
+      const int* getBotEndScanCoords() const {
+            return botEndScanCoords_;
+      }
+
     private:
+      bool moving_;
       int topEndScanCoords_[TOP_IMAGE_COLS];
       int botEndScanCoords_[BOT_IMAGE_COLS];
 };
@@ -1,14 +1,19 @@
 #include "perception/vision/camera/CombinedCamera.hpp"
 #include "perception/vision/camera/NaoCamera.hpp"
+#include "utils/Logger.hpp"
 
 Camera *CombinedCamera::top_camera_ = NULL;
 Camera *CombinedCamera::bot_camera_ = NULL;
 
+// How long to wait for a new frame from the capture threads, in us; the
+// same as a camera's own timeout.
+#define CAPTURE_WAIT_TIME 100000
+
 CombinedCamera::CombinedCamera(
     bool dumpframes,
     int dumprate,
     string dumpfile
-){
+) : capture_(NULL) {
     if (dumpframes) {
         // Setting recording on either camera starts it for both
         top_camera_->startRecording(dumpfile.c_str(), dumprate);
@@ -20,6 +25,8 @@ Camera* CombinedCamera::getCamera() {
 }
 
 CombinedCamera::~CombinedCamera(){
+    // Join the capture threads before anything stops the cameras
+    delete capture_;
     // Stopping recording on either camera starts it for both
     top_camera_->stopRecording();
 }
@@ -32,6 +39,39 @@ const uint8_t* CombinedCamera::getFrameBottom() {
     return bot_camera_->get();
 }
 
+FrameHandle CombinedCamera::getHandleTop() {
+    return top_camera_->getHandle();
+}
+
+FrameHandle CombinedCamera::getHandleBottom() {
+    return bot_camera_->getHandle();
+}
+
+bool CombinedCamera::startCapture() {
+    if (!top_camera_->ownsFrames() || !bot_camera_->ownsFrames()) {
+        llog(WARNING) << "Camera frames are not reference counted, "
+                      << "not capturing asynchronously" << std::endl;
+        return false;
+    }
+    if (capture_ == NULL) {
+        capture_ = new AsyncCapture(top_camera_, bot_camera_);
+    }
+    return true;
+}
+
+bool CombinedCamera::getHandles(FrameHandle &top, FrameHandle &bot) {
+    if (capture_ != NULL) {
+        return capture_->latest(top, bot, CAPTURE_WAIT_TIME);
+    }
+    top = top_camera_->getHandle();
+    bot = bot_camera_->getHandle();
+    return true;
+}
+
+unsigned int CombinedCamera::droppedFrames() const {
+    return capture_ ? capture_->dropped() : 0;
+}
+
 Camera* CombinedCamera::getCameraTop() {
     return top_camera_;
 }
@@ -4,6 +4,7 @@
 #include <string>
 
 #include "Camera.hpp"
+#include "perception/vision/camera/AsyncCapture.hpp"
 #include "types/CombinedFrame.hpp"
 #include "types/CombinedCameraSettings.hpp"
 
@@ -45,6 +46,37 @@ class CombinedCamera {
          */
         const uint8_t * getFrameTop();
         const uint8_t * getFrameBottom();
+
+        /**
+         * As getFrameTop() and getFrameBottom(), but the images stay valid
+         * for as long as the handles are held.
+         */
+        FrameHandle getHandleTop();
+        FrameHandle getHandleBottom();
+
+        /**
+         * Starts capturing from both cameras on threads of their own, unless
+         * either camera's handles do not keep its frames alive (see
+         * Camera::ownsFrames), as capture would overwrite frames still in
+         * use. Returns whether capture is running.
+         */
+        bool startCapture();
+
+        /**
+         * Gets the current top and bottom images: the newest pair from the
+         * capture threads if they're running, otherwise the next frame from
+         * each camera in turn.
+         *
+         * @return false, leaving top and bot alone, if no new images arrived
+         */
+        bool getHandles(FrameHandle &top, FrameHandle &bot);
+
+        /**
+         * The number of frames the capture threads have dropped, or 0 if
+         * they aren't running.
+         */
+        unsigned int droppedFrames() const;
+
         static Camera* getCameraTop();
         static Camera* getCameraBot();
         static void setCameraTop(Camera* camera);
@@ -61,6 +93,7 @@ class CombinedCamera {
     private:
         static Camera *top_camera_;
         static Camera *bot_camera_;
+        AsyncCapture *capture_;
 };
 
 #endif
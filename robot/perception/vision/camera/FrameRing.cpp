@@ -0,0 +1,186 @@
+#include "perception/vision/camera/FrameRing.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <stdexcept>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+
+#include "utils/Logger.hpp"
+
+using namespace std;
+
+/**
+ * Everything a handle needs to give its buffer back, shared between the ring
+ * and every outstanding handle so that it outlives whichever goes last.
+ */
+struct FrameRing::State {
+   State(int fd, enum v4l2_memory memory)
+      : fd(fd), memory(memory), streaming(false), numHeld(0) {}
+
+   ~State() {
+      for (size_t i = 0; i < buffers.size(); ++i) {
+         if (memory == V4L2_MEMORY_MMAP) {
+            munmap(buffers[i].start, buffers[i].length);
+         } else {
+            free(buffers[i].start);
+         }
+      }
+   }
+
+   /**
+    * Hands buffer index to the driver. Must be called with mutex held.
+    */
+   void queue(unsigned int index) {
+      if (-1 == ioctl(fd, VIDIOC_QBUF, &buffers[index].buf)) {
+         llog(ERROR) << "VIDIOC_QBUF error " << errno << ", "
+                     << strerror(errno) << endl;
+      }
+   }
+
+   struct Buffer {
+      uint8_t *start;
+      size_t length;
+      // As last dequeued, ready to be queued again.
+      struct v4l2_buffer buf;
+      bool held;
+   };
+
+   int fd;
+   enum v4l2_memory memory;
+   std::vector<Buffer> buffers;
+
+   boost::mutex mutex;
+   bool streaming;
+   unsigned int numHeld;
+};
+
+/**
+ * The deleter for a FrameHandle. Queues the buffer back to the driver, unless
+ * streaming has stopped in the meantime.
+ */
+class FrameRing::Release {
+   public:
+      Release(const boost::shared_ptr<State> &state, unsigned int index)
+         : state(state), index(index) {}
+
+      void operator()(const uint8_t *) {
+         boost::mutex::scoped_lock lock(state->mutex);
+         state->buffers[index].held = false;
+         --state->numHeld;
+         if (state->streaming) {
+            state->queue(index);
+         }
+      }
+
+   private:
+      boost::shared_ptr<State> state;
+      unsigned int index;
+};
+
+FrameRing::FrameRing() {
+}
+
+FrameRing::~FrameRing() {
+   release();
+}
+
+void FrameRing::adopt(int fd, enum v4l2_memory memory, uint8_t *const *starts,
+                      const size_t *lengths, unsigned int n) {
+   release();
+   state = boost::shared_ptr<State>(new State(fd, memory));
+   state->buffers.resize(n);
+   for (unsigned int i = 0; i < n; ++i) {
+      State::Buffer &buffer = state->buffers[i];
+      buffer.start = starts[i];
+      buffer.length = lengths[i];
+      buffer.held = false;
+      memset(&buffer.buf, 0, sizeof(buffer.buf));
+      buffer.buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      buffer.buf.memory = memory;
+      buffer.buf.index = i;
+      if (memory == V4L2_MEMORY_USERPTR) {
+         buffer.buf.m.userptr = (unsigned long) starts[i];
+         buffer.buf.length = lengths[i];
+      }
+   }
+}
+
+void FrameRing::release() {
+   if (state) {
+      stop();
+      state.reset();
+   }
+}
+
+void FrameRing::start() {
+   boost::mutex::scoped_lock lock(state->mutex);
+   for (unsigned int i = 0; i < state->buffers.size(); ++i) {
+      if (!state->buffers[i].held) {
+         if (-1 == ioctl(state->fd, VIDIOC_QBUF, &state->buffers[i].buf)) {
+            llog(ERROR) << "VIDIOC_QBUF error " << errno << ", "
+                        << strerror(errno) << endl;
+            throw runtime_error(strerror(errno));
+         }
+      }
+   }
+   state->streaming = true;
+}
+
+void FrameRing::stop() {
+   if (!state) {
+      return;
+   }
+   boost::mutex::scoped_lock lock(state->mutex);
+   state->streaming = false;
+}
+
+FrameHandle FrameRing::dequeue(struct timeval *timestamp) {
+   struct v4l2_buffer buf;
+   memset(&buf, 0, sizeof(buf));
+   buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+   buf.memory = state->memory;
+
+   if (-1 == ioctl(state->fd, VIDIOC_DQBUF, &buf)) {
+      if (errno == EAGAIN) {
+         return FrameHandle();
+      }
+      llog(ERROR) << "VIDIOC_DQBUF error " << errno << ", "
+                  << strerror(errno) << endl;
+      throw runtime_error(strerror(errno));
+   }
+
+   if (buf.index >= state->buffers.size()) {
+      throw runtime_error("VIDIOC_DQBUF returned an unknown buffer");
+   }
+
+   boost::mutex::scoped_lock lock(state->mutex);
+   State::Buffer &buffer = state->buffers[buf.index];
+   buffer.buf = buf;
+   buffer.held = true;
+   ++state->numHeld;
+   if (state->numHeld == state->buffers.size()) {
+      llog(WARNING) << "All " << state->numHeld << " camera buffers are held; "
+                    << "the driver has none to fill" << endl;
+   }
+
+   if (timestamp) {
+      *timestamp = buf.timestamp;
+   }
+   return FrameHandle(buffer.start, Release(state, buf.index));
+}
+
+unsigned int FrameRing::held() const {
+   if (!state) {
+      return 0;
+   }
+   boost::mutex::scoped_lock lock(state->mutex);
+   return state->numHeld;
+}
+
+unsigned int FrameRing::size() const {
+   return state ? state->buffers.size() : 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <linux/videodev2.h>
+
+#ifndef Q_MOC_RUN
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include "types/FrameHandle.hpp"
+
+/**
+ * Owns the streaming buffers of a V4L2 camera and hands out filled ones as
+ * reference counted FrameHandles.
+ *
+ * A buffer is queued back to the driver only when the last handle to it is
+ * released, so vision, the dumper and offnao streaming can all read the
+ * same image without copying it, and the driver can never overwrite an
+ * image someone is still using. The buffers themselves are unmapped or
+ * freed once the ring has released them and no handles remain.
+ *
+ * Handles may be released on any thread.
+ */
+class FrameRing {
+   public:
+      FrameRing();
+
+      /**
+       * Releases the buffers, as release() does.
+       */
+      ~FrameRing();
+
+      /**
+       * Takes ownership of n buffers belonging to fd.
+       *
+       * @param memory V4L2_MEMORY_MMAP for buffers to munmap, or
+       *               V4L2_MEMORY_USERPTR for buffers to free
+       */
+      void adopt(int fd, enum v4l2_memory memory, uint8_t *const *starts,
+                 const size_t *lengths, unsigned int n);
+
+      /**
+       * Gives up the buffers. They are freed now, or when the last
+       * outstanding handle is released.
+       */
+      void release();
+
+      /**
+       * Queues every buffer not held by a handle. Call before STREAMON.
+       */
+      void start();
+
+      /**
+       * Stops queueing released buffers. Call after STREAMOFF, which takes
+       * all buffers back from the driver.
+       */
+      void stop();
+
+      /**
+       * Dequeues the next filled buffer.
+       *
+       * @param timestamp if not NULL, set to the driver's capture time
+       * @return the image, or an empty handle if none is ready yet
+       */
+      FrameHandle dequeue(struct timeval *timestamp = NULL);
+
+      /**
+       * The number of buffers currently held by handles.
+       */
+      unsigned int held() const;
+
+      unsigned int size() const;
+
+   private:
+      FrameRing(const FrameRing &);
+      FrameRing &operator=(const FrameRing &);
+
+      struct State;
+      class Release;
+
+      boost::shared_ptr<State> state;
+};
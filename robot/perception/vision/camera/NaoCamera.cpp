@@ -2,6 +2,7 @@
 #include <limits.h>
 #include <stdio.h>
 #include <sys/mman.h>
+#include <sys/time.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -406,16 +407,20 @@ NaoCamera::~NaoCamera() {
    close_device();
 }
 
-const uint8_t *NaoCamera::read_frame(void) {
-   unsigned int i;
-   const uint8_t *image = NULL;
+/**
+ * Deleter for images a FrameHandle does not own.
+ */
+static void noRelease(const uint8_t *) {
+}
+
+FrameHandle NaoCamera::read_frame(struct timeval *timestamp) {
    switch (io) {
       /* reading from file and video device are exactly the same */
       case IO_METHOD_READ:
          if (-1 == read(fd, buffers[0].start, buffers[0].length)) {
             switch (errno) {
                case EAGAIN:
-                  return NULL;
+                  return FrameHandle();
 
                case EIO:
                   /* Could ignore EIO, see spec. */
@@ -427,98 +432,28 @@ const uint8_t *NaoCamera::read_frame(void) {
             }
          }
 
-         image = buffers[0].start;
-
-         break;
-
-      case IO_METHOD_MMAP:
-         if (lastDequeued.index != UINT_MAX) {
-            if (-1 == ioctl(fd, VIDIOC_QBUF, &lastDequeued)) {
-               errno_throw("VIDEOC_BUF");
-            }
-         }
-
-         CLEAR(lastDequeued);
-
-         lastDequeued.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-         lastDequeued.memory = V4L2_MEMORY_MMAP;
-
-         if (-1 == ioctl(fd, VIDIOC_DQBUF, &lastDequeued)) {
-            switch (errno) {
-               case EAGAIN:
-                  return NULL;
-
-               case EIO:
-                  /* Could ignore EIO, see spec. */
-                  std::cout << "eio" << std::endl;
-
-                  /* fall through */
-               case EFAULT:
-                  std::cout << "efault" << std::endl;
-
-               case EINVAL:
-                  std::cout << "einval" << std::endl;
-
-               default:
-                  std::cout << "lol mmap" << std::endl;
-                  errno_throw("VIDIOC_DQBUF");
-            }
+         if (timestamp) {
+            gettimeofday(timestamp, NULL);
          }
+         return FrameHandle(buffers[0].start, noRelease);
 
-         assert(lastDequeued.index < n_buffers);
-
-         image = buffers[lastDequeued.index].start;
-
-         break;
-
+      case IO_METHOD_MMAP:
       case IO_METHOD_USERPTR:
-         // TODO(jayen): verify that lastDequeued fix works for user pointers
-         if (lastDequeued.index != UINT_MAX) {
-            if (-1 == ioctl(fd, VIDIOC_QBUF, &lastDequeued)) {
-               errno_throw("VIDEOC_BUF");
-            }
-         }
-
-         CLEAR(lastDequeued);
-
-         lastDequeued.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-         lastDequeued.memory = V4L2_MEMORY_USERPTR;
-
-         if (-1 == ioctl(fd, VIDIOC_DQBUF, &lastDequeued)) {
-            switch (errno) {
-               case EAGAIN:
-                  return NULL;
-
-               case EIO:
-                  /* Could ignore EIO, see spec. */
-
-                  /* fall through */
-
-               default:
-                  std::cout << "lol user?" << std::endl;
-                  errno_throw("VIDIOC_DQBUF");
-            }
-         }
-
-         for (i = 0; i < n_buffers; ++i)
-            if (lastDequeued.m.userptr == (unsigned long) buffers[i].start
-                && lastDequeued.length == buffers[i].length)
-               break;
-
-         assert(i < n_buffers);
-
-         image =(const uint8_t*) lastDequeued.m.userptr;
-
-         break;
+         return ring.dequeue(timestamp);
 
       default:
          throw runtime_error("what kind of IO method is that?!?!?");
    }
-
-   return image;
 }
 
 const uint8_t *NaoCamera::get(const __u32 colourSpace) {
+   // Hold the image until the next call, as callers of get() expect.
+   current = getHandle(colourSpace, NULL);
+   return current.get();
+}
+
+FrameHandle NaoCamera::getHandle(const __u32 colourSpace,
+                                 struct timeval *timestamp) {
    if (colourSpace != V4L2_PIX_FMT_YUYV)
       throw runtime_error("only yuv422 is supported!");
    fd_set fds;
@@ -551,9 +486,9 @@ const uint8_t *NaoCamera::get(const __u32 colourSpace) {
 #endif // CTC_2_1
    }
 
-   const uint8_t *image = read_frame();
+   FrameHandle image = read_frame(timestamp);
    //writeFrame(image);
-   llog(DEBUG2) << "image returning from NaoCamera: " << (void *)image << endl;
+   llog(DEBUG2) << "image returning from NaoCamera: " << (void *)image.get() << endl;
    return image;
 }
 
@@ -762,6 +697,10 @@ void NaoCamera::stop_capturing(void) {
          if (-1 == ioctl(fd, VIDIOC_STREAMOFF, &type))
             errno_throw("VIDIOC_STREAMOFF");
 
+         // The driver has given every buffer back; don't requeue them as
+         // their handles are released.
+         ring.stop();
+
          break;
       default:
          throw runtime_error("unknown io method");
@@ -770,22 +709,15 @@ void NaoCamera::stop_capturing(void) {
 }
 
 void NaoCamera::uninit_buffers(void) {
-   unsigned int i;
-
    switch (io) {
       case IO_METHOD_READ:
          free(buffers[0].start);
          break;
 
       case IO_METHOD_MMAP:
-         for (i = 0; i < n_buffers; ++i)
-            if (-1 == munmap(buffers[i].start, buffers[i].length))
-               errno_throw("munmap");
-         break;
-
       case IO_METHOD_USERPTR:
-         for (i = 0; i < n_buffers; ++i)
-            free(buffers[i].start);
+         // Unmapped or freed once no handles to them remain.
+         ring.release();
          break;
       default:
          throw runtime_error("unknown io method");
@@ -864,6 +796,7 @@ void NaoCamera::init_mmap(void) {
       if (MAP_FAILED == buffers[n_buffers].start)
          errno_throw("mmap");
    }
+   adopt_buffers(V4L2_MEMORY_MMAP);
 }
 
 void NaoCamera::init_buffers(void) {
@@ -1195,14 +1128,21 @@ void NaoCamera::init_userp() {
          exit(EXIT_FAILURE);
       }
    }
+
+   adopt_buffers(V4L2_MEMORY_USERPTR);
+}
+
+void NaoCamera::adopt_buffers(enum v4l2_memory memory) {
+   uint8_t *starts[NUM_FRAME_BUFFERS];
+   size_t lengths[NUM_FRAME_BUFFERS];
+   for (unsigned int i = 0; i < n_buffers; ++i) {
+      starts[i] = buffers[i].start;
+      lengths[i] = buffers[i].length;
+   }
+   ring.adopt(fd, memory, starts, lengths, n_buffers);
 }
 
 void NaoCamera::start_capturing(void) {
-   // assign an impossible index to lastDequeued so we know not to
-   // re-enqueue if there have been no previous buffers
-   lastDequeued.index = UINT_MAX;
-
-   unsigned int i;
    enum v4l2_buf_type type;
 
    switch (io) {
@@ -1211,41 +1151,9 @@ void NaoCamera::start_capturing(void) {
          break;
 
       case IO_METHOD_MMAP:
-         for (i = 0; i < n_buffers; ++i) {
-            struct v4l2_buffer buf;
-
-            CLEAR(buf);
-
-            buf.type        = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-            buf.memory      = V4L2_MEMORY_MMAP;
-            buf.index       = i;
-
-            if (-1 == ioctl(fd, VIDIOC_QBUF, &buf))
-               errno_throw("VIDIOC_QBUF");
-         }
-
-         type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-
-         if (-1 == ioctl(fd, VIDIOC_STREAMON, &type))
-            errno_throw("VIDIOC_STREAMON");
-
-         break;
-
       case IO_METHOD_USERPTR:
-         for (i = 0; i < n_buffers; ++i) {
-            struct v4l2_buffer buf;
-
-            CLEAR(buf);
-
-            buf.type        = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-            buf.memory      = V4L2_MEMORY_USERPTR;
-            buf.index       = i;
-            buf.m.userptr   = (unsigned long) buffers[i].start;
-            buf.length      = buffers[i].length;
-
-            if (-1 == ioctl(fd, VIDIOC_QBUF, &buf))
-               errno_throw("VIDIOC_QBUF");
-         }
+         // Queues every buffer that is not still in use from before a stop.
+         ring.start();
 
          type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
@@ -5,6 +5,7 @@
 
 #include "perception/vision/camera/Camera.hpp"
 #include "perception/vision/camera/CameraDefinitions.hpp"
+#include "perception/vision/camera/FrameRing.hpp"
 #include "perception/vision/camera/NaoCameraDefinitions.hpp"
 #include "types/alvisiondefinitions.h"
 #include "types/CameraSettings.hpp"
@@ -18,8 +19,9 @@ typedef enum {
    NUM_IO_METHODS
 } IOMethod;
 
-// only four frame buffers are supported on the Nao V3
-#define NUM_FRAME_BUFFERS 4
+// only four frame buffers are supported on the Nao V3 (REQBUFS gives us fewer
+// if so); the other two cover the frames AsyncCapture holds on to
+#define NUM_FRAME_BUFFERS 6
 
 #ifdef CTC_2_1
    #define VIDEO_TOP "/dev/video0"
@@ -56,6 +58,9 @@ class NaoCamera : public Camera {
       virtual ~NaoCamera();
 
       const uint8_t *get(const __u32 colourSpace);
+      FrameHandle getHandle(const __u32 colourSpace,
+                            struct timeval *timestamp = NULL);
+      bool ownsFrames() const { return true; }
       bool setControl(const uint32_t id, const int32_t value);
 
 #ifndef CTC_2_1
@@ -76,9 +81,10 @@ class NaoCamera : public Camera {
        * Actually reads the frame from the camera (or does the appropriate ioctl
        * call if not using the read io method)
        *
-       * @return true if successful, false otherwise (if asked to read again)
+       * @param timestamp if not NULL, set to when the image was captured
+       * @return the image if successful, empty otherwise (if asked to read again)
        */
-      const uint8_t *read_frame();
+      FrameHandle read_frame(struct timeval *timestamp);
 
       /**
        * Calibrate the camera.  Turn off the auto-corrections.
@@ -108,6 +114,11 @@ class NaoCamera : public Camera {
        */
       void init_userp(void);
 
+      /**
+       * hands the streaming buffers over to the ring
+       */
+      void adopt_buffers(enum v4l2_memory memory);
+
       /**
        * just clears the image buffer
        */
@@ -190,16 +201,17 @@ class NaoCamera : public Camera {
       struct v4l2_querymenu querymenu;
 
       /**
-       * When dealing with mmap'ed buffers, we should
-       * 1. Dequeue a buffer and write its pointer to the blackboard
-       * 2. Allow perception to process the image
-       * 3. Enqueue the buffer again so it can be reused
-       *
-       * Before we were not allowing perception to process the current frame
-       * before enqueuing the buffer again, which could have potentially have
-       * lead to split images
+       * Owns the streaming buffers in mmap and user pointer mode. A buffer
+       * is only enqueued again once everything using its image (vision, the
+       * dumper, offnao streaming) has released it, so images are never
+       * split by the driver writing over them.
+       */
+      FrameRing ring;
+
+      /**
+       * The image last returned by get(), held until the next call.
        */
-      struct v4l2_buffer lastDequeued;
+      FrameHandle current;
 
       // Keep track of the current camera choice as a human-readable string
       std::string cameraChoice;
@@ -0,0 +1,149 @@
+#ifndef CTC_2_1
+#include "perception/vision/detector/BallClassifier.hpp"
+
+#include <string>
+
+#include <tiny_dnn/layers/convolutional_layer.h>
+#include <tiny_dnn/layers/max_pooling_layer.h>
+#include <tiny_dnn/layers/fully_connected_layer.h>
+#include <tiny_dnn/activations/relu_layer.h>
+
+#include "perception/vision/detector/DNNHelper.hpp"
+#include "utils/home_nao.hpp"
+
+#define DNN_WEIGHTS_DIR "data/dnn_model/ball_weights/"
+
+// The network's input is INPUT_SIZE by INPUT_SIZE.
+#define INPUT_SIZE 32
+
+/**
+ * Binarises each row of a region into a rows by cols image, 1 where white.
+ */
+struct WhiteRows {
+    uint8_t* white;
+
+    template <class Row>
+    void operator()(int y, const Row& row) const {
+        const int cols = row.size();
+        uint8_t* out = white + y * cols;
+        for (int x = 0; x < cols; ++x) {
+            out[x] = row[x] == cWHITE;
+        }
+    }
+};
+
+BallClassifier::BallClassifier() : count_(0) {
+    load_();
+}
+
+void BallClassifier::clear() {
+    count_ = 0;
+}
+
+int BallClassifier::add(const RegionI& region) {
+    const int rows = region.getRows();
+    const int cols = region.getCols();
+
+    white_.resize(rows * cols);
+    WhiteRows white_rows = { white_.data() };
+    region.for_each_row_fovea(white_rows);
+
+    if (count_ == (int)inputs_.size()) {
+        inputs_.push_back(tiny_dnn::vec_t(INPUT_SIZE * INPUT_SIZE));
+    }
+    resize_(rows, cols, inputs_[count_]);
+    return count_++;
+}
+
+void BallClassifier::classify() {
+    scores_.resize(count_);
+    if (count_ == 0) {
+        return;
+    }
+
+    // Run the layers as network::predict does, but without the copies of
+    // the batch and its results it returns by value. The layers keep their
+    // buffers between calls and only grow them.
+    batch_.resize(count_);
+    for (int i = 0; i < count_; ++i) {
+        batch_[i] = &inputs_[i];
+    }
+    nn_[0]->set_in_data(&batch_, 1);
+    const size_t layers = nn_.layer_size();
+    for (size_t l = 0; l < layers; ++l) {
+        nn_[l]->forward();
+    }
+    nn_[layers - 1]->output(outputs_);
+
+    const tiny_dnn::tensor_t& result = *outputs_[0];
+    for (int i = 0; i < count_; ++i) {
+        scores_[i] = result[i][1] - result[i][0];
+    }
+}
+
+void BallClassifier::resize_(int rows, int cols, tiny_dnn::vec_t& dst) {
+    float deltaX = (float)(rows) / INPUT_SIZE;
+    float lastX = (0.5 * rows) / INPUT_SIZE - 0.5;
+    float deltaY = (float)(cols) / INPUT_SIZE;
+    float lastY;
+    for (int i = 0; i < INPUT_SIZE; ++i) {
+        float x = lastX;
+        lastX += deltaX;
+        int fx = (int)x;
+        x -= fx;
+        short x1 = (1.f - x) * 2048;
+        short x2 = 2048 - x1;
+        if (fx >= rows - 1) {
+            fx = rows - 2;
+        }
+        const uint8_t *top = &white_[fx * cols];
+        const uint8_t *bottom = top + cols;
+
+        lastY = (0.5 * cols) / INPUT_SIZE - 0.5;
+        for (int j = 0; j < INPUT_SIZE; ++j) {
+            float y = lastY;
+            lastY += deltaY;
+            int fy = (int)y;
+            y -= fy;
+            if (fy >= cols - 1) {
+                fy = cols - 2;
+            }
+            short y1 = (1.f - y) * 2048;
+            short y2 = 2048 - y1;
+            dst[i * INPUT_SIZE + j] = (top[fy] * x1 * y1 + bottom[fy] * x2 * y1
+                                       + top[fy + 1] * x1 * y2 + bottom[fy + 1] * x2 * y2) >> 22;
+        }
+    }
+}
+
+void BallClassifier::load_() {
+    using conv     = tiny_dnn::convolutional_layer;
+    using max_pool = tiny_dnn::max_pooling_layer;
+    using fc       = tiny_dnn::fully_connected_layer;
+    using relu     = tiny_dnn::relu_layer;
+
+    nn_ << conv(32,32,3,1,4) /* 32x32 in, 5x5 kernel, 1-6 fmaps conv */
+        << relu(30,30,4)
+        << max_pool(30, 30, 4, 2) /* 28x28 in, 6 fmaps, 2x2 subsampling */
+        << conv(15, 15, 3, 4, 8) // layer 3
+        << relu(13, 13, 8)
+        << max_pool(13, 13, 8, 2)
+        << conv(6, 6, 3, 8, 8, padding::valid, true, 2, 2) // layer 6
+        << relu(2, 2, 8)
+        << max_pool(2, 2, 8, 2)
+        << fc(1 * 1 * 8, 8) // layer 9
+        << relu(1, 1, 8)
+        << fc(8, 2);
+
+    std::string root_path = getHomeNao(DNN_WEIGHTS_DIR);
+
+    // The layers with weights, and the files they are read from.
+    const int layers[] = {0, 3, 6, 9, 11};
+    const char *names[] = {"conv_0", "conv_1", "conv_2", "fc_1", "out_1"};
+    for (int i = 0; i < 5; ++i) {
+        std::vector<vec_t*> weights = nn_[layers[i]]->weights();
+        Read_File(*weights[0], root_path + names[i] + "_w.txt");
+        Read_File(*weights[1], root_path + names[i] + "_b.txt");
+    }
+}
+#endif // CTC_2_1
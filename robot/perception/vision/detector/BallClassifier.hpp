@@ -0,0 +1,80 @@
+#ifndef PERCEPTION_VISION_DETECTOR_BALLCLASSIFIER_H_
+#define PERCEPTION_VISION_DETECTOR_BALLCLASSIFIER_H_
+
+#ifndef CTC_2_1
+
+#include <stdint.h>
+#include <vector>
+
+#include "perception/vision/Region/Region.hpp"
+#include "tiny_dnn/network.h"
+
+/**
+ * The ball CNN, run once per frame over every ball candidate.
+ *
+ * Each candidate is binarised (white or not) and resized into its own slot
+ * of an input batch as it is added, and classify runs one forward pass of
+ * the shared network's layers over the whole batch. The slots, and the
+ * network's own buffers, are kept from frame to frame, so neither adding
+ * nor classifying candidates allocates once the batch has been as large
+ * before.
+ */
+class BallClassifier {
+    public:
+        /**
+         * Builds the network and reads its weights.
+         */
+        BallClassifier();
+
+        /**
+         * Empties the batch.
+         */
+        void clear();
+
+        /**
+         * Adds region to the batch and returns its index.
+         */
+        int add(const RegionI& region);
+
+        /**
+         * Classifies every candidate added since clear.
+         */
+        void classify();
+
+        int size() const { return count_; }
+
+        /**
+         * The ball output minus the not ball output for candidate index, as
+         * of the last classify. A candidate is a ball unless this is
+         * negative.
+         */
+        float score(int index) const { return scores_[index]; }
+        bool isBall(int index) const { return !(scores_[index] < 0); }
+
+    private:
+        void load_();
+
+        /**
+         * Bilinearly resizes the rows by cols binary image in white_ into
+         * dst, with 11 bit fixed point weights.
+         */
+        void resize_(int rows, int cols, tiny_dnn::vec_t& dst);
+
+        tiny_dnn::network<tiny_dnn::sequential> nn_;
+
+        // One input per slot; slots past count_ are spare.
+        std::vector<tiny_dnn::vec_t> inputs_;
+        int count_;
+
+        // The first count_ inputs, as the first layer takes them, and the
+        // last layer's output, so the forward pass does not allocate them.
+        std::vector<const tiny_dnn::vec_t*> batch_;
+        std::vector<const tiny_dnn::tensor_t*> outputs_;
+
+        std::vector<uint8_t> white_;
+        std::vector<float> scores_;
+};
+
+#endif // CTC_2_1
+
+#endif
@@ -2,15 +2,17 @@
 #include "perception/vision/Region/Region.hpp"
 #include "perception/vision/VisionDefinitions.hpp"
 #include "perception/vision/other/Ransac.hpp"
+#include "perception/vision/other/RansacEngine.hpp"
+#include "perception/vision/other/RoiSchedule.hpp"
 #include "perception/vision/other/WriteImage.hpp"
 
 #include "types/RansacTypes.hpp"
 #include "types/VisionInfoOut.hpp"
-#include "types/GroupLinks.hpp"
 #include "types/Point.hpp"
 #include "types/BBox.hpp"
 
 #include "utils/home_nao.hpp"
+#include "utils/Logger.hpp"
 
 #include "soccer.hpp"
 
@@ -19,13 +21,7 @@
 #include <climits>
 #include <vector>
 #include <iomanip>
-
-#ifndef CTC_2_1
-   #include <tiny_dnn/layers/convolutional_layer.h>
-   #include <tiny_dnn/layers/max_pooling_layer.h>
-   #include <tiny_dnn/layers/fully_connected_layer.h>
-   #include <tiny_dnn/activations/relu_layer.h>
-#endif
+#include <boost/bind.hpp>
 
 // #define BALL_TO_FILE_COMP 1
 #ifdef BALL_TO_FILE_COMP
@@ -79,6 +75,18 @@
 // region to be considered a potential ball.
 #define MIN_SECTION_SIZE_PORTION 0.01f
 
+// getSizeEst corrects the ball's y for the robot leaning sideways by
+// BALL_LEAN_HEIGHT * tan(latestAngleX), and shortens its distance by
+// BALL_DISTANCE_ERROR for every BALL_DISTANCE_ERROR_RANGE it is away.
+#define BALL_LEAN_HEIGHT 190
+#define BALL_DISTANCE_ERROR 30
+#define BALL_DISTANCE_ERROR_RANGE 500
+
+// The tracking window extends this many expected ball diameters either side
+// of the predicted ball, but never less than TRACKING_WINDOW_MIN pixels.
+#define TRACKING_WINDOW_DIAMETERS 1.5f
+#define TRACKING_WINDOW_MIN 40
+
 //#define BALL_DETECTOR_TIMINGS 1
 // #define BALL_DEBUG 1
 #define EARLY_EXIT 1 // Find the first ball and stop.
@@ -487,235 +495,301 @@ static inline void printTimings(string title, int time, int count){
 }
 #endif // BALL_DETECTOR_TIMINGS
 
+BallDetector::BallDetector() : estimator(ball),
+        tracking_interval_(0), frames_since_sweep_(0), track_valid_(false),
+        track_x_(0), track_y_(0), pool_(NULL), arena_(NULL) {
+#ifndef CTC_2_1
+    classifier_ = new BallClassifier();
+#endif // CTC_2_1
+}
+
+BallDetector::BallDetector(Worker) : estimator(ball),
+        tracking_interval_(0), frames_since_sweep_(0), track_valid_(false),
+        track_x_(0), track_y_(0), pool_(NULL), arena_(new FrameArena()) {
+#ifndef CTC_2_1
+    classifier_ = NULL;
+#endif // CTC_2_1
+}
+
+BallDetector::~BallDetector() {
+    setThreads(0);
+    for (unsigned int i = 0; i < searches_.size(); ++i) {
+        for (int list = 0; list < searches_[i].num_lists; ++list) {
+            clearBDVBs(searches_[i].lists[list]);
+        }
+    }
+    delete arena_;
+#ifndef CTC_2_1
+    delete classifier_;
+#endif // CTC_2_1
+}
+
+void BallDetector::setThreads(int threads) {
+#if defined(BALL_DETECTOR_TIMINGS) || defined(BALL_DETECTOR_USES_VDM)
+    // The timers and the debugger's region selection are shared by every ROI.
+    threads = 0;
+#endif
+    if (threads == (int)workers_.size()) {
+        return;
+    }
+
+    delete pool_;
+    pool_ = NULL;
+    for (unsigned int i = 0; i < workers_.size(); ++i) {
+        delete workers_[i];
+    }
+    workers_.clear();
+    delete arena_;
+    arena_ = NULL;
+
+    if (threads > 0) {
+        pool_ = new WorkerPool(threads, "BallROI");
+        for (int i = 0; i < threads; ++i) {
+            workers_.push_back(new BallDetector(Worker()));
+        }
+        arena_ = new FrameArena();
+    }
+    llog(INFO) << "Ball detector threads: " << threads << std::endl;
+}
+
+void BallDetector::setTracking(int interval) {
+    tracking_interval_ = max(interval, 0);
+    track_valid_ = false;
+    llog(INFO) << "Ball detector tracking interval: " << tracking_interval_ << std::endl;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////// ENTRY POINT TO THE BALL DETECTOR ////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 void BallDetector::detect(const VisionInfoIn& info_in, VisionInfoMiddle& info_middle, VisionInfoOut& info_out) {
     const vector<RegionI> &regions = info_middle.roi;
-
-    unsigned int region_index = regions.size() - 1;
-    unsigned int subregion_index = 0;
+    const unsigned int num_regions = regions.size();
 #ifdef BALL_DETECTOR_TIMINGS
     frame_timer.restart();
 #endif // BALL_DETECTOR_TIMINGS
 
-    for (vector<RegionI>::const_reverse_iterator rit = regions.rbegin();
-        rit != regions.rend(); ++rit, region_index--)
-    {
-        // This is our internal ROI
-
-        vector <BallDetectorVisionBundle> ball_regions;
-#ifdef BALL_DETECTOR_USES_VDM
-        if (vdm != NULL) {
-            VisionDebugQuery q = vdm->getQuery();
-            if (region_index == q.region_index) {
-                vdm->vision_debug_blackboard.values["Draw This Region"] = 1;
-            } else {
-                vdm->vision_debug_blackboard.values["Draw This Region"] = 0;
+    if (searches_.size() < num_regions) {
+        searches_.resize(num_regions);
+    }
+
+    // With a budget the ROIs are searched best first as the schedule ranks
+    // them, otherwise from the last, as they always were. While a ball is
+    // tracked those overlapping its predicted window go first, and if any
+    // of them has a ball the rest are not searched.
+    RoiSchedule *schedule = info_middle.schedule;
+    const bool ranked = schedule && schedule->getBudget() > 0 &&
+                        schedule->ranks(info_middle.roi_ranking);
+    order_.clear();
+    BBox window;
+    const bool tracking = predictTrackingWindow_(info_in, info_out, window);
+    if (tracking) {
+        for (unsigned int k = 0; k < num_regions; ++k) {
+            const unsigned int i = ranked ? schedule->order()[k] : num_regions - 1 - k;
+            if (overlapsWindow_(regions[i], window)) {
+                order_.push_back(i);
             }
         }
-#endif // BALL_DETECTOR_USES_VDM
-
-#ifdef BALL_DETECTOR_TIMINGS
-        timer.restart();
-#endif // BALL_DETECTOR_TIMINGS
+    }
+    const unsigned int num_tracked = order_.size();
+    for (unsigned int k = 0; k < num_regions; ++k) {
+        const unsigned int i = ranked ? schedule->order()[k] : num_regions - 1 - k;
+        if (!tracking || !overlapsWindow_(regions[i], window)) {
+            order_.push_back(i);
+        }
+    }
+    const unsigned int num_balls = info_out.balls.size();
 
-        comboROI(info_in, *rit, info_middle, info_out, true, ball_regions);
+    // With a budget, the search stops when it runs out, though the first
+    // ROI is always searched.
+    const bool budgeted = schedule && schedule->getBudget() > 0;
+    bool out_of_time = false;
 
-#ifdef BALL_DETECTOR_TIMINGS
-        roi_count++;
-        roi_time += timer.elapsed_us();
-#endif // BALL_DETECTOR_TIMINGS
+    // Whether to stop at the first ball. Not while using vdm.
+#ifdef EARLY_EXIT
+#ifdef BALL_DETECTOR_USES_VDM
+    const bool early_exit = vdm == NULL;
+#else
+    const bool early_exit = true;
+#endif // BALL_DETECTOR_USES_VDM
+#else
+    const bool early_exit = false;
+#endif // EARLY_EXIT
 
-        subregion_index = 1;
-        //cout << "SUB_BALLS " << ball_regions.size() << endl;
-        for (vector <BallDetectorVisionBundle>::iterator it = ball_regions.begin();
-                it != ball_regions.end(); it++, subregion_index++) {
+    // The ROIs are searched in waves, every thread taking its share of a
+    // wave at once. Each ROI is searched into its own RoiSearch, so the
+    // threads share nothing, and the wave's candidates are then classified
+    // in one batch and accepted in search order, as if each had been
+    // classified in turn. Stopping at the first ball therefore stops after
+    // the wave it is in, which is a wave of one ROI per thread, or of a
+    // single ROI without threads. Otherwise every ROI is in one wave.
+    //
+    // Each wave is searched with comboROI first, and then with blobROI only
+    // where it could still matter: blobROI's candidates come after an ROI's
+    // comboROI candidates, so once early exit has a comboROI ball, the ROIs
+    // from that one on need no blobROI search.
+    unsigned int wave = num_regions;
+#ifdef EARLY_EXIT
+    wave = workers_.size() + 1;
+#endif // EARLY_EXIT
+    if (pool_) {
+        if (budgeted) {
+            wave = workers_.size() + 1;
+        }
+        arena_->reset();
+        for (unsigned int i = 0; i < workers_.size(); ++i) {
+            workers_[i]->arena_->reset();
+        }
+    }
 
-#ifdef BALL_DETECTOR_TIMINGS
-            timer.restart();
-#endif // BALL_DETECTOR_TIMINGS
-            bool isBall = inspectBall(*it);
-#ifdef BALL_DETECTOR_TIMINGS
-            inspect_ball_count++;
-            inspect_ball_time += timer.elapsed_us();
-#endif // BALL_DETECTOR_TIMINGS
+    bool found = false;
+    unsigned int searched = 0;
+    while (searched < num_regions && !found &&
+            !(searched == num_tracked && info_out.balls.size() > num_balls)) {
+        if (budgeted && searched > 0 && schedule->expired()) {
+            out_of_time = true;
+            break;
+        }
 
-            if (isBall){
+        // A wave never spans the end of the tracked ROIs.
+        const unsigned int end = searched < num_tracked ? num_tracked : num_regions;
+        unsigned int last = min(end, searched + wave);
 
-#ifdef BALL_DEBUG
-                cout << "FOUND BALL" << endl;
-                //cout << "ball.rr.distance(): " << it->ball.rr.distance() << " ball.rr.heading(): " << it->ball.rr.heading() << endl;
-                cout << "ball.imageCoords[0]: " << it->ball.imageCoords[0] << " ball.imageCoords[1]: " << it->ball.imageCoords[1] << endl;
-                cout << "ball.radius: " << it->ball.radius << endl;
-                cout << "ball.topCamera: " << it->ball.topCamera << endl;
-#endif // BALL_DEBUG
-#ifdef BALL_TO_FILE
-                char name[] = "a";
-                char location[] = BALL_TO_FILE_DIR;
-                stringstream dir;
-                dir << location << num_images << ".png";
-                num_images++;
-                cout << "Writing binary ball image to: " << dir.str().c_str() << "\n";
-                WriteImage w;
-                if(w.writeImage(*it->region, COLOUR_FORMAT, dir.str().c_str(), name)) {
-                    cout << "Success\n";
-                }
-                else {
-                    cout << "Failed\n";
+        if (last - searched > 1 && pool_) {
+            runWave_(searched, last, false, info_in, info_middle, info_out);
+        } else {
+            for (unsigned int i = searched; i < last; ++i) {
+                if (budgeted && i > searched && schedule->expired()) {
+                    // The wave ends with the ROIs already searched.
+                    last = i;
+                    out_of_time = true;
+                    break;
                 }
-#endif  // BALL_TO_FILE
-
-                // Set the ball back to the region
-                Point center = it->region->getInternalFovea()->mapFoveaToImage(Point(it->circle_fit.result_circle.centre.x(),it->circle_fit.result_circle.centre.y()));
-                it->ball.imageCoords.x() = center.x();
-                it->ball.imageCoords.y() = center.y();
-
-                it->ball.topCamera = (it->region->isTopCamera());
-                it->ball.radius = (it->circle_fit.result_circle.radius * it->region->getDensity());
-
-                // HACK FOR Seeing FP Balls off the field, and in goals (@ijnek)
-                const AbsCoord &robotPos = info_in.robotPose;
-                const RRCoord &ballPosRR = it->ball.rr;
+                searchROI_(info_in, regions[order_[i]], info_middle,
+                           info_out, order_[i], searches_[i]);
+            }
+        }
 
-                float ballX = robotPos.x() + ballPosRR.distance() * cosf(robotPos.theta() + ballPosRR.heading());
-                float ballY = robotPos.y() + ballPosRR.distance() * sinf(robotPos.theta() + ballPosRR.heading());
+        classifyWave_(searched, last, false);
 
-                if (abs(ballX) < FIELD_LENGTH / 2.0 + 300 && abs(ballY) < FIELD_WIDTH / 2.0 + 300)
-                {
-                    info_out.balls.push_back(it->ball);
-                }
-#ifdef EARLY_EXIT
-// We don't want to early exit while using vdm
-#ifdef BALL_DETECTOR_USES_VDM
-                if (vdm == NULL) {
-                    clearBDVBs(ball_regions);
-                    return;
+        unsigned int blob_last = last;
+        for (unsigned int i = searched; i < blob_last && early_exit; ++i) {
+            const RoiSearch &search = searches_[i];
+            for (unsigned int c = 0; c < search.candidates.size(); ++c) {
+                if (search.candidates[c].ball) {
+                    blob_last = i;
+                    break;
                 }
-#else
-                clearBDVBs(ball_regions);
-                return;
-#endif // BALL_DETECTOR_USES_VDM
-#endif // EARLY_EXIT
             }
-#ifdef BALL_DETECTOR_USES_VDM
-            if (vdm != NULL) {
-                VisionDebugQuery q = vdm->getQuery();
-                cout << "REGION " << region_index << "/" << q.region_index << endl;
-                cout << "SUBREGION " << subregion_index << "/" << q.subregion_index << endl;
-                if (region_index == q.region_index && subregion_index == q.subregion_index) {
-                    it->drawBall();
-                }
+        }
+        if (blob_last - searched > 1 && pool_) {
+            runWave_(searched, blob_last, true, info_in, info_middle, info_out);
+        } else {
+            for (unsigned int i = searched; i < blob_last; ++i) {
+                searchBlobs_(info_in, info_middle, info_out, order_[i], searches_[i]);
             }
-#endif // BALL_DETECTOR_USES_VDM
         }
-        // If inspect fails and the region aspect was deemed to be normal
-        // we should let blobROI find the ball and rerun detect() on the
-        // regions created by blobROI.
-        for (vector <BallDetectorVisionBundle>::iterator it = ball_regions.begin();
-        it != ball_regions.end(); it++) {
-            if (it->region_aspect_type == NORMAL) {
-
-#ifdef BALL_DEBUG
-                cout << "Normal Region failed, retrying with blobROI\n";
-#endif //BALL_DEBUG
+        classifyWave_(searched, blob_last, true);
 
-                vector <BallDetectorVisionBundle> ball_regions_blob;
-#ifdef BALL_DETECTOR_TIMINGS
-                timer2.restart();
-#endif // BALL_DETECTOR_TIMINGS
-                blobROI(info_in, *it->original_region, info_middle, info_out, ball_regions_blob, it->region_aspect_type);
-#ifdef BALL_DETECTOR_TIMINGS
-                blob_roi_count++;
-                blob_roi_time += timer2.elapsed_us();
-#endif // BALL_DETECTOR_TIMINGS
+        for (unsigned int i = searched; i < last && !found; ++i) {
+            RoiSearch &search = searches_[i];
+            for (vector<BallCandidate>::const_iterator candidate = search.candidates.begin();
+                    candidate != search.candidates.end() && !found; ++candidate) {
+                BallDetectorVisionBundle *it = &search.lists[candidate->list][candidate->index];
 
-                unsigned int subregion_index_blob = 1;
-                for (vector <BallDetectorVisionBundle>::iterator itb = ball_regions_blob.begin();
-                itb != ball_regions_blob.end(); itb++, subregion_index_blob++) {
-#ifdef BALL_DETECTOR_TIMINGS
-                    timer.restart();
-#endif // BALL_DETECTOR_TIMINGS
-                    bool isBall = inspectBall(*itb);
-#ifdef BALL_DETECTOR_TIMINGS
-                    inspect_ball_count++;
-                    inspect_ball_time += timer.elapsed_us();
-#endif // BALL_DETECTOR_TIMINGS
-
-                    if (isBall){
+                if (candidate->ball){
 
 #ifdef BALL_DEBUG
-                        cout << "FOUND BALL" << endl;
-                        //cout << "ball.rr.distance(): " << it->ball.rr.distance() << " ball.rr.heading(): " << it->ball.rr.heading() << endl;
-                        cout << "ball.imageCoords[0]: " << itb->ball.imageCoords[0] << " ball.imageCoords[1]: " << itb->ball.imageCoords[1] << endl;
-                        cout << "ball.radius: " << itb->ball.radius << endl;
-                        cout << "ball.topCamera: " << itb->ball.topCamera << endl;
+                    cout << "FOUND BALL" << endl;
+                    //cout << "ball.rr.distance(): " << it->ball.rr.distance() << " ball.rr.heading(): " << it->ball.rr.heading() << endl;
+                    cout << "ball.imageCoords[0]: " << it->ball.imageCoords[0] << " ball.imageCoords[1]: " << it->ball.imageCoords[1] << endl;
+                    cout << "ball.radius: " << it->ball.radius << endl;
+                    cout << "ball.topCamera: " << it->ball.topCamera << endl;
 #endif // BALL_DEBUG
 #ifdef BALL_TO_FILE
-                        char name[] = "a";
-                        char location[] = BALL_TO_FILE_DIR;
-                        stringstream dir;
-                        dir << location << num_images << ".png";
-                        num_images++;
-                        cout << "Writing binary ball image to: " << dir.str().c_str() << "\n";
-                        WriteImage w;
-                        if(w.writeImage(*itb->region, COLOUR_FORMAT, dir.str().c_str(), name)) {
-                            cout << "Success\n";
-                        }
-                        else {
-                            cout << "Failed\n";
-                        }
+                    char name[] = "a";
+                    char location[] = BALL_TO_FILE_DIR;
+                    stringstream dir;
+                    dir << location << num_images << ".png";
+                    num_images++;
+                    cout << "Writing binary ball image to: " << dir.str().c_str() << "\n";
+                    WriteImage w;
+                    if(w.writeImage(*it->region, COLOUR_FORMAT, dir.str().c_str(), name)) {
+                        cout << "Success\n";
+                    }
+                    else {
+                        cout << "Failed\n";
+                    }
 #endif  // BALL_TO_FILE
 
-                        // Set the ball back to the region
-                        Point center = itb->region->getInternalFovea()->mapFoveaToImage(Point(itb->circle_fit.result_circle.centre.x(),itb->circle_fit.result_circle.centre.y()));
-                        itb->ball.imageCoords.x() = center.x();
-                        itb->ball.imageCoords.y() = center.y();
+                    // Set the ball back to the region
+                    Point center = it->region->getInternalFovea()->mapFoveaToImage(Point(it->circle_fit.result_circle.centre.x(),it->circle_fit.result_circle.centre.y()));
+                    it->ball.imageCoords.x() = center.x();
+                    it->ball.imageCoords.y() = center.y();
 
-                        itb->ball.topCamera = (itb->region->isTopCamera());
-                        itb->ball.radius = (itb->circle_fit.result_circle.radius * itb->region->getDensity());
+                    it->ball.topCamera = (it->region->isTopCamera());
+                    it->ball.radius = (it->circle_fit.result_circle.radius * it->region->getDensity());
 
-                        // HACK FOR Seeing FP Balls off the field, and in goals (@ijnek)
-                        const AbsCoord &robotPos = info_in.robotPose;
-                        const RRCoord &ballPosRR = it->ball.rr;
+                    // A blobROI ball reports the ball of the combo ROI candidate it
+                    // was found in.
+                    const BallDetectorVisionBundle &reported = candidate->parent_list < 0 ? *it :
+                        search.lists[candidate->parent_list][candidate->parent_index];
 
-                        float ballX = robotPos.x() + ballPosRR.distance() * cosf(robotPos.theta() + ballPosRR.heading());
-                        float ballY = robotPos.y() + ballPosRR.distance() * sinf(robotPos.theta() + ballPosRR.heading());
+                    // HACK FOR Seeing FP Balls off the field, and in goals (@ijnek)
+                    const AbsCoord &robotPos = info_in.robotPose;
+                    const RRCoord &ballPosRR = reported.ball.rr;
 
-                        if (abs(ballX) < FIELD_LENGTH / 2.0 + 300 && abs(ballY) < FIELD_WIDTH / 2.0 + 300)
-                        {
-                            info_out.balls.push_back(it->ball);
-                        }
-#ifdef EARLY_EXIT
-        // We don't want to early exit while using vdm
-#ifdef BALL_DETECTOR_USES_VDM
-                        if (vdm == NULL) {
-                            clearBDVBs(ball_regions_blob);
-                            return;
-                        }
-#else
-                        clearBDVBs(ball_regions_blob);
-                        return;
-#endif // BALL_DETECTOR_USES_VDM
-#endif // EARLY_EXIT
+                    float ballX = robotPos.x() + ballPosRR.distance() * cosf(robotPos.theta() + ballPosRR.heading());
+                    float ballY = robotPos.y() + ballPosRR.distance() * sinf(robotPos.theta() + ballPosRR.heading());
+
+                    if (abs(ballX) < FIELD_LENGTH / 2.0 + 300 && abs(ballY) < FIELD_WIDTH / 2.0 + 300)
+                    {
+                        info_out.balls.push_back(reported.ball);
                     }
+                    found = early_exit;
+                }
 #ifdef BALL_DETECTOR_USES_VDM
-                    if (vdm != NULL) {
-                        VisionDebugQuery q = vdm->getQuery();
-                        cout << "REGION " << region_index << "/" << q.region_index << endl;
-                        cout << "SUBREGION " << subregion_index_blob << "/" << q.subregion_index_blob << endl;
-                        if (region_index == q.region_index && subregion_index_blob == q.subregion_index_blob) {
-                            itb->drawBall();
-                        }
+                if (vdm != NULL) {
+                    VisionDebugQuery q = vdm->getQuery();
+                    cout << "REGION " << candidate->region_index << "/" << q.region_index << endl;
+                    cout << "SUBREGION " << candidate->subregion_index << "/" << q.subregion_index << endl;
+                    if (candidate->region_index == q.region_index &&
+                            candidate->subregion_index == q.subregion_index) {
+                        it->drawBall();
                     }
-#endif // BALL_DETECTOR_USES_VDM
                 }
-                clearBDVBs(ball_regions_blob);
+#endif // BALL_DETECTOR_USES_VDM
             }
         }
-        clearBDVBs(ball_regions);
+
+        searched = last;
+    }
+    if (out_of_time && !found) {
+        schedule->skip("Ball", num_regions - searched);
     }
 
+    for (unsigned int i = 0; i < searched; ++i) {
+        for (int list = 0; list < searches_[i].num_lists; ++list) {
+            clearBDVBs(searches_[i].lists[list]);
+        }
+        searches_[i].num_lists = 0;
+    }
+
+    // A frame that searched past the tracked ROIs was a full sweep.
+    if (searched > num_tracked || num_tracked == 0) {
+        frames_since_sweep_ = 0;
+    } else {
+        ++frames_since_sweep_;
+    }
+
+    // Track the first ball reported, or lose the track if there was none.
+    track_valid_ = tracking_interval_ > 0 && info_out.balls.size() > num_balls;
+    if (track_valid_) {
+        const RRCoord &rr = info_out.balls[num_balls].rr;
+        track_x_ = rr.distance() * cosf(rr.heading());
+        track_y_ = rr.distance() * sinf(rr.heading());
+    }
+    last_odometry_ = info_in.odometry;
+
 #ifdef BALL_DETECTOR_TIMINGS
     frame_time += frame_timer.elapsed_us();
 
@@ -811,6 +885,230 @@ static inline double checkRegionAspectRatio(const RegionI& region, BallDetectorV
     return (double) region.getCols()/region.getRows();
 }
 
+void BallDetector::runWave_(unsigned int first, unsigned int last, bool blobs,
+                            const VisionInfoIn& info_in, const VisionInfoMiddle& info_middle,
+                            VisionInfoOut& info_out) {
+    const unsigned int stride = min(last - first, (unsigned int)workers_.size() + 1);
+    jobs_.clear();
+    for (unsigned int job = 0; job < stride; ++job) {
+        jobs_.push_back(boost::bind(&BallDetector::searchROIs_, this,
+                job == 0 ? this : workers_[job - 1], first + job, last,
+                stride, blobs, &info_in, &info_middle, &info_out));
+    }
+    pool_->run(jobs_);
+}
+
+void BallDetector::searchROIs_(BallDetector* worker, unsigned int first, unsigned int last,
+                               unsigned int stride, bool blobs, const VisionInfoIn* info_in,
+                               const VisionInfoMiddle* info_middle, VisionInfoOut* info_out) {
+    FrameArena::Scope scope(*worker->arena_);
+    for (unsigned int i = first; i < last; i += stride) {
+        if (blobs) {
+            worker->searchBlobs_(*info_in, *info_middle, *info_out, order_[i], searches_[i]);
+        } else {
+            worker->searchROI_(*info_in, info_middle->roi[order_[i]], *info_middle,
+                               *info_out, order_[i], searches_[i]);
+        }
+    }
+}
+
+void BallDetector::classifyWave_(unsigned int first, unsigned int last, bool blobs) {
+#ifndef CTC_2_1
+    classifier_->clear();
+    for (unsigned int i = first; i < last; ++i) {
+        RoiSearch &search = searches_[i];
+        const unsigned int end = blobs ? search.candidates.size() : search.num_combo;
+        for (unsigned int c = blobs ? search.num_combo : 0; c < end; ++c) {
+            BallCandidate &candidate = search.candidates[c];
+            if (candidate.inspected) {
+                candidate.classifier_index = classifier_->add(
+                    *search.lists[candidate.list][candidate.index].modelRegion);
+            }
+        }
+    }
+
+#ifdef BALL_DETECTOR_TIMINGS
+    timer2.restart();
+#endif // BALL_DETECTOR_TIMINGS
+    classifier_->classify();
+#ifdef BALL_DETECTOR_TIMINGS
+    gmm_classifier_count += classifier_->size();
+    gmm_classifier_time += timer2.elapsed_us();
+#endif // BALL_DETECTOR_TIMINGS
+#endif // CTC_2_1
+
+    for (unsigned int i = first; i < last; ++i) {
+        RoiSearch &search = searches_[i];
+        const unsigned int end = blobs ? search.candidates.size() : search.num_combo;
+        for (unsigned int c = blobs ? search.num_combo : 0; c < end; ++c) {
+            BallCandidate &candidate = search.candidates[c];
+            candidate.ball = candidate.inspected;
+#ifndef CTC_2_1
+            candidate.ball = candidate.ball && classifier_->isBall(candidate.classifier_index);
+#endif // CTC_2_1
+        }
+    }
+}
+
+bool BallDetector::predictTrackingWindow_(const VisionInfoIn& info_in, VisionInfoOut& info_out,
+                                          BBox& window) {
+    if (!track_valid_ || frames_since_sweep_ + 1 >= tracking_interval_ || offNao) {
+        return false;
+    }
+#ifdef BALL_DETECTOR_USES_VDM
+    // The debugger picks its region from a full sweep.
+    if (vdm != NULL) {
+        return false;
+    }
+#endif // BALL_DETECTOR_USES_VDM
+
+    // Move the ball by the odometry since the last frame, as the ball
+    // filter does.
+    const Odometry delta = info_in.odometry - last_odometry_;
+    const float x = track_x_ - delta.forward;
+    const float y = track_y_ - delta.left;
+    const float cos_turn = cosf(delta.turn);
+    const float sin_turn = sinf(delta.turn);
+
+    // Undo the distance and lean corrections getSizeEst makes, and project
+    // the ball's centre, not the ground under it, as getSizeEst measured it.
+    const float scale = (float)BALL_DISTANCE_ERROR_RANGE /
+        (BALL_DISTANCE_ERROR_RANGE - BALL_DISTANCE_ERROR);
+    Point predicted = info_in.cameraToRR.pose.robotToImageXY(Point(
+        scale * (x * cos_turn + y * sin_turn),
+        scale * (-x * sin_turn + y * cos_turn) +
+            BALL_LEAN_HEIGHT * tan(info_in.latestAngleX)), BALL_RADIUS);
+
+    const bool top = predicted.y() < TOP_IMAGE_ROWS;
+    if (predicted.x() < 0 || predicted.x() >= (top ? TOP_IMAGE_COLS : BOT_IMAGE_COLS) ||
+            predicted.y() < 0 || predicted.y() >= TOP_IMAGE_ROWS + BOT_IMAGE_ROWS) {
+        return false;
+    }
+
+    const int half = max((int)(getDiamInImage(info_out, predicted) * TRACKING_WINDOW_DIAMETERS),
+                         TRACKING_WINDOW_MIN);
+    window.a = Point(predicted.x() - half, predicted.y() - half);
+    window.b = Point(predicted.x() + half, predicted.y() + half);
+    return true;
+}
+
+bool BallDetector::overlapsWindow_(const RegionI& region, const BBox& window) {
+    BBox box = region.getBoundingBoxRaw();
+    if (!region.isTopCamera()) {
+        box.a.y() += TOP_IMAGE_ROWS;
+        box.b.y() += TOP_IMAGE_ROWS;
+    }
+    return box.a.x() < window.b.x() && window.a.x() < box.b.x() &&
+           box.a.y() < window.b.y() && window.a.y() < box.b.y();
+}
+
+void BallDetector::searchROI_(const VisionInfoIn& info_in, const RegionI& region,
+                              const VisionInfoMiddle& info_middle, VisionInfoOut& info_out,
+                              unsigned int region_index, RoiSearch& search) {
+    search.num_lists = 0;
+    search.candidates.clear();
+
+    // This is our internal ROI
+
+    int combo_list = newBundleList_(search);
+#ifdef BALL_DETECTOR_USES_VDM
+    if (vdm != NULL) {
+        VisionDebugQuery q = vdm->getQuery();
+        if (region_index == q.region_index) {
+            vdm->vision_debug_blackboard.values["Draw This Region"] = 1;
+        } else {
+            vdm->vision_debug_blackboard.values["Draw This Region"] = 0;
+        }
+    }
+#endif // BALL_DETECTOR_USES_VDM
+
+#ifdef BALL_DETECTOR_TIMINGS
+    timer.restart();
+#endif // BALL_DETECTOR_TIMINGS
+
+    comboROI(info_in, region, info_middle, info_out, true, search.lists[combo_list]);
+
+#ifdef BALL_DETECTOR_TIMINGS
+    roi_count++;
+    roi_time += timer.elapsed_us();
+#endif // BALL_DETECTOR_TIMINGS
+
+    //cout << "SUB_BALLS " << search.lists[combo_list].size() << endl;
+    for (unsigned int i = 0; i < search.lists[combo_list].size(); ++i) {
+        addCandidate_(search, combo_list, i, -1, -1, region_index, i + 1);
+    }
+    search.num_combo = search.candidates.size();
+}
+
+void BallDetector::searchBlobs_(const VisionInfoIn& info_in, const VisionInfoMiddle& info_middle,
+                                VisionInfoOut& info_out, unsigned int region_index,
+                                RoiSearch& search) {
+    // comboROI's bundles are always the first list.
+    const int combo_list = 0;
+
+    // If inspect fails and the region aspect was deemed to be normal
+    // we should let blobROI find the ball and rerun detect() on the
+    // regions created by blobROI.
+    for (unsigned int i = 0; i < search.lists[combo_list].size(); ++i) {
+        if (search.lists[combo_list][i].region_aspect_type == NORMAL) {
+
+#ifdef BALL_DEBUG
+            cout << "Normal Region failed, retrying with blobROI\n";
+#endif //BALL_DEBUG
+
+            int blob_list = newBundleList_(search);
+            const BallDetectorVisionBundle &bdvb = search.lists[combo_list][i];
+#ifdef BALL_DETECTOR_TIMINGS
+            timer2.restart();
+#endif // BALL_DETECTOR_TIMINGS
+            blobROI(info_in, *bdvb.original_region, info_middle, info_out,
+                    search.lists[blob_list], bdvb.region_aspect_type);
+#ifdef BALL_DETECTOR_TIMINGS
+            blob_roi_count++;
+            blob_roi_time += timer2.elapsed_us();
+#endif // BALL_DETECTOR_TIMINGS
+
+            for (unsigned int j = 0; j < search.lists[blob_list].size(); ++j) {
+                addCandidate_(search, blob_list, j, combo_list, i, region_index, j + 1);
+            }
+        }
+    }
+}
+
+int BallDetector::newBundleList_(RoiSearch& search) {
+    if (search.num_lists == (int)search.lists.size()) {
+        search.lists.push_back(vector<BallDetectorVisionBundle>());
+    }
+    search.lists[search.num_lists].clear();
+    return search.num_lists++;
+}
+
+void BallDetector::addCandidate_(RoiSearch& search, int list, int index, int parent_list,
+                                 int parent_index, unsigned int region_index,
+                                 unsigned int subregion_index) {
+    BallDetectorVisionBundle &bdvb = search.lists[list][index];
+    BallCandidate candidate;
+    candidate.list = list;
+    candidate.index = index;
+    candidate.parent_list = parent_list;
+    candidate.parent_index = parent_index;
+    candidate.region_index = region_index;
+    candidate.subregion_index = subregion_index;
+
+#ifdef BALL_DETECTOR_TIMINGS
+    timer.restart();
+#endif // BALL_DETECTOR_TIMINGS
+    candidate.inspected = inspectBall(bdvb);
+#ifdef BALL_DETECTOR_TIMINGS
+    inspect_ball_count++;
+    inspect_ball_time += timer.elapsed_us();
+#endif // BALL_DETECTOR_TIMINGS
+
+    candidate.classifier_index = -1;
+    candidate.ball = false;
+    search.candidates.push_back(candidate);
+}
+
 // ComboROI
 // Routes the region of interest to the correct internal ROI finder based on its size and location.
 bool BallDetector::comboROI(const VisionInfoIn& info_in, const RegionI& region, const VisionInfoMiddle& info_middle,
@@ -992,7 +1290,7 @@ bool BallDetector::blackROI(const VisionInfoIn& info_in, const RegionI& region,
 
     for(int pixel=0; pixel < cols*rows; ++pixel)
     {
-        if (*cur_point.raw() < darkest_pixel) {
+        if (cur_point.getY() < darkest_pixel) {
             //cout << x << ", " << y << "\n";
             min_x = x;
             max_x = x;
@@ -1000,7 +1298,7 @@ bool BallDetector::blackROI(const VisionInfoIn& info_in, const RegionI& region,
             max_y = y;
 
             first = false;
-            darkest_pixel = *(cur_point.raw());
+            darkest_pixel = cur_point.getY();
 
         }
 
@@ -1351,13 +1649,8 @@ bool BallDetector::circleROI(const VisionInfoIn& info_in, const RegionI& region,
     float e = max((int) (radius * 0.1), 1); // 5.0; // was 15.0
     uint16_t n = max((int) (2.5 * radius), 20);
 
-    vector<bool> *con, cons_buf[2];
-    cons_buf[0].resize(bdvb.circle_fit_points.size());
-    cons_buf[1].resize(bdvb.circle_fit_points.size());
-    con = &cons_buf[0];
-
     int BALL_SIZE_PIXELS = 9;
-    findBestCircleFit(bdvb, BALL_SIZE_PIXELS, &con, cons_buf, e, n, 0.7, 2, bdvb.partial_ball_side);
+    findBestCircleFit(bdvb, BALL_SIZE_PIXELS, e, n, 0.7, 2, bdvb.partial_ball_side);
 
     if (bdvb.region->getRows() < 0 || bdvb.region->getCols() < 0) {
 #ifdef BALL_DEBUG
@@ -1626,6 +1919,8 @@ bool BallDetector::inspectBall(BallDetectorVisionBundle &bdvb){
 #ifdef BALL_DETECTOR_TIMINGS
     timer2.restart();
 #endif // BALL_DETECTOR_TIMINGS
+    // Otherwise the CNN classifies everything that gets this far, in one
+    // batch in detect.
     #ifdef CTC_2_1
     if (estimator.predict(*bdvb.modelRegion) == CLASSIFIER_FALSE) {
 #ifdef BALL_DEBUG
@@ -1633,20 +1928,12 @@ bool BallDetector::inspectBall(BallDetectorVisionBundle &bdvb){
 #endif //BALL_DEBUG
         return false;
     }
-    #else
-    Eigen::MatrixXf imageMat = convertMat(*bdvb.modelRegion);
-    Eigen::MatrixXf resized = dnn_resize(imageMat, 32, 32);
-    int classification = dnn_predict(resized, nn);
-    if (classification == 0){
-        return false;
-    }
-
-    #endif
 
 #ifdef BALL_DETECTOR_TIMINGS
     gmm_classifier_count++;
     gmm_classifier_time += timer2.elapsed_us();
 #endif // BALL_DETECTOR_TIMINGS
+    #endif
 
     return true; // Yay, made it!!
 }
@@ -1774,26 +2061,27 @@ void BallDetector::processInternalRegions(const RegionI& base_region, BallDetect
     max_internal_group_size = area_circle * 0.2;
 
     // Count the number of groups that do not touch the edge.
-    for(int group=0; group<group_links_.size(); ++group)
+    const std::vector<ConnectedComponents::Component>& groups = components_.components();
+    for(unsigned int group=0; group<groups.size(); ++group)
     {
-        if(group_counts_[group] > min_internal_group_size &&
-                group_counts_[group] < max_internal_group_size)
+        if(groups[group].area > min_internal_group_size &&
+                groups[group].area < max_internal_group_size)
             {
                 InternalRegion r;
-            r.num_pixels = group_counts_[group];
-            r.min_x = group_low_xs_[group];
-            r.max_x = group_high_xs_[group];
-            r.min_y = group_low_ys_[group];
-            r.max_y = group_high_ys_[group];
+            r.num_pixels = groups[group].area;
+            r.min_x = groups[group].min_x;
+            r.max_x = groups[group].max_x;
+            r.min_y = groups[group].min_y;
+            r.max_y = groups[group].max_y;
 
             if (
-                (DISTANCE_SQR(centre_x, centre_y, group_low_xs_[group], group_low_ys_[group])
+                (DISTANCE_SQR(centre_x, centre_y, r.min_x, r.min_y)
                     < result_circle.radius * result_circle.radius) &&
-                (DISTANCE_SQR(centre_x, centre_y, group_low_xs_[group], group_high_ys_[group])
+                (DISTANCE_SQR(centre_x, centre_y, r.min_x, r.max_y)
                     < result_circle.radius * result_circle.radius) &&
-                (DISTANCE_SQR(centre_x, centre_y, group_high_xs_[group], group_low_ys_[group])
+                (DISTANCE_SQR(centre_x, centre_y, r.max_x, r.min_y)
                     < result_circle.radius * result_circle.radius) &&
-                (DISTANCE_SQR(centre_x, centre_y, group_high_xs_[group], group_high_ys_[group])
+                (DISTANCE_SQR(centre_x, centre_y, r.max_x, r.max_y)
                     < result_circle.radius * result_circle.radius)) {
                 r.completely_internal = true;
                 internal_region_features.num_internal_regions++;
@@ -1853,20 +2141,21 @@ void BallDetector::processInternalRegionsROI(const RegionI &base_region, BallDet
     int cur_den_err;
 
     // Count the number of groups that might be blobby.
-    for(int group=0; group<group_links_.size(); ++group)
+    const std::vector<ConnectedComponents::Component>& groups = components_.components();
+    for(unsigned int group=0; group<groups.size(); ++group)
     {
-        if(group_counts_[group] > min_internal_group_size &&
-                group_counts_[group] < max_internal_group_size)
+        if(groups[group].area > min_internal_group_size &&
+                groups[group].area < max_internal_group_size)
         {
             InternalRegion r;
-            r.num_pixels = group_counts_[group];
-            r.min_x = group_low_xs_[group];
-            r.max_x = group_high_xs_[group];
-            r.min_y = group_low_ys_[group];
-            r.max_y = group_high_ys_[group];
+            r.num_pixels = groups[group].area;
+            r.min_x = groups[group].min_x;
+            r.max_x = groups[group].max_x;
+            r.min_y = groups[group].min_y;
+            r.max_y = groups[group].max_y;
 
-            float x_size = (group_high_xs_[group] - group_low_xs_[group]);
-            float y_size = (group_high_ys_[group] - group_low_ys_[group]);
+            float x_size = (r.max_x - r.min_x);
+            float y_size = (r.max_y - r.min_y);
 
             //If the aspect ratio of the blob not blobby enough, throw out
             float aspect = x_size / y_size;
@@ -1978,7 +2267,7 @@ bool BallDetector::analyseBallRawRange(BallDetectorVisionBundle &bdvb) {
     return (abs(bdvb.max_y_value - bdvb.min_y_value) < BALL_Y_RANGE_THRESHOLD);
 }
 
-void BallDetector::findBestCircleFit(BallDetectorVisionBundle &bdvb, float max_radius, vector<bool> **cons, vector <bool> cons_buf[2], float e, unsigned int n,
+void BallDetector::findBestCircleFit(BallDetectorVisionBundle &bdvb, float max_radius, float e, unsigned int n,
         float min_radius_prop, float step_size, PartialBallSide partial_ball_side) {
     // Systematically start from radius equal to half the columns and slowly reducing the radius
     // Try all centres such that the circle wholly fits inside the region
@@ -2007,8 +2296,8 @@ void BallDetector::findBestCircleFit(BallDetectorVisionBundle &bdvb, float max_r
     float minerr = numeric_limits<float>::max();
     c.var = numeric_limits<float>::max();
 
-    vector<bool> *best_concensus, *this_concensus;
-    best_concensus = &cons_buf[0];
+    // Every centre is scored against the same points.
+    const RANSAC::PointSet points(bdvb.circle_fit_points);
     //cout << "Cols: " << bdvb.region->getCols() << " Rows: " << bdvb.region->getRows() << "\n";
 
     while (curr_radius > min_radius_prop * max_radius) {
@@ -2036,57 +2325,18 @@ void BallDetector::findBestCircleFit(BallDetectorVisionBundle &bdvb, float max_r
                 //cout << "Centre: " << centre_x << "," << centre_y << " rad: " << curr_radius << "\n";
                 c.centre = PointF(centre_x, centre_y);
 
-                if (best_concensus == &cons_buf[0]) {
-                    this_concensus = &cons_buf[1];
-                } else {
-                   this_concensus = &cons_buf[0];
-                }
-
-                for (j = 0; j < 4; ++ j) {
-                   pos_var[j] = neg_var[j] = 0;
+                // Centres that cannot reach n points are dropped part way.
+                unsigned int n_concensus_points = RANSAC::scoreCircleQuadrants(points,
+                    c.centre, c.radius, e2, n, NULL, pos_var, neg_var);
+                if (n_concensus_points < n) {
+                    centre_y += step_size;
+                    continue;
                 }
-
-                unsigned int n_concensus_points = 0;
+#ifdef BALL_DEBUG
                 set <int> x_values;
                 set <int> y_values_l;
                 set <int> y_values_r;
-
-                for (j = 0; j != bdvb.circle_fit_points.size(); ++ j) {
-                   const PointF &p = bdvb.circle_fit_points[j].cast<float>();
-                   const PointF &d = c.centre - p;
-
-                   // Technically incorrect, but faster than a sqrt.
-                    float dist = d.norm() - c.radius;
-                    float dist2 = dist*dist;
-
-                    if (dist2 < e2) {
-                        int quadrant = 0;
-                        if (d.x() > 0) {
-                            if (d.y() > 0) {
-                                quadrant = 0;
-                            } else {
-                                quadrant = 3;
-                            }
-                        } else {
-                            if (d.y() > 0) {
-                                quadrant = 1;
-                            } else {
-                                quadrant = 2;
-                            }
-                        }
-
-                        if (dist > 0) {
-                            pos_var[quadrant] += dist2;
-                        } else {
-                            neg_var[quadrant] += dist2;
-                        }
-
-                        ++ n_concensus_points;
-                        (*this_concensus)[j] = true;
-                    } else {
-                        (*this_concensus)[j] = false;
-                    }
-                }
+#endif // BALL_DEBUG
 
                 const float k = 0.2;
 
@@ -2112,7 +2362,6 @@ void BallDetector::findBestCircleFit(BallDetectorVisionBundle &bdvb, float max_r
                     minerr = c.var;
                     c.var  = c.var / (bdvb.circle_fit_points.size() * e);
                     bdvb.circle_fit.result_circle = c;
-                    best_concensus = this_concensus;
 
                         // Select the first one that meets the requirements
 
@@ -2633,7 +2882,7 @@ void BallDetector::getSizeEst(BallDetectorVisionBundle &bdvb, const VisionInfoIn
     Point b = info_out.cameraToRR->pose.imageToRobotXY(pointForRR, BALL_RADIUS);
 
     // Account for robot leaning, if necessary
-    float diff = 190*tan(info_in.latestAngleX);
+    float diff = BALL_LEAN_HEIGHT*tan(info_in.latestAngleX);
     b.y() -= diff;
 
     RRCoord rr;
@@ -2641,8 +2890,7 @@ void BallDetector::getSizeEst(BallDetectorVisionBundle &bdvb, const VisionInfoIn
     rr.setHeading(atan2f(b.y(), b.x()));
     bdvb.ball.rr = rr;
 
-    float robot_height = 500;
-    float error = 30 * bdvb.ball.rr.distance() / robot_height;
+    float error = BALL_DISTANCE_ERROR * bdvb.ball.rr.distance() / BALL_DISTANCE_ERROR_RANGE;
     bdvb.ball.rr.setDistance(bdvb.ball.rr.distance() - error);
 
     XYZ_Coord neckRelative =
@@ -2750,477 +2998,52 @@ string BallDetector::getFeatureSummary(VisionInfoOut& info_out, BallDetectorVisi
 }
 
 // **************************** CONNECTED COMPONENT ANALYSIS *******************************************
+namespace {
+
+// Non white pixels between a left and right column, inclusive, on each row.
+struct NotWhiteInSpans {
+    NotWhiteInSpans(const int* lefts, const int* rights) :
+        lefts(lefts), rights(rights) {}
+    bool operator()(int x, int y, Colour colour) const {
+        return x >= lefts[y] && x <= rights[y] && colour != cWHITE;
+    }
+    const int* lefts;
+    const int* rights;
+};
+
+}
+
 // CCA for regions inside a circle
 void BallDetector::connectedComponentAnalysisNotWhiteAndInside(const RegionI& base_region,
     BallDetectorVisionBundle &bdvb,
     RANSACCircle &circle)
 {
-    // Reset group_links for use.
-    group_links_.fullReset();
-
-    // Clear the data vectors (hopefully leaving space allocated).
-
-    // The number of pixels in each group.
-    group_counts_.clear();
-
-    // The smallest x value in each group.
-    group_low_xs_.clear();
-
-    // The largest x value in each group.
-    group_high_xs_.clear();
-
-    // The smallest y value in each group.
-    group_low_ys_.clear();
-
-    // The largest y value in each group.
-    group_high_ys_.clear();
-
-    // Set to USHRT_MAX when there is no neighbour.
-    uint16_t top_neighbour = USHRT_MAX;
-    uint16_t left_neighbour = USHRT_MAX;
-    bool has_neighbour = false;
-
-    // Iterator that move through the region.
-    RegionI::iterator_fovea cur_point = base_region.begin_fovea();
-
-    // Track the literal location of the iterators.
-    int x = 0;
-    int y = 0;
-
-    // A pointer tracking through the underlying array of groups.
-    uint16_t* group = groups_;
-
     // The number of rows and columns in the region.
     int rows = base_region.getRows();
     int cols = base_region.getCols();
 
-    // Connected component analysis.
-
-    // Critical points where the x value is inside the circle
-    int critical_point_left;
-    int critical_point_right;
-    int critical_point_above_left = 0;
-    int critical_point_above_right = 0;
-
-    bool groupCapHit = false;
-
-    for(int pixel=0; pixel < cols*rows && !groupCapHit;)
-    {
-        critical_point_left = calculateCircleLeft(y, cols, circle);
-        // If calculateCircleLeft has returned cols then there is no circle on this row
-        // Increment all counters and continue the main loop
-        if (critical_point_left == cols) {
-            for (int i = 0; i < cols; i++) {
-                ++x;
-                ++group;
-                ++cur_point;
-                ++pixel;
-            }
-            if(x == cols)
-            {
-                // Store the previous critical point
-                critical_point_above_left = critical_point_left;
-                x = 0;
-                ++y;
-            }
-            continue;
-        }
-        // Else increment counters to the critical point
-        while (x < critical_point_left) {
-            ++x;
-            ++group;
-            ++cur_point;
-            ++pixel;
-        }
-        // Find the next critical point and do regular CCA up to and including it
-        critical_point_right = calculateCircleRight(y, cols, circle);
-        while (x <= critical_point_right) {
-            //Normal Connected component analysis.
-            // If this is not a white pixel, group it.
-            if (cur_point.colour() != cWHITE)
-            {
-                // Get all neighbours.
-                has_neighbour = false;
-                // Check: the left pixel exists, the left pixel is not past the crit point, the left pixel != cWHITE
-                if ((x > critical_point_left) && (cur_point.colourLeft() != cWHITE))
-                {
-                    left_neighbour = *(group-1);
-                    has_neighbour = true;
-                }
-                else
-                    left_neighbour = USHRT_MAX;
-                // Check: the above pixel exists, the above row is some part in the circle,
-                // the above pixel is between the critical points, the above pixel != cWHITE
-                if ((y != 0) && (critical_point_above_left != cols) && (x >= critical_point_above_left) && (x <= critical_point_above_right) &&
-                    (cur_point.colourAbove() != cWHITE))
-                {
-                    top_neighbour = *(group-cols);
-                    has_neighbour = true;
-                }
-                else
-                    top_neighbour = USHRT_MAX;
-
-                // If there are no neighbours create a new label.
-                if(!has_neighbour)
-                {
-                    // Try to add the new group. If this fails, the group cap has
-                    // been hit and CCA should terminate.
-                    if(!group_links_.newGroup())
-                    {
-                        groupCapHit = true;
-                        break;
-                    }
-
-                    *group = group_links_.size()-1;
-                    group_low_xs_.push_back(x);
-                    group_high_xs_.push_back(x);
-                    group_low_ys_.push_back(y);
-                    group_high_ys_.push_back(y);
-                    group_counts_.push_back(1);
-                }
-                // If there is a neighbour build components.
-                else
-                {
-                    if(top_neighbour < left_neighbour)
-                    {
-                        // Set the pixel's group.
-                        *group = top_neighbour;
-
-                        // Add a parent to the left neighbour if needed.
-                        if(left_neighbour != USHRT_MAX)
-                        {
-                            bool new_link;
-                            new_link = group_links_.addLink(left_neighbour,
-                                                                    top_neighbour);
-                            if(new_link)
-                            {
-                                push_heap(group_links_.begin(left_neighbour),
-                                        group_links_.end(left_neighbour),
-                                                            greater<int>());
-                            }
-                        }
-
-                        // Update bounding box.
-                        group_counts_[top_neighbour] += 1;
-                        if(group_high_xs_[top_neighbour] < x) {
-                            group_high_xs_[top_neighbour] = x;
-                        }
-                        if(group_high_ys_[top_neighbour] < y) {
-                            group_high_ys_[top_neighbour] = y;
-                        }
-                    }
-                    else
-                    {
-                        // Set the pixel's group.
-                        *group = left_neighbour;
-
-                        // Add a parent to the top neighbour if needed.
-                        if(top_neighbour != USHRT_MAX)
-                        {
-                            bool new_link;
-                            new_link = group_links_.addLink(top_neighbour,
-                                                                    left_neighbour);
-                            if(new_link)
-                            {
-                                push_heap(group_links_.begin(top_neighbour),
-                                        group_links_.end(top_neighbour),
-                                                            greater<int>());
-                            }
-                        }
-
-                        // Update bounding box.
-                        group_counts_[left_neighbour] += 1;
-                        if(group_high_xs_[left_neighbour] < x)
-                            group_high_xs_[left_neighbour] = x;
-                        if(group_high_ys_[left_neighbour] < y)
-                            group_high_ys_[left_neighbour] = y;
-                    }
-                }
-            }
-            ++x;
-            ++group;
-            ++cur_point;
-            ++pixel;
-        }
-        while (x < cols) {
-            ++x;
-            ++group;
-            ++cur_point;
-            ++pixel;
-        }
-        if(x == cols)
-        {
-            // Store the previous critical points
-            critical_point_above_left = critical_point_left;
-            critical_point_above_right = critical_point_right;
-            x = 0;
-            ++y;
-        }
-    }
-
-    // Don't need a full second pass as we only need bounding boxes. Combining
-    // by grabbing pixel location extremes is sufficient. May be a faster way
-    // to implement this.
-
-    // Find the parent group for each group.
-    bool changed = true;
-    while(changed)
-    {
-        changed = false;
-        for(int group=0; group<group_links_.size(); group++)
-        {
-            // Tell all linked groups the lowest linked group.
-            for(int owner=1; owner<group_links_.size(group); owner++)
-            {
-                // Insert in sorted order.
-                changed = true;
-                if(group_links_.get(group, owner) != group)
-                {
-                    bool new_link;
-                    new_link = group_links_.addLink(group_links_.get(group, owner),
-                                                    group_links_.get(group, 0));
-                    if(new_link)
-                    {
-                        push_heap(group_links_.begin(
-                            group_links_.get(group, owner)),
-                            group_links_.end(group_links_.get(group, owner)),
-                                                        greater<int>());
-                    }
-                }
-            }
-
-            // Delete all but the lowest owner.
-            group_links_.clearHigh(group);
+    // Critical points where the x value is inside the circle, for each row.
+    circle_lefts_.resize(rows);
+    circle_rights_.resize(rows);
+    for (int y = 0; y < rows; ++y) {
+        circle_lefts_[y] = calculateCircleLeft(y, cols, circle);
+        // If calculateCircleLeft has returned cols then there is no circle on
+        // this row
+        if (circle_lefts_[y] == cols) {
+            circle_rights_[y] = -1;
+        } else {
+            circle_rights_[y] = calculateCircleRight(y, cols, circle);
         }
     }
 
-    // Apply combinations.
-    for(int group=group_links_.size()-1; group>=0; group--)
-    {
-        int owner = group_links_.get(group, 0);
-        if(owner != group)
-        {
-            group_counts_[owner] += group_counts_[group];
-            group_counts_[group] = 0;
-            if(group_low_xs_[group] < group_low_xs_[owner])
-                group_low_xs_[owner] = group_low_xs_[group];
-            if(group_low_ys_[group] < group_low_ys_[owner])
-                group_low_ys_[owner] = group_low_ys_[group];
-            if(group_high_xs_[group] > group_high_xs_[owner])
-                group_high_xs_[owner] = group_high_xs_[group];
-            if(group_high_ys_[group] > group_high_ys_[owner])
-                group_high_ys_[owner] = group_high_ys_[group];
-        }
-    }
+    components_.label(base_region,
+                      NotWhiteInSpans(&circle_lefts_[0], &circle_rights_[0]));
 }
 
-//TODO: This function should probably be templated and combined with the above function
 // CCA for regions without a concern for a circle
 void BallDetector::connectedComponentAnalysisNotWhite(const RegionI& base_region, BallDetectorVisionBundle &bdvb)
 {
-    // Reset group_links for use.
-    group_links_.fullReset();
-
-    // Clear the data vectors (hopefully leaving space allocated).
-
-    // The number of pixels in each group.
-    group_counts_.clear();
-
-    // The smallest x value in each group.
-    group_low_xs_.clear();
-
-    // The largest x value in each group.
-    group_high_xs_.clear();
-
-    // The smallest y value in each group.
-    group_low_ys_.clear();
-
-    // The largest y value in each group.
-    group_high_ys_.clear();
-
-    // Set to USHRT_MAX when there is no neighbour.
-    uint16_t top_neighbour = USHRT_MAX;
-    uint16_t left_neighbour = USHRT_MAX;
-    bool has_neighbour = false;
-
-    // Iterator that move through the region.
-    RegionI::iterator_fovea cur_point = base_region.begin_fovea();
-
-    // Track the literal location of the iterators.
-    int x = 0;
-    int y = 0;
-
-    // A pointer tracking through the underlying array of groups.
-    uint16_t* group = groups_;
-
-    // The number of rows and columns in the region.
-    int rows = base_region.getRows();
-    int cols = base_region.getCols();
-    // Connected component analysis.
-
-    for(int pixel=0; pixel < cols*rows; ++pixel)
-    {
-        // If this is not a white pixel, group it.
-        if (cur_point.colour() != cWHITE)
-        {
-
-            // Get all neighbours.
-            has_neighbour = false;
-            if (x != 0 && (cur_point.colourLeft() != cWHITE))
-            {
-                left_neighbour = *(group-1);
-                has_neighbour = true;
-            }
-            else
-                left_neighbour = USHRT_MAX;
-
-            if (y != 0 && (cur_point.colourAbove() != cWHITE))
-            {
-                top_neighbour = *(group-cols);
-                has_neighbour = true;
-            }
-            else
-                top_neighbour = USHRT_MAX;
-
-            // If there are no neighbours create a new label.
-            if(!has_neighbour)
-            {
-                // Try to add the new group. If this fails, the group cap has
-                // been hit and CCA should terminate.
-                if(!group_links_.newGroup())
-                    break;
-
-                *group = group_links_.size()-1;
-                group_low_xs_.push_back(x);
-                group_high_xs_.push_back(x);
-                group_low_ys_.push_back(y);
-                group_high_ys_.push_back(y);
-                group_counts_.push_back(1);
-            }
-            // If there is a neighbour build components.
-            else
-            {
-                if(top_neighbour < left_neighbour)
-                {
-                    // Set the pixel's group.
-                    *group = top_neighbour;
-
-                    // Add a parent to the left neighbour if needed.
-                    if(left_neighbour != USHRT_MAX)
-                    {
-                        bool new_link;
-                        new_link = group_links_.addLink(left_neighbour,
-                                                                top_neighbour);
-                        if(new_link)
-                        {
-                            push_heap(group_links_.begin(left_neighbour),
-                                    group_links_.end(left_neighbour),
-                                                        greater<int>());
-                        }
-                    }
-
-                    // Update bounding box.
-                    group_counts_[top_neighbour] += 1;
-                    if(group_high_xs_[top_neighbour] < x) {
-                        group_high_xs_[top_neighbour] = x;
-                    }
-                    if(group_high_ys_[top_neighbour] < y) {
-                        group_high_ys_[top_neighbour] = y;
-                    }
-                }
-                else
-                {
-                    // Set the pixel's group.
-                    *group = left_neighbour;
-
-                    // Add a parent to the top neighbour if needed.
-                    if(top_neighbour != USHRT_MAX)
-                    {
-                        bool new_link;
-                        new_link = group_links_.addLink(top_neighbour,
-                                                                left_neighbour);
-                        if(new_link)
-                        {
-                            push_heap(group_links_.begin(top_neighbour),
-                                    group_links_.end(top_neighbour),
-                                                        greater<int>());
-                        }
-                    }
-
-                    // Update bounding box.
-                    group_counts_[left_neighbour] += 1;
-                    if(group_high_xs_[left_neighbour] < x)
-                        group_high_xs_[left_neighbour] = x;
-                    if(group_high_ys_[left_neighbour] < y)
-                        group_high_ys_[left_neighbour] = y;
-                }
-            }
-        }
-
-        ++x;
-        ++group;
-        ++cur_point;
-        if(x == cols)
-        {
-            x = 0;
-            ++y;
-        }
-    }
-
-    // Don't need a full second pass as we only need bounding boxes. Combining
-    // by grabbing pixel location extremes is sufficient. May be a faster way
-    // to implement this.
-
-    // Find the parent group for each group.
-    bool changed = true;
-    while(changed)
-    {
-        changed = false;
-        for(int group=0; group<group_links_.size(); group++)
-        {
-            // Tell all linked groups the lowest linked group.
-            for(int owner=1; owner<group_links_.size(group); owner++)
-            {
-                // Insert in sorted order.
-                changed = true;
-                if(group_links_.get(group, owner) != group)
-                {
-                    bool new_link;
-                    new_link = group_links_.addLink(group_links_.get(group, owner),
-                                                    group_links_.get(group, 0));
-                    if(new_link)
-                    {
-                        push_heap(group_links_.begin(
-                            group_links_.get(group, owner)),
-                            group_links_.end(group_links_.get(group, owner)),
-                                                        greater<int>());
-                    }
-                }
-            }
-
-            // Delete all but the lowest owner.
-            group_links_.clearHigh(group);
-        }
-    }
-
-    // Apply combinations.
-    for(int group=group_links_.size()-1; group>=0; group--)
-    {
-        int owner = group_links_.get(group, 0);
-        if(owner != group)
-        {
-            group_counts_[owner] += group_counts_[group];
-            group_counts_[group] = 0;
-            if(group_low_xs_[group] < group_low_xs_[owner])
-                group_low_xs_[owner] = group_low_xs_[group];
-            if(group_low_ys_[group] < group_low_ys_[owner])
-                group_low_ys_[owner] = group_low_ys_[group];
-            if(group_high_xs_[group] > group_high_xs_[owner])
-                group_high_xs_[owner] = group_high_xs_[group];
-            if(group_high_ys_[group] > group_high_ys_[owner])
-                group_high_ys_[owner] = group_high_ys_[group];
-        }
-    }
+    components_.label(base_region, NotWhite());
 }
 
 void BallDetector::getAverageBrightness(BallDetectorVisionBundle &bdvb)
@@ -3252,7 +3075,7 @@ void BallDetector::getAverageBrightness(BallDetectorVisionBundle &bdvb)
     for(int pixel = 0; pixel < cols*rows; ++pixel)
     {
         if (cur_point_fov.colour() == 1) {
-            total_raw += int(*cur_point_raw.raw());
+            total_raw += int(cur_point_raw.getY());
             whites++;
         }
         ++cur_point_fov;
@@ -3550,7 +3373,7 @@ void BallDetector::ballRawRange(BallDetectorVisionBundle &bdvb) {
     for(int pixel = 0; pixel < cols*rows; ++pixel)
     {
         if (DISTANCE_SQR((float)x, (float)y, circ_x, circ_y) < circ_r2) {       // If inside circle
-            currY = *cur_point.raw();
+            currY = cur_point.getY();
             minY = min(minY, currY);
             maxY = max(maxY, currY);
         }
@@ -3646,167 +3469,3 @@ int BallDetector::calculateCircleRight(int y, int cols, RANSACCircle c) {
     return crit_point;
 }
 
-#ifndef CTC_2_1
-tiny_dnn::network<sequential> BallDetector::load_3_layer_cnn(){
-
-    using conv     = tiny_dnn::convolutional_layer;
-    using max_pool = tiny_dnn::max_pooling_layer;
-    using fc       = tiny_dnn::fully_connected_layer;
-    using relu     = tiny_dnn::relu_layer;
-    using tiny_dnn::core::connection_table;
-
-
-    tiny_dnn::network<sequential> nn;
-    nn << conv(32,32,3,1,4) /* 32x32 in, 5x5 kernel, 1-6 fmaps conv */
-        << relu(30,30,4)
-        << max_pool(30, 30, 4, 2) /* 28x28 in, 6 fmaps, 2x2 subsampling */
-        << conv(15, 15, 3, 4, 8) // layer 3
-        << relu(13, 13, 8)
-        << max_pool(13, 13, 8, 2)
-        << conv(6, 6, 3, 8, 8, padding::valid, true, 2, 2) // layer 6
-        << relu(2, 2, 8)
-        << max_pool(2, 2, 8, 2)
-        << fc(1 * 1 * 8, 8) // layer 9
-        << relu(1, 1, 8)
-        << fc(8, 2);
-
-
-    // for (int i = 0; i < nn.depth(); i++)
-	// {
-	// 	std::cout << "#layer:" << i << "\n";
-	// 	std::cout << "layer type:" << nn[i]->layer_type() << "\n";
-	// 	std::cout << "input:" << nn[i]->in_data_size() << "(" << nn[i]->in_data_shape() << ")\n";
-	// 	std::cout << "output:" << nn[i]->out_data_size() << "(" << nn[i]->out_data_shape() << ")\n";
-
-	// }
-
-    std::string weight_path;
-    std::string bias_path;
-    std::string root_path = getHomeNao(DNN_WEIGHTS_DIR);
-
-    std::vector<vec_t*> weights_input_layer0 = nn[0]->weights();
-    weight_path = root_path + "conv_0_w.txt";
-    bias_path = root_path + "conv_0_b.txt";
-    Read_File(*weights_input_layer0[0], weight_path);
-    Read_File(*weights_input_layer0[1], bias_path);
-
-    weight_path = root_path + "conv_1_w.txt";
-    bias_path = root_path + "conv_1_b.txt";
-    std::vector<vec_t*> weights_layer0_layer1 = nn[3]->weights();
-    Read_File(*weights_layer0_layer1[0], weight_path);
-    Read_File(*weights_layer0_layer1[1], bias_path);
-
-    weight_path = root_path + "conv_2_w.txt";
-    bias_path = root_path + "conv_2_b.txt";
-    std::vector<vec_t*> weights_layer1_layer2 = nn[6]->weights();
-    Read_File(*weights_layer1_layer2[0], weight_path);
-    Read_File(*weights_layer1_layer2[1], bias_path);
-
-    weight_path = root_path + "fc_1_w.txt";
-    bias_path = root_path + "fc_1_b.txt";
-    std::vector<vec_t*> weights_layer2_layer3 = nn[9]->weights();
-    Read_File(*weights_layer2_layer3[0], weight_path);
-    Read_File(*weights_layer2_layer3[1], bias_path);
-
-    weight_path = root_path + "out_1_w.txt";
-    bias_path = root_path + "out_1_b.txt";
-    std::vector<vec_t*> weights_layer3_output = nn[11]->weights();
-    Read_File(*weights_layer3_output[0], weight_path);
-    Read_File(*weights_layer3_output[1], bias_path);
-
-    return nn;
-}
-
-Eigen::MatrixXf BallDetector::dnn_resize(Eigen::MatrixXf &img, int resize_height, int resize_width)
-{
-    /*
-	Resize the input image with Bilinear Interpolation method.
-
-	*/
-	int rows = img.rows();
-    int cols = img.cols();
-    float deltaX = (float)(rows) / resize_width;
-    float lastX = (0.5 * rows) / resize_width - 0.5;
-    // float x = lastX;
-    float deltaY = (float)(cols) / resize_height;
-    float lastY = (0.5 * cols) / resize_height - 0.5;
-    float y = lastY;
-    Eigen::MatrixXf dst(resize_width, resize_height);
-    for(int i = 0; i < resize_width; ++i) {
-        //float x = (i+0.5)*rows/NEW_SIZE-0.5;
-        float x = lastX;
-        lastX += deltaX;
-        int fx = (int)x;
-        x -= fx;
-        short x1 = (1.f - x) * 2048;
-        short x2 = 2048 - x1;
-        if (fx >= rows - 1){
-            fx = rows - 2;
-        }
-        lastY = (0.5 * cols) / resize_height -0.5;
-        for(int j = 0; j < resize_height; ++j) {
-            //float y = (j+0.5)*cols/NEW_SIZE-0.5;
-            y = lastY;
-            lastY += deltaY;
-
-            int fy = (int)y;
-            y -= fy;
-            if (fy >= cols - 1){
-                fy = cols - 2;
-            }
-            short y1 = (1.f - y) * 2048;
-            short y2 = 2048 - y1;
-            dst(i, j) = ((int)img(fx, fy) * x1 * y1 + (int)img(fx + 1, fy) * x2 * y1
-                        + (int)img(fx, fy + 1) * x1 * y2 + (int)img(fx + 1, fy + 1) * x2 * y2) >> 22;
-
-        }
-    }
-    return dst;
-}
-
-
-int BallDetector::dnn_predict(Eigen::MatrixXf &img, network<sequential> nn){
-
-    vec_t dnn_image;
-    for (int i = 0; i < img.rows(); i++){
-        for (int j = 0; j < img.cols(); j++){
-            dnn_image.push_back(img(i, j));
-        }
-    }
-    vec_t result = nn.predict(dnn_image);
-    if (result[0] > result[1]){
-        return 0;
-    }
-    return 1;
-}
-
-Eigen::MatrixXf BallDetector::convertMat(const RegionI& region){
-
-    RegionI::iterator_fovea cur_point = region.begin_fovea();
-    // Track the literal location of the iterators.
-    int x = 0;
-    int y = 0;
-    // The number of rows and columns in the region.
-    int rows = region.getRows();
-    int cols = region.getCols();
-    Eigen::MatrixXf dst(rows, cols);
-    // Loop
-    for(int pixel = 0; pixel < cols * rows; ++pixel)
-    {
-        // std::cout<<cur_point.colour() << " ";
-        if (cur_point.colour() == cWHITE){
-            dst(y, x) = 1;
-        }
-        else{
-            dst(y, x) = 0;
-        }
-        cur_point++;
-        x++;
-        if (x == cols){
-            x = 0;
-            ++y;
-        }
-    }
-    return dst;
-}
-#endif
@@ -6,13 +6,15 @@
 #include "perception/vision/detector/DetectorInterface.hpp"
 #include "perception/vision/Region/Region.hpp"
 #include "types/VisionInfoOut.hpp"
-#include "types/GroupLinks.hpp"
+#include "types/BBox.hpp"
+#include "types/Odometry.hpp"
 #include "perception/vision/other/GMM_classifier.hpp"
+#include "perception/vision/other/ConnectedComponents.hpp"
+#include "perception/vision/other/FrameArena.hpp"
+#include "thread/WorkerPool.hpp"
 
 #include "types/RansacTypes.hpp"
 
-#define MAX_RES TOP_IMAGE_COLS*TOP_IMAGE_ROWS
-
 // #define BALL_DETECTOR_USES_VDM
 #ifdef BALL_DETECTOR_USES_VDM
 
@@ -22,12 +24,9 @@
 #endif // BALL_DETECTOR_USES_VDM
 
 #ifndef CTC_2_1
-#include "tiny_dnn/network.h"
-#include "DNNHelper.hpp"
+#include "perception/vision/detector/BallClassifier.hpp"
 #endif
 
-#define DNN_WEIGHTS_DIR "data/dnn_model/ball_weights/"
-
 enum PartialBallSide {
     BALL_SIDE_LEFT = 0,
     BALL_SIDE_TOP,
@@ -201,16 +200,30 @@ struct BallDetectorVisionBundle {
 class BallDetector: public Detector {
     public:
 
-        BallDetector() : estimator(ball) {
-            #ifndef CTC_2_1
-            nn = load_3_layer_cnn();
-            #endif
-        }
+        BallDetector();
+        ~BallDetector();
+
+        /**
+         * Searches the ROIs on threads threads as well as the one calling
+         * detect, or all on the calling thread if threads is 0. Balls are
+         * reported in the same order either way.
+         */
+        void setThreads(int threads);
+
+        /**
+         * While a ball is tracked, first searches only the ROIs that overlap
+         * the window the last ball is predicted in, and searches the rest
+         * only if no ball is found there. Every interval-th frame is a full
+         * sweep regardless. 0 turns tracking off.
+         */
+        void setTracking(int interval);
 
         /**
          * detect implementation of abstract infterface function
          */
         void detect(const VisionInfoIn& info_in, VisionInfoMiddle& info_middle, VisionInfoOut& info_out);
+        uint32_t reads() const { return vdROI | vdSTART_SCAN_COORDS; }
+        uint32_t writes() const { return vdBALLS | vdCHILD_FOVEAE; }
 
         /**
          * Determines whether the region is just a simple white blob, or
@@ -254,8 +267,8 @@ class BallDetector: public Detector {
 
         bool comboROI(const VisionInfoIn& info_in, const RegionI& region, const VisionInfoMiddle& info_middle, VisionInfoOut& info_out, bool doReject, std::vector <BallDetectorVisionBundle> &res);
 
-        // I know this is ugly copied code. But unless we template it (so the compiler knows about it and can inline)
-        // Not sure how to make this clean AND efficient
+        // Label the non white pixels of base_region, inside circle or anywhere,
+        // into components_.
         void connectedComponentAnalysisNotWhiteAndInside(const RegionI& base_region,
             BallDetectorVisionBundle &bdvb,RANSACCircle &circle);
         void connectedComponentAnalysisNotWhite(const RegionI& base_region, BallDetectorVisionBundle &bdvb);
@@ -264,7 +277,7 @@ class BallDetector: public Detector {
 
         void findLargestCircleFit(BallDetectorVisionBundle &bdvb, float max_radius, std::vector<bool> **cons, std::vector <bool> cons_buf[2], float e, unsigned int n,
             float min_radius_prop, float step_size, PartialBallSide partial_ball_side);
-        void findBestCircleFit(BallDetectorVisionBundle &bdvb, float max_radius, std::vector<bool> **cons, std::vector <bool> cons_buf[2], float e, unsigned int n,
+        void findBestCircleFit(BallDetectorVisionBundle &bdvb, float max_radius, float e, unsigned int n,
             float min_radius_prop, float step_size, PartialBallSide partial_ball_side);
 
         void getAverageBrightness(BallDetectorVisionBundle &bdvb);
@@ -300,37 +313,124 @@ class BallDetector: public Detector {
         int calculateCircleLeft(int y, int cols, RANSACCircle c);
         int calculateCircleRight(int y, int cols, RANSACCircle c);
 
-        Eigen::MatrixXf convertMat(const RegionI& region);
+        /**
+         * A candidate found in one ROI, in the order it would have been
+         * inspected. Its bundle is lists[list][index] of the ROI's RoiSearch.
+         */
+        struct BallCandidate {
+            int list;
+            int index;
+            // For a blobROI candidate, the combo ROI bundle it was found in;
+            // otherwise -1.
+            int parent_list;
+            int parent_index;
+            unsigned int region_index;
+            unsigned int subregion_index;
+            // Whether it passed inspectBall, and if so, its index in the
+            // classifier's batch.
+            bool inspected;
+            int classifier_index;
+            // Whether it passed inspectBall and the classifier.
+            bool ball;
+        };
 
-        #ifndef CTC_2_1
-        tiny_dnn::network<sequential> load_3_layer_cnn();
+        /**
+         * Everything comboROI and blobROI found in one ROI. Lists past
+         * num_lists are spare, kept for their storage. The first num_combo
+         * candidates are comboROI's, and any after them blobROI's.
+         */
+        struct RoiSearch {
+            RoiSearch() : num_lists(0), num_combo(0) {}
+            std::vector<std::vector<BallDetectorVisionBundle> > lists;
+            int num_lists;
+            std::vector<BallCandidate> candidates;
+            unsigned int num_combo;
+        };
 
-        Eigen::MatrixXf dnn_resize(Eigen::MatrixXf &, int, int);
+        /**
+         * Workers search ROIs for another BallDetector, in their own scratch
+         * and child fovea arena. They have no classifier or workers of their
+         * own.
+         */
+        struct Worker {};
+        explicit BallDetector(Worker);
 
-        int dnn_predict(Eigen::MatrixXf &, network<sequential>);
-        #endif
+        /**
+         * Finds and inspects comboROI's candidates in region, without
+         * classifying any. Only touches this detector's scratch and search.
+         */
+        void searchROI_(const VisionInfoIn& info_in, const RegionI& region,
+                        const VisionInfoMiddle& info_middle, VisionInfoOut& info_out,
+                        unsigned int region_index, RoiSearch& search);
+
+        /**
+         * After searchROI_, finds and inspects blobROI's candidates in
+         * search's normal comboROI candidates, as searchROI_ does.
+         */
+        void searchBlobs_(const VisionInfoIn& info_in, const VisionInfoMiddle& info_middle,
+                          VisionInfoOut& info_out, unsigned int region_index,
+                          RoiSearch& search);
+
+        /**
+         * Searches the ROIs from first up to last, counted in the order
+         * detect searches them, shared between this detector and its
+         * workers on the pool. With blobs, searchBlobs_ them, otherwise
+         * searchROI_ them.
+         */
+        void runWave_(unsigned int first, unsigned int last, bool blobs,
+                      const VisionInfoIn& info_in, const VisionInfoMiddle& info_middle,
+                      VisionInfoOut& info_out);
 
-        // The set of links between groups generated during CCA. Here to avoid
-        // reallocation.
-        GroupLinks group_links_;
+        /**
+         * Searches every stride-th ROI from first up to last on worker, as
+         * runWave_.
+         */
+        void searchROIs_(BallDetector* worker, unsigned int first, unsigned int last,
+                         unsigned int stride, bool blobs, const VisionInfoIn* info_in,
+                         const VisionInfoMiddle* info_middle, VisionInfoOut* info_out);
 
-        // The ID of the group for each pixel.
-        uint16_t groups_[MAX_RES];
+        /**
+         * Classifies, in one batch, the comboROI candidates of the ROIs
+         * from first up to last, or with blobs their blobROI candidates,
+         * and sets their ball.
+         */
+        void classifyWave_(unsigned int first, unsigned int last, bool blobs);
 
-        // The number of pixels in each group.
-        std::vector<int> group_counts_;
+        /**
+         * Predicts where the tracked ball is in this frame, from its last
+         * robot relative position moved by the odometry since. Returns false
+         * if there is no track, this frame is a full sweep, or the ball is
+         * predicted off both images; otherwise sets window to the image
+         * coordinates, bottom camera below top, the ball should be in.
+         */
+        bool predictTrackingWindow_(const VisionInfoIn& info_in, VisionInfoOut& info_out,
+                                    BBox& window);
 
-        // The smallest x value in each group.
-        std::vector<int> group_low_xs_;
+        /**
+         * Whether region overlaps window, in the coordinates of
+         * predictTrackingWindow_.
+         */
+        static bool overlapsWindow_(const RegionI& region, const BBox& window);
 
-        // The largest x value in each group.
-        std::vector<int> group_high_xs_;
+        /**
+         * Returns the index of an empty list in search.
+         */
+        static int newBundleList_(RoiSearch& search);
 
-        // The smallest y value in each group.
-        std::vector<int> group_low_ys_;
+        /**
+         * Inspects search.lists[list][index] and records it in
+         * search.candidates.
+         */
+        void addCandidate_(RoiSearch& search, int list, int index, int parent_list,
+                           int parent_index, unsigned int region_index,
+                           unsigned int subregion_index);
+
+        // The groups found by CCA. Here to avoid reallocation.
+        ConnectedComponents components_;
 
-        // The largest y value in each group.
-        std::vector<int> group_high_ys_;
+        // The columns of the circle on each row for CCA inside a circle.
+        std::vector<int> circle_lefts_;
+        std::vector<int> circle_rights_;
 
         // For tringle combinations
         std::vector <Point> combo_;
@@ -341,7 +441,41 @@ class BallDetector: public Detector {
         Estimator estimator;
 
         #ifndef CTC_2_1
-        tiny_dnn::network<sequential> nn;
+        // NULL in workers.
+        BallClassifier* classifier_;
         #endif
+
+        // One search per ROI this frame, indexed in the order the ROIs are
+        // searched, kept until their candidates are classified.
+        std::vector<RoiSearch> searches_;
+
+        // The index in info_middle.roi of the ROI each search is of.
+        std::vector<unsigned int> order_;
+
+        // Frames between full sweeps while tracking, or 0 if not tracking.
+        int tracking_interval_;
+        int frames_since_sweep_;
+
+        // The last ball reported, robot relative, if track_valid_.
+        bool track_valid_;
+        float track_x_;
+        float track_y_;
+
+        // Odometry is cumulative, so the last frame's gives the delta.
+        Odometry last_odometry_;
+
+        // pool_ is NULL, and there are no workers, unless setThreads was
+        // given threads. Worker i searches for job i + 1; the caller of
+        // detect takes job 0 itself.
+        WorkerPool* pool_;
+        std::vector<BallDetector*> workers_;
+        std::vector<WorkerPool::Job> jobs_;
+
+        // Where the child foveae of the ROIs this detector searches go while
+        // ROIs are searched on several threads; NULL while they are not.
+        FrameArena* arena_;
+
+        BallDetector(const BallDetector&);
+        BallDetector& operator=(const BallDetector&);
 };
 #endif
@@ -1,6 +1,9 @@
 #ifndef PERCEPTION_VISION_DETECTOR_DETECTORINTERFACE_H_
 #define PERCEPTION_VISION_DETECTOR_DETECTORINTERFACE_H_
 
+#include <stdint.h>
+
+#include "perception/vision/VisionDefinitions.hpp"
 #include "types/VisionInfoIn.hpp"
 #include "types/VisionInfoMiddle.hpp"
 #include "types/VisionInfoOut.hpp"
@@ -12,6 +15,13 @@ public:
      */
     virtual void detect(const VisionInfoIn& info_in,
                     VisionInfoMiddle& info_middle, VisionInfoOut& info_out) = 0;
+    /**
+     * The VisionData this detector reads and writes, used to run independent
+     * stages at the same time. Defaults to everything, so a detector that does not
+     * override these always runs on its own.
+     */
+    virtual uint32_t reads() const { return vdALL; }
+    virtual uint32_t writes() const { return vdALL; }
     virtual ~Detector(){};
 };
 
@@ -0,0 +1,251 @@
+#include "perception/vision/detector/ForestModel.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+#include "utils/Logger.hpp"
+
+namespace {
+
+// Samples walked through a tree together
+const int BLOCK = 8;
+
+// Bounds the per-block class sums, which live on the stack
+const int MAX_CLASSES = 16;
+
+// Bounds the complete layout of a tree to 2^MAX_DEPTH leaves
+const int MAX_DEPTH = 12;
+
+// A node as stored in the model file
+struct FileNode {
+    int feature;
+    float threshold;
+    int left;
+    int right;
+};
+
+template <typename T>
+bool readAll(FILE* file, std::vector<T>& values) {
+    return values.empty() ||
+           fread(&values[0], sizeof(T), values.size(), file) == values.size();
+}
+
+}
+
+ForestModel::ForestModel() : num_features_(0), num_classes_(0) {
+}
+
+void ForestModel::clear() {
+    num_features_ = 0;
+    num_classes_ = 0;
+    trees_.clear();
+    nodes_.clear();
+    leaves_.clear();
+    values_.clear();
+}
+
+bool ForestModel::load(const std::string& path) {
+    /*
+    // FOREST MODEL DUMP FORMAT
+    num_features(int), num_classes(int), num_trees(int), num_nodes(int)
+    roots[num_trees](int)
+    for each node:
+        feature(int), threshold(float), left(int), right(int)
+    num_leaves(int)
+    leaf_probabilities[num_leaves, num_classes](float)
+
+    A leaf has feature -1 and its leaf index in left. Node and leaf indices
+    are over the whole forest.
+    */
+    clear();
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL) {
+        llog(ERROR) << "Failed to open forest model " << path << std::endl;
+        return false;
+    }
+
+    int header[4];
+    int num_leaves = 0;
+    std::vector<int> roots;
+    std::vector<FileNode> nodes;
+    std::vector<float> values;
+
+    bool ok = fread(header, sizeof(int), 4, file) == 4 &&
+              header[0] > 0 && header[1] > 0 && header[1] <= MAX_CLASSES &&
+              header[2] > 0 && header[3] > 0;
+    if (ok) {
+        roots.resize(header[2]);
+        nodes.resize(header[3]);
+        ok = readAll(file, roots) && readAll(file, nodes) &&
+             fread(&num_leaves, sizeof(int), 1, file) == 1 && num_leaves > 0;
+    }
+    if (ok) {
+        values.resize((size_t)num_leaves * header[1]);
+        ok = readAll(file, values);
+    }
+    fclose(file);
+
+    const int num_features = ok ? header[0] : 0;
+    const int num_nodes = nodes.size();
+
+    // Children must come after their parents, which rules out cycles and
+    // lets depths be found in one pass from the back.
+    for (int i = 0; ok && i < num_nodes; ++i) {
+        const FileNode& node = nodes[i];
+        if (node.feature < 0) {
+            ok = node.left >= 0 && node.left < num_leaves;
+        } else {
+            ok = node.feature < num_features &&
+                 node.left > i && node.left < num_nodes &&
+                 node.right > i && node.right < num_nodes;
+        }
+    }
+    for (size_t t = 0; ok && t < roots.size(); ++t) {
+        ok = roots[t] >= 0 && roots[t] < num_nodes;
+    }
+    if (!ok) {
+        llog(ERROR) << "Malformed forest model " << path << std::endl;
+        return false;
+    }
+
+    std::vector<int> depth(num_nodes, 0);
+    for (int i = num_nodes - 1; i >= 0; --i) {
+        if (nodes[i].feature >= 0) {
+            depth[i] = 1 + std::max(depth[nodes[i].left], depth[nodes[i].right]);
+        }
+    }
+
+    Node pass;
+    pass.feature = 0;
+    pass.threshold = std::numeric_limits<float>::infinity();
+
+    std::vector<Tree> trees(roots.size());
+    std::vector<Node> flat;
+    std::vector<int> leaves;
+    for (size_t t = 0; t < roots.size(); ++t) {
+        Tree& tree = trees[t];
+        tree.depth = depth[roots[t]];
+        if (tree.depth > MAX_DEPTH) {
+            llog(ERROR) << "Forest model " << path << " has a tree deeper than "
+                        << MAX_DEPTH << std::endl;
+            return false;
+        }
+        tree.nodes = flat.size();
+        tree.leaves = leaves.size();
+
+        // Lays out one level at a time, source holding the file node each
+        // slot of the level came from. A leaf above the bottom is carried
+        // down the left of a passing split, leaving the slots to its right
+        // unreachable.
+        const int width = 1 << tree.depth;
+        flat.resize(tree.nodes + width - 1, pass);
+        leaves.resize(tree.leaves + width, 0);
+        std::vector<int> source(1, roots[t]);
+        for (int level = 0; level < tree.depth; ++level) {
+            std::vector<int> below(2 * source.size(), -1);
+            for (size_t i = 0; i < source.size(); ++i) {
+                const int s = source[i];
+                if (s < 0) {
+                    continue;
+                }
+                if (nodes[s].feature < 0) {
+                    below[2 * i] = s;
+                } else {
+                    Node& node = flat[tree.nodes + (1 << level) - 1 + i];
+                    node.feature = nodes[s].feature;
+                    node.threshold = nodes[s].threshold;
+                    below[2 * i] = nodes[s].left;
+                    below[2 * i + 1] = nodes[s].right;
+                }
+            }
+            source.swap(below);
+        }
+        for (int i = 0; i < width; ++i) {
+            if (source[i] >= 0) {
+                leaves[tree.leaves + i] = nodes[source[i]].left * header[1];
+            }
+        }
+    }
+
+    num_features_ = num_features;
+    num_classes_ = header[1];
+    trees_.swap(trees);
+    nodes_.swap(flat);
+    leaves_.swap(leaves);
+    values_.swap(values);
+    return true;
+}
+
+void ForestModel::classify(const float* features, int samples,
+                           int* classes, float* confidences) const {
+    const int num_trees = trees_.size();
+
+    for (int first = 0; first < samples; first += BLOCK) {
+        const int count = std::min(BLOCK, samples - first);
+
+        // A short last block walks its last sample in the spare slots, so
+        // the loops below always run over a whole block.
+        const float* x[BLOCK];
+        for (int s = 0; s < BLOCK; ++s) {
+            x[s] = features + (size_t)(first + std::min(s, count - 1)) * num_features_;
+        }
+
+        float sums[BLOCK][MAX_CLASSES];
+        for (int s = 0; s < BLOCK; ++s) {
+            for (int c = 0; c < num_classes_; ++c) {
+                sums[s][c] = 0.0f;
+            }
+        }
+
+        for (int t = 0; t < num_trees; ++t) {
+            const Tree& tree = trees_[t];
+            // A leaf-only last tree starts past the end of nodes_
+            const Node* nodes = nodes_.data() + tree.nodes;
+
+            // The children of node i are 2i + 1 and 2i + 2
+            int node[BLOCK];
+            for (int s = 0; s < BLOCK; ++s) {
+                node[s] = 0;
+            }
+            for (int d = 0; d < tree.depth; ++d) {
+                for (int s = 0; s < BLOCK; ++s) {
+                    const Node& n = nodes[node[s]];
+                    node[s] = 2 * node[s] + 1 + !(x[s][n.feature] <= n.threshold);
+                }
+            }
+
+            // Every sample ends on the last level, whose first node is the
+            // tree's first leaf
+            const int* leaves = leaves_.data() + tree.leaves;
+            const int first_leaf = (1 << tree.depth) - 1;
+            for (int s = 0; s < BLOCK; ++s) {
+                const float* leaf = &values_[leaves[node[s] - first_leaf]];
+                for (int c = 0; c < num_classes_; ++c) {
+                    sums[s][c] += leaf[c];
+                }
+            }
+        }
+
+        for (int s = 0; s < count; ++s) {
+            int best = 0;
+            float highest = 0.0f;
+            for (int c = 0; c < num_classes_; ++c) {
+                if (sums[s][c] > highest) {
+                    best = c;
+                    highest = sums[s][c];
+                }
+            }
+            classes[first + s] = best;
+            confidences[first + s] = highest;
+        }
+    }
+}
+
+int ForestModel::classify(const std::vector<float>& features,
+                          float& confidence) const {
+    int classification;
+    classify(&features[0], 1, &classification, &confidence);
+    return classification;
+}
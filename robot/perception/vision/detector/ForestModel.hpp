@@ -0,0 +1,83 @@
+#ifndef PERCEPTION_VISION_DETECTOR_FORESTMODEL_H_
+#define PERCEPTION_VISION_DETECTOR_FORESTMODEL_H_
+
+#include <string>
+#include <vector>
+
+// The location of the robot detector's forest, written by
+// utils/random-forest/forest_to_model.py
+#define FOREST_MODEL_DIR_ROBOT "data/vision/robotdetection/robot_forest.model"
+
+/**
+ * A random forest loaded at runtime from a model file, in place of a forest
+ * generated as nested ifs such as RandomForest.
+ *
+ * Each tree is stored flat as a complete binary tree of its depth, in level
+ * order, with leaves above the bottom level padded out by splits that always
+ * go left. A node's children are then found by arithmetic rather than a
+ * load, and every sample takes exactly depth steps through a tree, using
+ * each comparison as an index instead of a branch. Samples are classified in
+ * blocks, stepping a tree for the whole block at once so the walks overlap
+ * rather than wait on each other's loads.
+ *
+ * Classifies exactly as the generated code does: a sample goes left at a
+ * split if its feature is <= the threshold, the class probabilities of the
+ * trees are summed in tree order, and the class with the highest strictly
+ * positive sum wins, ties going to the lower class, with that sum as the
+ * confidence.
+ */
+class ForestModel {
+public:
+    ForestModel();
+
+    /**
+     * Replaces the model with the one in path, returning false and leaving
+     * the model empty if it can't be read, is malformed or has a tree deeper
+     * than the complete layout allows.
+     */
+    bool load(const std::string& path);
+
+    bool empty() const { return trees_.empty(); }
+    int numFeatures() const { return num_features_; }
+    int numClasses() const { return num_classes_; }
+
+    /**
+     * Classifies samples rows of numFeatures() features each, writing the
+     * class and confidence of each.
+     */
+    void classify(const float* features, int samples,
+                  int* classes, float* confidences) const;
+
+    /**
+     * Classifies one sample, with the same interface as RandomForest.
+     */
+    int classify(const std::vector<float>& features, float& confidence) const;
+
+private:
+    struct Tree {
+        int depth;
+        // Offsets of the tree's 2^depth - 1 splits in nodes_, and its 2^depth
+        // leaves in leaves_
+        int nodes;
+        int leaves;
+    };
+
+    struct Node {
+        int feature;
+        float threshold;
+    };
+
+    int num_features_;
+    int num_classes_;
+
+    std::vector<Tree> trees_;
+    std::vector<Node> nodes_;
+
+    // The offset in values_ of each leaf's class probabilities
+    std::vector<int> leaves_;
+    std::vector<float> values_;
+
+    void clear();
+};
+
+#endif
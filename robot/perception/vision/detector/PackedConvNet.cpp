@@ -0,0 +1,303 @@
+#include "perception/vision/detector/PackedConvNet.hpp"
+
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+namespace {
+
+int outLength(int in, int window, int stride, bool same) {
+    int length = same ? in : in - window + 1;
+    return (length + stride - 1) / stride;
+}
+
+float activate(float x, PackedConvNet::Activation activation) {
+    float sigmoid = 1.0f / (1.0f + std::exp(-x));
+    return activation == PackedConvNet::SILU ? x * sigmoid : sigmoid;
+}
+
+#ifdef __SSE2__
+inline __m128 load4(const float* w) {
+    return _mm_loadu_ps(w);
+}
+
+inline __m128 load4(const int8_t* w) {
+    int32_t packed;
+    memcpy(&packed, w, sizeof(packed));
+    // Sign extend each byte into the top of a 32 bit lane, then shift down.
+    __m128i v = _mm_cvtsi32_si128(packed);
+    v = _mm_unpacklo_epi8(v, v);
+    v = _mm_unpacklo_epi16(v, v);
+    return _mm_cvtepi32_ps(_mm_srai_epi32(v, 24));
+}
+
+/**
+ * e^x, using the Cephes polynomial as in sse_mathfun. Within 2 ulp of
+ * std::exp over the range that matters for the activations.
+ */
+inline __m128 exp4(__m128 x) {
+    x = _mm_min_ps(x, _mm_set1_ps(88.3762626647949f));
+    x = _mm_max_ps(x, _mm_set1_ps(-88.3762626647949f));
+
+    // n = round(x / ln 2), with floor done by hand as SSE2 has no round.
+    __m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f)),
+                           _mm_set1_ps(0.5f));
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+    __m128 correction = _mm_and_ps(_mm_cmpgt_ps(truncated, fx), _mm_set1_ps(1.0f));
+    fx = _mm_sub_ps(truncated, correction);
+
+    // x - n ln 2, with ln 2 split in two for precision.
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(0.693359375f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(-2.12194440e-4f)));
+
+    __m128 y = _mm_set1_ps(1.9875691500E-4f);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.3981999507E-3f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(8.3334519073E-3f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(4.1665795894E-2f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.6666665459E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(5.0000001201E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, _mm_mul_ps(x, x)), x);
+    y = _mm_add_ps(y, _mm_set1_ps(1.0f));
+
+    // Times 2^n, built directly in the exponent bits.
+    __m128i n = _mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(0x7f));
+    return _mm_mul_ps(y, _mm_castsi128_ps(_mm_slli_epi32(n, 23)));
+}
+
+inline __m128 activate4(__m128 x, PackedConvNet::Activation activation) {
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 negated = _mm_sub_ps(_mm_setzero_ps(), x);
+    __m128 sigmoid = _mm_div_ps(one, _mm_add_ps(one, exp4(negated)));
+    return activation == PackedConvNet::SILU ? _mm_mul_ps(x, sigmoid) : sigmoid;
+}
+#endif // __SSE2__
+
+}
+
+PackedConvNet::PackedConvNet(const std::vector<Conv>& convs, Precision precision)
+    : precision_(precision), reference_(false) {
+    if (convs.empty()) {
+        throw std::invalid_argument("PackedConvNet needs at least one layer");
+    }
+
+    layers_.resize(convs.size());
+    for (size_t i = 0; i < convs.size(); ++i) {
+        const Conv& conv = convs[i];
+        Layer& layer = layers_[i];
+        layer.conv = conv;
+        layer.out_width = outLength(conv.in_width, conv.window_width,
+                                    conv.stride_width, conv.same_padding);
+        layer.out_height = outLength(conv.in_height, conv.window_height,
+                                     conv.stride_height, conv.same_padding);
+        layer.groups = (conv.out_channels + 3) / 4;
+
+        if (i > 0) {
+            const Layer& previous = layers_[i - 1];
+            if (conv.in_width != previous.out_width ||
+                conv.in_height != previous.out_height ||
+                conv.in_channels != previous.conv.out_channels) {
+                throw std::invalid_argument("PackedConvNet layers do not chain");
+            }
+        }
+
+        // Same padding puts the extra column or row on the left or top,
+        // as tiny-dnn does for even windows.
+        int padded_rows = conv.in_height;
+        layer.pad_left = 0;
+        layer.pad_top = 0;
+        layer.cols = conv.in_width;
+        if (conv.same_padding) {
+            layer.pad_left = conv.window_width / 2;
+            layer.pad_top = conv.window_height / 2;
+            layer.cols += conv.window_width - 1;
+            padded_rows += conv.window_height - 1;
+        }
+        // Earlier layers store four channels at a time. The network's input
+        // is filled by the caller and is kept dense.
+        layer.stride = i == 0 ? conv.in_channels : (conv.in_channels + 3) / 4 * 4;
+        layer.in.assign(layer.cols * padded_rows * layer.stride, 0.0f);
+
+        size_t packed = layer.groups * conv.window_height * conv.window_width *
+                        conv.in_channels * 4;
+        if (precision_ == FLOAT) {
+            layer.weights.assign(packed, 0.0f);
+        } else {
+            layer.quantised.assign(packed, 0);
+        }
+        layer.scale.assign(layer.groups * 4, 1.0f);
+        layer.bias.assign(layer.groups * 4, 0.0f);
+    }
+
+    const Layer& last = layers_.back();
+    output_.assign(last.conv.out_channels * last.out_height * last.out_width, 0.0f);
+}
+
+void PackedConvNet::setWeights(int index, const float* weights, const float* bias) {
+    Layer& layer = layers_.at(index);
+    const Conv& conv = layer.conv;
+    const int window = conv.window_height * conv.window_width;
+
+    for (int out = 0; out < conv.out_channels; ++out) {
+        const float* kernel = weights + out * conv.in_channels * window;
+
+        // Symmetric quantisation, with the largest weight of the output
+        // channel at 127.
+        float scale = 1.0f;
+        if (precision_ == INT8) {
+            float largest = 0.0f;
+            for (int i = 0; i < conv.in_channels * window; ++i) {
+                largest = std::max(largest, std::fabs(kernel[i]));
+            }
+            if (largest > 0.0f) {
+                scale = largest / 127.0f;
+            }
+        }
+        layer.scale[out] = scale;
+        layer.bias[out] = bias ? bias[out] : 0.0f;
+
+        for (int in = 0; in < conv.in_channels; ++in) {
+            for (int wy = 0; wy < conv.window_height; ++wy) {
+                for (int wx = 0; wx < conv.window_width; ++wx) {
+                    float w = kernel[(in * conv.window_height + wy) * conv.window_width + wx];
+                    size_t packed = (((out / 4 * conv.window_height + wy) * conv.window_width
+                                      + wx) * conv.in_channels + in) * 4 + out % 4;
+                    if (precision_ == FLOAT) {
+                        layer.weights[packed] = w;
+                    } else {
+                        float q = std::floor(w / scale + 0.5f);
+                        layer.quantised[packed] = (int8_t) std::max(-127.0f, std::min(127.0f, q));
+                    }
+                }
+            }
+        }
+    }
+}
+
+float* PackedConvNet::inputRow(int y) {
+    Layer& first = layers_.front();
+    return &first.in[((y + first.pad_top) * first.cols + first.pad_left) * first.stride];
+}
+
+const float* PackedConvNet::run() {
+    for (size_t i = 0; i < layers_.size(); ++i) {
+        Layer* next = i + 1 < layers_.size() ? &layers_[i + 1] : NULL;
+#ifdef __SSE2__
+        if (!reference_) {
+            if (precision_ == FLOAT) {
+                dispatch_(layers_[i], &layers_[i].weights[0], next);
+            } else {
+                dispatch_(layers_[i], &layers_[i].quantised[0], next);
+            }
+            continue;
+        }
+#endif // __SSE2__
+        runReference_(layers_[i], next);
+    }
+    return &output_[0];
+}
+
+template <typename W>
+void PackedConvNet::dispatch_(const Layer& layer, const W* weights, Layer* next) {
+    // The windows the robot detector uses get unrolled kernels.
+    const Conv& conv = layer.conv;
+    if (conv.window_width == 3 && conv.window_height == 3) {
+        runFast_<3, 3>(layer, weights, next);
+    } else if (conv.window_width == 8 && conv.window_height == 3) {
+        runFast_<8, 3>(layer, weights, next);
+    } else if (conv.window_width == 1 && conv.window_height == 1) {
+        runFast_<1, 1>(layer, weights, next);
+    } else {
+        runFast_<0, 0>(layer, weights, next);
+    }
+}
+
+template <int WINDOW_WIDTH, int WINDOW_HEIGHT, typename W>
+void PackedConvNet::runFast_(const Layer& layer, const W* weights, Layer* next) {
+#ifdef __SSE2__
+    const Conv& conv = layer.conv;
+    // Zero means the window size is only known at run time.
+    const int window_width = WINDOW_WIDTH ? WINDOW_WIDTH : conv.window_width;
+    const int window_height = WINDOW_HEIGHT ? WINDOW_HEIGHT : conv.window_height;
+    const int taps = window_height * window_width * conv.in_channels;
+    const int row_step = layer.cols * layer.stride;
+
+    for (int g = 0; g < layer.groups; ++g) {
+        const W* group_weights = weights + g * taps * 4;
+        const __m128 scale = _mm_loadu_ps(&layer.scale[g * 4]);
+        const __m128 bias = _mm_loadu_ps(&layer.bias[g * 4]);
+
+        for (int y = 0; y < layer.out_height; ++y) {
+            const float* row = &layer.in[y * conv.stride_height * row_step];
+            for (int x = 0; x < layer.out_width; ++x) {
+                const float* window = row + x * conv.stride_width * layer.stride;
+                const W* w = group_weights;
+                __m128 sum = _mm_setzero_ps();
+                for (int wy = 0; wy < window_height; ++wy) {
+                    const float* pixel = window + wy * row_step;
+                    for (int wx = 0; wx < window_width; ++wx) {
+                        for (int in = 0; in < conv.in_channels; ++in) {
+                            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(pixel[in]), load4(w)));
+                            w += 4;
+                        }
+                        pixel += layer.stride;
+                    }
+                }
+                __m128 out = activate4(_mm_add_ps(_mm_mul_ps(sum, scale), bias),
+                                       conv.activation);
+
+                if (next) {
+                    _mm_storeu_ps(destination_(next, x, y) + g * 4, out);
+                } else {
+                    float lanes[4];
+                    _mm_storeu_ps(lanes, out);
+                    int channels = std::min(4, conv.out_channels - g * 4);
+                    for (int lane = 0; lane < channels; ++lane) {
+                        output_[((g * 4 + lane) * layer.out_height + y) * layer.out_width + x] = lanes[lane];
+                    }
+                }
+            }
+        }
+    }
+#endif // __SSE2__
+}
+
+void PackedConvNet::runReference_(const Layer& layer, Layer* next) {
+    const Conv& conv = layer.conv;
+
+    for (int out = 0; out < conv.out_channels; ++out) {
+        for (int y = 0; y < layer.out_height; ++y) {
+            for (int x = 0; x < layer.out_width; ++x) {
+                float sum = 0.0f;
+                for (int in = 0; in < conv.in_channels; ++in) {
+                    for (int wy = 0; wy < conv.window_height; ++wy) {
+                        for (int wx = 0; wx < conv.window_width; ++wx) {
+                            int px = x * conv.stride_width + wx;
+                            int py = y * conv.stride_height + wy;
+                            size_t packed = (((out / 4 * conv.window_height + wy) * conv.window_width
+                                              + wx) * conv.in_channels + in) * 4 + out % 4;
+                            float w = precision_ == FLOAT ? layer.weights[packed]
+                                                          : layer.quantised[packed];
+                            sum += layer.in[(py * layer.cols + px) * layer.stride + in] * w;
+                        }
+                    }
+                }
+                float value = activate(sum * layer.scale[out] + layer.bias[out], conv.activation);
+
+                if (next) {
+                    destination_(next, x, y)[out] = value;
+                } else {
+                    output_[(out * layer.out_height + y) * layer.out_width + x] = value;
+                }
+            }
+        }
+    }
+}
+
+float* PackedConvNet::destination_(Layer* next, int x, int y) {
+    return &next->in[((y + next->pad_top) * next->cols + x + next->pad_left) * next->stride];
+}
@@ -0,0 +1,113 @@
+#ifndef PERCEPTION_VISION_DETECTOR_PACKEDCONVNET_H_
+#define PERCEPTION_VISION_DETECTOR_PACKEDCONVNET_H_
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Forward pass of a fixed chain of convolutions, each followed by an
+ * activation, such as the SSRobotDetector YOLO network.
+ *
+ * Weights are packed once, four output channels to a group in the order the
+ * kernel reads them, so one SSE multiply-add covers a group. Each
+ * convolution adds its bias and applies its activation as it stores its
+ * output. Activations are kept with channels interleaved in buffers that
+ * are allocated up front with zeroed borders for same padding, so a forward
+ * pass neither allocates nor pads.
+ *
+ * Weights are stored as float, or as int8 with a scale per output channel.
+ * The reference mode runs plain scalar loops and std::exp over the same
+ * packed weights, to check the vectorised kernels against.
+ */
+class PackedConvNet {
+public:
+    enum Activation { SILU, SIGMOID };
+    enum Precision { FLOAT, INT8 };
+
+    struct Conv {
+        int in_width;
+        int in_height;
+        int in_channels;
+        int out_channels;
+        int window_width;
+        int window_height;
+        int stride_width;
+        int stride_height;
+        bool same_padding;
+        Activation activation;
+    };
+
+    /**
+     * Each layer's output shape must be the next layer's input shape.
+     * Weights start at zero.
+     */
+    PackedConvNet(const std::vector<Conv>& layers, Precision precision = FLOAT);
+
+    /**
+     * Packs layer's weights and bias, laid out as tiny-dnn does: weight
+     * (out, in, wy, wx) is at ((out * in_channels + in) * window_height + wy)
+     * * window_width + wx.
+     */
+    void setWeights(int layer, const float* weights, const float* bias);
+
+    void setReference(bool reference) { reference_ = reference; }
+    bool reference() const { return reference_; }
+    Precision precision() const { return precision_; }
+
+    /**
+     * Row y of the input, to be filled before run. Channels are interleaved:
+     * channel c of pixel x is at inputRow(y)[x * in_channels + c].
+     */
+    float* inputRow(int y);
+
+    /**
+     * Runs every layer on the input and returns the output in tiny-dnn's
+     * layout: channel c of pixel (x, y) is at (c * height + y) * width + x.
+     */
+    const float* run();
+
+    int outputSize() const { return output_.size(); }
+
+private:
+
+    struct Layer {
+        Conv conv;
+        int out_width;
+        int out_height;
+        int groups;
+
+        // Input buffer, padded and with channels interleaved.
+        int pad_left;
+        int pad_top;
+        int cols;
+        int stride;
+        std::vector<float> in;
+
+        // Weight (out, in, wy, wx) is at (((out / 4 * window_height + wy)
+        // * window_width + wx) * in_channels + in) * 4 + out % 4 in whichever
+        // of weights or quantised precision uses.
+        std::vector<float> weights;
+        std::vector<int8_t> quantised;
+        std::vector<float> scale;
+        std::vector<float> bias;
+    };
+
+    template <typename W>
+    void dispatch_(const Layer& layer, const W* weights, Layer* next);
+    template <int WINDOW_WIDTH, int WINDOW_HEIGHT, typename W>
+    void runFast_(const Layer& layer, const W* weights, Layer* next);
+    void runReference_(const Layer& layer, Layer* next);
+
+    /**
+     * Where channel 0 of output pixel (x, y) goes in the next layer's input.
+     * The last layer writes output_ instead.
+     */
+    float* destination_(Layer* next, int x, int y);
+
+    const Precision precision_;
+    bool reference_;
+    std::vector<Layer> layers_;
+    std::vector<float> output_;
+};
+
+#endif
@@ -330,7 +330,7 @@ const float leafVal325[2] = {0.4166666666666667, 0.5833333333333334};
 // This is an automatically generated file. If you need to make changes edit the generator, ForestToCPP.py, located at (TBD, sorry if this hasn't been updated with the final location).
 #include "RandomForest.hpp"
 #include <vector>
-int RandomForest::classify(std::vector<float> histogram, float &confidence)
+int RandomForest::classify(const std::vector<float>& histogram, float &confidence)
 {
     const float* tree0;
     if(histogram[1] <= 272.5){
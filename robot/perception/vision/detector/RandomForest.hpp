@@ -3,5 +3,5 @@
 
 class RandomForest {
 public:
-    int classify(std::vector<float> histogram, float &confidence);
+    int classify(const std::vector<float>& histogram, float &confidence);
 };
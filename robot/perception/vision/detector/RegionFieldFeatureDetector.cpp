@@ -7,7 +7,6 @@
 #include "types/RansacTypes.hpp"
 #include "types/Point.hpp"
 #include "types/IndexSorter.hpp"
-#include "types/GroupLinks.hpp"
 #include "perception/vision/other/WriteImage.hpp"
 
 #include "utils/SPLDefs.hpp"
@@ -220,9 +219,6 @@
 // one of the corner lines.
 #define CORNER_POINT_TO_LINE_DISTANCE_MAX 4
 
-// Maximum resolution
-#define MAX_RES TOP_IMAGE_COLS*TOP_IMAGE_ROWS
-
 #define MAX_PENALTY_CROSS_CONSIDERING_DISTANCE (2000*2000)
 
 // The minimum penalty cross region a-b distance
@@ -526,9 +522,29 @@ void RegionFieldFeatureDetector::analyseRegions_(
     const VisionInfoIn& info_in,
     VisionInfoMiddle& info_middle)
 {
+    // With a budget, analyse only the most valuable regions there is
+    // expected to be time for, still in region order, and stop if time runs
+    // out regardless. Skipped regions keep empty region data.
+    RoiSchedule* schedule = info_middle.schedule;
+    if(schedule)
+        schedule->select(info_middle.roi, info_middle.roi_ranking, cost_, chosen_);
+    else
+        chosen_.assign(info_middle.roi.size(), true);
+    const bool budgeted = schedule && schedule->getBudget() > 0;
+    int skipped = 0;
+    int pixels = 0;
+    Timer costTimer;
+
     // Run through all the regions.
     for(unsigned int regionID=0; regionID<info_middle.roi.size(); ++regionID)
     {
+        if(!chosen_[regionID] || (budgeted && schedule->expired()))
+        {
+            ++skipped;
+            continue;
+        }
+        pixels += info_middle.roi[regionID].getCols() *
+                                        info_middle.roi[regionID].getRows();
 
         IF_RFFD_USING_VATNAO(
             // If this is the region, enable a flag to notify all function calls to
@@ -690,6 +706,10 @@ void RegionFieldFeatureDetector::analyseRegions_(
 
     }
 
+    cost_.update(pixels, costTimer.elapsed_us());
+    if(schedule)
+        schedule->skip("FieldFeature", skipped);
+
     IF_RFFD_USING_VATNAO(
         for(unsigned int regionID=0; regionID<info_middle.roi.size(); ++regionID)
         {
@@ -825,6 +845,39 @@ std::pair<Point, BorderTraverseStates> nextBorderPoint(
     return std::pair<Point, BorderTraverseStates>(Point(x, y), state);
 }
 
+namespace {
+    /*
+    The ends found along the border of a padded region, as filled by
+    analyseRegionBorder_.
+    */
+    struct RegionEnds
+    {
+        std::vector<int> border;
+        std::vector<Point, Eigen::aligned_allocator<Point> > ends;
+        std::vector<int> sizes;
+        std::vector<std::pair<int, int> > borderPairs;
+        std::vector<std::pair<Point, Point> > xyPairs;
+
+        void clear()
+        {
+            border.clear();
+            ends.clear();
+            sizes.clear();
+            borderPairs.clear();
+            xyPairs.clear();
+        }
+
+        void swap(RegionEnds& other)
+        {
+            border.swap(other.border);
+            ends.swap(other.ends);
+            sizes.swap(other.sizes);
+            borderPairs.swap(other.borderPairs);
+            xyPairs.swap(other.xyPairs);
+        }
+    };
+}
+
 /*
 Spread seedRegion to neighbors if regionEnds don't change. This can spread for
 SPREAD_ITERATION times.
@@ -832,6 +885,10 @@ SPREAD_ITERATION times.
 SPREAD_ITERATION = 1 : Combine directly overlapping and neighbor regions
 SPREAD_ITERATION = 2 : Combine with neighbor's neighbors
 ...
+
+The region grows incrementally: candidates are combined and padded by value,
+only the final spreaded regions are put on the heap, and a candidate that
+doesn't grow the spreaded region is added without analysing the border again.
 */
 RegionI& RegionFieldFeatureDetector::spreadRegion_(
     const RegionI& seedRegion,
@@ -839,32 +896,21 @@ RegionI& RegionFieldFeatureDetector::spreadRegion_(
     const unsigned int seedRegionID,
     const std::vector<RegionI>& regions)
 {
-    // Copy original region, and store in data
-    RegionI* spreadedRegion = new RegionI(seedRegion);
-    seedRegionData.spreadedRegion = spreadedRegion;
-    seedRegionData.relatedRegions.push_back(spreadedRegion);
-
-    // Pad original region, and store in data
-    RegionI* spreadedRegionWithPadding = padRegion_(seedRegion, seedRegionData);
-    seedRegionData.spreadedRegionWithPadding = spreadedRegionWithPadding;
-    seedRegionData.relatedRegions.push_back(spreadedRegionWithPadding);
-
+    // Copy and pad original region
+    RegionI spreadedRegion(seedRegion);
+    RegionI spreadedRegionWithPadding = padRegion_(seedRegion);
 
     // Analyse region border
-    std::vector<int> regionEndsBorder;
-    std::vector<Point, Eigen::aligned_allocator<Point> > regionEnds;
-    std::vector<int> regionEndSizes;
-    std::vector<std::pair<int, int> > borderEndPairs;
-    std::vector<std::pair<Point, Point> > regionEndXYPairs;
+    RegionEnds regionEnds;
 
     IF_FIELD_FEATURE_TIMINGS(spreadRegionAnalyseRegionBorderTimer.restart();)
 
-    analyseRegionBorder_(*spreadedRegionWithPadding,
-                         regionEndsBorder,
-                         regionEnds,
-                         regionEndSizes,
-                         borderEndPairs,
-                         regionEndXYPairs);
+    analyseRegionBorder_(spreadedRegionWithPadding,
+                         regionEnds.border,
+                         regionEnds.ends,
+                         regionEnds.sizes,
+                         regionEnds.borderPairs,
+                         regionEnds.xyPairs);
 
     IF_FIELD_FEATURE_TIMINGS(
         spreadRegionAnalyseRegionBorderTime +=
@@ -881,7 +927,7 @@ RegionI& RegionFieldFeatureDetector::spreadRegion_(
     IF_FIELD_FEATURE_TIMINGS(findOverlappingRegionIDsTimer.restart();)
 
     std::vector<int> overLappingRegionIDs =
-        findOverlappingRegionIDs_(*spreadedRegion, regions);
+        findOverlappingRegionIDs_(spreadedRegion, regions);
 
     IF_FIELD_FEATURE_TIMINGS(findOverlappingRegionIDsTime += findOverlappingRegionIDsTimer.elapsed_us();)
 
@@ -895,6 +941,9 @@ RegionI& RegionFieldFeatureDetector::spreadRegion_(
             regionsSpreadStatus[*it] = SPREAD_REGION_POTENTIAL_SPREAD;
     }
 
+    // Experimental spread
+    RegionEnds regionEndsExperiment;
+
     // Replace following for loop with this while loop to allow spreading until
     // no more spreadable regions.
     // while (std::find(
@@ -931,31 +980,34 @@ RegionI& RegionFieldFeatureDetector::spreadRegion_(
                 it != potentialSpreadRegionIDs.end();
                 ++it)
         {
-            // Experimental spread
-            std::vector<int> regionEndsBorderExperiment;
-            std::vector<Point, Eigen::aligned_allocator<Point> > regionEndsExperiment;
-            std::vector<int> regionEndSizesExperiment;
-            std::vector<std::pair<int, int> > borderEndPairsExperiment;
-            std::vector<std::pair<Point, Point> > regionEndXYPairsExperiment;
-
-            // Experimentally combine and pad region
-            RegionI* experimentalSpreadRegion =
-                combineRegions_(*spreadedRegion, regions[*it]);
-            RegionI* experimentalSpreadRegionPadded =
-                padRegion_(*experimentalSpreadRegion, seedRegionData);
-
-            // add the regions to relatedRegions (so they get deleted at the end)
-            seedRegionData.relatedRegions.push_back(experimentalSpreadRegion);
-            seedRegionData.relatedRegions.push_back(experimentalSpreadRegionPadded);
+            // Experimentally combine region
+            RegionI experimentalSpreadRegion =
+                combineRegions_(spreadedRegion, regions[*it]);
+
+            // A region inside the spreaded region leaves it, its padding and
+            // so its ends as they were, so spreading succeeds as is.
+            if (experimentalSpreadRegion.getBoundingBoxRaw() ==
+                    spreadedRegion.getBoundingBoxRaw() &&
+                experimentalSpreadRegion.getInternalFovea() ==
+                    spreadedRegion.getInternalFovea())
+            {
+                seedRegionData.neighborRegionIDs.push_back(*it);
+                regionsSpreadStatus[*it] = SPREAD_REGION_ADDED;
+                continue;
+            }
+
+            RegionI experimentalSpreadRegionPadded =
+                padRegion_(experimentalSpreadRegion);
 
             IF_FIELD_FEATURE_TIMINGS(spreadRegionAnalyseRegionBorderTimer.restart();)
 
-            analyseRegionBorder_(*experimentalSpreadRegionPadded,
-                                regionEndsBorderExperiment,
-                                regionEndsExperiment,
-                                regionEndSizesExperiment,
-                                borderEndPairsExperiment,
-                                regionEndXYPairsExperiment);
+            regionEndsExperiment.clear();
+            analyseRegionBorder_(experimentalSpreadRegionPadded,
+                                regionEndsExperiment.border,
+                                regionEndsExperiment.ends,
+                                regionEndsExperiment.sizes,
+                                regionEndsExperiment.borderPairs,
+                                regionEndsExperiment.xyPairs);
 
             IF_FIELD_FEATURE_TIMINGS(
                 spreadRegionAnalyseRegionBorderTime +=
@@ -963,21 +1015,13 @@ RegionI& RegionFieldFeatureDetector::spreadRegion_(
             )
 
             // If number of region ends didn't change, then spreading succeeded! Update
-            // spreadedRegion and spreadedRegionWithPadding. Store these in seedRegionData.
-            // Also,update all "end" information
-            if (regionEndsExperiment.size() == regionEnds.size()){
+            // spreadedRegion, spreadedRegionWithPadding and all "end" information.
+            if (regionEndsExperiment.ends.size() == regionEnds.ends.size()){
                 // Update information
                 spreadedRegion = experimentalSpreadRegion;
                 spreadedRegionWithPadding = experimentalSpreadRegionPadded;
-                regionEndsBorder = regionEndsBorderExperiment;
-                regionEnds = regionEndsExperiment;
-                regionEndSizes = regionEndSizesExperiment;
-                borderEndPairs = borderEndPairsExperiment;
-                regionEndXYPairs = regionEndXYPairsExperiment;
-                // Update seedRegionData
+                regionEnds.swap(regionEndsExperiment);
                 seedRegionData.neighborRegionIDs.push_back(*it);
-                seedRegionData.spreadedRegion = spreadedRegion;
-                seedRegionData.spreadedRegionWithPadding = spreadedRegionWithPadding;
 
                 // Mark region as SPREAD_REGION_ADDED
                 regionsSpreadStatus[*it] = SPREAD_REGION_ADDED;
@@ -991,7 +1035,7 @@ RegionI& RegionFieldFeatureDetector::spreadRegion_(
         IF_FIELD_FEATURE_TIMINGS(findOverlappingRegionIDsTimer.restart();)
 
         std::vector<int> overLappingRegionIDs =
-            findOverlappingRegionIDs_(*spreadedRegion, regions);
+            findOverlappingRegionIDs_(spreadedRegion, regions);
 
         IF_FIELD_FEATURE_TIMINGS(
             findOverlappingRegionIDsTime +=
@@ -1009,12 +1053,21 @@ RegionI& RegionFieldFeatureDetector::spreadRegion_(
         }
     }
 
+    // Store the spreaded regions in data, which deletes them at the end of the
+    // frame.
+    seedRegionData.spreadedRegion = new RegionI(spreadedRegion);
+    seedRegionData.relatedRegions.push_back(seedRegionData.spreadedRegion);
+    seedRegionData.spreadedRegionWithPadding =
+                                        new RegionI(spreadedRegionWithPadding);
+    seedRegionData.relatedRegions.push_back(
+                                    seedRegionData.spreadedRegionWithPadding);
+
     // Store all information
-    seedRegionData.regionEndsBorder = regionEndsBorder;
-    seedRegionData.regionEnds = regionEnds;
-    seedRegionData.regionEndSizes = regionEndSizes;
-    seedRegionData.borderEndPairs = borderEndPairs;
-    seedRegionData.regionEndXYPairs = regionEndXYPairs;
+    seedRegionData.regionEndsBorder.swap(regionEnds.border);
+    seedRegionData.regionEnds.swap(regionEnds.ends);
+    seedRegionData.regionEndSizes.swap(regionEnds.sizes);
+    seedRegionData.borderEndPairs.swap(regionEnds.borderPairs);
+    seedRegionData.regionEndXYPairs.swap(regionEnds.xyPairs);
 
     IF_RFFD_USING_VATNAO(
         // Draw Region
@@ -1033,15 +1086,17 @@ RegionI& RegionFieldFeatureDetector::spreadRegion_(
         }
 
         // Redo the border.
-        analyseRegionBorder_(*spreadedRegionWithPadding, regionEndsBorder,
-                    regionEnds, regionEndSizes, borderEndPairs, regionEndXYPairs);
+        RegionEnds debugEnds;
+        analyseRegionBorder_(spreadedRegionWithPadding, debugEnds.border,
+                    debugEnds.ends, debugEnds.sizes, debugEnds.borderPairs,
+                                                            debugEnds.xyPairs);
 
         // Show regionEnds
         if (vdm != NULL && q.options["Show RegionEnds"] == "true" &&
             vdm->vision_debug_blackboard.values["REQUESTED_REGION"] == 1)
         {
-            for (std::vector<std::pair<Point, Point> >::iterator it = regionEndXYPairs.begin();
-                it != regionEndXYPairs.end();
+            for (std::vector<std::pair<Point, Point> >::iterator it = debugEnds.xyPairs.begin();
+                it != debugEnds.xyPairs.end();
                 ++it)
             {
                 p->draw((*it).first.x(), (*it).first.y(), VisionPainter::BLACK);
@@ -1050,7 +1105,7 @@ RegionI& RegionFieldFeatureDetector::spreadRegion_(
         }
     )
 
-    return *spreadedRegionWithPadding;
+    return *seedRegionData.spreadedRegionWithPadding;
 }
 
 /*
@@ -1102,9 +1157,9 @@ std::vector<int> RegionFieldFeatureDetector::findOverlappingRegionIDs_(
 }
 
 /*
-Combine two regions, return pointer to new region
+Combine two regions into the region covering both
 */
-RegionI* RegionFieldFeatureDetector::combineRegions_(
+RegionI RegionFieldFeatureDetector::combineRegions_(
     const RegionI& region1,
     const RegionI& region2)
 {
@@ -1127,17 +1182,13 @@ RegionI* RegionFieldFeatureDetector::combineRegions_(
     const BBox combinedBBox(Point(combinedBBoxAX, combinedBBoxAY),
                             Point(combinedBBoxBX, combinedBBoxBY));
 
-    RegionI* combinedRegion = new RegionI(region1.subRegion(combinedBBox));
-
-    return combinedRegion;
+    return region1.subRegion(combinedBBox);
 }
 
 /*
 Pad region to ensure the feature is included and not unnecesarily touching the border
 */
-RegionI* RegionFieldFeatureDetector::padRegion_(
-    const RegionI& region,
-    FieldFeatureRegionData& data)
+RegionI RegionFieldFeatureDetector::padRegion_(const RegionI& region)
 {
     const BBox originalBoundsRaw = region.getBoundingBoxRaw();
     BBox newBoundsRaw = region.getBoundingBoxRaw();
@@ -1168,9 +1219,7 @@ RegionI* RegionFieldFeatureDetector::padRegion_(
               (newBoundsRaw.b.y() - originalBoundsRaw.a.y()) / density)
     );
 
-    RegionI *paddedRegion = new RegionI(region.subRegion(newBoundsFovea));
-
-    return paddedRegion;
+    return region.subRegion(newBoundsFovea);
 }
 
 /*
@@ -1199,13 +1248,12 @@ void RegionFieldFeatureDetector::analyseRegionBorder_(
 
     // Construct a vector of booleans indicating whether or not the pixel along
     // the border is white or not.
-    const std::vector<bool> border =
-        constructBorder_(region, numCols, numRows, borderLength);
+    constructBorder_(region, numCols, numRows, borderLength, border_);
 
     findRegionEnds_(region,
                     numCols,
                     numRows,
-                    border,
+                    border_,
                     borderLength,
                     regionEndsBorder,
                     regionEnds,
@@ -1217,17 +1265,18 @@ void RegionFieldFeatureDetector::analyseRegionBorder_(
 
 
 /*
-Construct a vector of booleans indicating whether or not the pixel along
-the border is white or not.
+Fill border with booleans indicating whether or not the pixel along the border
+is white or not.
 */
-const std::vector<bool> RegionFieldFeatureDetector::constructBorder_(
+void RegionFieldFeatureDetector::constructBorder_(
     const RegionI& region,
     const int numCols,
     const int numRows,
-    const int borderLength)
+    const int borderLength,
+    std::vector<bool>& border)
 {
     // Make space for the border points.
-    std::vector<bool> border(borderLength);
+    border.resize(borderLength);
 
     // Get an iterator to the upper left of the region.
     RegionI::iterator_fovea curPixel = region.begin_fovea();
@@ -1306,8 +1355,6 @@ const std::vector<bool> RegionFieldFeatureDetector::constructBorder_(
             }
         }
     )
-
-    return border;
 }
 
 /*
@@ -1624,224 +1671,38 @@ void RegionFieldFeatureDetector::findRegionEnds_(
 
 }
 
+namespace {
+    /*
+    Non white pixels, noting whether any are body parts.
+    */
+    struct NotWhiteNoteBodyPart
+    {
+        explicit NotWhiteNoteBodyPart(bool* has_body_part) :
+            has_body_part(has_body_part) {}
+        bool operator()(int, int, Colour colour) const
+        {
+            if (colour == cBODY_PART)
+                *has_body_part = true;
+            return colour != cWHITE;
+        }
+        bool* has_body_part;
+    };
+}
+
 /*
 Check if there is internal black region in a petential penalty cross
 */
 void RegionFieldFeatureDetector::checkInternalNotWhiteRegion(const RegionI& base_region)
 {
-    // Reset group_links for use.
-    group_links_.fullReset();
-
-    // Clear the data vectors (hopefully leaving space allocated).
-
-    // The number of pixels in each group.
-    group_counts_.clear();
-
-    // The smallest x value in each group.
-    group_low_xs_.clear();
-
-    // The largest x value in each group.
-    group_high_xs_.clear();
-
-    // The smallest y value in each group.
-    group_low_ys_.clear();
-
-    // The largest y value in each group.
-    group_high_ys_.clear();
-
-    // Number of white pixels Connected Component Analysis
-    num_whites = 0;
-
     // Whether connected component analysis detected body part
     has_body_part = false;
 
-    // Set to USHRT_MAX when there is no neighbour.
-    uint16_t top_neighbour = USHRT_MAX;
-    uint16_t left_neighbour = USHRT_MAX;
-    bool has_neighbour = false;
-
-    // Iterator that move through the region.
-    RegionI::iterator_fovea cur_point = base_region.begin_fovea();
-
-    // Track the literal location of the iterators.
-    int x = 0;
-    int y = 0;
-
-    // A pointer tracking through the underlying array of groups.
-    uint16_t* group = groups_;
-
-    // The number of rows and columns in the region.
-    int rows = base_region.getRows();
-    int cols = base_region.getCols();
     // Connected component analysis.
+    components_.label(base_region, NotWhiteNoteBodyPart(&has_body_part));
 
-    for(int pixel=0; pixel < cols*rows; ++pixel)
-    {
-        // If this is not a white pixel, group it.
-        if (cur_point.colour() != cWHITE)
-        {
-            if (cur_point.colour() == cBODY_PART)
-                has_body_part = true;
-
-            // Get all neighbours.
-            has_neighbour = false;
-            if (x != 0 && (cur_point.colourLeft() != cWHITE))
-            {
-                left_neighbour = *(group-1);
-                has_neighbour = true;
-            }
-            else
-                left_neighbour = USHRT_MAX;
-
-            if (y != 0 && (cur_point.colourAbove() != cWHITE))
-            {
-                top_neighbour = *(group-cols);
-                has_neighbour = true;
-            }
-            else
-                top_neighbour = USHRT_MAX;
-
-            // If there are no neighbours create a new label.
-            if(!has_neighbour)
-            {
-                // Try to add the new group. If this fails, the group cap has
-                // been hit and CCA should terminate.
-                if(!group_links_.newGroup())
-                    break;
-
-                *group = group_links_.size()-1;
-                group_low_xs_.push_back(x);
-                group_high_xs_.push_back(x);
-                group_low_ys_.push_back(y);
-                group_high_ys_.push_back(y);
-                group_counts_.push_back(1);
-            }
-            // If there is a neighbour build components.
-            else
-            {
-                if(top_neighbour < left_neighbour)
-                {
-                    // Set the pixel's group.
-                    *group = top_neighbour;
-
-                    // Add a parent to the left neighbour if needed.
-                    if(left_neighbour != USHRT_MAX)
-                    {
-                        bool new_link;
-                        new_link = group_links_.addLink(left_neighbour,
-                                                                top_neighbour);
-                        if(new_link)
-                        {
-                            push_heap(group_links_.begin(left_neighbour),
-                                    group_links_.end(left_neighbour),
-                                                        std::greater<int>());
-                        }
-                    }
-
-                    // Update bounding box.
-                    group_counts_[top_neighbour] += 1;
-                    if(group_high_xs_[top_neighbour] < x) {
-                        group_high_xs_[top_neighbour] = x;
-                    }
-                    if(group_high_ys_[top_neighbour] < y) {
-                        group_high_ys_[top_neighbour] = y;
-                    }
-                }
-                else
-                {
-                    // Set the pixel's group.
-                    *group = left_neighbour;
-
-                    // Add a parent to the top neighbour if needed.
-                    if(top_neighbour != USHRT_MAX)
-                    {
-                        bool new_link;
-                        new_link = group_links_.addLink(top_neighbour,
-                                                                left_neighbour);
-                        if(new_link)
-                        {
-                            push_heap(group_links_.begin(top_neighbour),
-                                    group_links_.end(top_neighbour),
-                                                        std::greater<int>());
-                        }
-                    }
-
-                    // Update bounding box.
-                    group_counts_[left_neighbour] += 1;
-                    if(group_high_xs_[left_neighbour] < x)
-                        group_high_xs_[left_neighbour] = x;
-                    if(group_high_ys_[left_neighbour] < y)
-                        group_high_ys_[left_neighbour] = y;
-                }
-            }
-        } else {
-            num_whites++;
-        }
-
-        ++x;
-        ++group;
-        ++cur_point;
-        if(x == cols)
-        {
-            x = 0;
-            ++y;
-        }
-    }
-
-    // Don't need a full second pass as we only need bounding boxes. Combining
-    // by grabbing pixel location extremes is sufficient. May be a faster way
-    // to implement this.
-
-    // Find the parent group for each group.
-    bool changed = true;
-    while(changed)
-    {
-        changed = false;
-        for(int group=0; group<group_links_.size(); group++)
-        {
-            // Tell all linked groups the lowest linked group.
-            for(int owner=1; owner<group_links_.size(group); owner++)
-            {
-                // Insert in sorted order.
-                changed = true;
-                if(group_links_.get(group, owner) != group)
-                {
-                    bool new_link;
-                    new_link = group_links_.addLink(group_links_.get(group, owner),
-                                                    group_links_.get(group, 0));
-                    if(new_link)
-                    {
-                        push_heap(group_links_.begin(
-                            group_links_.get(group, owner)),
-                            group_links_.end(group_links_.get(group, owner)),
-                                                        std::greater<int>());
-                    }
-                }
-            }
-
-            // Delete all but the lowest owner.
-            group_links_.clearHigh(group);
-        }
-    }
-
-    // Apply combinations.
-    for(int group=group_links_.size()-1; group>=0; group--)
-    {
-        int owner = group_links_.get(group, 0);
-        if(owner != group)
-        {
-            group_counts_[owner] += group_counts_[group];
-            group_counts_[group] = 0;
-            if(group_low_xs_[group] < group_low_xs_[owner])
-                group_low_xs_[owner] = group_low_xs_[group];
-            if(group_low_ys_[group] < group_low_ys_[owner])
-                group_low_ys_[owner] = group_low_ys_[group];
-            if(group_high_xs_[group] > group_high_xs_[owner])
-                group_high_xs_[owner] = group_high_xs_[group];
-            if(group_high_ys_[group] > group_high_ys_[owner])
-                group_high_ys_[owner] = group_high_ys_[group];
-        }
-    }
+    // Number of white pixels Connected Component Analysis
+    num_whites = base_region.getRows() * base_region.getCols() -
+        components_.area();
 }
 
 /*
@@ -2029,10 +1890,12 @@ void RegionFieldFeatureDetector::determineIfPenaltyCross(const VisionInfoIn& inf
 
 
     int numBlackRegion = 0;
-    for(int group=0; group<group_links_.size(); group++)
+    const std::vector<ConnectedComponents::Component>& groups =
+        components_.components();
+    for(unsigned int group=0; group<groups.size(); group++)
     {
         // Check the group actually has pixels.
-        if(group_counts_[group] >= min_group_count)
+        if(groups[group].area >= min_group_count)
         {
             ++numBlackRegion;
 
@@ -2043,10 +1906,10 @@ void RegionFieldFeatureDetector::determineIfPenaltyCross(const VisionInfoIn& inf
                     && vdm->vision_debug_blackboard.values["REQUESTED_REGION"] == 1)
                 {
                     p->drawRect(
-                        group_low_xs_[group],
-                        group_low_ys_[group],
-                        group_high_xs_[group] - group_low_xs_[group],
-                        group_high_ys_[group] - group_low_ys_[group],
+                        groups[group].min_x,
+                        groups[group].min_y,
+                        groups[group].max_x - groups[group].min_x,
+                        groups[group].max_y - groups[group].min_y,
                         VisionPainter::BLUE);
                 }
             )
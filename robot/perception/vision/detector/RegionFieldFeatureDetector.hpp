@@ -4,16 +4,15 @@
 #include "DetectorInterface.hpp"
 
 #include "perception/vision/VisionDefinitions.hpp"
+#include "perception/vision/other/ConnectedComponents.hpp"
 #include "perception/vision/other/GMM_classifier.hpp"
+#include "perception/vision/other/RoiSchedule.hpp"
 
 #include "utils/Timer.hpp"
-#include "types/GroupLinks.hpp"
 
 // Whether to make and output time taken for field features components.
 // #define FIELD_FEATURE_TIMINGS
 
-#define MAX_RES TOP_IMAGE_COLS*TOP_IMAGE_ROWS
-
 class RegionFieldFeatureDetector : public Detector
 {
 
@@ -32,6 +31,9 @@ public:
         const VisionInfoIn& info_in,
         VisionInfoMiddle& info_middle,
         VisionInfoOut& info_out);
+    uint32_t reads() const { return vdROI; }
+    uint32_t writes() const
+        { return vdFIELD_FEATURE_DATA | vdFEATURES | vdCHILD_FOVEAE; }
 
 private:
 
@@ -64,18 +66,16 @@ private:
         const std::vector<RegionI>& regions);
 
     /*
-    Combine two regions, return pointer to new region
+    Combine two regions into the region covering both
     */
-    RegionI* combineRegions_(
+    RegionI combineRegions_(
         const RegionI& region1,
         const RegionI& region2);
 
     /*
     Pad region to ensure the feature is included and not unnecesarily touching the border
     */
-    RegionI* padRegion_(
-        const RegionI& region,
-        FieldFeatureRegionData& data);
+    RegionI padRegion_(const RegionI& region);
 
     /*
     Analyses region border. Populates regionEndsBorder, regionEnds,
@@ -90,14 +90,15 @@ private:
         std::vector<std::pair<Point, Point> >& regionEndXYPairs);
 
     /*
-    Construct a vector of booleans indicating whether or not the pixel along
-    the border is white or not.
+    Fill border with booleans indicating whether or not the pixel along the
+    border is white or not.
     */
-    const std::vector<bool> constructBorder_(
+    void constructBorder_(
         const RegionI& region,
         const int numCols,
         const int numRows,
-        const int borderLength);
+        const int borderLength,
+        std::vector<bool>& border);
 
     /*
     Find the "ends" of each region. Populates regionEndsBorder, regionEnds, regionEndSizes,
@@ -403,26 +404,13 @@ private:
         Point startIntersection, Point endIntersection,
               std::vector<Point, Eigen::aligned_allocator<Point> >& edgePoints);
 
-    // The set of links between groups generated during determine penalty cross.
-    GroupLinks group_links_;
-
-    // The ID of the group for each pixel.
-    uint16_t groups_[MAX_RES];
+    // The groups of non white pixels found when determining penalty crosses.
+    ConnectedComponents components_;
 
-    // The number of pixels in each group.
-    std::vector<int> group_counts_;
-
-    // The smallest x value in each group.
-    std::vector<int> group_low_xs_;
-
-    // The largest x value in each group.
-    std::vector<int> group_high_xs_;
-
-    // The smallest y value in each group.
-    std::vector<int> group_low_ys_;
-
-    // The largest y value in each group.
-    std::vector<int> group_high_ys_;
+    // The time region analysis takes per pixel, and the regions the
+    // schedule leaves time to analyse this frame.
+    RoiSchedule::Cost cost_;
+    std::vector<bool> chosen_;
 
     // Number of white pixels Connected Component Analysis
     int num_whites;
@@ -443,6 +431,10 @@ private:
     std::vector<Point, Eigen::aligned_allocator<Point> > firstEdge;
     std::vector<Point, Eigen::aligned_allocator<Point> > secondEdge;
 
+    // The border of the region being analysed, kept between regions so
+    // spreading doesn't allocate one for every region it tries.
+    std::vector<bool> border_;
+
 #ifdef FIELD_FEATURE_TIMINGS
     // Count to determine when timings should be output.
     int frameCount;
@@ -68,10 +68,21 @@ RobotDetector::RobotDetector() {
     #endif
 }
 
+void RobotDetector::setForestModel(bool model) {
+    forest_ = ForestModel();
+    if (model) {
+        forest_.load(getHomeNao(FOREST_MODEL_DIR_ROBOT));
+    }
+}
+
 Detector *newRobotDetector() {
    return new RobotDetector();
 }
 
+void setRobotDetectorForest(Detector *detector, bool model) {
+   static_cast<RobotDetector*>(detector)->setForestModel(model);
+}
+
 void RobotDetector::detect(const VisionInfoIn& info_in, VisionInfoMiddle& info_middle, VisionInfoOut& info_out) {
 
     IF_RD_USING_VATNAO(
@@ -181,6 +192,7 @@ void RobotDetector::runColorRoi(const VisionInfoIn& info_in, VisionInfoMiddle& i
 
 	//ensure to clear out existing rois
 	info_middle.roi.clear();
+	info_middle.roi_ranking = 0;
 
 	// Run the region finder. This will update info_middle
 	regionFinder->find(info_in, info_middle, info_out);
@@ -198,6 +210,7 @@ void RobotDetector::runBasepointScanner(const VisionInfoIn& info_in, VisionInfoM
 
 	//ensure to clear out existing rois
 	info_middle.roi.clear();
+	info_middle.roi_ranking = 0;
 
   float windowSize = 10; // pixels
   float RATIO_TO_CONSIDER_ROBOT = 0.8;
@@ -365,19 +378,49 @@ void RobotDetector::findRobots(VisionInfoMiddle& info_mid, VisionInfoOut& info_o
 
     std::vector<RobotVisionInfo> robots;
 
+#ifdef CTC_2_1
+    // Extract the features of every candidate first, so the forest
+    // classifies them all in one batch
+    std::vector<size_t> classified;
+    std::vector<float> features;
+    for(size_t i = 0; i < candidates.size(); ++i) {
+        BBox bound = candidates[i].box_;
+        if (bound.width() > bound.height()) continue;
+        featureExtraction(info_mid, candidates[i].fbox_, features);
+        classified.push_back(i);
+    }
+
+    std::vector<int> classifications(classified.size());
+    std::vector<float> confidences(classified.size());
+    if (!classified.empty()) {
+        // Without a model, or with one trained on other features, the
+        // generated forest classifies them
+        if (!forest_.empty() &&
+                forest_.numFeatures() * classified.size() == features.size()) {
+            forest_.classify(&features[0], classified.size(),
+                             &classifications[0], &confidences[0]);
+        } else {
+            const size_t num_features = features.size() / classified.size();
+            for(size_t j = 0; j < classified.size(); ++j) {
+                std::vector<float> sample(features.begin() + j * num_features,
+                                          features.begin() + (j + 1) * num_features);
+                classifications[j] = classifier_.classify(sample, confidences[j]);
+            }
+        }
+    }
+    for(size_t j = 0; j < classified.size(); ++j) {
+        candidates[classified[j]].isRobot_ = classifications[j];
+        candidates[classified[j]].confidence_ = confidences[j];
+    }
+#endif
+
     for(size_t i = 0; i < candidates.size(); ++i) {
         BBox bound = candidates[i].box_;
         if (bound.width() > bound.height()) continue;
 
         #ifdef CTC_2_1
 
-        std::vector<float> features;
-        featureExtraction(info_mid, candidates[i].fbox_, features);
-        float confidence;
-        int classification = classifier_.classify(features, confidence);
-        candidates[i].isRobot_ = classification;
-        candidates[i].confidence_ = confidence;
-        if(classification == 0||confidence <= 0.7)
+        if(!candidates[i].isRobot_||candidates[i].confidence_ <= 0.7)
             continue;
 
         #else
@@ -6,6 +6,7 @@
 
 #include "../regionfinder/RobotColorROI.hpp"
 #include "RandomForest.hpp"
+#include "ForestModel.hpp"
 #include <Eigen/Eigen>
 #include <algorithm>
 #include <iostream>
@@ -98,6 +99,12 @@ public:
 	RobotDetector();
 	void detect(const VisionInfoIn& info_in, VisionInfoMiddle& info_middle, VisionInfoOut& info_out);
 
+    /**
+     * Whether to classify with the forest in FOREST_MODEL_DIR_ROBOT rather
+     * than the generated one, which is the default as it is faster.
+     */
+    void setForestModel(bool model);
+
 private:
 
     RegionI* newTop_;
@@ -105,6 +112,10 @@ private:
 
     RandomForest classifier_;
 
+    // Loaded from FOREST_MODEL_DIR_ROBOT if setForestModel asks for it, with
+    // classifier_ as the fallback if it can't be. Empty otherwise
+    ForestModel forest_;
+
     RobotColorROI* regionFinder;
 
     std::vector<Cluster> clusters;
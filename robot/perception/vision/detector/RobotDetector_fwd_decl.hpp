@@ -7,9 +7,12 @@
 #ifndef RUNSWIFT_ROBOTDETECTOR_FWD_DECL_HPP
 #define RUNSWIFT_ROBOTDETECTOR_FWD_DECL_HPP
 
+#include <string>
 #include "DetectorInterface.hpp"
 
 Detector *newRobotDetector();
 Detector *newSSRobotDetector();
+void setSSRobotDetectorEngine(Detector *detector, std::string const& engine);
+void setRobotDetectorForest(Detector *detector, bool model);
 
 #endif //RUNSWIFT_ROBOTDETECTOR_FWD_DECL_HPP
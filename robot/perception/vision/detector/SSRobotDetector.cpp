@@ -16,18 +16,29 @@
 #include <tiny_dnn/activations/relu_layer.h>
 #include <tiny_dnn/activations/silu_layer.h>
 #include <tiny_dnn/activations/sigmoid_layer.h>
+#include "perception/vision/other/ImagePyramid.hpp"
 #include "utils/eigen_helpers.hpp"
 #include "utils/home_nao.hpp"
+#include "utils/Logger.hpp"
 
 SSRobotDetector::SSRobotDetector(){
     constructNet(nn);
     loadWeights(SSRobotDetector::weight_path, nn);
+    #ifndef RD_USE_PIXEL_CLASSIFIER
+    for (int level = 0; level < 256; ++level) {
+        levels_[level] = level / 255.0f;
+    }
+    #endif // RD_USE_PIXEL_CLASSIFIER
 }
 
 Detector *newSSRobotDetector() {
     return new SSRobotDetector();
 }
 
+void setSSRobotDetectorEngine(Detector *detector, std::string const& engine) {
+    static_cast<SSRobotDetector*>(detector)->setEngine(engine);
+}
+
 void SSRobotDetector::detect(VisionInfoIn const& info_in, VisionInfoMiddle& info_middle, VisionInfoOut& info_out) {
     #ifdef RD_USE_PIXEL_CLASSIFIER
     std::cout << "Pixel classifier detect\n";
@@ -58,20 +69,38 @@ void SSRobotDetector::detect(VisionInfoIn const& info_in, VisionInfoMiddle& info
     
     
     #else
-    // Step 1 - Get top camera image (default wxh: 320x240)
-    BBox full_bound = BBox(Point(0,0), Point(TOP_IMAGE_ROWS-1, TOP_IMAGE_COLS-1)); 
-    RegionI *top_region = new RegionI(info_middle.full_regions[0].subRegion(full_bound));
-    
-    // STEP 2 - Normalise grayscale image and convert to vec_t 
-    tiny_dnn::vec_t dnn_image = convertVecT(*top_region); 
-    tiny_dnn::vec_t dnn_image_resized = resizeImage(dnn_image, 320, 240, SSRobotDetector::in_width, SSRobotDetector::in_height);
-
-    // Step 3 - Pass image through net
-    tiny_dnn::vec_t output = nn.predict(dnn_image_resized);
-    
-    // Step 4 - Extract candidate bboxes from output
+    // Step 1 - Get the top camera image from the pyramid, at the coarsest
+    // density that is still no smaller than the input (default wxh: 320x240)
+    const ImagePyramid& pyramid = *info_middle.top_pyramid;
+    int density = 1;
+    while (ImagePyramid::hasDensity(density * 2) &&
+           pyramid.cols(density * 2) >= int(SSRobotDetector::in_width) &&
+           pyramid.rows(density * 2) >= int(SSRobotDetector::in_height)) {
+        density *= 2;
+    }
+    const uint8_t *grey = pyramid.y(density);
+    if (!grey) {
+        return;
+    }
+    const int cols = pyramid.cols(density);
+    const int rows = pyramid.rows(density);
     std::vector<tiny_dnn::bounding_box> bboxes;
-    SSRobotDetector::getCandidates(output, bboxes, anchors);
+
+    if (packed_) {
+        // Steps 2 to 4, with the image resized straight into the packed engine's input
+        fillPackedInput(grey, cols, rows);
+        SSRobotDetector::getCandidates(packed_->run(), bboxes, anchors);
+    } else {
+        // STEP 2 - Normalise grayscale image and convert to vec_t 
+        tiny_dnn::vec_t dnn_image = convertVecT(grey, cols, rows);
+        tiny_dnn::vec_t dnn_image_resized = resizeImage(dnn_image, cols, rows, SSRobotDetector::in_width, SSRobotDetector::in_height);
+
+        // Step 3 - Pass image through net
+        tiny_dnn::vec_t output = nn.predict(dnn_image_resized);
+
+        // Step 4 - Extract candidate bboxes from output
+        SSRobotDetector::getCandidates(&output[0], bboxes, anchors);
+    }
     
     // Step 5 - Apply NMS to get indices of final bboxes
     std::vector<int> keep_indices = tiny_dnn::nms(bboxes, SSRobotDetector::iou_thres);
@@ -103,6 +132,16 @@ tiny_dnn::vec_t SSRobotDetector::convertVecT(RegionI const& region) {
     return dnn_image;
 }
 
+#ifndef RD_USE_PIXEL_CLASSIFIER
+tiny_dnn::vec_t SSRobotDetector::convertVecT(uint8_t const* grey, int cols, int rows) {
+    tiny_dnn::vec_t dnn_image(rows * cols);
+    for (int pixel = 0; pixel < rows * cols; ++pixel) {
+        dnn_image[pixel] = levels_[grey[pixel]];
+    }
+    return dnn_image;
+}
+#endif // RD_USE_PIXEL_CLASSIFIER
+
 tiny_dnn::vec_t SSRobotDetector::resizeImage(tiny_dnn::vec_t const& src, int w1, int h1, int w2, int h2) {
     const float x_ratio = w1 / float(w2);
     const float y_ratio = h1 / float(h2);
@@ -230,6 +269,106 @@ std::vector<RobotVisionInfo> SSRobotDetector::getRobotsInfo(Eigen::MatrixXf& mat
 }
 #endif
 
+#ifndef RD_USE_PIXEL_CLASSIFIER
+void SSRobotDetector::fillPackedInput(uint8_t const* grey, int cols, int rows) {
+    // Nearest neighbour, sampling the same pixels as resizeImage
+    const float x_ratio = cols / float(SSRobotDetector::in_width);
+    const float y_ratio = rows / float(SSRobotDetector::in_height);
+    for (size_t i = 0; i < SSRobotDetector::in_height; ++i) {
+        const uint8_t *src = &grey[int(i * y_ratio) * cols];
+        float *dst = packed_->inputRow(i);
+        for (size_t j = 0; j < SSRobotDetector::in_width; ++j) {
+            dst[j] = levels_[src[int(j * x_ratio)]];
+        }
+    }
+}
+
+float SSRobotDetector::checkPackedEngine() {
+    // A fixed textured image, so the check does not depend on what the camera sees
+    tiny_dnn::vec_t image(SSRobotDetector::in_width * SSRobotDetector::in_height);
+    for (size_t i = 0; i < SSRobotDetector::in_height; ++i) {
+        float *dst = packed_->inputRow(i);
+        for (size_t j = 0; j < SSRobotDetector::in_width; ++j) {
+            dst[j] = levels_[((i ^ j) * 37 + i * j) & 0xff];
+            image[i * SSRobotDetector::in_width + j] = dst[j];
+        }
+    }
+
+    tiny_dnn::vec_t expected = nn.predict(image);
+    const float *actual = packed_->run();
+    float largest = 0.0f;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        largest = std::max(largest, std::fabs(actual[i] - expected[i]));
+    }
+    return largest;
+}
+#endif // RD_USE_PIXEL_CLASSIFIER
+
+void SSRobotDetector::setEngine(std::string const& engine) {
+    #ifdef RD_USE_PIXEL_CLASSIFIER
+    if (engine != "tinydnn") {
+        llog(WARNING) << "The pixel classifier robot detector only runs on tiny-dnn" << std::endl;
+    }
+    #else
+    packed_.reset();
+    if (engine == "tinydnn") {
+        llog(INFO) << "Robot detector engine: tinydnn" << std::endl;
+        return;
+    }
+    if (engine != "float" && engine != "int8" && engine != "reference") {
+        llog(ERROR) << "Unknown robot detector engine " << engine << ", using tinydnn" << std::endl;
+        return;
+    }
+
+    // Must match the YOLO network in constructNet
+    typedef PackedConvNet::Conv Conv;
+    const Conv convs[] = {
+        {256, 192, 1, 4, 3, 3, 2, 2, true, PackedConvNet::SILU},
+        {128, 96, 4, 4, 8, 3, 4, 2, true, PackedConvNet::SILU},
+        {32, 48, 4, 4, 3, 3, 1, 1, true, PackedConvNet::SILU},
+        {32, 48, 4, 8, 3, 3, 1, 2, true, PackedConvNet::SILU},
+        {32, 24, 8, 8, 3, 3, 1, 1, true, PackedConvNet::SILU},
+        {32, 24, 8, 12, 3, 3, 2, 2, true, PackedConvNet::SILU},
+        {16, 12, 12, 12, 3, 3, 1, 1, true, PackedConvNet::SILU},
+        {16, 12, 12, 16, 3, 3, 1, 1, true, PackedConvNet::SILU},
+        {16, 12, 16, 18, 1, 1, 1, 1, false, PackedConvNet::SIGMOID},
+    };
+    const size_t nb_convs = sizeof(convs) / sizeof(convs[0]);
+
+    PackedConvNet::Precision precision = engine == "int8" ? PackedConvNet::INT8 : PackedConvNet::FLOAT;
+    packed_.reset(new PackedConvNet(std::vector<Conv>(convs, convs + nb_convs), precision));
+    packed_->setReference(engine == "reference");
+
+    size_t conv = 0;
+    for (size_t i = 0; i < nn.layer_size(); ++i) {
+        if (nn[i]->layer_type() != "conv") {
+            continue;
+        }
+        std::vector<tiny_dnn::vec_t*> weights = nn[i]->weights();
+        if (conv == nb_convs || weights.size() != 2 || weights[0]->size() !=
+                size_t(convs[conv].out_channels * convs[conv].in_channels *
+                       convs[conv].window_width * convs[conv].window_height)) {
+            llog(ERROR) << "Robot detector network does not match the packed engine, using tinydnn" << std::endl;
+            packed_.reset();
+            return;
+        }
+        packed_->setWeights(conv++, &(*weights[0])[0], &(*weights[1])[0]);
+    }
+
+    // Float only reorders the sums; int8 may move the output probabilities a little
+    const float tolerance = precision == PackedConvNet::INT8 ? 0.05f : 1e-4f;
+    float difference = checkPackedEngine();
+    if (difference > tolerance) {
+        llog(ERROR) << "Robot detector engine " << engine << " differs from tinydnn by "
+                    << difference << ", using tinydnn" << std::endl;
+        packed_.reset();
+        return;
+    }
+    llog(INFO) << "Robot detector engine: " << engine << ", differs from tinydnn by "
+               << difference << std::endl;
+    #endif // RD_USE_PIXEL_CLASSIFIER
+}
+
 void SSRobotDetector::constructNet(tiny_dnn::network<tiny_dnn::sequential> &nn) {
     #ifdef RD_USE_PIXEL_CLASSIFIER
     using tiny_jnn::conv;
@@ -303,7 +442,7 @@ void SSRobotDetector::loadWeights(std::string const& path, tiny_dnn::network<tin
 
 
 #ifndef RD_USE_PIXEL_CLASSIFIER
-void SSRobotDetector::getCandidates(tiny_dnn::vec_t &output, std::vector<tiny_dnn::bounding_box> &bboxes, std::vector<std::vector<float>> const& anchors) {
+void SSRobotDetector::getCandidates(const float *output, std::vector<tiny_dnn::bounding_box> &bboxes, std::vector<std::vector<float>> const& anchors) {
     
     // Iterate through each cell
     for (size_t a = 0; a < SSRobotDetector::nb_anchors; ++a) { // iterate over anchors
@@ -15,6 +15,7 @@
 #include "tiny_dnn/network.h"
 #include "tiny_dnn/util/nms.h"
 #include "DNNHelper.hpp"
+#include "PackedConvNet.hpp"
 #include "utils/home_nao.hpp"
 
 //#define RD_USE_PIXEL_CLASSIFIER // otherwise use YOLO robot detector
@@ -23,6 +24,16 @@ class SSRobotDetector : public Detector {
 public:
     SSRobotDetector();
     void detect(VisionInfoIn const& info_in, VisionInfoMiddle& info_middle, VisionInfoOut& info_out); // called in Vision.cpp
+    uint32_t reads() const { return vdFULL_REGIONS; }
+    uint32_t writes() const { return vdROBOTS; }
+
+    /**
+     * Selects how the network runs: "tinydnn", or PackedConvNet with
+     * "float" or "int8" weights, or its scalar "reference" mode. A packed
+     * engine is checked against tiny-dnn first, and not used if its output
+     * differs by more than its precision allows.
+     */
+    void setEngine(std::string const& engine);
 private:
     RegionI* newTop_;
     tiny_dnn::network<sequential> nn;
@@ -38,7 +49,8 @@ private:
     Eigen::MatrixXf dnnPredict(vec_t const& img, network<sequential>& nn);
     const std::string weight_path = getHomeNao("data/vision/robotdetection/JNN7.weights");
     #else 
-    void getCandidates(tiny_dnn::vec_t &output, std::vector<tiny_dnn::bounding_box> &bboxes, std::vector<std::vector<float>> const& anchors);
+    tiny_dnn::vec_t convertVecT(uint8_t const* grey, int cols, int rows);
+    void getCandidates(const float *output, std::vector<tiny_dnn::bounding_box> &bboxes, std::vector<std::vector<float>> const& anchors);
     std::vector<RobotVisionInfo> getRobotsInfo(std::vector<tiny_dnn::bounding_box> &bboxes, std::vector<int> &keep_indices, VisionInfoOut& info_out);
 
     /*
@@ -62,6 +74,16 @@ private:
     const float conf_thres = 0.2f; // hyperparameter for obtaining candidate bboxes
     const float iou_thres = 0.4f;  // hyperparameter for NMS
 
+    /*
+     * The packed engine, NULL when running through tiny-dnn. It takes the
+     * resized image straight from the pyramid, without convertVecT and
+     * resizeImage allocating every frame.
+     */
+    std::unique_ptr<PackedConvNet> packed_;
+    float levels_[256]; // grey level / 255, as convertVecT normalises
+    void fillPackedInput(uint8_t const* grey, int cols, int rows);
+    float checkPackedEngine();
+
     #endif // RD_USE_PIXEL_CLASSIFIER
 };
 
@@ -1,7 +1,12 @@
 #include "FieldBoundaryFinder.hpp"
 
+#include <algorithm>
 #include <limits>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
 #include "perception/vision/other/Ransac.hpp"
 #include "perception/vision/VisionDefinitions.hpp"
 
@@ -21,11 +26,179 @@ const int VERTICAL_OFFSET = 50;
 
 const int FieldBoundaryFinder::consecutive_green = 2;
 
-FieldBoundaryFinder::FieldBoundaryFinder() {
+FieldBoundaryFinder::FieldBoundaryFinder() : searchWindow(0) {
    // reserve space for the maximum number of field boundary points we may have
    // note, this is a lot faster than letting the vector resize itself
    boundaryPointsTop.reserve(TOP_SALIENCY_COLS);
    boundaryPointsBot.reserve(BOT_SALIENCY_COLS);
+
+   std::fill(lastTopRows, lastTopRows + TOP_SALIENCY_COLS, -1);
+   std::fill(lastBotRows, lastBotRows + BOT_SALIENCY_COLS, -1);
+}
+
+/**
+ * Scans one column of colours, stride apart, from row begin to before row
+ * end, and returns the row the field starts at, or -1 if it does not.
+ *
+ * The field starts at the first of `consecutive_green' green pixels, which
+ * may have a single white or background pixel between them and may be
+ * preceded by a single white pixel.
+ */
+static int scanColumn(const Colour *column, int stride, int begin, int end,
+                      int consecutive_green)
+{
+   int green_count =  0;
+   int white_count =  0;
+   int overshoot   = -1;
+
+   for (int j = begin; j < end; ++ j) {
+      Colour c = column[j * stride];
+
+      if (c == cGREEN) {
+         ++ green_count;
+         ++ overshoot;
+         white_count = 0;
+
+         if (green_count == consecutive_green) {
+            return j - overshoot;
+         }
+      } else if ((c == cWHITE || c == cBACKGROUND)
+              && (white_count < 1 && green_count != 0))
+      {
+         /* Allow for white between two green pixels */
+         ++ overshoot;
+         ++ white_count;
+      } else if (c == cWHITE && green_count == 0) {
+         /* first pixel can be white */
+         overshoot   = 0;
+         white_count = 1;
+      } else {
+         green_count =  0;
+         white_count =  0;
+         overshoot   = -1;
+      }
+   }
+   return -1;
+}
+
+/**
+ * scanColumn for each of cols columns of a fovea, with begins[i] and ends[i]
+ * for column i, into found[i]. Columns with begins[i] >= ends[i] are not
+ * scanned.
+ *
+ * With SSE2, sixteen columns are scanned at once, a row at a time, with the
+ * scan's counters for each column in a 16 bit lane.
+ */
+static void scanColumns(const Colour *colour, int stride, int cols,
+                        const int *begins, const int *ends, int *found,
+                        int consecutive_green)
+{
+   int x = 0;
+#ifdef __SSE2__
+   const __m128i zero  = _mm_setzero_si128();
+   const __m128i one   = _mm_set1_epi16(1);
+   const __m128i green = _mm_set1_epi16(cGREEN);
+   const __m128i white = _mm_set1_epi16(cWHITE);
+   const __m128i background = _mm_set1_epi16(cBACKGROUND);
+   const __m128i consecutive = _mm_set1_epi16(consecutive_green);
+
+   for (; x + 16 <= cols; x += 16) {
+      // The rows any of the sixteen columns scan
+      int first = std::numeric_limits<int>::max();
+      int last_begin = 0, last_end = 0;
+      for (int i = x; i < x + 16; ++ i) {
+         if (begins[i] < ends[i]) {
+            first = std::min(first, begins[i]);
+            last_begin = std::max(last_begin, begins[i]);
+            last_end = std::max(last_end, ends[i]);
+         }
+      }
+
+      __m128i begin[2], end[2], green_count[2], white_count[2], overshoot[2];
+      __m128i result[2];
+      for (int half = 0; half < 2; ++ half) {
+         const int *b = begins + x + 8 * half;
+         const int *e = ends + x + 8 * half;
+         begin[half] = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)b),
+                                       _mm_loadu_si128((const __m128i*)(b + 4)));
+         end[half] = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)e),
+                                     _mm_loadu_si128((const __m128i*)(e + 4)));
+         green_count[half] = zero;
+         white_count[half] = zero;
+         overshoot[half] = _mm_set1_epi16(-1);
+         result[half] = _mm_set1_epi16(-1);
+      }
+
+      for (int j = first; j < last_end; ++ j) {
+         const __m128i row = _mm_set1_epi16(j);
+         int scanning = 0;
+         for (int half = 0; half < 2; ++ half) {
+            const Colour *c = colour + j * stride + x + 8 * half;
+            const __m128i pixels = _mm_packs_epi32(
+               _mm_loadu_si128((const __m128i*)c),
+               _mm_loadu_si128((const __m128i*)(c + 4)));
+
+            // Lanes between their begin and end that have not found the field
+            const __m128i active = _mm_andnot_si128(
+               _mm_or_si128(_mm_cmpgt_epi16(begin[half], row),
+                            _mm_cmpgt_epi16(result[half], _mm_set1_epi16(-1))),
+               _mm_cmpgt_epi16(end[half], row));
+            scanning |= _mm_movemask_epi8(active);
+
+            const __m128i is_white = _mm_cmpeq_epi16(pixels, white);
+            const __m128i no_green = _mm_cmpeq_epi16(green_count[half], zero);
+
+            // The branches of scanColumn, which are mutually exclusive
+            const __m128i g = _mm_and_si128(active, _mm_cmpeq_epi16(pixels, green));
+            const __m128i wb = _mm_and_si128(
+               _mm_andnot_si128(no_green, active),
+               _mm_and_si128(
+                  _mm_or_si128(is_white, _mm_cmpeq_epi16(pixels, background)),
+                  _mm_cmplt_epi16(white_count[half], one)));
+            const __m128i w0 = _mm_and_si128(_mm_and_si128(active, no_green),
+                                             is_white);
+            const __m128i other = _mm_andnot_si128(
+               _mm_or_si128(_mm_or_si128(g, wb), w0), active);
+
+            // A mask of all ones is -1, so subtracting it increments.
+            green_count[half] = _mm_andnot_si128(
+               other, _mm_sub_epi16(green_count[half], g));
+            overshoot[half] = _mm_or_si128(
+               _mm_andnot_si128(_mm_or_si128(w0, other),
+                                _mm_sub_epi16(overshoot[half],
+                                              _mm_or_si128(g, wb))),
+               other);
+            white_count[half] = _mm_or_si128(
+               _mm_andnot_si128(_mm_or_si128(_mm_or_si128(g, other), w0),
+                                _mm_sub_epi16(white_count[half], wb)),
+               _mm_and_si128(w0, one));
+
+            const __m128i done = _mm_and_si128(
+               g, _mm_cmpeq_epi16(green_count[half], consecutive));
+            result[half] = _mm_or_si128(
+               _mm_andnot_si128(done, result[half]),
+               _mm_and_si128(done, _mm_sub_epi16(row, overshoot[half])));
+         }
+
+         // Stop once every column has started and none is still scanning.
+         if (!scanning && j >= last_begin) {
+            break;
+         }
+      }
+
+      for (int half = 0; half < 2; ++ half) {
+         int16_t lanes[8];
+         _mm_storeu_si128((__m128i*)lanes, result[half]);
+         for (int i = 0; i < 8; ++ i) {
+            found[x + 8 * half + i] = lanes[i];
+         }
+      }
+   }
+#endif // __SSE2__
+   for (; x < cols; ++ x) {
+      found[x] = scanColumn(colour + x, stride, begins[x], ends[x],
+                            consecutive_green);
+   }
 }
 
 void FieldBoundaryFinder::find(const VisionInfoIn& info_in, VisionInfoMiddle& info_middle, VisionInfoOut& info_out) {
@@ -120,11 +293,9 @@ void FieldBoundaryFinder::fieldBoundaryPoints(
    int intercept = horizon_adj.first / fovea.getDensity();
 
    int i, j, start;
-   int colour_j;
    int image_end, fovea_end;
    int horizon_ave;
    int fieldline_width_at_top;
-   int green_count, white_count, overshoot;
    bool possible_fieldline;
 
 
@@ -168,13 +339,15 @@ void FieldBoundaryFinder::fieldBoundaryPoints(
 
    int cols = TOP_SALIENCY_COLS;
    if (!top) cols = BOT_SALIENCY_COLS;
-   for (i = 0; i < cols; ++i) {
-      if (i != 0) {
-         greenTops[i] = greenTops[i - 1];
-      } else {
-         greenTops[0] = 0;
-      }
+   int *lastRows = (top) ? lastTopRows : lastBotRows;
 
+   const int window = searchWindow / fovea.getDensity();
+   const bool windowed = window > 0 && !info_in.cameraToRR.isRobotMoving();
+
+   int starts[TOP_SALIENCY_COLS], begins[TOP_SALIENCY_COLS];
+   int ends[TOP_SALIENCY_COLS], found[TOP_SALIENCY_COLS];
+   bool fieldlines[TOP_SALIENCY_COLS];
+   for (i = 0; i < cols; ++i) {
       float horizonIntercept = gradient * i + intercept;
       if (!top) horizonIntercept -= ROWS / fovea.getDensity();
       start = std::min(std::max(0.0f, horizonIntercept), (float)(ROWS / fovea.getDensity())); //start of the scan must not got below the image
@@ -189,77 +362,83 @@ void FieldBoundaryFinder::fieldBoundaryPoints(
 
       fovea_end = fovea.mapImageToFovea(Point(0, image_end)).y();
 
-      white_count = 0;
-      overshoot   = 0;
-
-      j = start;
-      colour_j = j;
-
       /* Test for fieldline at top of image */
       possible_fieldline = false;
-      for (; j < fieldline_width_at_top; ++ j, ++ colour_j) {
-         if (fovea.getFoveaColour(i, colour_j) == cWHITE) {
+      for (j = start; j < fieldline_width_at_top; ++ j) {
+         if (fovea.getFoveaColour(i, j) == cWHITE) {
             possible_fieldline = true;
             break;
          }
       }
 
-      /* Now search for the field boundary */
-      green_count =  0;
-      white_count =  0;
-      overshoot   = -1;
+      starts[i] = start;
+      ends[i] = fovea_end;
+      fieldlines[i] = possible_fieldline;
 
-      colour_j -= (j - start);
-      j  = start;
+      /* While still, the boundary is close to where it was last frame */
+      begins[i] = start;
+      if (windowed && lastRows[i] >= 0) {
+         begins[i] = std::min(std::max(start, lastRows[i] - window), fovea_end);
+      }
+   }
 
-      // NOTE: REMOVE THIS AFTER BRAZIL, THIS IS A SPECIAL CASE FOR THE NICE BLACK BORDER WE GET
-      //bool seenBlack = false;
-      for (; j < fovea_end; ++ j, ++ colour_j) {
-         Colour c = fovea.getFoveaColour(i, colour_j);
-         //if (*c == cBLACK) seenBlack = true;
-         //if (!seenBlack) continue;
+   /* Now search for the field boundary */
+   const int stride = fovea.getBBox().width();
+   scanColumns(fovea.getInternalColour(), stride, cols, begins, ends, found,
+               consecutive_green);
 
-         if (c == cGREEN) {
-            ++ green_count;
-            ++ overshoot;
-            white_count = 0;
+   /* Rescan from the horizon any column whose boundary may have moved out of
+    * the top of its window
+    */
+   if (windowed) {
+      int rescans[TOP_SALIENCY_COLS], refound[TOP_SALIENCY_COLS];
+      bool rescan = false;
+      for (i = 0; i < cols; ++i) {
+         if (begins[i] > starts[i] && (found[i] < 0 || found[i] == begins[i])) {
+            rescans[i] = starts[i];
+            rescan = true;
+         } else {
+            rescans[i] = ends[i];
+         }
+      }
+      if (rescan) {
+         scanColumns(fovea.getInternalColour(), stride, cols, rescans, ends,
+                     refound, consecutive_green);
+         for (i = 0; i < cols; ++i) {
+            if (rescans[i] < ends[i]) {
+               found[i] = refound[i];
+            }
+         }
+      }
+   }
 
-            if (green_count == consecutive_green) {
-               j -= overshoot;
+   for (i = 0; i < cols; ++i) {
+      if (i != 0) {
+         greenTops[i] = greenTops[i - 1];
+      } else {
+         greenTops[0] = 0;
+      }
 
-               /* Check that we didn't detect a fieldline */
-               if (possible_fieldline && j < start + fieldline_width_at_top) {
-                  break;
-               }
-               if (j != 0) {
-                  if (top) {
-                     boundaryPointsTop.push_back(Point(i, j) * fovea.getDensity());
-                  } else {
-                     Point p = Point(i, j) * fovea.getDensity();
-                     p.y() += ROWS;
-                     boundaryPointsBot.push_back(p);
-                  }
-               } else {
-                  ++ greenTops[i];
-               }
+      lastRows[i] = found[i];
+      if (found[i] < 0) {
+         continue;
+      }
+      j = found[i];
 
-               break;
-            }
-         } else if ((c == cWHITE || c == cBACKGROUND)
-                 && (white_count < 1 && green_count != 0))
-         {
-            /* Allow for white between two green pixels */
-            ++ overshoot;
-            ++ white_count;
-         } else if (c == cWHITE && green_count == 0) {
-            /* first pixel can be white */
-            overshoot   = 0;
-            white_count = 1;
+      /* Check that we didn't detect a fieldline */
+      if (fieldlines[i] && j < starts[i] + fieldline_width_at_top) {
+         continue;
+      }
+      if (j != 0) {
+         if (top) {
+            boundaryPointsTop.push_back(Point(i, j) * fovea.getDensity());
          } else {
-            green_count =  0;
-            white_count =  0;
-            overshoot   = -1;
+            Point p = Point(i, j) * fovea.getDensity();
+            p.y() += ROWS;
+            boundaryPointsBot.push_back(p);
          }
+      } else {
+         ++ greenTops[i];
       }
    }
 }
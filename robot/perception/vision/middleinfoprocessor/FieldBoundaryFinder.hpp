@@ -32,10 +32,13 @@ class FieldBoundaryFinder : public MiddleInfoProcessor
       int botStartScanCoords[BOT_IMAGE_COLS];
 
       void find(const VisionInfoIn& info_in, VisionInfoMiddle& info_middle, VisionInfoOut& info_out);
+      uint32_t reads() const { return vdFULL_REGIONS; }
+      uint32_t writes() const { return vdBOUNDARIES | vdSTART_SCAN_COORDS; }
 
       /**
        * Find coordinates of points that may be at the boundary
-       * of the field by using the saliency scan
+       * of the field by using the saliency scan. Columns are scanned
+       * sixteen at a time where SSE2 is available.
        * @param frame      Current vision frame
        * @param fovea      Current fovea to be searched
        **/
@@ -61,6 +64,13 @@ class FieldBoundaryFinder : public MiddleInfoProcessor
 
       explicit FieldBoundaryFinder();
 
+      /**
+       * While the robot is still, start each column's scan this many image
+       * rows above where the previous frame found the boundary, rather than
+       * at the horizon. 0 always scans from the horizon.
+       **/
+      void setSearchWindow(int rows) { searchWindow = rows; }
+
       std::vector<FieldBoundaryInfo> fieldBoundaries;
 
    private:
@@ -77,6 +87,14 @@ class FieldBoundaryFinder : public MiddleInfoProcessor
        */
       int greenTops[TOP_SALIENCY_COLS];
       int totalGreens;
+
+      /**
+       * The fovea row the boundary was found at in each column of the
+       * previous frame, or -1 if it was not
+       */
+      int lastTopRows[TOP_SALIENCY_COLS];
+      int lastBotRows[BOT_SALIENCY_COLS];
+      int searchWindow;
 };
 
 #endif
@@ -1,6 +1,9 @@
 #ifndef PERCEPTION_VISION_MIDDLE_INFO_PROCESSOR_INTERFACE_H_
 #define PERCEPTION_VISION_MIDDLE_INFO_PROCESSOR_INTERFACE_H_
 
+#include <stdint.h>
+
+#include "perception/vision/VisionDefinitions.hpp"
 #include "types/VisionInfoIn.hpp"
 #include "types/VisionInfoOut.hpp"
 #include "types/VisionInfoMiddle.hpp"
@@ -11,6 +14,13 @@ public:
      * detect abstract function intended for implementation in a subclass
      */
     virtual void find(const VisionInfoIn& info_in, VisionInfoMiddle& info_middle, VisionInfoOut& info_out) = 0;
+    /**
+     * The VisionData this processor reads and writes, used to run independent
+     * stages at the same time. Defaults to everything, so a processor that does not
+     * override these always runs on its own.
+     */
+    virtual uint32_t reads() const { return vdALL; }
+    virtual uint32_t writes() const { return vdALL; }
     virtual ~MiddleInfoProcessor(){};
 };
 
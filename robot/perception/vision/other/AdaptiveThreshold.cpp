@@ -0,0 +1,326 @@
+#include "perception/vision/other/AdaptiveThreshold.hpp"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define ADAPTIVE_THRESHOLD_X86
+#include <immintrin.h>
+#endif // defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+
+namespace AdaptiveThreshold {
+
+/*
+ * Scalar reference implementations. These are the original Fovea loops and
+ * define the expected output of the vectorised kernels.
+ */
+
+static void integralImageScalar(const uint8_t* raw, int step, int row_size,
+                                int width, int height, int* int_img)
+{
+    const uint8_t* curr_raw = raw;
+    int* curr_intImg = int_img;
+    int* upper_intImg = int_img;
+    int sum;
+
+    for(int i=0; i < height; ++i)
+    {
+        sum = 0;
+        for(int j=0; j < width; ++j)
+        {
+            sum += (*curr_raw);
+            if (i == 0){
+                *curr_intImg = sum;
+            } else {
+                *curr_intImg = *upper_intImg + sum;
+                ++upper_intImg;
+            }
+            curr_raw += step;
+            ++curr_intImg;
+        }
+        curr_raw += row_size - width * step;
+    }
+}
+
+static void thresholdRowScalar(const uint8_t* raw, int step, const int* lower,
+                               const int* upper, int window, int count,
+                               int percentage, int n, Colour* out)
+{
+    for(int j=0; j < n; ++j)
+    {
+        int sum = lower[j] - lower[j-window] - upper[j] + upper[j-window];
+        if ((*raw * count) * 100 <= (sum * (100-percentage)))
+        {
+            out[j] = cGREEN;
+        }
+        else
+        {
+            out[j] = cWHITE;
+        }
+        raw += step;
+    }
+}
+
+#ifdef ADAPTIVE_THRESHOLD_X86
+
+/*
+ * The vectorised kernels write the classification straight out as 32 bit
+ * lanes, so they are only used when Colour is 32 bits wide and the
+ * green/white values are 0/1.
+ */
+static const bool colourIsInt32 = sizeof(Colour) == sizeof(int32_t) &&
+                                  cGREEN == 0 && cWHITE == 1;
+
+/*
+ * SSE4.1 kernels. _mm_mullo_epi32 is the only instruction past SSE2 needed.
+ */
+
+template <bool kHasUpper>
+__attribute__((target("sse4.1")))
+static inline void integralRowSSE41(const uint8_t* r, int step, int width,
+                                    const int* upper, int* curr)
+{
+    __m128i carry = _mm_setzero_si128();
+    int j = 0;
+    for(; j+4 <= width; j += 4)
+    {
+        __m128i x = _mm_set_epi32(r[3*step], r[2*step], r[step], r[0]);
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, carry);
+        carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+        if (kHasUpper)
+            x = _mm_add_epi32(x, _mm_loadu_si128((const __m128i*)(upper+j)));
+        _mm_storeu_si128((__m128i*)(curr+j), x);
+        r += 4*step;
+    }
+    int sum = _mm_cvtsi128_si32(carry);
+    for(; j < width; ++j)
+    {
+        sum += *r;
+        curr[j] = kHasUpper ? upper[j] + sum : sum;
+        r += step;
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void integralImageSSE41(const uint8_t* raw, int step, int row_size,
+                               int width, int height, int* int_img)
+{
+    if (height <= 0)
+        return;
+    integralRowSSE41<false>(raw, step, width, NULL, int_img);
+    for(int i=1; i < height; ++i)
+    {
+        integralRowSSE41<true>(raw + i*row_size, step, width,
+                               int_img + (i-1)*width, int_img + i*width);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void thresholdRowSSE41(const uint8_t* raw, int step, const int* lower,
+                              const int* upper, int window, int count,
+                              int percentage, int n, Colour* out)
+{
+    const __m128i count100 = _mm_set1_epi32(count * 100);
+    const __m128i factor = _mm_set1_epi32(100 - percentage);
+    const __m128i one = _mm_set1_epi32(1);
+    int j = 0;
+    for(; j+4 <= n; j += 4)
+    {
+        __m128i sum = _mm_sub_epi32(
+            _mm_loadu_si128((const __m128i*)(lower+j)),
+            _mm_loadu_si128((const __m128i*)(lower+j-window)));
+        sum = _mm_sub_epi32(sum,
+            _mm_loadu_si128((const __m128i*)(upper+j)));
+        sum = _mm_add_epi32(sum,
+            _mm_loadu_si128((const __m128i*)(upper+j-window)));
+        __m128i y = _mm_set_epi32(raw[3*step], raw[2*step], raw[step], raw[0]);
+        __m128i white = _mm_cmpgt_epi32(_mm_mullo_epi32(y, count100),
+                                        _mm_mullo_epi32(sum, factor));
+        _mm_storeu_si128((__m128i*)(out+j), _mm_and_si128(white, one));
+        raw += 4*step;
+    }
+    thresholdRowScalar(raw, step, lower+j, upper+j, window, count, percentage,
+                       n-j, out+j);
+}
+
+/*
+ * AVX2 kernels.
+ */
+
+template <bool kHasUpper>
+__attribute__((target("avx2")))
+static inline void integralRowAVX2(const uint8_t* r, int step, int width,
+                                   const int* upper, int* curr)
+{
+    const __m256i last = _mm256_set1_epi32(7);
+    __m256i carry = _mm256_setzero_si256();
+    int j = 0;
+    for(; j+8 <= width; j += 8)
+    {
+        __m256i x = _mm256_set_epi32(r[7*step], r[6*step], r[5*step],
+                                     r[4*step], r[3*step], r[2*step], r[step],
+                                     r[0]);
+        // Prefix sum within each 128 bit lane.
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+        // Carry the low lane's total into the high lane.
+        __m256i low = _mm256_permute2x128_si256(x, x, 0x08);
+        x = _mm256_add_epi32(x, _mm256_shuffle_epi32(low, _MM_SHUFFLE(3, 3, 3, 3)));
+        x = _mm256_add_epi32(x, carry);
+        carry = _mm256_permutevar8x32_epi32(x, last);
+        if (kHasUpper)
+            x = _mm256_add_epi32(x,
+                             _mm256_loadu_si256((const __m256i*)(upper+j)));
+        _mm256_storeu_si256((__m256i*)(curr+j), x);
+        r += 8*step;
+    }
+    int sum = _mm256_cvtsi256_si32(carry);
+    for(; j < width; ++j)
+    {
+        sum += *r;
+        curr[j] = kHasUpper ? upper[j] + sum : sum;
+        r += step;
+    }
+}
+
+__attribute__((target("avx2")))
+static void integralImageAVX2(const uint8_t* raw, int step, int row_size,
+                              int width, int height, int* int_img)
+{
+    if (height <= 0)
+        return;
+    integralRowAVX2<false>(raw, step, width, NULL, int_img);
+    for(int i=1; i < height; ++i)
+    {
+        integralRowAVX2<true>(raw + i*row_size, step, width,
+                              int_img + (i-1)*width, int_img + i*width);
+    }
+}
+
+__attribute__((target("avx2")))
+static void thresholdRowAVX2(const uint8_t* raw, int step, const int* lower,
+                             const int* upper, int window, int count,
+                             int percentage, int n, Colour* out)
+{
+    const __m256i count100 = _mm256_set1_epi32(count * 100);
+    const __m256i factor = _mm256_set1_epi32(100 - percentage);
+    const __m256i one = _mm256_set1_epi32(1);
+    int j = 0;
+    for(; j+8 <= n; j += 8)
+    {
+        __m256i sum = _mm256_sub_epi32(
+            _mm256_loadu_si256((const __m256i*)(lower+j)),
+            _mm256_loadu_si256((const __m256i*)(lower+j-window)));
+        sum = _mm256_sub_epi32(sum,
+            _mm256_loadu_si256((const __m256i*)(upper+j)));
+        sum = _mm256_add_epi32(sum,
+            _mm256_loadu_si256((const __m256i*)(upper+j-window)));
+        __m256i y = _mm256_set_epi32(raw[7*step], raw[6*step], raw[5*step],
+                                     raw[4*step], raw[3*step], raw[2*step],
+                                     raw[step], raw[0]);
+        __m256i white = _mm256_cmpgt_epi32(_mm256_mullo_epi32(y, count100),
+                                           _mm256_mullo_epi32(sum, factor));
+        _mm256_storeu_si256((__m256i*)(out+j), _mm256_and_si256(white, one));
+        raw += 8*step;
+    }
+    thresholdRowScalar(raw, step, lower+j, upper+j, window, count, percentage,
+                       n-j, out+j);
+}
+
+#endif // ADAPTIVE_THRESHOLD_X86
+
+/*
+ * Runtime dispatch.
+ */
+
+typedef void (*IntegralImageFn)(const uint8_t*, int, int, int, int, int*);
+typedef void (*ThresholdRowFn)(const uint8_t*, int, const int*, const int*,
+                               int, int, int, int, Colour*);
+
+static Kernel currentKernel = KERNEL_SCALAR;
+static IntegralImageFn integralImageFn = &integralImageScalar;
+static ThresholdRowFn thresholdRowFn = &thresholdRowScalar;
+
+static bool kernelSupported(Kernel kernel)
+{
+#ifdef ADAPTIVE_THRESHOLD_X86
+    // Needed as this can run from a static initialiser.
+    __builtin_cpu_init();
+#endif // ADAPTIVE_THRESHOLD_X86
+    switch (kernel) {
+    case KERNEL_SCALAR:
+        return true;
+#ifdef ADAPTIVE_THRESHOLD_X86
+    case KERNEL_SSE41:
+        return colourIsInt32 && __builtin_cpu_supports("sse4.1");
+    case KERNEL_AVX2:
+        return colourIsInt32 && __builtin_cpu_supports("avx2");
+#endif // ADAPTIVE_THRESHOLD_X86
+    default:
+        return false;
+    }
+}
+
+Kernel setKernel(Kernel kernel)
+{
+    if (kernel == KERNEL_AUTO || !kernelSupported(kernel))
+    {
+        kernel = KERNEL_SCALAR;
+        if (kernelSupported(KERNEL_SSE41))
+            kernel = KERNEL_SSE41;
+        if (kernelSupported(KERNEL_AVX2))
+            kernel = KERNEL_AVX2;
+    }
+
+    switch (kernel) {
+#ifdef ADAPTIVE_THRESHOLD_X86
+    case KERNEL_SSE41:
+        integralImageFn = &integralImageSSE41;
+        thresholdRowFn = &thresholdRowSSE41;
+        break;
+    case KERNEL_AVX2:
+        integralImageFn = &integralImageAVX2;
+        thresholdRowFn = &thresholdRowAVX2;
+        break;
+#endif // ADAPTIVE_THRESHOLD_X86
+    default:
+        kernel = KERNEL_SCALAR;
+        integralImageFn = &integralImageScalar;
+        thresholdRowFn = &thresholdRowScalar;
+        break;
+    }
+    currentKernel = kernel;
+    return kernel;
+}
+
+Kernel getKernel()
+{
+    return currentKernel;
+}
+
+const char* kernelName(Kernel kernel)
+{
+    switch (kernel) {
+    case KERNEL_SCALAR: return "scalar";
+    case KERNEL_SSE41:  return "sse4.1";
+    case KERNEL_AVX2:   return "avx2";
+    default:            return "auto";
+    }
+}
+
+// Pick the best kernel before main, so Fovea never sees an unset dispatch.
+static const Kernel initialKernel = setKernel(KERNEL_AUTO);
+
+void integralImage(const uint8_t* raw, int step, int row_size,
+                   int width, int height, int* int_img)
+{
+    integralImageFn(raw, step, row_size, width, height, int_img);
+}
+
+void thresholdRow(const uint8_t* raw, int step, const int* lower,
+                  const int* upper, int window, int count, int percentage,
+                  int n, Colour* out)
+{
+    thresholdRowFn(raw, step, lower, upper, window, count, percentage, n, out);
+}
+
+}
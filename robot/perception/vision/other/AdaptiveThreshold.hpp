@@ -0,0 +1,68 @@
+#ifndef PERCEPTION_VISION_OTHER_ADAPTIVETHRESHOLD_H_
+#define PERCEPTION_VISION_OTHER_ADAPTIVETHRESHOLD_H_
+
+#include <stdint.h>
+#include "perception/vision/VisionDefinitions.hpp"
+
+/**
+ * Kernels for the adaptive thresholding used by Fovea::makeBinary_.
+ *
+ * Each kernel has a scalar reference implementation plus SSE4.1 and AVX2
+ * implementations. The vectorised versions are compiled with per-function
+ * target attributes so the binary still runs on CPUs without them; the best
+ * available implementation is picked once at runtime from the CPU features.
+ * All implementations produce bit-identical output.
+ */
+namespace AdaptiveThreshold {
+
+enum Kernel {
+    KERNEL_SCALAR = 0,
+    KERNEL_SSE41,
+    KERNEL_AVX2,
+    KERNEL_AUTO
+};
+
+/**
+ * Builds the integral image of the luma channel of a fovea.
+ *
+ * raw is the Y value of the fovea's first pixel, step is the distance in
+ * bytes between horizontally adjacent fovea pixels and row_size the distance
+ * in bytes between vertically adjacent fovea pixels. int_img must hold
+ * width*height values.
+ */
+void integralImage(const uint8_t* raw, int step, int row_size,
+                   int width, int height, int* int_img);
+
+/**
+ * Thresholds n consecutive fovea pixels whose windows lie fully inside the
+ * fovea.
+ *
+ * lower and upper point at the integral image entries for the bottom right
+ * and just-above-top right corners of the first pixel's window, which is
+ * window pixels wide and contains count pixels. A pixel is classified white
+ * if raw * count * 100 > sum * (100 - percentage), otherwise green.
+ */
+void thresholdRow(const uint8_t* raw, int step, const int* lower,
+                  const int* upper, int window, int count, int percentage,
+                  int n, Colour* out);
+
+/**
+ * Selects the kernel used by integralImage and thresholdRow. KERNEL_AUTO picks
+ * the fastest kernel the CPU supports, and requests for unsupported kernels
+ * fall back the same way. Returns the kernel actually selected.
+ */
+Kernel setKernel(Kernel kernel);
+
+/**
+ * The kernel currently in use.
+ */
+Kernel getKernel();
+
+/**
+ * A printable name for a kernel, for logging.
+ */
+const char* kernelName(Kernel kernel);
+
+}
+
+#endif
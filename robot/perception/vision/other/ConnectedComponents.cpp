@@ -0,0 +1,112 @@
+#include "perception/vision/other/ConnectedComponents.hpp"
+
+namespace {
+
+// The sum of the squares of 0 to n
+inline int64_t sumSquares(int n) {
+    return (int64_t)n * (n + 1) * (2 * n + 1) / 6;
+}
+
+}
+
+void ConnectedComponents::joinRows_(int above_begin, int row_begin,
+                                    int row_end, Connectivity connectivity,
+                                    int cut)
+{
+    // Runs touching diagonally only join when eight connected
+    const int slack = connectivity == EIGHT_CONNECTED ? 1 : 0;
+
+    // Both rows are sorted by x, so the first run above that the current run
+    // could touch only moves right.
+    int first = above_begin;
+    for (int r = row_begin; r < row_end; ++r) {
+        const Run& run = runs_[r];
+        while (first < row_begin && runs_[first].x_end + slack <= run.x_begin) {
+            ++first;
+        }
+        for (int a = first;
+             a < row_begin && runs_[a].x_begin < run.x_end + slack; ++a) {
+            // Runs never cross a cut column, but may touch diagonally
+            // across one.
+            if (cut <= 0 || runs_[a].x_begin / cut == run.x_begin / cut) {
+                union_(a, r);
+            }
+        }
+    }
+}
+
+int ConnectedComponents::find_(int run)
+{
+    while (parents_[run] != run) {
+        parents_[run] = parents_[parents_[run]];
+        run = parents_[run];
+    }
+    return run;
+}
+
+void ConnectedComponents::union_(int a, int b)
+{
+    a = find_(a);
+    b = find_(b);
+    if (a < b) {
+        parents_[b] = a;
+    } else if (b < a) {
+        parents_[a] = b;
+    }
+}
+
+void ConnectedComponents::resolve_()
+{
+    const int num_runs = runs_.size();
+    labels_.resize(num_runs);
+    components_.clear();
+    area_ = 0;
+
+    for (int i = 0; i < num_runs; ++i) {
+        const Run& run = runs_[i];
+        const int first = run.x_begin;
+        const int last = run.x_end - 1;
+        const int n = run.x_end - run.x_begin;
+        const int y = run.y;
+
+        // Sums over the run, those of x and x^2 in closed form
+        const int sum_x = ((first + last) * n) >> 1;
+        const int64_t sum_xx = sumSquares(last) - sumSquares(first - 1);
+
+        // A parent is always labelled before its children
+        const int parent = parents_[i];
+        if (parent == i) {
+            labels_[i] = components_.size();
+            components_.resize(components_.size() + 1);
+            Component& component = components_.back();
+            component.area = n;
+            component.min_x = first;
+            component.max_x = last;
+            component.min_y = y;
+            component.max_y = y;
+            component.sum_x = sum_x;
+            component.sum_y = n * y;
+            component.sum_xx = sum_xx;
+            component.sum_xy = (int64_t)sum_x * y;
+            component.sum_yy = (int64_t)(n * y) * y;
+        } else {
+            labels_[i] = labels_[parent];
+            Component& component = components_[labels_[i]];
+            component.area += n;
+            if (first < component.min_x) {
+                component.min_x = first;
+            }
+            if (last > component.max_x) {
+                component.max_x = last;
+            }
+            component.max_y = y;
+            component.sum_x += sum_x;
+            component.sum_y += n * y;
+            component.sum_xx += sum_xx;
+            component.sum_xy += (int64_t)sum_x * y;
+            component.sum_yy += (int64_t)(n * y) * y;
+        }
+
+        area_ += n;
+    }
+}
@@ -0,0 +1,167 @@
+#ifndef PERCEPTION_VISION_OTHER_CONNECTEDCOMPONENTS_H_
+#define PERCEPTION_VISION_OTHER_CONNECTEDCOMPONENTS_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "perception/vision/Region/Region.hpp"
+#include "perception/vision/other/FieldMask.hpp"
+#include "perception/vision/VisionDefinitions.hpp"
+
+/**
+ * Connected component labelling over the fovea colours of a region, shared by
+ * the detectors and region finders that group pixels by colour.
+ *
+ * Labelling is run based and two pass. The first pass walks the region once,
+ * cutting each row into runs of the pixels the caller's predicate includes,
+ * and joins each run to the runs it touches in the row above with a
+ * union-find over run indices. The second pass gives each run its component
+ * and adds the run's statistics in closed form, so no label image is kept and
+ * everything after the scan is per run rather than per pixel.
+ *
+ * Components are numbered in raster order of their first pixel, the order the
+ * earlier label-and-merge code left its groups in.
+ *
+ * The buffers are members and only ever grow, so a caller that keeps one
+ * ConnectedComponents allocates nothing once it has labelled its largest
+ * region. Not thread safe; use one per thread.
+ */
+class ConnectedComponents {
+
+public:
+
+    enum Connectivity {
+        FOUR_CONNECTED,
+        EIGHT_CONNECTED
+    };
+
+    /**
+     * A component in region coordinates, with its bounding box inclusive and
+     * raw sums from which the centroid and second moments are found.
+     */
+    struct Component {
+        int area;
+        int min_x;
+        int max_x;
+        int min_y;
+        int max_y;
+
+        int64_t sum_x;
+        int64_t sum_y;
+        int64_t sum_xx;
+        int64_t sum_xy;
+        int64_t sum_yy;
+
+        float centroidX() const { return (float)sum_x / area; }
+        float centroidY() const { return (float)sum_y / area; }
+
+        // Second moments about the centroid, per pixel
+        float varianceX() const {
+            return (float)sum_xx / area - centroidX() * centroidX();
+        }
+        float varianceY() const {
+            return (float)sum_yy / area - centroidY() * centroidY();
+        }
+        float covarianceXY() const {
+            return (float)sum_xy / area - centroidX() * centroidY();
+        }
+    };
+
+    ConnectedComponents() : area_(0) {}
+
+    /**
+     * Labels the pixels of region for which include(x, y, colour) is true,
+     * x and y being region coordinates. include is called exactly once for
+     * each pixel, in raster order.
+     *
+     * If cut is positive, pixels are never joined across a row or column
+     * that is a multiple of cut, so no component spans more than one
+     * cut x cut cell.
+     *
+     * If mask is given, only the pixels it leaves in are visited, and
+     * include is only called for those. Pixels it leaves out are treated
+     * as not included.
+     */
+    template <typename Include>
+    void label(const RegionI& region, Include include,
+               Connectivity connectivity = FOUR_CONNECTED, int cut = 0,
+               const FieldMask* mask = NULL);
+
+    const std::vector<Component>& components() const { return components_; }
+
+    /**
+     * For callers that go on to merge or filter the components in place.
+     */
+    std::vector<Component>& components() { return components_; }
+
+    /**
+     * The number of pixels included in the last labelling.
+     */
+    int area() const { return area_; }
+
+private:
+
+    // A run of included pixels [x_begin, x_end) on row y
+    struct Run {
+        int x_begin;
+        int x_end;
+        int y;
+    };
+
+    std::vector<Run> runs_;
+
+    // The union-find forest over runs_. A run's parent always has a lower
+    // index, so the root of a component is its first run.
+    std::vector<int> parents_;
+
+    // The component of each run, filled in by resolve_
+    std::vector<int> labels_;
+
+    std::vector<Component> components_;
+
+    // The spans of the row being scanned
+    std::vector<FieldSpan> spans_;
+
+    int area_;
+
+    void addRun_(int x_begin, int x_end, int y);
+
+    /**
+     * Joins the runs [row_begin, row_end) to the runs they touch in the row
+     * above, [above_begin, row_begin).
+     */
+    void joinRows_(int above_begin, int row_begin, int row_end,
+                   Connectivity connectivity, int cut);
+
+    int find_(int run);
+    void union_(int a, int b);
+
+    /**
+     * Numbers the components and accumulates their statistics.
+     */
+    void resolve_();
+};
+
+/**
+ * Predicates for label() shared by more than one caller.
+ */
+struct NotWhite {
+    bool operator()(int, int, Colour colour) const {
+        return colour != cWHITE;
+    }
+};
+
+/**
+ * White pixels below a start row per column, such as the field boundary.
+ */
+struct WhiteBelow {
+    explicit WhiteBelow(const int* starts) : starts(starts) {}
+    bool operator()(int x, int y, Colour colour) const {
+        return y > starts[x] && colour == cWHITE;
+    }
+    const int* starts;
+};
+
+#include "perception/vision/other/ConnectedComponents.tcc"
+
+#endif
@@ -0,0 +1,75 @@
+template <typename Include>
+void ConnectedComponents::label(const RegionI& region, Include include,
+                                Connectivity connectivity, int cut,
+                                const FieldMask* mask)
+{
+    runs_.clear();
+    parents_.clear();
+
+    const int rows = region.getRows();
+    const int cols = region.getCols();
+
+    if (!mask) {
+        spans_.resize(1);
+        spans_[0].begin = 0;
+        spans_[0].end = cols;
+    }
+
+    // The runs of the previous row start here
+    int above_begin = 0;
+
+    for (int y = 0; y < rows; ++y) {
+        const int row_begin = runs_.size();
+
+        if (mask) {
+            region.getFieldSpans(*mask, y, spans_);
+        }
+        for (size_t s = 0; s < spans_.size(); ++s) {
+            const int begin = spans_[s].begin;
+            const int end = spans_[s].end;
+            RegionI::iterator_fovea pixel =
+                region.get_iterator_fovea(Point(begin, y));
+
+            // The start of the open run, or -1 if there is none
+            int start = -1;
+            int next_cut = cut > 0 ? (begin / cut + 1) * cut : cols;
+            for (int x = begin; x < end; ++x, ++pixel) {
+                if (x == next_cut) {
+                    if (start >= 0) {
+                        addRun_(start, x, y);
+                        start = -1;
+                    }
+                    next_cut += cut;
+                }
+                if (include(x, y, pixel.colour())) {
+                    if (start < 0) {
+                        start = x;
+                    }
+                } else if (start >= 0) {
+                    addRun_(start, x, y);
+                    start = -1;
+                }
+            }
+            if (start >= 0) {
+                addRun_(start, end, y);
+            }
+        }
+
+        if (cut <= 0 || y % cut != 0) {
+            joinRows_(above_begin, row_begin, runs_.size(), connectivity, cut);
+        }
+        above_begin = row_begin;
+    }
+
+    resolve_();
+}
+
+inline void ConnectedComponents::addRun_(int x_begin, int x_end, int y)
+{
+    Run run;
+    run.x_begin = x_begin;
+    run.x_end = x_end;
+    run.y = y;
+    parents_.push_back(runs_.size());
+    runs_.push_back(run);
+}
@@ -0,0 +1,119 @@
+#include "perception/vision/other/FieldMask.hpp"
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+FieldMask::FieldMask(int cols, int rows)
+    : raw_cols_(cols), raw_rows_(rows), density_(1), cols_(cols), rows_(rows),
+      row_begins_(rows + 1)
+{
+    // Everything is left in until the first build.
+    FieldSpan span = { 0, cols };
+    spans_.assign(rows, span);
+    for (int row = 0; row <= rows; ++row)
+        row_begins_[row] = row;
+}
+
+void FieldMask::build(const int* starts, int start_offset, const int* ends,
+                      int density)
+{
+    density_ = density;
+    cols_ = raw_cols_ / density;
+    rows_ = raw_rows_ / density;
+
+    const int padded = (cols_ + 15) & ~15;
+    first_.assign(padded, INT16_MAX);
+    last_.assign(padded, 0);
+    for (int x = 0; x < cols_; ++x)
+    {
+        const int x_raw = x * density;
+
+        // Rows at or below the field boundary, a superset of those a white
+        // below the boundary test at density leaves in
+        const int start = std::max(starts[x_raw] - start_offset, 0);
+        first_[x] = std::min((start + density - 1) / density, rows_);
+
+        // Rows above the first the full region fovea marks a body part
+        last_[x] = std::min(std::max(ends[x_raw], 0) / density, rows_);
+    }
+
+    spans_.clear();
+    row_begins_.resize(rows_ + 1);
+    row_begins_[0] = 0;
+    for (int row = 0; row < rows_; ++row)
+    {
+        buildRow_(row);
+        row_begins_[row + 1] = spans_.size();
+    }
+}
+
+unsigned FieldMask::inRow_(int row, int x) const
+{
+#ifdef __SSE2__
+    // Left in where first <= row < last, sixteen columns at a time
+    const __m128i r = _mm_set1_epi16(row);
+    const __m128i first0 = _mm_loadu_si128((const __m128i*)&first_[x]);
+    const __m128i first1 = _mm_loadu_si128((const __m128i*)&first_[x + 8]);
+    const __m128i last0 = _mm_loadu_si128((const __m128i*)&last_[x]);
+    const __m128i last1 = _mm_loadu_si128((const __m128i*)&last_[x + 8]);
+    const __m128i in0 = _mm_andnot_si128(_mm_cmpgt_epi16(first0, r),
+                                         _mm_cmpgt_epi16(last0, r));
+    const __m128i in1 = _mm_andnot_si128(_mm_cmpgt_epi16(first1, r),
+                                         _mm_cmpgt_epi16(last1, r));
+    return _mm_movemask_epi8(_mm_packs_epi16(in0, in1));
+#else
+    unsigned bits = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        if (first_[x + i] <= row && row < last_[x + i])
+            bits |= 1u << i;
+    }
+    return bits;
+#endif // __SSE2__
+}
+
+void FieldMask::buildRow_(int row)
+{
+    // The first column of the open span, or -1 if there is none
+    int open = -1;
+    const int padded = first_.size();
+    for (int x = 0; x < padded; x += 16)
+    {
+        const unsigned bits = inRow_(row, x);
+
+        // Most blocks are wholly in or out and leave the open span as it is.
+        if (bits == (open >= 0 ? 0xFFFFu : 0u))
+            continue;
+
+        for (int i = 0; i < 16; ++i)
+        {
+            const bool in = (bits >> i) & 1;
+            if (in && open < 0)
+            {
+                open = x + i;
+            }
+            else if (!in && open >= 0)
+            {
+                FieldSpan span = { open * density_, (x + i) * density_ };
+                spans_.push_back(span);
+                open = -1;
+            }
+        }
+    }
+    if (open >= 0)
+    {
+        FieldSpan span = { open * density_, cols_ * density_ };
+        spans_.push_back(span);
+    }
+}
+
+float FieldMask::coverage() const
+{
+    int64_t area = 0;
+    for (size_t i = 0; i < spans_.size(); ++i)
+        area += spans_[i].end - spans_[i].begin;
+    return (float)(area * density_) / ((int64_t)raw_cols_ * raw_rows_);
+}
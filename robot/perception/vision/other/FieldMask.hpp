@@ -0,0 +1,95 @@
+#ifndef PERCEPTION_VISION_OTHER_FIELDMASK_H_
+#define PERCEPTION_VISION_OTHER_FIELDMASK_H_
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * A run of columns [begin, end) on one row.
+ */
+struct FieldSpan {
+    int begin;
+    int end;
+};
+
+/**
+ * The part of one camera's image that can hold the field: below the field
+ * boundary and above the robot's own body, as row by row spans of columns.
+ *
+ * Built once per frame from the per column field boundary and body exclusion
+ * rows, at a density no finer than that of the regions that read it. Regions
+ * turn it into spans of their own columns with RegionI::getFieldSpans, so
+ * scans over a region visit only the pixels the mask leaves in.
+ *
+ * A pixel is left in if its row at the mask's density is at or below the
+ * field boundary and above the first body part row, the same rows a full
+ * region fovea marks as body parts. Regions finer than the mask see each
+ * mask row's spans for every raw row it covers.
+ */
+class FieldMask {
+
+public:
+
+    /**
+     * A mask for a cols by rows image, leaving in the whole image until built.
+     */
+    FieldMask(int cols, int rows);
+
+    /**
+     * Builds the mask at density from the raw row of the field boundary in
+     * each raw column, less start_offset, and the raw row of the first body
+     * part in each raw column.
+     */
+    void build(const int* starts, int start_offset, const int* ends, int density);
+
+    /**
+     * The spans of raw row y in raw columns, sorted and disjoint, from
+     * rowBegin(y) up to rowEnd(y).
+     */
+    const FieldSpan* rowBegin(int y) const {
+        return spans_.data() + row_begins_[row_(y)];
+    }
+    const FieldSpan* rowEnd(int y) const {
+        return spans_.data() + row_begins_[row_(y) + 1];
+    }
+
+    int getDensity() const { return density_; }
+
+    /**
+     * The fraction of the image the mask leaves in.
+     */
+    float coverage() const;
+
+private:
+
+    // The mask row covering raw row y
+    int row_(int y) const {
+        const int row = y / density_;
+        return row < 0 ? 0 : (row < rows_ ? row : rows_ - 1);
+    }
+
+    // Bit i is set if column x + i is left in on mask row row.
+    unsigned inRow_(int row, int x) const;
+
+    // Appends the spans of mask row row.
+    void buildRow_(int row);
+
+    const int raw_cols_;
+    const int raw_rows_;
+
+    int density_;
+    int cols_;
+    int rows_;
+
+    // The first mask row left in per mask column and one past the last,
+    // padded to a multiple of 16 columns with empty columns.
+    std::vector<int16_t> first_;
+    std::vector<int16_t> last_;
+
+    std::vector<FieldSpan> spans_;
+
+    // The spans of mask row r are [row_begins_[r], row_begins_[r + 1]).
+    std::vector<int> row_begins_;
+};
+
+#endif
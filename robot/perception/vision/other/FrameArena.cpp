@@ -0,0 +1,90 @@
+#include "perception/vision/other/FrameArena.hpp"
+
+#include <algorithm>
+
+#include "utils/Logger.hpp"
+
+__thread FrameArena* FrameArena::current_ = NULL;
+
+FrameArena::Scope::Scope(FrameArena& arena) : previous_(current_)
+{
+    current_ = &arena;
+}
+
+FrameArena::Scope::~Scope()
+{
+    current_ = previous_;
+}
+
+FrameArena::FrameArena(size_t capacity)
+    : block_(new uint8_t[capacity]), capacity_(capacity), used_(0),
+      overflow_bytes_(0), high_water_(0), frame_peak_(0)
+{
+    // Enough room that reset() never needs to grow the overflow list.
+    overflow_.reserve(16);
+    // Grows to the most objects a frame needs, then stays that size.
+    destructors_.reserve(64);
+}
+
+FrameArena::~FrameArena()
+{
+    runDestructors();
+    for (size_t i = 0; i < overflow_.size(); ++i)
+        delete[] overflow_[i];
+    delete[] block_;
+}
+
+void* FrameArena::allocate(size_t bytes, size_t align)
+{
+    size_t start = (reinterpret_cast<uintptr_t>(block_) + used_ + align - 1) &
+                                                                   ~(align - 1);
+    start -= reinterpret_cast<uintptr_t>(block_);
+
+    if (start + bytes <= capacity_)
+    {
+        used_ = start + bytes;
+        frame_peak_ = std::max(frame_peak_, used_ + overflow_bytes_);
+        high_water_ = std::max(high_water_, frame_peak_);
+        return block_ + start;
+    }
+
+    // Out of room this frame. Serve from the heap and grow at the next reset.
+    uint8_t* overflow = new uint8_t[bytes + align];
+    overflow_.push_back(overflow);
+    overflow_bytes_ += bytes + align;
+    frame_peak_ = std::max(frame_peak_, capacity_ + overflow_bytes_);
+    high_water_ = std::max(high_water_, frame_peak_);
+    return reinterpret_cast<void*>(
+        (reinterpret_cast<uintptr_t>(overflow) + align - 1) & ~(align - 1));
+}
+
+void FrameArena::runDestructors()
+{
+    for (size_t i = destructors_.size(); i > 0; --i)
+        destructors_[i - 1].first(destructors_[i - 1].second);
+    destructors_.clear();
+}
+
+void FrameArena::reset()
+{
+    // Before any overflow block the objects may live in is freed.
+    runDestructors();
+
+    if (!overflow_.empty())
+    {
+        for (size_t i = 0; i < overflow_.size(); ++i)
+            delete[] overflow_[i];
+        overflow_.clear();
+
+        // Grow so the frame that overflowed would have fit, with some slack.
+        size_t new_capacity = frame_peak_ + frame_peak_ / 4;
+        llog(INFO) << "FrameArena growing from " << capacity_ << " to "
+                   << new_capacity << " bytes" << std::endl;
+        delete[] block_;
+        block_ = new uint8_t[new_capacity];
+        capacity_ = new_capacity;
+    }
+    used_ = 0;
+    overflow_bytes_ = 0;
+    frame_peak_ = 0;
+}
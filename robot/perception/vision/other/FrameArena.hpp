@@ -0,0 +1,144 @@
+#ifndef PERCEPTION_VISION_OTHER_FRAMEARENA_H_
+#define PERCEPTION_VISION_OTHER_FRAMEARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+// Initial size of each camera's frame arena. The arena grows to its high water
+// mark on the first frames that need more, after which it is never resized.
+#define FRAME_ARENA_DEFAULT_BYTES (1 << 20)
+
+/**
+ * A bump allocator for memory that only needs to live for one vision frame,
+ * such as child foveae and integral images.
+ *
+ * Allocation just advances an offset into a preallocated block and reset()
+ * rewinds it in O(1), so once the arena has reached its working size the
+ * perception thread makes no heap calls for this memory. Objects constructed
+ * in the arena are not destructed unless passed to destroyOnReset(), which
+ * any object whose destructor frees memory, such as one with std::vector
+ * members, must be.
+ *
+ * If a frame needs more than the block holds the excess is served from
+ * overflow blocks on the heap. These are freed at the next reset(), which also
+ * grows the main block so that the next frame fits.
+ *
+ * Not thread safe. Use one arena per thread; a Scope directs the child foveae
+ * created on its thread into an arena of that thread's own.
+ */
+class FrameArena {
+
+public:
+
+    explicit FrameArena(size_t capacity = FRAME_ARENA_DEFAULT_BYTES);
+    ~FrameArena();
+
+    /**
+     * While a Scope exists, current() on the thread that made it returns its
+     * arena. Scopes nest.
+     */
+    class Scope {
+    public:
+        explicit Scope(FrameArena& arena);
+        ~Scope();
+    private:
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+        FrameArena* previous_;
+    };
+
+    /**
+     * The arena of the innermost Scope on this thread, or NULL if there is
+     * none.
+     */
+    static FrameArena* current() { return current_; }
+
+    /**
+     * Returns bytes of uninitialised memory aligned to align, which must be
+     * a power of two. Valid until the next reset().
+     */
+    void* allocate(size_t bytes, size_t align = 16);
+
+    /**
+     * Allocates an uninitialised array of n Ts.
+     */
+    template <typename T>
+    T* allocateArray(size_t n)
+    {
+        return static_cast<T*>(allocate(n * sizeof(T)));
+    }
+
+    /**
+     * Has reset() call obj's destructor. obj must have been constructed in
+     * memory from this arena. Objects are destructed in the reverse of the
+     * order they were passed in.
+     */
+    template <typename T>
+    void destroyOnReset(T* obj)
+    {
+        destructors_.push_back(std::make_pair(&destroy<T>, obj));
+    }
+
+    /**
+     * Destructs the objects passed to destroyOnReset() and releases everything
+     * allocated since the last reset. Call at the start of each frame.
+     */
+    void reset();
+
+    /**
+     * Returns a marker that can later be passed to rewind() to release all
+     * main block allocations made after it, for scratch memory that is done
+     * with before the end of the frame.
+     */
+    size_t mark() const { return used_; }
+
+    /**
+     * Releases main block allocations made since marker was taken. Runs no
+     * destructors, so only use it for scratch memory.
+     */
+    void rewind(size_t marker) { if (marker < used_) used_ = marker; }
+
+    /**
+     * Size of the main block in bytes.
+     */
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * The most bytes in use at once since the last call to resetHighWater().
+     */
+    size_t highWater() const { return high_water_; }
+    void resetHighWater() { high_water_ = used_ + overflow_bytes_; }
+
+private:
+
+    FrameArena(const FrameArena&);
+    FrameArena& operator=(const FrameArena&);
+
+    static __thread FrameArena* current_;
+
+    template <typename T>
+    static void destroy(void* obj) { static_cast<T*>(obj)->~T(); }
+
+    // Runs and forgets the destructors recorded by destroyOnReset().
+    void runDestructors();
+
+    // The main block.
+    uint8_t* block_;
+    size_t capacity_;
+    size_t used_;
+
+    // Blocks taken from the heap when the main block ran out this frame.
+    std::vector<uint8_t*> overflow_;
+    size_t overflow_bytes_;
+
+    // Objects to destruct at the next reset, in construction order.
+    std::vector<std::pair<void (*)(void*), void*> > destructors_;
+
+    // The most bytes in use at once, used to size the main block.
+    size_t high_water_;
+    size_t frame_peak_;
+};
+
+#endif
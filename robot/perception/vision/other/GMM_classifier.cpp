@@ -20,16 +20,187 @@ double GaussianDistribution::logprob(const Vectorxf &X)
     return log_normalise_factor_ - 0.5 * (X_ * precision_ * X_.transpose())(0);
 }
 
+FixedGMM::FixedGMM() :
+  input_width_(0), input_height_(0), dims_(0), components_(0), classes_(0)
+{
+}
+
+bool FixedGMM::build(const PCA &pca, const ClassConditionalGMM &gmm)
+{
+    dims_ = 0;
+    const int features = pca.n_features_;
+    const int dims = pca.n_components_;
+    if (features <= 0 || features > GMM_MAX_FEATURES ||
+        dims <= 0 || dims > GMM_MAX_DIMS || gmm.n_features_ != dims ||
+        gmm.n_components_ <= 0 || gmm.n_components_ > GMM_MAX_COMPONENTS ||
+        gmm.n_classes_ <= 0 || gmm.n_classes_ > GMM_MAX_CLASSES)
+    {
+        return false;
+    }
+
+    input_width_ = pca.input_width_;
+    input_height_ = pca.input_height_;
+    components_ = gmm.n_components_;
+    classes_ = gmm.n_classes_;
+    means_ = pca.means_.transpose().cast<float>();
+    projection_ = pca.components_T_.transpose().cast<float>();
+
+    const int gaussians = classes_ * components_;
+    factors_.resize(gaussians * dims, dims);
+    offsets_.resize(gaussians * dims);
+    for (int cls = 0; cls < classes_; cls++)
+    {
+        // As ClassConditionalGMM::logprob reads them
+        log_priors_[cls] = gmm.log_priors_[cls];
+        for (int i = 0; i < components_; i++)
+        {
+            const GaussianDistribution &gaussian = gmm.gaussians_[cls][i];
+            const int g = cls * components_ + i;
+
+            // precision = L L^T = U^T U, so (z - mean) precision (z - mean)^T
+            // is the squared norm of U (z - mean)^T.
+            Eigen::LLT<Matrixxf> llt(gaussian.precision_);
+            if (llt.info() != Eigen::Success)
+            {
+                return false;
+            }
+            const Matrixxf upper = llt.matrixU();
+            factors_.block(g * dims, 0, dims, dims) = upper.cast<float>();
+            offsets_.segment(g * dims, dims) =
+                (upper * gaussian.mean_.transpose()).cast<float>();
+            constants_[g] = gmm.log_weights_[cls][i] +
+                            gaussian.log_normalise_factor_;
+        }
+    }
+    dims_ = dims;
+    return true;
+}
+
+bool FixedGMM::accepts(const RegionI& region) const
+{
+    return !empty() && region.getRows() >= 2 && region.getCols() >= 2 &&
+           (region.has_view_fovea<1>() || region.has_view_fovea<2>() ||
+            region.has_view_fovea<4>());
+}
+
+template <class View>
+void FixedGMM::sample_(const View& view, int rows, int cols, float* features) const
+{
+    // Estimator::resize, reading the four pixels around each sample from
+    // the region rather than an image of it. Pixels are 255 if white, else 0.
+    float deltaX = (float)(rows) / input_width_;
+    float lastX = (0.5 * rows) / input_width_ - 0.5;
+    float deltaY = (float)(cols) / input_height_;
+    for (int i = 0; i < input_width_; ++i)
+    {
+        float x = lastX;
+        lastX += deltaX;
+        int fx = (int)x;
+        x -= fx;
+        short x1 = (1.f - x) * 2048;
+        short x2 = 2048 - x1;
+        if (fx >= rows - 1)
+        {
+            fx = rows - 2;
+        }
+        const typename View::row_type top = view.row(fx);
+        const typename View::row_type bottom = view.row(fx + 1);
+        float lastY = (0.5 * cols) / input_height_ - 0.5;
+        for (int j = 0; j < input_height_; ++j)
+        {
+            float y = lastY;
+            lastY += deltaY;
+            int fy = (int)y;
+            y -= fy;
+            if (fy >= cols - 1)
+            {
+                fy = cols - 2;
+            }
+            short y1 = (1.f - y) * 2048;
+            short y2 = 2048 - y1;
+            const int a = top[fy] == cWHITE ? 255 : 0;
+            const int b = bottom[fy] == cWHITE ? 255 : 0;
+            const int c = top[fy + 1] == cWHITE ? 255 : 0;
+            const int d = bottom[fy + 1] == cWHITE ? 255 : 0;
+            // Estimator::reshape's column major order
+            features[j * input_width_ + i] =
+                (a * x1 * y1 + b * x2 * y1 + c * x1 * y2 + d * x2 * y2) >> 22;
+        }
+    }
+}
+
+int FixedGMM::predict(const RegionI& region) const
+{
+    const int rows = region.getRows();
+    const int cols = region.getCols();
+    Input X(means_.size());
+    if (region.has_view_fovea<1>())
+    {
+        sample_(region.get_view_fovea<1>(), rows, cols, X.data());
+    }
+    else if (region.has_view_fovea<2>())
+    {
+        sample_(region.get_view_fovea<2>(), rows, cols, X.data());
+    }
+    else
+    {
+        sample_(region.get_view_fovea<4>(), rows, cols, X.data());
+    }
+    X -= means_;
+
+    Reduced Z(dims_);
+    Z.noalias() = projection_ * X;
+    Stacked Y(offsets_.size());
+    Y.noalias() = factors_ * Z;
+    Y -= offsets_;
+
+    /*
+    NOTE:
+    as Estimator::predict, the most likely class rather than probabilities
+    */
+    float max_likelihood = -std::numeric_limits<float>::infinity();
+    int argmax = 0;
+    for (int cls = 0; cls < classes_; cls++)
+    {
+        float component_log_likelihood[GMM_MAX_COMPONENTS];
+        float max_ll = -std::numeric_limits<float>::infinity();
+        for (int i = 0; i < components_; i++)
+        {
+            const int g = cls * components_ + i;
+            component_log_likelihood[i] = constants_[g] -
+                0.5f * Y.segment(g * dims_, dims_).squaredNorm();
+            if (component_log_likelihood[i] > max_ll)
+                max_ll = component_log_likelihood[i];
+        }
+        float likelihood = 0.f;
+        for (int i = 0; i < components_; i++)
+            likelihood += expf(component_log_likelihood[i] - max_ll);
+
+        const float log_likelihood = log_priors_[cls] + max_ll + logf(likelihood);
+        if (log_likelihood > max_likelihood)
+        {
+            max_likelihood = log_likelihood;
+            argmax = cls;
+        }
+    }
+    return argmax;
+}
+
 Estimator::Estimator(ClassifierType type) : 
   pca_(type), ccgmm_(type)
 {
     n_features_ = pca_.getNFeatures();
     input_width_ = pca_.getInputWidth();
     input_height_ = pca_.getInputHeight();
+    if (!fixed_.build(pca_, ccgmm_) && n_features_ > 0)
+        printf("WARNING: GMM too big for FixedGMM, using dynamic matrices\n");
 }
 
 int Estimator::predict(const RegionI& region)
 {
+    if (fixed_.accepts(region))
+        return fixed_.predict(region);
+
     const Matrixxf img = convert(region);
 
     /*
@@ -150,7 +321,8 @@ Vectorxf Estimator::reshape(const Matrixxf &img)
     return result;
 }
 
-PCA::PCA(ClassifierType type)
+PCA::PCA(ClassifierType type) :
+  n_features_(0), input_height_(0), input_width_(0), n_components_(0)
 {
     /*
     // PCA MODEL DUMP FORMAT
@@ -228,7 +400,8 @@ int PCA::getInputHeight()
     return input_height_;
 }
 
-ClassConditionalGMM::ClassConditionalGMM(ClassifierType type)
+ClassConditionalGMM::ClassConditionalGMM(ClassifierType type) :
+  n_classes_(0), n_features_(0), n_components_(0)
 {
     /*
     // GMM MODEL DUMP FORMAT
@@ -18,6 +18,15 @@
 typedef Eigen::Matrix<double, 1, Eigen::Dynamic> Vectorxf;
 typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> Matrixxf;
 
+// The largest models FixedGMM holds. Its matrices have these as fixed
+// capacities, so they live inside it and on the stack rather than the heap.
+// Bigger models are classified by the dynamic Eigen path instead.
+#define GMM_MAX_FEATURES 1024
+#define GMM_MAX_DIMS 32
+#define GMM_MAX_COMPONENTS 8
+#define GMM_MAX_CLASSES 2
+#define GMM_MAX_GAUSSIANS (GMM_MAX_CLASSES * GMM_MAX_COMPONENTS)
+
 // The location directory of model files
 #define PCA_MODEL_DIR_BALL "data/ball_classifier.pca"
 #define GMM_MODEL_DIR_BALL "data/ball_classifier.gmm"
@@ -47,6 +56,8 @@ class GaussianDistribution
     double logprob(const Vectorxf &);
 
   private:
+    friend class FixedGMM;
+
     Vectorxf mean_;
     Matrixxf precision_;
     double log_normalise_factor_;
@@ -66,6 +77,8 @@ class ClassConditionalGMM
     int getNClasses();
 
   private:
+    friend class FixedGMM;
+
     int n_classes_;
     int n_features_;
     int n_components_;
@@ -90,6 +103,8 @@ class PCA
     int getInputWidth();
 
   private:
+    friend class FixedGMM;
+
     int n_features_;
     int input_height_;
     int input_width_;
@@ -98,6 +113,76 @@ class PCA
     Matrixxf components_T_;
 };
 
+/*
+FixedGMM
+A PCA and class conditional GMM precomputed for classifying without heap
+allocation. Each Gaussian's precision matrix is factored as U^T U offline,
+and its mean folded into an offset, so every Gaussian of every class is
+evaluated at once as one matrix-vector product, U z - U mean, and the
+squared norm of each Gaussian's part of it. The PCA projection is applied
+once and shared by the Gaussians; folding it into each of them would
+multiply its cost by the number of Gaussians.
+
+Region pixels are sampled and resized straight from the region's rows,
+exactly as Estimator::resize does, without building the full size image.
+Classifies as the dynamic path does, to float rather than double precision.
+*/
+class FixedGMM
+{
+  public:
+    FixedGMM();
+
+    /*
+    Precomputes pca and gmm, returning false and leaving this empty if they
+    did not load, do not fit the GMM_MAX_ bounds or a precision matrix is
+    not positive definite.
+    */
+    bool build(const PCA &pca, const ClassConditionalGMM &gmm);
+
+    bool empty() const { return dims_ == 0; }
+
+    /*
+    Whether region can be classified here. Regions without a row view, or
+    smaller than 2x2, are left to the dynamic path.
+    */
+    bool accepts(const RegionI& region) const;
+
+    int predict(const RegionI& region) const;
+
+  private:
+    typedef Eigen::Matrix<float, Eigen::Dynamic, 1, Eigen::ColMajor,
+                          GMM_MAX_FEATURES, 1> Input;
+    typedef Eigen::Matrix<float, Eigen::Dynamic, 1, Eigen::ColMajor,
+                          GMM_MAX_DIMS, 1> Reduced;
+    typedef Eigen::Matrix<float, Eigen::Dynamic, 1, Eigen::ColMajor,
+                          GMM_MAX_GAUSSIANS * GMM_MAX_DIMS, 1> Stacked;
+    typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor,
+                          GMM_MAX_DIMS, GMM_MAX_FEATURES> Projection;
+    typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor,
+                          GMM_MAX_GAUSSIANS * GMM_MAX_DIMS, GMM_MAX_DIMS> Factors;
+
+    int input_width_;
+    int input_height_;
+    int dims_;
+    int components_;
+    int classes_;
+
+    Input means_;
+    Projection projection_;
+
+    // Each Gaussian's U stacked, class by class, and U mean
+    Factors factors_;
+    Stacked offsets_;
+
+    // Each Gaussian's log weight plus log normalise factor, and each class's
+    // log prior
+    float constants_[GMM_MAX_GAUSSIANS];
+    float log_priors_[GMM_MAX_CLASSES];
+
+    template <class View>
+    void sample_(const View& view, int rows, int cols, float* features) const;
+};
+
 /*
 Estimator
 The interface of the classifier. It will constrct the PCA model and
@@ -115,6 +200,7 @@ class Estimator
     int input_width_;
     PCA pca_;
     ClassConditionalGMM ccgmm_;
+    FixedGMM fixed_;
 
     Matrixxf convert(const RegionI& region);
     Vectorxf preprocessor(const Matrixxf &);
@@ -0,0 +1,35 @@
+#include "perception/vision/other/ImagePlanes.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+ImagePlanes::ImagePlanes(int cols, int rows)
+    : cols_(cols), rows_(rows), y_(cols * rows)
+{
+}
+
+/**
+ * Copies the Y of n YUYV pixels to out.
+ */
+static inline void unpackY(const uint8_t* yuyv, int n, uint8_t* out)
+{
+    int x = 0;
+#ifdef __SSE2__
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    for (; x + 16 <= n; x += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(yuyv + 2*x));
+        __m128i b = _mm_loadu_si128((const __m128i*)(yuyv + 2*x + 16));
+        _mm_storeu_si128((__m128i*)(out + x),
+            _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+    }
+#endif // __SSE2__
+    for (; x < n; ++x)
+        out[x] = yuyv[2*x];
+}
+
+void ImagePlanes::build(const uint8_t* yuyv)
+{
+    unpackY(yuyv, cols_ * rows_, &y_[0]);
+}
@@ -0,0 +1,45 @@
+#ifndef PERCEPTION_VISION_OTHER_IMAGEPLANES_H_
+#define PERCEPTION_VISION_OTHER_IMAGEPLANES_H_
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * The full resolution Y plane of one camera image, unpacked from the
+ * camera's YUV422 in a single pass per frame.
+ *
+ * Reading Y from a packed plane, rather than every other byte of the raw
+ * image, halves the memory Fovea and the region iterators touch. Coarser
+ * densities are box filtered from it by ImagePyramid.
+ */
+class ImagePlanes {
+
+public:
+
+    /**
+     * Planes for a cols by rows image.
+     */
+    ImagePlanes(int cols, int rows);
+
+    /**
+     * Fills the plane from a cols by rows YUV422 (YUYV) image.
+     */
+    void build(const uint8_t* yuyv);
+
+    /**
+     * The Y plane. Pixel (x, y) of the plane is at y * cols() + x.
+     */
+    const uint8_t* y() const { return &y_[0]; }
+
+    int cols() const { return cols_; }
+    int rows() const { return rows_; }
+
+private:
+
+    const int cols_;
+    const int rows_;
+
+    std::vector<uint8_t> y_;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "perception/vision/other/ImagePyramid.hpp"
+
+#include "perception/vision/other/ImagePlanes.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+/**
+ * Box filters a plane to half its size on each axis, each output pixel the
+ * rounded mean of the two by two block it covers.
+ */
+static void halve(const uint8_t* src, int src_cols, int cols, int rows,
+                  uint8_t* dst)
+{
+    for (int row = 0; row < rows; ++row)
+    {
+        const uint8_t* a = src + 2 * row * src_cols;
+        const uint8_t* b = a + src_cols;
+        uint8_t* out = dst + row * cols;
+
+        int x = 0;
+#ifdef __SSE2__
+        // Sum the even and odd bytes of both rows in 16 bit lanes.
+        const __m128i mask = _mm_set1_epi16(0x00FF);
+        const __m128i two = _mm_set1_epi16(2);
+        for (; x + 16 <= cols; x += 16)
+        {
+            __m128i sums[2];
+            for (int half = 0; half < 2; ++half)
+            {
+                const __m128i va = _mm_loadu_si128((const __m128i*)(a + 2*x + 16*half));
+                const __m128i vb = _mm_loadu_si128((const __m128i*)(b + 2*x + 16*half));
+                __m128i sum = _mm_add_epi16(_mm_and_si128(va, mask), _mm_srli_epi16(va, 8));
+                sum = _mm_add_epi16(sum, _mm_and_si128(vb, mask));
+                sum = _mm_add_epi16(sum, _mm_srli_epi16(vb, 8));
+                sums[half] = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+            }
+            _mm_storeu_si128((__m128i*)(out + x), _mm_packus_epi16(sums[0], sums[1]));
+        }
+#endif // __SSE2__
+        for (; x < cols; ++x)
+            out[x] = (a[2*x] + a[2*x + 1] + b[2*x] + b[2*x + 1] + 2) >> 2;
+    }
+}
+
+ImagePyramid::ImagePyramid(int cols, int rows)
+    : cols_(cols), rows_(rows), planes_(NULL), y_levels_(0)
+{
+    for (int level = 0; level < NUM_LEVELS; ++level)
+    {
+        y_[level] = NULL;
+        if (level > 0)
+            y_store_[level].resize((cols >> level) * (rows >> level));
+    }
+}
+
+void ImagePyramid::reset(const ImagePlanes* planes)
+{
+    planes_ = planes;
+    y_levels_ = 0;
+    for (int level = 0; level < NUM_LEVELS; ++level)
+        y_[level] = NULL;
+}
+
+int ImagePyramid::level_(int density)
+{
+    for (int level = 0; level < NUM_LEVELS; ++level)
+    {
+        if (density == 1 << level)
+            return level;
+    }
+    return -1;
+}
+
+void ImagePyramid::buildY_(int level) const
+{
+    if (y_levels_ == 0)
+    {
+        y_[0] = planes_->y();
+        y_levels_ = 1;
+    }
+    for (; y_levels_ <= level; ++y_levels_)
+    {
+        const int density = 1 << y_levels_;
+        uint8_t* out = &y_store_[y_levels_][0];
+        halve(y_[y_levels_ - 1], cols(density / 2), cols(density),
+              rows(density), out);
+        y_[y_levels_] = out;
+    }
+}
+
+const uint8_t* ImagePyramid::y(int density) const
+{
+    const int level = level_(density);
+    if (level < 0 || !planes_)
+        return NULL;
+
+    boost::mutex::scoped_lock lock(y_mutex_);
+    if (level >= y_levels_)
+        buildY_(level);
+    return y_[level];
+}
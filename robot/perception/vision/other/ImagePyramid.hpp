@@ -0,0 +1,79 @@
+#ifndef PERCEPTION_VISION_OTHER_IMAGEPYRAMID_H_
+#define PERCEPTION_VISION_OTHER_IMAGEPYRAMID_H_
+
+#include <stdint.h>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+
+class ImagePlanes;
+
+/**
+ * One camera's image at densities 1, 2, 4 and 8, shared by everything that
+ * reads the image at one of those densities in a frame.
+ *
+ * Each density has a Y plane, every pixel of which is the mean of the
+ * density by density block of full resolution pixels it covers. Planes are
+ * built the first time they are asked for in a frame, each from the one
+ * before, and are then views for the rest of the frame, so each is computed
+ * at most once per frame however many foveae and detectors read it.
+ *
+ * Planes may be asked for from several threads at once; only reset is not
+ * thread safe.
+ */
+class ImagePyramid {
+
+public:
+
+    static const int NUM_LEVELS = 4;
+
+    /**
+     * A pyramid for a cols by rows image. cols and rows must be multiples
+     * of the coarsest density.
+     */
+    ImagePyramid(int cols, int rows);
+
+    /**
+     * Starts a frame, forgetting every plane built for the last. planes
+     * holds the frame's full resolution Y plane, or is NULL if there is no
+     * image.
+     */
+    void reset(const ImagePlanes* planes);
+
+    /**
+     * Whether the pyramid has planes at density.
+     */
+    static bool hasDensity(int density) { return level_(density) >= 0; }
+
+    /**
+     * The Y plane at density, or NULL if there is no image. Pixel (x, y) of
+     * the plane is at y * cols(density) + x.
+     */
+    const uint8_t* y(int density) const;
+
+    int cols(int density) const { return cols_ / density; }
+    int rows(int density) const { return rows_ / density; }
+
+private:
+
+    // The level of density, or -1 if the pyramid does not have it.
+    static int level_(int density);
+
+    // Builds the Y planes up to level. Call with y_mutex_ held.
+    void buildY_(int level) const;
+
+    const int cols_;
+    const int rows_;
+
+    const ImagePlanes* planes_;
+
+    mutable boost::mutex y_mutex_;
+    mutable int y_levels_;
+    mutable const uint8_t* y_[NUM_LEVELS];
+    // Storage for every level but the first, which is the planes'.
+    mutable std::vector<uint8_t> y_store_[NUM_LEVELS];
+
+    ImagePyramid(const ImagePyramid&);
+    ImagePyramid& operator=(const ImagePyramid&);
+};
+
+#endif
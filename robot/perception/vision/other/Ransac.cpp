@@ -1,10 +1,12 @@
 #include "Ransac.hpp"
+#include "RansacEngine.hpp"
 #include "utils/basic_maths.hpp"
 
 #include <limits>
 #include <iostream>
 
 using namespace std;
+using namespace RANSAC;
 
 bool RANSAC::findLine(const std::vector<Point>  &points,
                  std::vector<bool>        **cons,
@@ -38,15 +40,18 @@ bool RANSAC::findLineConstrained(const std::vector<Point>  &points,
    /* error of best line found so far */
    float minerr = std::numeric_limits<float>::max();
 
-   std::vector<bool> *best_concensus, *this_concensus;
-   best_concensus = &cons_buf[0];
+   const PointSet set(points);
+   Consensus best_concensus, this_concensus;
+   best_concensus.resize(points.size());
+   this_concensus.resize(points.size());
 
-   unsigned int i, j;
+   unsigned int i;
+   unsigned int iterations = k;
 
    /**
     * Randomly select 2 points and create a line
     */
-   for (i = 0; i < k; ++ i) {
+   for (i = 0; i < iterations; ++ i) {
       unsigned int p1, p2;
       p1 = rand_r(seed) % points.size();
       do {
@@ -65,32 +70,10 @@ bool RANSAC::findLineConstrained(const std::vector<Point>  &points,
       const float denom = sqrt(l.t1*l.t1 + l.t2*l.t2);
       const float newe  = e*denom;
 
-      /**
-       * Choose the currently unused concensus buffer
-       */
-      if (best_concensus == &cons_buf[0]) {
-         this_concensus = &cons_buf[1];
-      } else {
-         this_concensus = &cons_buf[0];
-      }
-
-      unsigned int n_concensus_points = 0;
-      for (j = 0; j != points.size(); ++ j) {
-         const Point &p = points[j];
-         float dist = (l.t1 * p.x() + l.t2 * p.y() + l.t3);
-
-         if (dist < 0) {
-            dist = -dist;
-         }
-
-         if (dist < newe) {
-            l.var += dist;
-            ++ n_concensus_points;
-            (*this_concensus)[j] = true;
-         } else {
-            (*this_concensus)[j] = false;
-         }
-      }
+      float distsum = 0, dist2sum = 0;
+      unsigned int n_concensus_points = scoreLine(set, l, newe, n,
+            &this_concensus, &distsum, &dist2sum);
+      l.var += distsum;
       l.var /= denom;
 
       const float k = 0.2;
@@ -100,12 +83,14 @@ bool RANSAC::findLineConstrained(const std::vector<Point>  &points,
          l.var  = l.var / (points.size() * e);
          result = l;
          //std::cout << result.t1 << " " << result.t2 << " " << result.t3 << " " << result.var << std::endl;
-         best_concensus = this_concensus;
+         best_concensus.swap(this_concensus);
+         iterations = adaptiveIterations(n_concensus_points, points.size(), 2, iterations);
       }
    }
 
    if (minerr < std::numeric_limits<float>::max()) {
-      *cons = best_concensus;
+      best_concensus.copyTo(cons_buf[0], points.size());
+      *cons = &cons_buf[0];
       return true;
    } else {
       return false;
@@ -133,15 +118,18 @@ bool RANSAC::findCircleOfRadius(
    /* error of best circle found so far */
    float minerr = std::numeric_limits<float>::max();
 
-   std::vector<bool> *best_concensus, *this_concensus;
-   best_concensus = &cons_buf[0];
+   const PointSet set(points);
+   Consensus best_concensus, this_concensus;
+   best_concensus.resize(points.size());
+   this_concensus.resize(points.size());
 
-   unsigned int i, j;
+   unsigned int i;
+   unsigned int iterations = k;
 
    /**
     * Randomly select 2 points and create a circle
     */
-   for (i = 0; i < k; ++ i) {
+   for (i = 0; i < iterations; ++ i) {
       unsigned int p1, p2;
       p1 = rand_r(seed) % points.size();
       do {
@@ -150,39 +138,23 @@ bool RANSAC::findCircleOfRadius(
 
       RANSACCircle c(points[p1], points[p2], radius);
       Point centre = c.centre.cast<int>();
-      /**
-       * Choose the currently unused concensus buffer
-       */
-      if (best_concensus == &cons_buf[0]) {
-         this_concensus = &cons_buf[1];
-      } else {
-         this_concensus = &cons_buf[0];
-      }
-      unsigned int n_concensus_points = 0;
-      for (j = 0; j != points.size(); ++ j) {
-         const Point &p = points[j];
-         /* TODO(carl) look into integer version of this */
-         float dist = sqrt((centre - p).squaredNorm()) - radius;
-         int dist2 = dist * dist;
-         if (dist2 < e2) {
-            c.var += dist2;
-            ++ n_concensus_points;
-            (*this_concensus)[j] = true;
-         } else {
-            (*this_concensus)[j] = false;
-         }
-      }
+      float dist2sum = 0;
+      unsigned int n_concensus_points = scoreCircle(set, centre.cast<float>(),
+            radius, e2, n, &this_concensus, &dist2sum);
+      c.var += dist2sum;
       const float k = 0.2;
       c.var = (k * c.var) - n_concensus_points;
       if (c.var < minerr && n_concensus_points >= n) {
          minerr = c.var;
          c.var  = c.var / (points.size() * e);
          result = c;
-         best_concensus = this_concensus;
+         best_concensus.swap(this_concensus);
+         iterations = adaptiveIterations(n_concensus_points, points.size(), 2, iterations);
       }
    }
    if (minerr < std::numeric_limits<float>::max()) {
-      *cons = best_concensus;
+      best_concensus.copyTo(cons_buf[0], points.size());
+      *cons = &cons_buf[0];
       return true;
    } else {
       return false;
@@ -210,15 +182,18 @@ bool RANSAC::findCircleOfRadius3P(
    /* error of best circle found so far */
    float minerr = std::numeric_limits<float>::max();
 
-   std::vector<bool> *best_concensus, *this_concensus;
-   best_concensus = &cons_buf[0];
+   const PointSet set(points);
+   Consensus best_concensus, this_concensus;
+   best_concensus.resize(points.size());
+   this_concensus.resize(points.size());
 
    unsigned int i, j;
+   unsigned int iterations = k;
 
    float pos_var[4], neg_var[4];
 
    RANSACCircle c;
-   for (i = 0; i < k; ++ i) {
+   for (i = 0; i < iterations; ++ i) {
       /**
        * Randomly select 3 points and create a circle
        */
@@ -247,54 +222,10 @@ bool RANSAC::findCircleOfRadius3P(
          return false;
       }
 
-      /**
-       * Choose the currently unused concensus buffer
-       */
-      if (best_concensus == &cons_buf[0]) {
-         this_concensus = &cons_buf[1];
-      } else {
-         this_concensus = &cons_buf[0];
-      }
-
-      for (j = 0; j < 4; ++ j) {
-         pos_var[j] = neg_var[j] = 0;
-      }
-
-      unsigned int n_concensus_points = 0;
-      for (j = 0; j != points.size(); ++ j) {
-         const PointF &p = points[j].cast<float>();
-         const PointF &d = c.centre - p;
-         /* TODO(carl) look into integer version of this */
-         float dist = d.norm() - c.radius;
-         float dist2 = dist * dist;
-
-         if (dist2 < e2) {
-            int quadrant = 0;
-            if (d.x() > 0) {
-               if (d.y() > 0) {
-                  quadrant = 0;
-               } else {
-                  quadrant = 3;
-               }
-            } else {
-               if (d.y() > 0) {
-                  quadrant = 1;
-               } else {
-                  quadrant = 2;
-               }
-            }
-
-            if (dist > 0) {
-               pos_var[quadrant] += dist2;
-            } else {
-               neg_var[quadrant] += dist2;
-            }
-
-            ++ n_concensus_points;
-            (*this_concensus)[j] = true;
-         } else {
-            (*this_concensus)[j] = false;
-         }
+      unsigned int n_concensus_points = scoreCircleQuadrants(set, c.centre,
+            c.radius, e2, n, &this_concensus, pos_var, neg_var);
+      if (n_concensus_points < n) {
+         continue;
       }
 
       const float k = 0.2;
@@ -310,12 +241,14 @@ bool RANSAC::findCircleOfRadius3P(
          minerr = c.var;
          c.var  = c.var / (points.size() * e);
          result = c;
-         best_concensus = this_concensus;
+         best_concensus.swap(this_concensus);
+         iterations = adaptiveIterations(n_concensus_points, points.size(), 3, iterations);
       }
    }
 
    if (minerr < std::numeric_limits<float>::max()) {
-      *cons = best_concensus;
+      best_concensus.copyTo(cons_buf[0], points.size());
+      *cons = &cons_buf[0];
       return true;
    } else {
       return false;
@@ -347,16 +280,19 @@ bool RANSAC::findCircleOfRadius3PInsideBounds(
    /* error of best circle found so far */
    float minerr = std::numeric_limits<float>::max();
 
-   std::vector<bool> *best_concensus, *this_concensus;
-   best_concensus = &cons_buf[0];
+   const PointSet set(points);
+   Consensus best_concensus, this_concensus;
+   best_concensus.resize(points.size());
+   this_concensus.resize(points.size());
 
    unsigned int i, j;
+   unsigned int iterations = k;
 
    float pos_var[4], neg_var[4];
 
    RANSACCircle c = RANSACCircle(PointF(0, 0), 0);
 
-   for (i = 0; i < k; ++ i) {
+   for (i = 0; i < iterations; ++ i) {
       /**
        * Randomly select 3 points and create a circle
        */
@@ -388,54 +324,10 @@ bool RANSAC::findCircleOfRadius3PInsideBounds(
          return false;
       }
 
-      /**
-       * Choose the currently unused concensus buffer
-       */
-      if (best_concensus == &cons_buf[0]) {
-         this_concensus = &cons_buf[1];
-      } else {
-         this_concensus = &cons_buf[0];
-      }
-
-      for (j = 0; j < 4; ++ j) {
-         pos_var[j] = neg_var[j] = 0;
-      }
-
-      unsigned int n_concensus_points = 0;
-      for (j = 0; j != points.size(); ++ j) {
-         const PointF &p = points[j].cast<float>();
-         const PointF &d = c.centre - p;
-         /* TODO(carl) look into integer version of this */
-         float dist = d.norm() - c.radius;
-         float dist2 = dist * dist;
-
-         if (dist2 < e2) {
-            int quadrant = 0;
-            if (d.x() > 0) {
-               if (d.y() > 0) {
-                  quadrant = 0;
-               } else {
-                  quadrant = 3;
-               }
-            } else {
-               if (d.y() > 0) {
-                  quadrant = 1;
-               } else {
-                  quadrant = 2;
-               }
-            }
-
-            if (dist > 0) {
-               pos_var[quadrant] += dist2;
-            } else {
-               neg_var[quadrant] += dist2;
-            }
-
-            ++ n_concensus_points;
-            (*this_concensus)[j] = true;
-         } else {
-            (*this_concensus)[j] = false;
-         }
+      unsigned int n_concensus_points = scoreCircleQuadrants(set, c.centre,
+            c.radius, e2, n, &this_concensus, pos_var, neg_var);
+      if (n_concensus_points < n) {
+         continue;
       }
 
       const float k = 0.2;
@@ -451,12 +343,14 @@ bool RANSAC::findCircleOfRadius3PInsideBounds(
          minerr = c.var;
          c.var  = c.var / (points.size() * e);
          result = c;
-         best_concensus = this_concensus;
+         best_concensus.swap(this_concensus);
+         iterations = adaptiveIterations(n_concensus_points, points.size(), 3, iterations);
       }
    }
 
    if (minerr < std::numeric_limits<float>::max()) {
-      *cons = best_concensus;
+      best_concensus.copyTo(cons_buf[0], points.size());
+      *cons = &cons_buf[0];
       return true;
    } else {
       return false;
@@ -627,15 +521,18 @@ bool RANSAC::findLinesAndCircles(const std::vector<Point>  &points,
    float minerr = std::numeric_limits<float>::max();
    const int e2 = e * e;
 
-   std::vector<bool> *best_concensus, *this_concensus;
-   best_concensus = &cons_buf[0];
+   const PointSet set(points);
+   Consensus best_concensus, this_concensus;
+   best_concensus.resize(points.size());
+   this_concensus.resize(points.size());
 
-   unsigned int i, j;
+   unsigned int i;
+   unsigned int iterations = k;
 
    /**
     * Randomly select 2 points and create a line
     */
-   for (i = 0; i < k; ++ i) {
+   for (i = 0; i < iterations; ++ i) {
       unsigned int p1, p2;
       p1 = rand_r(seed) % points.size();
       p2 = p1;
@@ -664,32 +561,10 @@ bool RANSAC::findLinesAndCircles(const std::vector<Point>  &points,
       const float denom = sqrt(l.t1*l.t1 + l.t2*l.t2);
       const float newe  = e*denom;
 
-      /**
-       * Choose the currently unused concensus buffer
-       */
-      if (best_concensus == &cons_buf[0]) {
-         this_concensus = &cons_buf[1];
-      } else {
-         this_concensus = &cons_buf[0];
-      }
-      float distsum = 0;
-      unsigned int n_concensus_points = 0;
-      for (j = 0; j != points.size(); ++ j) {
-         const Point &p = points[j];
-         float dist = (l.t1 * p.x() + l.t2 * p.y() + l.t3);
-
-         if (dist < 0) {
-            dist = -dist;
-         }
-
-         if (dist < newe) {
-            l.var += (dist*dist);
-            ++ n_concensus_points;
-            (*this_concensus)[j] = true;
-         } else {
-            (*this_concensus)[j] = false;
-         }
-      }
+      float distsum = 0, dist2sum = 0;
+      unsigned int n_concensus_points = scoreLine(set, l, newe, n,
+            &this_concensus, &distsum, &dist2sum);
+      l.var += dist2sum;
       l.var /= (denom * denom);
       distsum = l.var;
       //const float k = 0.2;
@@ -707,7 +582,8 @@ bool RANSAC::findLinesAndCircles(const std::vector<Point>  &points,
          //std::cout << "line var = " << l.var
          //          << " and distsum = " << distsum << std::endl;
          //std::cout << result.t1 << " " << result.t2 << " " << result.t3 << " " << result.var << std::endl;
-         best_concensus = this_concensus;
+         best_concensus.swap(this_concensus);
+         iterations = adaptiveIterations(n_concensus_points, points.size(), 2, iterations);
       }
 
 //      int count = 0;
@@ -726,16 +602,6 @@ bool RANSAC::findLinesAndCircles(const std::vector<Point>  &points,
       }
       Point centre = c.centre.cast<int>();
 
-      //
-      // Choose the currently unused concensus buffer
-      //
-      if (best_concensus == &cons_buf[0]) {
-         this_concensus = &cons_buf[1];
-      } else {
-         this_concensus = &cons_buf[0];
-      }
-
-      n_concensus_points = 0;
 /*
       float point_dist = sqrt((points[p1] - points[p2]).squaredNorm());
       std::cout << "p1 = " << p1 << " p2 = " << p2 << std::endl;
@@ -747,21 +613,10 @@ bool RANSAC::findLinesAndCircles(const std::vector<Point>  &points,
       std::cout << "centre = ( " << centre.x() << ", " << centre.y()
                 << ")" << std::endl;
 */
-      for (j = 0; j != points.size(); ++ j) {
-         const Point &p = points[j];
-         // TODO(carl) look into integer version of this
-         float dist = sqrt((centre - p).squaredNorm()) - radius;
-         float dist2 = dist*dist;
-//         std::cout << "j = " << j << " and dist = " << dist << std::endl;
-
-         if (dist2 < e2) {
-            c.var += dist2;
-            ++ n_concensus_points;
-            (*this_concensus)[j] = true;
-         } else {
-            (*this_concensus)[j] = false;
-         }
-      }
+      dist2sum = 0;
+      n_concensus_points = scoreCircle(set, centre.cast<float>(), radius, e2, n,
+            &this_concensus, &dist2sum);
+      c.var += dist2sum;
       distsum = c.var;
       //c.var = (k * c.var) - n_concensus_points;
       //c.var /= (n_concensus_points * n_concensus_points);
@@ -779,7 +634,8 @@ bool RANSAC::findLinesAndCircles(const std::vector<Point>  &points,
       if (c.var < minerr && n_concensus_points >= n) {
          minerr = c.var;
          resultCircle = c;
-         best_concensus = this_concensus;
+         best_concensus.swap(this_concensus);
+         iterations = adaptiveIterations(n_concensus_points, points.size(), 2, iterations);
          //std::cout << "circle var = " << c.var
          //          << " and distsum = " << distsum << std::endl;
       }
@@ -787,12 +643,77 @@ bool RANSAC::findLinesAndCircles(const std::vector<Point>  &points,
    }
 
    if (minerr < std::numeric_limits<float>::max()) {
-      *cons = best_concensus;
+      best_concensus.copyTo(cons_buf[0], points.size());
+      *cons = &cons_buf[0];
       return true;
    } else {
       return false;
    }
 }
+
+template <>
+bool RANSAC::Ransac<RANSACLine>::operator() (
+      const Generator<RANSACLine> &generator,
+      const std::vector<Point>    &points,
+      std::vector<bool>          **cons,
+      RANSACLine                  &result,
+      unsigned int                 k,
+      float                        e,
+      unsigned int                 n,
+      std::vector<bool>            cons_buf[2],
+      unsigned int                *seed)
+{
+   if (points.size() < n)
+   {
+      return false;
+   }
+
+   /* error of best line found so far */
+   float minerr = std::numeric_limits<float>::max();
+
+   const PointSet set(points);
+   Consensus best_concensus, this_concensus;
+   best_concensus.resize(points.size());
+   this_concensus.resize(points.size());
+
+   unsigned int i;
+   unsigned int iterations = k;
+   for (i = 0; i < iterations; ++ i) {
+      /* Generate a model */
+      RANSACLine model;
+      if (! generator(model, points, seed)) {
+         break;
+      }
+
+      /* Accept and finalise as Acceptor<RANSACLine> does */
+      const float denom = model.t1 * model.t1 + model.t2 * model.t2;
+      const float e2 = (e * e) * denom;
+      float distsum = 0, dist2sum = 0;
+      unsigned int n_concensus_points = scoreLine(set, model, sqrtf(e2), n,
+            &this_concensus, &distsum, &dist2sum);
+      model.var += dist2sum;
+      model.var = model.var / e2;
+
+      model.var /= (n_concensus_points / 2);
+      model.var -= (((float)n_concensus_points) / points.size());
+
+      if (model.var < minerr && n_concensus_points >= n) {
+         minerr = model.var;
+         result = model;
+         best_concensus.swap(this_concensus);
+         iterations = adaptiveIterations(n_concensus_points, points.size(), 2, iterations);
+      }
+   }
+
+   if (minerr < std::numeric_limits<float>::max()) {
+      best_concensus.copyTo(cons_buf[0], points.size());
+      *cons = &cons_buf[0];
+      return true;
+   } else {
+      return false;
+   }
+}
+
 /**
  * RANSACLine Acceptor
  */
@@ -8,6 +8,14 @@
 
 namespace RANSAC
 {
+   /**
+    * The find functions below score hypotheses with the SSE scorers in
+    * RansacEngine.hpp, keep consensus sets as bitsets until the best is
+    * written to cons_buf[0], and stop before k iterations once the best
+    * consensus so far makes a better sample unlikely (see
+    * adaptiveIterations).
+    */
+
    /**
     * Ransac generators
     */
@@ -257,6 +265,23 @@ namespace RANSAC
            );
    };
 
+   /**
+    * Lines are scored four points at a time by scoreLine rather than point
+    * by point through their Acceptor, to the same effect.
+    */
+   template <>
+   bool Ransac<RANSACLine>::operator() (
+         const Generator<RANSACLine> &generator,
+         const std::vector<Point>    &points,
+         std::vector<bool>          **cons,
+         RANSACLine                  &result,
+         unsigned int                 k,
+         float                        e,
+         unsigned int                 n,
+         std::vector<bool>            cons_buf[2],
+         unsigned int                *seed
+        );
+
 };
 
 #include "Ransac.tcc"
@@ -0,0 +1,304 @@
+#include "RansacEngine.hpp"
+
+#include <math.h>
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+namespace {
+#ifdef __SSE2__
+   /**
+    * All ones in lane i if base + i < size.
+    */
+   inline __m128 validLanes(unsigned int base, unsigned int size)
+   {
+      const __m128i lanes = _mm_add_epi32(_mm_set1_epi32(base),
+                                          _mm_setr_epi32(0, 1, 2, 3));
+      return _mm_castsi128_ps(_mm_cmplt_epi32(lanes, _mm_set1_epi32(size)));
+   }
+
+   inline float horizontalSum(__m128 v)
+   {
+      float f[4];
+      _mm_storeu_ps(f, v);
+      return (f[0] + f[1]) + (f[2] + f[3]);
+   }
+#endif // __SSE2__
+
+   /**
+    * The circle scorers. Points are taken a word of the consensus, 32 points,
+    * at a time, so the early exit costs one test per word.
+    */
+   template <bool QUADRANTS>
+   unsigned int scoreCircle_(const RANSAC::PointSet &points, PointF centre,
+                             float radius, float e2, unsigned int needed,
+                             RANSAC::Consensus *consensus, float *sum_squares,
+                             float pos_var[4], float neg_var[4])
+   {
+      const unsigned int size = points.size();
+      const float *xs = points.xs();
+      const float *ys = points.ys();
+
+#ifdef __SSE2__
+      const __m128 cx = _mm_set1_ps(centre.x());
+      const __m128 cy = _mm_set1_ps(centre.y());
+      const __m128 r = _mm_set1_ps(radius);
+      const __m128 limit = _mm_set1_ps(e2);
+      const __m128 zero = _mm_setzero_ps();
+
+      __m128 sum = zero;
+      __m128 pos[4] = {zero, zero, zero, zero};
+      __m128 neg[4] = {zero, zero, zero, zero};
+#else
+      float sum = 0.f;
+      float pos[4] = {0.f, 0.f, 0.f, 0.f};
+      float neg[4] = {0.f, 0.f, 0.f, 0.f};
+#endif // __SSE2__
+
+      unsigned int count = 0;
+      for (unsigned int base = 0; base < size; base += 32) {
+         const unsigned int end = std::min(base + 32, size);
+         uint32_t word = 0;
+#ifdef __SSE2__
+         for (unsigned int i = base; i < end; i += 4) {
+            const __m128 dx = _mm_sub_ps(cx, _mm_loadu_ps(xs + i));
+            const __m128 dy = _mm_sub_ps(cy, _mm_loadu_ps(ys + i));
+            const __m128 dist = _mm_sub_ps(_mm_sqrt_ps(_mm_add_ps(
+                     _mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))), r);
+            const __m128 dist2 = _mm_mul_ps(dist, dist);
+
+            __m128 in = _mm_cmplt_ps(dist2, limit);
+            if (i + 4 > size) {
+               in = _mm_and_ps(in, validLanes(i, size));
+            }
+            word |= (uint32_t)_mm_movemask_ps(in) << (i - base);
+
+            const __m128 inlier2 = _mm_and_ps(in, dist2);
+            if (QUADRANTS) {
+               const __m128 right = _mm_cmpgt_ps(dx, zero);
+               const __m128 up = _mm_cmpgt_ps(dy, zero);
+               const __m128 outside = _mm_cmpgt_ps(dist, zero);
+
+               const __m128 out2 = _mm_and_ps(outside, inlier2);
+               const __m128 out2_up = _mm_and_ps(up, out2);
+               const __m128 out2_down = _mm_andnot_ps(up, out2);
+               pos[0] = _mm_add_ps(pos[0], _mm_and_ps(right, out2_up));
+               pos[1] = _mm_add_ps(pos[1], _mm_andnot_ps(right, out2_up));
+               pos[2] = _mm_add_ps(pos[2], _mm_andnot_ps(right, out2_down));
+               pos[3] = _mm_add_ps(pos[3], _mm_and_ps(right, out2_down));
+
+               const __m128 in2 = _mm_andnot_ps(outside, inlier2);
+               const __m128 in2_up = _mm_and_ps(up, in2);
+               const __m128 in2_down = _mm_andnot_ps(up, in2);
+               neg[0] = _mm_add_ps(neg[0], _mm_and_ps(right, in2_up));
+               neg[1] = _mm_add_ps(neg[1], _mm_andnot_ps(right, in2_up));
+               neg[2] = _mm_add_ps(neg[2], _mm_andnot_ps(right, in2_down));
+               neg[3] = _mm_add_ps(neg[3], _mm_and_ps(right, in2_down));
+            } else {
+               sum = _mm_add_ps(sum, inlier2);
+            }
+         }
+#else
+         for (unsigned int i = base; i < end; ++i) {
+            const float dx = centre.x() - xs[i];
+            const float dy = centre.y() - ys[i];
+            const float dist = sqrtf(dx * dx + dy * dy) - radius;
+            const float dist2 = dist * dist;
+            if (!(dist2 < e2)) {
+               continue;
+            }
+            word |= (uint32_t)1 << (i - base);
+
+            if (QUADRANTS) {
+               const int q = dy > 0 ? (dx > 0 ? 0 : 1) : (dx > 0 ? 3 : 2);
+               if (dist > 0) {
+                  pos[q] += dist2;
+               } else {
+                  neg[q] += dist2;
+               }
+            } else {
+               sum += dist2;
+            }
+         }
+#endif // __SSE2__
+
+         if (consensus) {
+            consensus->words()[base >> 5] = word;
+         }
+         count += __builtin_popcount(word);
+         if (count + (size - end) < needed) {
+            return count;
+         }
+      }
+
+      if (QUADRANTS) {
+         for (int q = 0; q < 4; ++q) {
+#ifdef __SSE2__
+            pos_var[q] = horizontalSum(pos[q]);
+            neg_var[q] = horizontalSum(neg[q]);
+#else
+            pos_var[q] = pos[q];
+            neg_var[q] = neg[q];
+#endif // __SSE2__
+         }
+      } else {
+#ifdef __SSE2__
+         *sum_squares += horizontalSum(sum);
+#else
+         *sum_squares += sum;
+#endif // __SSE2__
+      }
+      return count;
+   }
+}
+
+void RANSAC::PointSet::assign(const std::vector<Point> &points)
+{
+   size_ = points.size();
+
+   // At least one block, so that xs() and ys() are valid when empty.
+   const unsigned int padded = std::max((size_ + 3) & ~3u, 4u);
+   xs_.assign(padded, 0.f);
+   ys_.assign(padded, 0.f);
+   for (unsigned int i = 0; i < size_; ++i) {
+      xs_[i] = points[i].x();
+      ys_[i] = points[i].y();
+   }
+}
+
+void RANSAC::Consensus::copyTo(std::vector<bool> &out, unsigned int size) const
+{
+   for (unsigned int i = 0; i < size; ++i) {
+      out[i] = (*this)[i];
+   }
+}
+
+unsigned int RANSAC::scoreLine(const PointSet     &points,
+                               const RANSACLine   &line,
+                               float               limit,
+                               unsigned int        needed,
+                               Consensus          *consensus,
+                               float              *sum,
+                               float              *sum_squares)
+{
+   const unsigned int size = points.size();
+   const float *xs = points.xs();
+   const float *ys = points.ys();
+
+   // Measured from p1 rather than with t3, which keeps the products small
+   // enough for float when the points are in millimetres.
+#ifdef __SSE2__
+   const __m128 t1 = _mm_set1_ps(line.t1);
+   const __m128 t2 = _mm_set1_ps(line.t2);
+   const __m128 x1 = _mm_set1_ps(line.p1.x());
+   const __m128 y1 = _mm_set1_ps(line.p1.y());
+   const __m128 max = _mm_set1_ps(limit);
+   const __m128 sign = _mm_set1_ps(-0.f);
+
+   __m128 total = _mm_setzero_ps();
+   __m128 total2 = _mm_setzero_ps();
+#else
+   float total = 0.f;
+   float total2 = 0.f;
+#endif // __SSE2__
+
+   unsigned int count = 0;
+   for (unsigned int base = 0; base < size; base += 32) {
+      const unsigned int end = std::min(base + 32, size);
+      uint32_t word = 0;
+#ifdef __SSE2__
+      for (unsigned int i = base; i < end; i += 4) {
+         const __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), x1);
+         const __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), y1);
+         const __m128 dist = _mm_andnot_ps(sign, _mm_add_ps(_mm_mul_ps(t1, dx),
+                                                            _mm_mul_ps(t2, dy)));
+
+         __m128 in = _mm_cmplt_ps(dist, max);
+         if (i + 4 > size) {
+            in = _mm_and_ps(in, validLanes(i, size));
+         }
+         word |= (uint32_t)_mm_movemask_ps(in) << (i - base);
+
+         const __m128 inlier = _mm_and_ps(in, dist);
+         total = _mm_add_ps(total, inlier);
+         total2 = _mm_add_ps(total2, _mm_mul_ps(inlier, inlier));
+      }
+#else
+      for (unsigned int i = base; i < end; ++i) {
+         const float dist = fabsf(line.t1 * (xs[i] - line.p1.x()) +
+                                  line.t2 * (ys[i] - line.p1.y()));
+         if (dist < limit) {
+            word |= (uint32_t)1 << (i - base);
+            total += dist;
+            total2 += dist * dist;
+         }
+      }
+#endif // __SSE2__
+
+      if (consensus) {
+         consensus->words()[base >> 5] = word;
+      }
+      count += __builtin_popcount(word);
+      if (count + (size - end) < needed) {
+         return count;
+      }
+   }
+
+#ifdef __SSE2__
+   *sum += horizontalSum(total);
+   *sum_squares += horizontalSum(total2);
+#else
+   *sum += total;
+   *sum_squares += total2;
+#endif // __SSE2__
+   return count;
+}
+
+unsigned int RANSAC::scoreCircle(const PointSet   &points,
+                                 PointF            centre,
+                                 float             radius,
+                                 float             e2,
+                                 unsigned int      needed,
+                                 Consensus        *consensus,
+                                 float            *sum_squares)
+{
+   return scoreCircle_<false>(points, centre, radius, e2, needed, consensus,
+                              sum_squares, NULL, NULL);
+}
+
+unsigned int RANSAC::scoreCircleQuadrants(const PointSet   &points,
+                                          PointF            centre,
+                                          float             radius,
+                                          float             e2,
+                                          unsigned int      needed,
+                                          Consensus        *consensus,
+                                          float             pos_var[4],
+                                          float             neg_var[4])
+{
+   return scoreCircle_<true>(points, centre, radius, e2, needed, consensus,
+                             NULL, pos_var, neg_var);
+}
+
+unsigned int RANSAC::adaptiveIterations(unsigned int inliers,
+                                        unsigned int size,
+                                        unsigned int sample_size,
+                                        unsigned int k)
+{
+   if (inliers == 0 || size == 0) {
+      return k;
+   }
+
+   // The chance that one sample is all inliers.
+   const float good = powf((float)inliers / size, sample_size);
+   if (good >= 1.f) {
+      return std::min(k, 1u);
+   }
+
+   const float needed = logf(1.f - RANSAC_CONFIDENCE) / logf(1.f - good);
+   if (!(needed < k)) {
+      return k;
+   }
+   return std::max(1u, (unsigned int)ceilf(needed));
+}
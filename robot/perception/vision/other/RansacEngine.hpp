@@ -0,0 +1,127 @@
+#ifndef PERCEPTION_VISION_RANSACENGINE_H_
+#define PERCEPTION_VISION_RANSACENGINE_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "types/RansacTypes.hpp"
+#include "types/Point.hpp"
+
+/**
+ * The probability with which an adaptive RANSAC loop must have drawn at least
+ * one sample of inliers only before it stops early.
+ */
+#define RANSAC_CONFIDENCE 0.99f
+
+namespace RANSAC
+{
+   /**
+    * Points in structure of arrays form, so that the scorers below test four
+    * points against a model with each SSE instruction, or one at a time
+    * without SSE2. The arrays are padded to a multiple of four; the padding
+    * is never counted.
+    */
+   class PointSet
+   {
+      public:
+         PointSet() : size_(0) {}
+         explicit PointSet(const std::vector<Point> &points) { assign(points); }
+
+         void assign(const std::vector<Point> &points);
+
+         unsigned int size() const { return size_; }
+         const float *xs() const { return &xs_[0]; }
+         const float *ys() const { return &ys_[0]; }
+
+      private:
+         unsigned int size_;
+         std::vector<float> xs_;
+         std::vector<float> ys_;
+   };
+
+   /**
+    * A consensus set as a bitset, point i being bit i % 32 of word i / 32.
+    */
+   class Consensus
+   {
+      public:
+         void resize(unsigned int size) { words_.resize((size + 31) / 32); }
+         bool operator[](unsigned int i) const
+         {
+            return (words_[i >> 5] >> (i & 31)) & 1;
+         }
+         void swap(Consensus &other) { words_.swap(other.words_); }
+
+         /**
+          * Writes the first size bits into out, for callers that take a
+          * std::vector<bool>.
+          */
+         void copyTo(std::vector<bool> &out, unsigned int size) const;
+
+         uint32_t *words() { return &words_[0]; }
+
+      private:
+         std::vector<uint32_t> words_;
+   };
+
+   /**
+    * The scorers each test every point against one model and return the
+    * number of inliers, writing them to consensus unless it is NULL, which
+    * must be resized to the number of points. Once the points left could no
+    * longer bring the count up to needed they stop and return early with a
+    * count below needed, leaving the sums and consensus incomplete.
+    */
+
+   /**
+    * A point is an inlier if |t1 x + t2 y + t3| < limit. Adds that distance
+    * and its square over the inliers to sum and sum_squares. line.p1 must
+    * be on the line, as it is for any line made from two points.
+    */
+   unsigned int scoreLine(const PointSet     &points,
+                          const RANSACLine   &line,
+                          float               limit,
+                          unsigned int        needed,
+                          Consensus          *consensus,
+                          float              *sum,
+                          float              *sum_squares);
+
+   /**
+    * A point is an inlier if the square of its distance from the circle
+    * of radius about centre is below e2. Adds those squares over the
+    * inliers to sum_squares.
+    */
+   unsigned int scoreCircle(const PointSet   &points,
+                            PointF            centre,
+                            float             radius,
+                            float             e2,
+                            unsigned int      needed,
+                            Consensus        *consensus,
+                            float            *sum_squares);
+
+   /**
+    * As scoreCircle, but sums the squares by the quadrant of centre - p, in
+    * pos_var for inliers outside the circle and neg_var for those inside.
+    * Quadrants are numbered anticlockwise from x > 0, y > 0, with points
+    * on an axis in the quadrant at their lower x and y.
+    */
+   unsigned int scoreCircleQuadrants(const PointSet   &points,
+                                     PointF            centre,
+                                     float             radius,
+                                     float             e2,
+                                     unsigned int      needed,
+                                     Consensus        *consensus,
+                                     float             pos_var[4],
+                                     float             neg_var[4]);
+
+   /**
+    * The number of iterations after which a sample of sample_size inliers
+    * has been drawn with RANSAC_CONFIDENCE, if inliers of size points are
+    * inliers, capped at k.
+    */
+   unsigned int adaptiveIterations(unsigned int inliers,
+                                   unsigned int size,
+                                   unsigned int sample_size,
+                                   unsigned int k);
+};
+
+#endif
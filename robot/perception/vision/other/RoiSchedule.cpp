@@ -0,0 +1,205 @@
+#include "perception/vision/other/RoiSchedule.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "perception/vision/camera/CameraToRR.hpp"
+#include "utils/SPLDefs.hpp"
+
+// The distance at which an ROI is worth half what one at the robot's feet is
+#define ROI_HALF_VALUE_DISTANCE 1000.0f
+
+// The distance given to ROIs that do not project onto the field
+#define ROI_FAR_DISTANCE 10000.0f
+
+// The value added to an ROI within BALL_PRIOR_RADIUS of the expected ball
+#define BALL_PRIOR_VALUE 1.0f
+#define BALL_PRIOR_RADIUS 750.0f
+
+// The value added to an ROI over a ball detected the frame before
+#define RECENT_BALL_VALUE 1.0f
+
+// How quickly the time per pixel follows new measurements
+#define COST_RATE 0.1f
+
+// The time per pixel assumed before any is measured
+#define COST_INITIAL_US_PER_PIXEL 0.5f
+
+RoiSchedule::Cost::Cost() : us_per_pixel_(COST_INITIAL_US_PER_PIXEL)
+{
+}
+
+float RoiSchedule::Cost::predict(const RegionI& region) const
+{
+    return us_per_pixel_ * region.getCols() * region.getRows();
+}
+
+void RoiSchedule::Cost::update(int pixels, int time_us)
+{
+    if (pixels > 0)
+    {
+        us_per_pixel_ += COST_RATE * ((float)time_us / pixels - us_per_pixel_);
+    }
+}
+
+RoiSchedule::RoiSchedule() : budget_us_(0), ranking_(0)
+{
+}
+
+void RoiSchedule::setBudget(int budget_us)
+{
+    budget_us_ = std::max(budget_us, 0);
+}
+
+void RoiSchedule::start()
+{
+    timer_.restart();
+    nextRanking_();
+    order_.clear();
+    boost::mutex::scoped_lock lock(skips_mutex_);
+    skips_.clear();
+}
+
+void RoiSchedule::remember(const std::vector<BallInfo>& balls)
+{
+    recent_ = balls;
+}
+
+unsigned int RoiSchedule::rank(const std::vector<RegionI>& roi,
+                               const CameraToRR& camera_to_rr,
+                               const RRCoord& ball)
+{
+    ranked_.clear();
+    for (unsigned int i = 0; i < roi.size(); ++i)
+    {
+        ranked_.push_back(std::make_pair(-value_(roi[i], camera_to_rr, ball), i));
+    }
+
+    // Stable, so equal ROIs keep the region finder's order
+    std::stable_sort(ranked_.begin(), ranked_.end());
+    order_.clear();
+    for (unsigned int i = 0; i < ranked_.size(); ++i)
+    {
+        order_.push_back(ranked_[i].second);
+    }
+    return nextRanking_();
+}
+
+unsigned int RoiSchedule::nextRanking_()
+{
+    // 0 is never a ranking, even when the id wraps.
+    if (++ranking_ == 0)
+    {
+        ++ranking_;
+    }
+    return ranking_;
+}
+
+float RoiSchedule::value_(const RegionI& region,
+                          const CameraToRR& camera_to_rr,
+                          const RRCoord& ball) const
+{
+    const BBox box = region.getBoundingBoxRaw();
+    const int offset = region.isTopCamera() ? 0 : TOP_IMAGE_ROWS;
+
+    // Closer ROIs hold bigger, better resolved objects that matter sooner.
+    // The bottom of an ROI is where what it holds meets the field.
+    const Point foot = camera_to_rr.pose.imageToRobotXY(
+        Point((box.a.x() + box.b.x()) / 2, box.b.y() + offset), 0);
+    float distance = hypotf(foot.x(), foot.y());
+    if (!(distance < ROI_FAR_DISTANCE))
+    {
+        distance = ROI_FAR_DISTANCE;
+    }
+    float value = 1.0f / (1.0f + distance / ROI_HALF_VALUE_DISTANCE);
+
+    if (ball.distance() > 0)
+    {
+        const Point centre = camera_to_rr.pose.imageToRobotXY(
+            Point((box.a.x() + box.b.x()) / 2,
+                  (box.a.y() + box.b.y()) / 2 + offset), BALL_RADIUS);
+        const Point expected = ball.toCartesian();
+        if (hypotf(centre.x() - expected.x(), centre.y() - expected.y()) <
+                BALL_PRIOR_RADIUS)
+        {
+            value += BALL_PRIOR_VALUE;
+        }
+    }
+
+    for (std::vector<BallInfo>::const_iterator it = recent_.begin();
+            it != recent_.end(); ++it)
+    {
+        if (it->topCamera == region.isTopCamera() &&
+                it->imageCoords.x() >= box.a.x() && it->imageCoords.x() < box.b.x() &&
+                it->imageCoords.y() >= box.a.y() && it->imageCoords.y() < box.b.y())
+        {
+            value += RECENT_BALL_VALUE;
+            break;
+        }
+    }
+    return value;
+}
+
+bool RoiSchedule::expired() const
+{
+    return budget_us_ > 0 && elapsed() >= budget_us_;
+}
+
+int RoiSchedule::select(const std::vector<RegionI>& roi, unsigned int ranking,
+                        const Cost& cost, std::vector<bool>& chosen) const
+{
+    chosen.assign(roi.size(), budget_us_ <= 0);
+    if (budget_us_ <= 0)
+    {
+        return roi.size();
+    }
+
+    const bool ranked = ranks(ranking);
+    float remaining = budget_us_ - elapsed();
+    int num_chosen = 0;
+    for (unsigned int i = 0; i < roi.size(); ++i)
+    {
+        const int index = ranked ? order_[i] : i;
+        const float expected = cost.predict(roi[index]);
+        if (expected > remaining)
+        {
+            break;
+        }
+        remaining -= expected;
+        chosen[index] = true;
+        ++num_chosen;
+    }
+    return num_chosen;
+}
+
+void RoiSchedule::skip(const char* stage, int rois)
+{
+    if (rois > 0)
+    {
+        boost::mutex::scoped_lock lock(skips_mutex_);
+        skips_.push_back(std::make_pair(stage, rois));
+    }
+}
+
+int RoiSchedule::skipped() const
+{
+    boost::mutex::scoped_lock lock(skips_mutex_);
+    int total = 0;
+    for (unsigned int i = 0; i < skips_.size(); ++i)
+    {
+        total += skips_[i].second;
+    }
+    return total;
+}
+
+std::string RoiSchedule::skips() const
+{
+    boost::mutex::scoped_lock lock(skips_mutex_);
+    std::stringstream out;
+    for (unsigned int i = 0; i < skips_.size(); ++i)
+    {
+        out << (i ? ", " : "") << skips_[i].first << " " << skips_[i].second;
+    }
+    return out.str();
+}
@@ -0,0 +1,153 @@
+#ifndef PERCEPTION_VISION_OTHER_ROISCHEDULE_H_
+#define PERCEPTION_VISION_OTHER_ROISCHEDULE_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+
+#include "perception/vision/Region/Region.hpp"
+#include "types/BallInfo.hpp"
+#include "types/RRCoord.hpp"
+#include "utils/Timer.hpp"
+
+class CameraToRR;
+
+/**
+ * The order in which detectors look at a frame's ROIs, and the time they
+ * have left to look at them in.
+ *
+ * ROIs are ranked best first once per frame, after the region finder, by
+ * the value of looking at them: ROIs closer to the robot, projected onto
+ * the field, are worth more, as are those near where state estimation
+ * expects the ball and those over a ball detected the frame before.
+ *
+ * With a budget, the frame has that many microseconds from start() for
+ * everything. Detectors choose the best ROIs they can expect to finish in
+ * the time left with select(), or check expired() as they go, and report
+ * the ROIs they skipped with skip(). Without a budget nothing is skipped.
+ */
+class RoiSchedule {
+
+public:
+
+    /**
+     * One detector's time per ROI pixel, learnt as it runs.
+     */
+    class Cost {
+    public:
+        Cost();
+
+        /**
+         * The time region is expected to take, in microseconds.
+         */
+        float predict(const RegionI& region) const;
+
+        /**
+         * Learns from having processed pixels ROI pixels in time_us.
+         */
+        void update(int pixels, int time_us);
+
+    private:
+        float us_per_pixel_;
+    };
+
+    RoiSchedule();
+
+    /**
+     * The microseconds a frame has from start(), or 0 for no budget.
+     */
+    void setBudget(int budget_us);
+    int getBudget() const { return budget_us_; }
+
+    /**
+     * Starts a frame now, forgetting the last frame's ranking and skips.
+     */
+    void start();
+
+    /**
+     * Remembers a frame's balls, so ROIs over them are favoured next frame.
+     */
+    void remember(const std::vector<BallInfo>& balls);
+
+    /**
+     * Ranks roi, and returns the ranking's id, never 0. ball is where state
+     * estimation expects the ball, with a distance of 0 if it has no idea.
+     */
+    unsigned int rank(const std::vector<RegionI>& roi,
+                      const CameraToRR& camera_to_rr, const RRCoord& ball);
+
+    /**
+     * The indices of the ranked ROIs, best first.
+     */
+    const std::vector<int>& order() const { return order_; }
+
+    /**
+     * Whether ranking, as returned by rank(), is this frame's ranking. A
+     * stage that replaces the ROIs after the ranking clears their ranking,
+     * leaving them in the region finder's order.
+     */
+    bool ranks(unsigned int ranking) const {
+        return ranking != 0 && ranking == ranking_;
+    }
+
+    /**
+     * Whether the budget has run out. Never true without a budget.
+     */
+    bool expired() const;
+
+    /**
+     * Sets chosen[i] for the best of roi whose expected cost, summed best
+     * first, fits in the time left, and returns how many there are. roi are
+     * taken in order if ranking is not this frame's. Every ROI is chosen
+     * without a budget.
+     */
+    int select(const std::vector<RegionI>& roi, unsigned int ranking,
+               const Cost& cost, std::vector<bool>& chosen) const;
+
+    /**
+     * Records that stage skipped rois ROIs this frame. Thread safe.
+     */
+    void skip(const char* stage, int rois);
+
+    /**
+     * The ROIs skipped this frame by every stage.
+     */
+    int skipped() const;
+
+    /**
+     * The stages that skipped ROIs this frame and how many, as
+     * "Ball 3, FieldFeature 2", or empty if none did.
+     */
+    std::string skips() const;
+
+    /**
+     * The microseconds since start().
+     */
+    int elapsed() const { return timer_.elapsed_us(); }
+
+private:
+
+    // Changes ranking_ to a new id, and returns it
+    unsigned int nextRanking_();
+
+    // The value of looking at region
+    float value_(const RegionI& region, const CameraToRR& camera_to_rr,
+                 const RRCoord& ball) const;
+
+    int budget_us_;
+    mutable Timer timer_;
+
+    // The id of the last ranking, changed by every start() and rank()
+    unsigned int ranking_;
+    std::vector<int> order_;
+    std::vector<std::pair<float, int> > ranked_;
+
+    // Where balls were detected the frame before, in camera coordinates
+    std::vector<BallInfo> recent_;
+
+    mutable boost::mutex skips_mutex_;
+    std::vector<std::pair<const char*, int> > skips_;
+};
+
+#endif
@@ -7,10 +7,7 @@
 #include "perception/vision/Region/Region.hpp"
 #include "perception/vision/regionfinder/RegionFinderInterface.hpp"
 
-#include "types/GroupLinks.hpp"
-
-// The base resolution CCA should be run at.
-#define RES_TARGET TOP_IMAGE_COLS*TOP_IMAGE_ROWS
+#include "perception/vision/other/ConnectedComponents.hpp"
 
 // Finds ROI in the frame based on colour alone.
 class ColourROI : public RegionFinder
@@ -18,44 +15,34 @@ class ColourROI : public RegionFinder
 
 public:
 
-    // Initialise basic ColourROI variables on creation.
-    ColourROI() : group_counts_(std::vector<int>(0, 0)),
-                    group_low_xs_(std::vector<int>(0, 0)),
-                    group_high_xs_(std::vector<int>(0, 0)),
-                    group_low_ys_(std::vector<int>(0, 0)),
-                                      group_high_ys_(std::vector<int>(0, 0)) {};
-
     // Finds ROI in the top and bottom images and stores them in
     // frame.regionsOfInterest.
     void find(const VisionInfoIn& info_in, VisionInfoMiddle& info_middle, VisionInfoOut& info_out);
+    uint32_t reads() const { return vdFULL_REGIONS | vdSTART_SCAN_COORDS; }
+    uint32_t writes() const { return vdROI | vdREGIONS; }
+
+    /**
+     * Finds ROI in one full camera region, appending them to roi and regions
+     * (normally info_middle.roi and info_out.regions). Only reads info_out,
+     * and mask, the region's camera's field mask, if it is given.
+     * Lets the cameras be processed separately, using one ColourROI each.
+     */
+    void findInRegion(const RegionI& region, const VisionInfoOut& info_out,
+                  std::vector<RegionI>& roi, std::vector<RegionI>& regions,
+                  const FieldMask* mask = NULL);
 
 private:
 
     // Finds ROI in just the top or bottom image.
     template<int columns, int rows> void findROIImage_(const RegionI& region,
-                        std::vector<RegionI>& regions_out, VisionInfoOut& info_out);
-
-    // The set of links between groups generated during findROIImage. Here to
-    // avoid reallocation.
-    GroupLinks group_links_;
-
-    // The ID of the group for each pixel.
-    uint16_t groups_[RES_TARGET];
-
-    // The number of pixels in each group.
-    std::vector<int> group_counts_;
-
-    // The smallest x value in each group.
-    std::vector<int> group_low_xs_;
-
-    // The largest x value in each group.
-    std::vector<int> group_high_xs_;
-
-    // The smallest y value in each group.
-    std::vector<int> group_low_ys_;
-
-    // The largest y value in each group.
-    std::vector<int> group_high_ys_;
+                        std::vector<RegionI>& regions_out,
+                        std::vector<RegionI>& info_out_regions,
+                        const VisionInfoOut& info_out,
+                        const FieldMask* mask);
+
+    // The groups of white pixels found by findROIImage. Here to avoid
+    // reallocation.
+    ConnectedComponents components_;
 };
 
 #endif /* end of include guard: COLOUR_ROI_H_ */
@@ -10,7 +10,6 @@
 #include "perception/vision/VisionDefinitions.hpp"
 #include "utils/Timer.hpp"
 #include "types/BBox.hpp"
-#include "types/GroupLinks.hpp"
 
 // Whether we're optimising.
 //#define DEBUG_OPTIMISE
@@ -34,80 +33,26 @@ void RobotColorROI::find(const VisionInfoIn& info_in, VisionInfoMiddle& info_mid
         // no bottom regions
         if (!region.isTopCamera()) continue;
 
-        connectedComponents(info_out, region, info_middle.roi);
+        connectedComponents(info_out, region, info_middle.roi,
+                            info_middle.top_field_mask);
     }
     return;
 }
 
-void RobotColorROI::connectedComponents(const VisionInfoOut& info_out, RegionI& region, std::vector<RegionI>& regions_out) {
-
-
-    // The set of links between groups generated during findROIImage. Here to
-    // avoid reallocation.
-    GroupLinks group_links_;
+void RobotColorROI::connectedComponents(const VisionInfoOut& info_out,
+                                        RegionI& region,
+                                        std::vector<RegionI>& regions_out,
+                                        const FieldMask* mask) {
 
     int rows = region.getRows();
     int cols = region.getCols();
 
-    // The ID of the group for each pixel.
-    uint16_t groups_[rows*cols];
-
-    // The number of pixels in each group.
-    std::vector<int> group_counts_;
-
-    // The smallest x value in each group.
-    std::vector<int> group_low_xs_;
-
-    // The largest x value in each group.
-    std::vector<int> group_high_xs_;
-
-    // The smallest y value in each group.
-    std::vector<int> group_low_ys_;
-
-    // The largest y value in each group.
-    std::vector<int> group_high_ys_;
-    // Reset group_links for use.
-    group_links_.fullReset();
-
-    // Clear the data vectors (hopefully leaving space allocated).
-
-    // The number of pixels in each group.
-    group_counts_.clear();
-
-    // The smallest x value in each group.
-    group_low_xs_.clear();
-
-    // The largest x value in each group.
-    group_high_xs_.clear();
-
-    // The smallest y value in each group.
-    group_low_ys_.clear();
-
-    // The largest y value in each group.
-    group_high_ys_.clear();
-
-
 #ifdef DEBUG_OPTIMISE
     // Timer for optimisation.
     Timer timer;
     timer.restart();
 #endif // DEBUG_OPTIMISE
 
-    // Set to USHRT_MAX when there is no neighbour.
-    uint16_t top_neighbour = USHRT_MAX;
-    uint16_t left_neighbour = USHRT_MAX;
-    bool has_neighbour = false;
-
-    // Iterators that move through the region.
-    RegionI::iterator_fovea cur_point = region.begin_fovea();
-
-    // Track the literal location of the iterators.
-    int x = 0;
-    int y = 0;
-
-    // A pointer tracking through the underlying array of groups.
-    uint16_t* group = groups_;
-
     int max_region_size;
     if(region.isTopCamera())
         max_region_size = rows*cols*MAX_REGION_PORTION_TOP;
@@ -131,191 +76,24 @@ void RobotColorROI::connectedComponents(const VisionInfoOut& info_out, RegionI&
         }
     }
 
-    for(int pixel=0; pixel < cols*rows; ++pixel)
-    {
-        // If this is a white pixel, group it. TODO: Make this fast.
-        if(y > fieldBoundary[x] && cur_point.colour() == cWHITE)
-        {
-            // Get all neighbours.
-            has_neighbour = false;
-            if(x % CUT_SIZE != 0 && y > fieldBoundary[x-1] &&
-                                               cur_point.colourLeft() == cWHITE)
-            {
-                left_neighbour = *(group-1);
-                has_neighbour = true;
-            }
-            else
-                left_neighbour = USHRT_MAX;
-            if(y > fieldBoundary[x]+1 && y % CUT_SIZE != 0 &&
-                                              cur_point.colourAbove() == cWHITE)
-            {
-                top_neighbour = *(group-cols);
-                has_neighbour = true;
-            }
-            else
-                top_neighbour = USHRT_MAX;
-
-            // If there are no neighbours create a new label.
-            if(!has_neighbour)
-            {
-                // Try to add the new group. If this fails, the group cap has
-                // been hit and CCA should terminate.
-                if(!group_links_.newGroup())
-                    break;
-
-                *group = group_links_.size()-1;
-                group_low_xs_.push_back(x);
-                group_high_xs_.push_back(x);
-                group_low_ys_.push_back(y);
-                group_high_ys_.push_back(y);
-                group_counts_.push_back(1);
-            }
-            // If there is a neighbour build components.
-            else
-            {
-                if(top_neighbour < left_neighbour)
-                {
-                    // Set the pixel's group.
-                    *group = top_neighbour;
-
-                    // Add a parent to the left neighbour if needed.
-                    if(left_neighbour != USHRT_MAX)
-                    {
-                        bool new_link;
-                        new_link = group_links_.addLink(left_neighbour,
-                                                                 top_neighbour);
-                        if(new_link)
-                        {
-                            push_heap(group_links_.begin(left_neighbour),
-                                      group_links_.end(left_neighbour),
-                                                           std::greater<int>());
-                        }
-                    }
-
-                    // Update bounding box.
-                    group_counts_[top_neighbour] += 1;
-                    if(group_high_xs_[top_neighbour] < x)
-                        group_high_xs_[top_neighbour] = x;
-                    if(group_high_ys_[top_neighbour] < y)
-                        group_high_ys_[top_neighbour] = y;
-                }
-                else
-                {
-                    // Set the pixel's group.
-                    *group = left_neighbour;
-
-                    // Add a parent to the top neighbour if needed.
-                    if(top_neighbour != USHRT_MAX)
-                    {
-                        bool new_link;
-                        new_link = group_links_.addLink(top_neighbour,
-                                                                 left_neighbour);
-                        if(new_link)
-                        {
-                            push_heap(group_links_.begin(top_neighbour),
-                                      group_links_.end(top_neighbour),
-                                                           std::greater<int>());
-                        }
-                    }
-
-                    // Update bounding box.
-                    group_counts_[left_neighbour] += 1;
-                    if(group_high_xs_[left_neighbour] < x)
-                        group_high_xs_[left_neighbour] = x;
-                    if(group_high_ys_[left_neighbour] < y)
-                        group_high_ys_[left_neighbour] = y;
-                }
-            }
-        }
-
-        ++cur_point;
-        ++x;
-        ++group;
-        if(x == cols)
-        {
-            x = 0;
-            ++y;
-        }
-    }
-
-    // Don't need a full second pass as we only need bounding boxes. Combining
-    // by grabbing pixel location extremes is sufficient. May be a faster way
-    // to implement this.
+    // Group the white pixels below the field boundary, sorted from upper left
+    // to bottom right by their first pixel.
+    components_.label(region, WhiteBelow(fieldBoundary),
+                      ConnectedComponents::FOUR_CONNECTED, CUT_SIZE, mask);
+    std::vector<ConnectedComponents::Component>& groups =
+                                                      components_.components();
+    const int num_groups = groups.size();
 
 #ifdef DEBUG_OPTIMISE
     std::cout << "CCA: " << timer.elapsed_us() << "us"<< std::endl;
-    std::cout << "Number of groups: " << group_links_.size() << std::endl;
-    int white_pix = 0;
-    for(int group=0; group<group_links_.size(); ++group)
-        white_pix += group_counts_[group];
-    int num_groups_combined = 0;
-    timer.restart();
-#endif // DEBUG_OPTIMISE
-
-    // Find the parent group for each group.
-    bool changed = true;
-    while(changed)
-    {
-        changed = false;
-        for(int group=0; group<group_links_.size(); group++)
-        {
-            // Tell all linked groups the lowest linked group.
-            for(int owner=1; owner<group_links_.size(group); owner++)
-            {
-                // Insert in sorted order.
-                changed = true;
-                if(group_links_.get(group, owner) != group)
-                {
-                    bool new_link;
-                    new_link = group_links_.addLink(group_links_.get(group,
-                                            owner), group_links_.get(group, 0));
-                    if(new_link)
-                    {
-                        push_heap(group_links_.begin(
-                            group_links_.get(group, owner)),
-                            group_links_.end(group_links_.get(group, owner)),
-                                                           std::greater<int>());
-                    }
-                }
-            }
-
-            // Delete all but the lowest owner.
-            group_links_.clearHigh(group);
-        }
-    }
-
-    // Apply combinations.
-    for(int group=group_links_.size()-1; group>=0; group--)
-    {
-        int owner = group_links_.get(group, 0);
-        if(owner != group)
-        {
-#ifdef DEBUG_OPTIMISE
-            ++num_groups_combined;
-#endif // DEBUG_OPTIMISE
-            group_counts_[owner] += group_counts_[group];
-            group_counts_[group] = 0;
-            if(group_low_xs_[group] < group_low_xs_[owner])
-                group_low_xs_[owner] = group_low_xs_[group];
-            if(group_low_ys_[group] < group_low_ys_[owner])
-                group_low_ys_[owner] = group_low_ys_[group];
-            if(group_high_xs_[group] > group_high_xs_[owner])
-                group_high_xs_[owner] = group_high_xs_[group];
-            if(group_high_ys_[group] > group_high_ys_[owner])
-                group_high_ys_[owner] = group_high_ys_[group];
-        }
-    }
-
-#ifdef DEBUG_OPTIMISE
-    std::cout << "Group combining: " << timer.elapsed_us() << "us"<< std::endl;
-    std::cout << "Num groups: " << group_links_.size()-num_groups_combined <<
-                                                                      std::endl;
+    std::cout << "Number of groups: " << num_groups << std::endl;
+    std::cout << "Number of white pixels: " << components_.area() << std::endl;
     timer.restart();
     int num_merges = 0;
 #endif // DEBUG_OPTIMISE
 
     // Merge groups where density remains good.
-    changed = true;
+    bool changed = true;
     int thresh = MERGE_MULT_1;
     while(changed)
     {
@@ -323,73 +101,65 @@ void RobotColorROI::connectedComponents(const VisionInfoOut& info_out, RegionI&
 
         // Check through the groups for merging. Groups are implicitly sorted
         // from upper left to bottom right by upper left corner.
-        for(int group1=0; group1<group_links_.size(); ++group1)
+        for(int group1=0; group1<num_groups; ++group1)
         {
-            if(group_counts_[group1] > EARLY_IGNORE_THRESHOLD)
+            ConnectedComponents::Component& g1 = groups[group1];
+            if(g1.area > EARLY_IGNORE_THRESHOLD)
             {
                 int group2=group1+1;
-                int group1_width = group_high_xs_[group1]-group_low_xs_[group1];
-                int group1_size = group1_width * (group_high_ys_[group1] -
-                                                         group_low_ys_[group1]);
+                int group1_width = g1.max_x-g1.min_x;
+                int group1_size = group1_width * (g1.max_y - g1.min_y);
                 bool continue_check = true;
 
                 // Continue while it is reasonably probable that a below
                 // threshold group can be created.
-                while(group2 < group_links_.size() && continue_check)
+                while(group2 < num_groups && continue_check)
                 {
-                    if(group_counts_[group2] > EARLY_IGNORE_THRESHOLD)
+                    ConnectedComponents::Component& g2 = groups[group2];
+                    if(g2.area > EARLY_IGNORE_THRESHOLD)
                     {
                         // If both groups have pixels and density after
                         // combining is good, combine.
-                        int xL = std::min(group_low_xs_[group1],
-                                                         group_low_xs_[group2]);
-                        int xH = std::max(group_high_xs_[group1],
-                                                        group_high_xs_[group2]);
-                        int yL = std::min(group_low_ys_[group1],
-                                                         group_low_ys_[group2]);
-                        int yH = std::max(group_high_ys_[group1],
-                                                        group_high_ys_[group2]);
+                        int xL = std::min(g1.min_x, g2.min_x);
+                        int xH = std::max(g1.max_x, g2.max_x);
+                        int yL = std::min(g1.min_y, g2.min_y);
+                        int yH = std::max(g1.max_y, g2.max_y);
                         int size = (xH-xL+1)*(yH-yL+1);
 
                         // To avoid division the ratio comparison is done by
                         // multiplying the number of white pixels by a value and
                         // comparing that to the size of the new bounding box
                         // times 10 (to allow a decimal place).
-                        if((group_counts_[group1]+group_counts_[group2])*thresh
-                                            > size*10 && size < max_region_size)
+                        if((g1.area+g2.area)*thresh > size*10 &&
+                                                        size < max_region_size)
                         {
 #ifdef DEBUG_OPTIMISE
                             ++num_merges;
 #endif // DEBUG_OPTIMISE
                             changed = true;
-                            group_low_xs_[group1] = xL;
-                            group_high_xs_[group1] = xH;
-                            group_low_ys_[group1] = yL;
-                            group_high_ys_[group1] = yH;
-                            group_counts_[group1] += group_counts_[group2];
-                            group_counts_[group2] = 0;
-                            group1_width = group_high_xs_[group1] -
-                                                          group_low_xs_[group1];
-                            group1_size = group1_width * (group_high_ys_[group1]
-                                                       - group_low_ys_[group1]);
+                            g1.min_x = xL;
+                            g1.max_x = xH;
+                            g1.min_y = yL;
+                            g1.max_y = yH;
+                            g1.area += g2.area;
+                            g2.area = 0;
+                            group1_width = g1.max_x - g1.min_x;
+                            group1_size = group1_width * (g1.max_y - g1.min_y);
                         }
                     }
                     ++group2;
 
-#ifdef VALGRIND
                     // We don't need to deal with the continue check on the last
-                    // loop as we'll break either way, but this check isn't done
-                    // normally to save computation.
-                    if(group2 == group_links_.size())
+                    // loop as we'll break either way.
+                    if(group2 == num_groups)
                         continue;
-#endif // VALGRIND
 
                     // Check if we should continue.
-                    int empty_space = group1_width * (group_low_ys_[group2] -
-                                                        group_high_ys_[group1]);
+                    int empty_space = group1_width * (groups[group2].min_y -
+                                                                      g1.max_y);
                     if(empty_space > 0)
                     {
-                        continue_check = group_counts_[group1]*thresh >
+                        continue_check = g1.area*thresh >
                                                    (empty_space+group1_size)*10;
                     }
                 }
@@ -431,23 +201,23 @@ void RobotColorROI::connectedComponents(const VisionInfoOut& info_out, RegionI&
     // them later.
 
 
-    for(int group=0; group<group_links_.size(); group++)
+    for(int group=0; group<num_groups; group++)
     {
         // Check the group actually has pixels.
-        if(group_counts_[group] > LATE_IGNORE_THRESHOLD)
+        if(groups[group].area > LATE_IGNORE_THRESHOLD)
         {
             // The corners of the new ROI.
             Point upper_left;
             Point lower_right;
 
             // Calculate corners.
-            upper_left[0] = group_low_xs_[group];
-            upper_left[1] = group_low_ys_[group];
-            lower_right[0] = group_high_xs_[group]+1;
-            lower_right[1] = group_high_ys_[group]+1;
+            upper_left[0] = groups[group].min_x;
+            upper_left[1] = groups[group].min_y;
+            lower_right[0] = groups[group].max_x+1;
+            lower_right[1] = groups[group].max_y+1;
 
             // Add the white pixel counts
-            activatedCounts_.push_back(group_counts_[group]);
+            activatedCounts_.push_back(groups[group].area);
 
             // Create a region of interest.
             regions_out.push_back(RegionI(region.subRegion(upper_left, lower_right)));
@@ -9,6 +9,7 @@ in detection and is expensive to recalculate
 */
 
 #include "perception/vision/regionfinder/RegionFinderInterface.hpp"
+#include "perception/vision/other/ConnectedComponents.hpp"
 
 // This is how many pixels there should be between each image cut.
 #define CUT_SIZE 16
@@ -56,7 +57,15 @@ private:
 
     std::vector<int> activatedCounts_;
 
-    void connectedComponents(const VisionInfoOut& info_out, RegionI& region, std::vector<RegionI>& regions_out);
+    // The groups of white pixels in the region being searched. Here to avoid
+    // reallocation.
+    ConnectedComponents components_;
+
+    // Groups the white pixels of region below the field boundary, scanning
+    // only what mask leaves in if it is given.
+    void connectedComponents(const VisionInfoOut& info_out, RegionI& region,
+                             std::vector<RegionI>& regions_out,
+                             const FieldMask* mask = NULL);
 
 };
 
@@ -22,19 +22,32 @@ SET(SOCCER_SRCS
    perception/vision/camera/CameraToRR.cpp
    perception/vision/camera/CombinedCamera.cpp
    perception/vision/camera/NaoCameraDefinitions.cpp
+   perception/vision/camera/FrameRing.cpp
+   perception/vision/camera/AsyncCapture.cpp
    perception/vision/camera/terminalCalibration.cpp
    perception/vision/other/YUV.cpp
    perception/vision/other/Ransac.cpp
+   perception/vision/other/RansacEngine.cpp
+   perception/vision/other/AdaptiveThreshold.cpp
+   perception/vision/other/FrameArena.cpp
+   perception/vision/other/ConnectedComponents.cpp
+   perception/vision/other/ImagePlanes.cpp
+   perception/vision/other/ImagePyramid.cpp
+   perception/vision/other/FieldMask.cpp
+   perception/vision/other/RoiSchedule.cpp
    perception/vision/other/GMM_classifier.cpp
    perception/vision/other/WriteImage.cpp
    perception/vision/regionfinder/ColourROI.cpp
    perception/vision/regionfinder/RobotColorROI.cpp
    perception/vision/detector/BallDetector.cpp
+   perception/vision/detector/BallClassifier.cpp
    perception/vision/detector/ClusterDetector.cpp
    perception/vision/detector/RegionFieldFeatureDetector.cpp
    perception/vision/detector/RobotDetector.cpp
+   perception/vision/detector/PackedConvNet.cpp
    perception/vision/detector/SSRobotDetector.cpp
    perception/vision/detector/RandomForest.cpp
+   perception/vision/detector/ForestModel.cpp
    perception/vision/detector/DNNHelper.cpp
    perception/vision/middleinfoprocessor/FieldBoundaryFinder.cpp
    perception/dumper/PerceptionDumper.cpp
@@ -97,6 +110,8 @@ SET(SOCCER_SRCS
    receiver/Team.cpp
    thread/Thread.cpp
    thread/ThreadManager.cpp
+   thread/WorkerPool.cpp
+   thread/TaskGraph.cpp
    transmitter/Nao.cpp
    transmitter/OffNao.cpp
    transmitter/SimExTransmitter.cpp
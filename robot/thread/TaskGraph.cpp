@@ -0,0 +1,94 @@
+#include "thread/TaskGraph.hpp"
+
+#include <boost/bind.hpp>
+
+TaskGraph::TaskGraph()
+   : readyHead(0), finished(0), failed(false) {
+}
+
+int TaskGraph::add(const std::string &name, const Task &task,
+                   uint32_t reads, uint32_t writes) {
+   Node node;
+   node.name = name;
+   node.task = task;
+   node.reads = reads;
+   node.writes = writes;
+
+   int index = nodes.size();
+   for (int earlier = 0; earlier < index; ++earlier) {
+      const Node &other = nodes[earlier];
+      if ((other.writes & (reads | writes)) || (other.reads & writes)) {
+         node.dependencies.push_back(earlier);
+         nodes[earlier].dependents.push_back(index);
+      }
+   }
+   nodes.push_back(node);
+
+   // Size the run state now so run() never allocates.
+   waitingOn.resize(nodes.size());
+   ready.reserve(nodes.size());
+   return index;
+}
+
+void TaskGraph::run(WorkerPool *pool) {
+   if (pool == NULL || pool->size() == 0) {
+      for (size_t i = 0; i < nodes.size(); ++i) {
+         nodes[i].task();
+      }
+      return;
+   }
+
+   {
+      boost::lock_guard<boost::mutex> lock(mutex);
+      ready.clear();
+      readyHead = 0;
+      finished = 0;
+      failed = false;
+      for (size_t i = 0; i < nodes.size(); ++i) {
+         waitingOn[i] = nodes[i].dependencies.size();
+         if (waitingOn[i] == 0) {
+            ready.push_back(i);
+         }
+      }
+   }
+
+   // One runner per thread that can work on the graph, including this one.
+   size_t numRunners = pool->size() + 1;
+   if (runners.size() != numRunners) {
+      runners.assign(numRunners, boost::bind(&TaskGraph::runner, this));
+   }
+   pool->run(runners);
+}
+
+void TaskGraph::runner() {
+   boost::unique_lock<boost::mutex> lock(mutex);
+   while (true) {
+      while (readyHead == ready.size() && finished < nodes.size() && !failed) {
+         changed.wait(lock);
+      }
+      if (finished == nodes.size() || failed) {
+         return;
+      }
+
+      int task = ready[readyHead++];
+      lock.unlock();
+      try {
+         nodes[task].task();
+      } catch (...) {
+         lock.lock();
+         failed = true;
+         changed.notify_all();
+         throw;
+      }
+      lock.lock();
+
+      ++finished;
+      const std::vector<int> &dependents = nodes[task].dependents;
+      for (size_t i = 0; i < dependents.size(); ++i) {
+         if (--waitingOn[dependents[i]] == 0) {
+            ready.push_back(dependents[i]);
+         }
+      }
+      changed.notify_all();
+   }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "thread/WorkerPool.hpp"
+
+/**
+ * Runs a fixed set of tasks, starting each one as soon as the tasks it
+ * depends on have finished.
+ *
+ * Dependencies are worked out from the data each task declares it reads and
+ * writes, as bit masks. Tasks are added in the order they would run
+ * sequentially, and a task waits for every earlier task it conflicts with:
+ * one writes something the other reads or writes. Tasks that touch disjoint
+ * data may run at the same time.
+ *
+ * The graph is built once and run every tick; running it does not allocate.
+ */
+class TaskGraph {
+   public:
+      typedef boost::function<void()> Task;
+
+      TaskGraph();
+
+      /**
+       * Adds a task after all existing ones and returns its index.
+       */
+      int add(const std::string &name, const Task &task,
+              uint32_t reads, uint32_t writes);
+
+      /**
+       * Runs every task once. With a pool the tasks are spread over its
+       * threads and the calling thread; with NULL they run on the calling
+       * thread in the order they were added.
+       */
+      void run(WorkerPool *pool);
+
+      size_t size() const { return nodes.size(); }
+      const std::string &name(int task) const { return nodes[task].name; }
+
+      /**
+       * The tasks that task waits for.
+       */
+      const std::vector<int> &dependencies(int task) const {
+         return nodes[task].dependencies;
+      }
+
+   private:
+      struct Node {
+         std::string name;
+         Task task;
+         uint32_t reads;
+         uint32_t writes;
+         std::vector<int> dependencies;
+         std::vector<int> dependents;
+      };
+
+      /**
+       * Takes ready tasks and runs them until the graph is finished.
+       */
+      void runner();
+
+      std::vector<Node> nodes;
+
+      // State for the current run, guarded by mutex.
+      boost::mutex mutex;
+      boost::condition_variable changed;
+      std::vector<int> waitingOn;
+      std::vector<int> ready;
+      size_t readyHead;
+      size_t finished;
+      bool failed;
+
+      std::vector<WorkerPool::Job> runners;
+};
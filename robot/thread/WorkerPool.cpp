@@ -0,0 +1,90 @@
+#include "thread/WorkerPool.hpp"
+
+#include <boost/bind.hpp>
+
+#include "thread/Thread.hpp"
+
+WorkerPool::WorkerPool(int num_threads, const std::string &name)
+   : name(name), batch(NULL), nextJob(0), jobsRemaining(0), generation(0),
+     stopping(false) {
+   for (int i = 0; i < num_threads; ++i) {
+      threads.push_back(
+         new boost::thread(boost::bind(&WorkerPool::workerLoop, this)));
+   }
+}
+
+WorkerPool::~WorkerPool() {
+   {
+      boost::lock_guard<boost::mutex> lock(mutex);
+      stopping = true;
+   }
+   batchReady.notify_all();
+   for (size_t i = 0; i < threads.size(); ++i) {
+      threads[i]->join();
+      delete threads[i];
+   }
+}
+
+void WorkerPool::run(const std::vector<Job> &jobs) {
+   if (jobs.empty()) {
+      return;
+   }
+
+   boost::unique_lock<boost::mutex> lock(mutex);
+   batch = &jobs;
+   nextJob = 0;
+   jobsRemaining = jobs.size();
+   error = boost::exception_ptr();
+   ++generation;
+   batchReady.notify_all();
+
+   // Help out, then wait for any jobs still running on the workers.
+   drain(lock);
+   while (jobsRemaining > 0) {
+      batchDone.wait(lock);
+   }
+   batch = NULL;
+
+   if (error) {
+      boost::exception_ptr e = error;
+      error = boost::exception_ptr();
+      lock.unlock();
+      boost::rethrow_exception(e);
+   }
+}
+
+void WorkerPool::workerLoop() {
+   Thread::name = name.c_str();
+   boost::unique_lock<boost::mutex> lock(mutex);
+   unsigned int seen = generation;
+   while (true) {
+      while (!stopping && generation == seen) {
+         batchReady.wait(lock);
+      }
+      if (stopping) {
+         return;
+      }
+      seen = generation;
+      drain(lock);
+   }
+}
+
+void WorkerPool::drain(boost::unique_lock<boost::mutex> &lock) {
+   while (batch != NULL && nextJob < batch->size()) {
+      const Job &job = (*batch)[nextJob++];
+      lock.unlock();
+      boost::exception_ptr jobError;
+      try {
+         job();
+      } catch (...) {
+         jobError = boost::current_exception();
+      }
+      lock.lock();
+      if (jobError && !error) {
+         error = jobError;
+      }
+      if (--jobsRemaining == 0) {
+         batchDone.notify_all();
+      }
+   }
+}
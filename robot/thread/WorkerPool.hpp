@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <boost/exception_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+/**
+ * A small pool of persistent threads for splitting one module's tick across
+ * cores, e.g. running the top and bottom camera halves of vision at once.
+ *
+ * run() hands out a batch of jobs and blocks until all of them are done. The
+ * calling thread works through the batch too, so a pool of n threads runs up
+ * to n+1 jobs at once and a pool of 0 threads simply runs the jobs in order.
+ * The threads sleep between batches, so an idle pool costs nothing.
+ *
+ * Only one thread may call run() at a time.
+ */
+class WorkerPool {
+   public:
+      typedef boost::function<void()> Job;
+
+      /**
+       * Starts num_threads threads. name is given to them as Thread::name.
+       */
+      WorkerPool(int num_threads, const std::string &name = "Worker");
+
+      /**
+       * Stops and joins the threads.
+       */
+      ~WorkerPool();
+
+      /**
+       * The number of threads in the pool, not counting the caller of run().
+       */
+      int size() const { return threads.size(); }
+
+      /**
+       * Runs every job in jobs and returns once they have all finished. If
+       * any job throws, the first exception is rethrown here after the rest
+       * of the batch has finished.
+       */
+      void run(const std::vector<Job> &jobs);
+
+   private:
+      WorkerPool(const WorkerPool &);
+      WorkerPool &operator=(const WorkerPool &);
+
+      void workerLoop();
+
+      /**
+       * Runs jobs from the current batch until none are left. Must be called
+       * with lock held; the lock is released while each job runs.
+       */
+      void drain(boost::unique_lock<boost::mutex> &lock);
+
+      std::string name;
+      std::vector<boost::thread *> threads;
+
+      boost::mutex mutex;
+      boost::condition_variable batchReady;
+      boost::condition_variable batchDone;
+
+      // The batch being run, guarded by mutex.
+      const std::vector<Job> *batch;
+      size_t nextJob;
+      size_t jobsRemaining;
+      unsigned int generation;
+      bool stopping;
+      boost::exception_ptr error;
+};
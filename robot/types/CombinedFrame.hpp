@@ -9,22 +9,48 @@
 
 #include "perception/vision/camera/CameraToRR.hpp"
 #include "perception/vision/camera/CameraDefinitions.hpp"
+#include "types/FrameHandle.hpp"
+
+class ImagePlanes;
+class ImagePyramid;
 
 struct CombinedFrame {
     const uint8_t *top_frame_;
     const uint8_t *bot_frame_;
     const CameraToRR &camera_to_rr_;
+    // Packed planes of each image, or NULL to read the raw YUV422. Set by
+    // Vision::processFrame.
+    const ImagePlanes *top_planes_;
+    const ImagePlanes *bot_planes_;
+    // Each image's pyramid, or NULL. Also set by Vision::processFrame.
+    const ImagePyramid *top_pyramid_;
+    const ImagePyramid *bot_pyramid_;
     boost::shared_ptr<CombinedFrame> last_;
+    // Keep the frames valid while this is alive; empty if not owned.
+    FrameHandle top_handle_;
+    FrameHandle bot_handle_;
 
     CombinedFrame(const uint8_t *top_image, const uint8_t *bot_image,
             const CameraToRR &camera_to_rr,
             boost::shared_ptr<CombinedFrame> last) :
         top_frame_(top_image), bot_frame_(bot_image),
-        camera_to_rr_(camera_to_rr), last_(last) {}
+        camera_to_rr_(camera_to_rr), top_planes_(NULL), bot_planes_(NULL),
+        top_pyramid_(NULL), bot_pyramid_(NULL),
+        last_(last) {}
+
+    CombinedFrame(const FrameHandle &top_image, const FrameHandle &bot_image,
+            const CameraToRR &camera_to_rr,
+            boost::shared_ptr<CombinedFrame> last) :
+        top_frame_(top_image.get()), bot_frame_(bot_image.get()),
+        camera_to_rr_(camera_to_rr), top_planes_(NULL), bot_planes_(NULL),
+        top_pyramid_(NULL), bot_pyramid_(NULL),
+        last_(last),
+        top_handle_(top_image), bot_handle_(bot_image) {}
 
     CombinedFrame(const uint8_t *top_image, const uint8_t *bot_image) :
         top_frame_(top_image), bot_frame_(bot_image),
-        camera_to_rr_(CameraToRR()),
+        camera_to_rr_(CameraToRR()), top_planes_(NULL), bot_planes_(NULL),
+        top_pyramid_(NULL), bot_pyramid_(NULL),
         last_(boost::shared_ptr<CombinedFrame>()) {}
 };
 
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifndef Q_MOC_RUN
+#include <boost/shared_ptr.hpp>
+#endif
+
+/**
+ * A camera image that stays valid for as long as any copy of the handle is
+ * alive. For images straight from the driver the buffer is only given back
+ * to it once the last copy is released; see FrameRing.
+ */
+typedef boost::shared_ptr<const uint8_t> FrameHandle;
@@ -6,6 +6,8 @@
 #include "perception/kinematics/Pose.hpp"
 #include "types/ActionCommand.hpp"
 #include "types/AbsCoord.hpp"
+#include "types/Odometry.hpp"
+#include "types/RRCoord.hpp"
 
 struct VisionInfoIn {
    uint8_t const* top_frame;
@@ -22,6 +24,12 @@ struct VisionInfoIn {
    float latestAngleX;
 
    AbsCoord robotPose; // pose of robot
+
+   // Cumulative odometry from motion, to follow objects between frames.
+   Odometry odometry;
+
+   // Where state estimation expects the ball, to look there first.
+   RRCoord ballPosRR;
 };
 
 #endif
@@ -6,8 +6,17 @@
 #include "types/CombinedFrame.hpp"
 #include "types/FieldFeatureRegionData.hpp"
 
+class FieldMask;
+class ImagePyramid;
+class RoiSchedule;
+
 struct VisionInfoMiddle
 {
+    VisionInfoMiddle()
+        : this_frame(NULL), top_pyramid(NULL), bot_pyramid(NULL),
+          top_field_mask(NULL), bot_field_mask(NULL), schedule(NULL),
+          roi_ranking(0) {}
+
     // Regions covering the full frame.
     std::vector<RegionI> full_regions;
 
@@ -79,6 +88,25 @@ struct VisionInfoMiddle
     // The raw data associated with this frame.
     const CombinedFrame* this_frame;
 
+    // Each camera's image at densities 1, 2, 4 and 8, built as they are
+    // asked for. Read these rather than resampling the image.
+    const ImagePyramid* top_pyramid;
+    const ImagePyramid* bot_pyramid;
+
+    // The part of each camera's image below the field boundary and above the
+    // robot's body, built with the start scan coordinates. Scans over full
+    // regions can pass these to skip the rest of the image.
+    const FieldMask* top_field_mask;
+    const FieldMask* bot_field_mask;
+
+    // The order to look at roi in and the time left to do it, or NULL to
+    // look at them all in order.
+    RoiSchedule* schedule;
+
+    // The schedule's ranking of roi, or 0 if they are unranked. Anything
+    // that rewrites roi after the ranking sets it back to 0.
+    unsigned int roi_ranking;
+
     std::vector<Point> basePoints;
     std::vector<Point> basePointImageCoords;
 };
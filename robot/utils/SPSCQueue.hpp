@@ -0,0 +1,49 @@
+#pragma once
+
+#ifndef Q_MOC_RUN
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#endif
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/* A bounded first-in first-out queue for handing items from one producer
+ * thread to one consumer thread, e.g. vision results to state estimation.
+ * Items are swapped with the queue's slots rather than copied, so the
+ * storage of items such as structs of vectors circulates between producer,
+ * queue and consumer, and nothing is allocated or copied once the queue has
+ * warmed up. A full queue rejects new items rather than blocking the
+ * producer */
+template <class T>
+class SPSCQueue {
+   public:
+      /* @param capacity the most items the queue holds at once */
+      explicit SPSCQueue(std::size_t capacity);
+
+      /* Add an item to the back of the queue, leaving item holding a stale
+       * item to overwrite. Producer only.
+       * @return false, leaving the queue and item unchanged, if it is full */
+      bool tryPush(T &item);
+
+      /* Take the item at the front of the queue, which is left holding
+       * item's old value to be overwritten. Consumer only.
+       * @return false, leaving item unchanged, if the queue is empty */
+      bool tryPop(T &item);
+
+      /* As tryPop, but wait up to timeoutMicroseconds for an item to arrive */
+      bool waitPop(T &item, int timeoutMicroseconds);
+
+      /* @return the number of items in the queue */
+      std::size_t size() const;
+      std::size_t capacity() const;
+
+   private:
+      std::vector<T> slots;
+      std::size_t head;
+      std::size_t count;
+      mutable boost::mutex theLock;
+      boost::condition_variable notEmpty;
+};
+
+#include "utils/SPSCQueue.tcc"
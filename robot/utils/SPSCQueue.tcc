@@ -0,0 +1,62 @@
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+template <class T>
+SPSCQueue<T>::SPSCQueue(std::size_t capacity)
+   : slots(capacity), head(0), count(0) {
+}
+
+template <class T>
+bool SPSCQueue<T>::tryPush(T &item) {
+   {
+      boost::mutex::scoped_lock lock(theLock);
+      if (count == slots.size()) {
+         return false;
+      }
+      using std::swap;
+      swap(slots[(head + count) % slots.size()], item);
+      ++count;
+   }
+   notEmpty.notify_one();
+   return true;
+}
+
+template <class T>
+bool SPSCQueue<T>::tryPop(T &item) {
+   boost::mutex::scoped_lock lock(theLock);
+   if (count == 0) {
+      return false;
+   }
+   using std::swap;
+   swap(item, slots[head]);
+   head = (head + 1) % slots.size();
+   --count;
+   return true;
+}
+
+template <class T>
+bool SPSCQueue<T>::waitPop(T &item, int timeoutMicroseconds) {
+   boost::mutex::scoped_lock lock(theLock);
+   boost::system_time deadline = boost::get_system_time() +
+      boost::posix_time::microseconds(timeoutMicroseconds);
+   while (count == 0) {
+      if (!notEmpty.timed_wait(lock, deadline) && count == 0) {
+         return false;
+      }
+   }
+   using std::swap;
+   swap(item, slots[head]);
+   head = (head + 1) % slots.size();
+   --count;
+   return true;
+}
+
+template <class T>
+std::size_t SPSCQueue<T>::size() const {
+   boost::mutex::scoped_lock lock(theLock);
+   return count;
+}
+
+template <class T>
+std::size_t SPSCQueue<T>::capacity() const {
+   return slots.size();
+}
@@ -227,6 +227,36 @@ void populate_options(po::options_description &config_file_options) {
       "dump frames every arg milliseconds")
       ("vision.dumpfile,f", po::value<string>()->default_value("dump.yuv"),
       "file to store frames in")
+      ("vision.parallelcameras", po::value<bool>()->default_value(false),
+      "process the top and bottom cameras on separate threads where possible")
+      ("vision.parallelstages", po::value<bool>()->default_value(false),
+      "run vision stages that use disjoint data on separate threads")
+      ("vision.pipelined", po::value<bool>()->default_value(false),
+      "run vision on its own thread, overlapping the next frame with state "
+      "estimation and behaviour on the last")
+      ("vision.asynccapture", po::value<bool>()->default_value(false),
+      "capture from each camera on its own thread, so vision always gets the "
+      "newest frames without waiting on the driver")
+      ("vision.robotengine", po::value<string>()->default_value("float"),
+      "how the robot detector runs its network: tinydnn, or the packed engine "
+      "with float or int8 weights, or its scalar reference mode")
+      ("vision.robotforest", po::value<bool>()->default_value(false),
+      "classify V5 robot candidates with the forest model file rather than "
+      "the generated forest")
+      ("vision.ballthreads", po::value<int>()->default_value(0),
+      "extra threads the ball detector searches regions of interest on")
+      ("vision.balltracking", po::value<int>()->default_value(0),
+      "frames the ball detector searches only around the last ball between "
+      "full searches of the regions of interest, 0 to always search them all")
+      ("vision.roibudget", po::value<int>()->default_value(0),
+      "microseconds a frame has before detectors skip their least valuable "
+      "regions of interest, 0 for no limit")
+      ("vision.boundarywindow", po::value<int>()->default_value(0),
+      "image rows above the last frame's field boundary to start looking for "
+      "it at while the robot is still, 0 to always look from the horizon")
+      ("vision.pyramidfoveae", po::value<bool>()->default_value(false),
+      "threshold foveae from the image pyramid's box filtered planes rather "
+      "than point samples of the image")
       ("vision.top.adaptivethresholdingwindow", po::value<int>()->default_value(101),
       "base top camera adaptive thresholding window size")
       ("vision.top.adaptivethresholdingpercent", po::value<int>()->default_value(-40),
@@ -170,9 +170,10 @@ void AroundFeetTab::newNaoData(NaoData *naoData) {
    AroundFeetPainter painter(&renderPixmap);
 
    // If we have vision balls, draw them
-   if (blackboard->vision.balls.size() > 0)
+   std::vector<BallInfo> balls = blackboard->vision.balls.read();
+   if (balls.size() > 0)
    {
-      RRCoord &visionBallRR = blackboard->vision.balls[0].rr;
+      RRCoord &visionBallRR = balls[0].rr;
       float x = visionBallRR.distance() * cosf(visionBallRR.heading());
       float y = visionBallRR.distance() * sinf(visionBallRR.heading());
       painter.drawVisionBall(x, y);
@@ -0,0 +1,84 @@
+/**
+ * Times ForestModel against the generated RandomForest on random samples,
+ * and checks that both give the same class and confidence for every one.
+ *
+ *     ./benchmark robot_forest.model [samples]
+ *
+ * Features are drawn uniformly over the range the forest's splits cover, so
+ * samples reach every part of the trees instead of mostly the outermost
+ * leaves.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <boost/random.hpp>
+
+#include "perception/vision/detector/ForestModel.hpp"
+#include "perception/vision/detector/RandomForest.hpp"
+#include "utils/Timer.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s model [samples]\n", argv[0]);
+        return 1;
+    }
+    const int samples = argc > 2 ? atoi(argv[2]) : 100000;
+
+    ForestModel model;
+    if (!model.load(argv[1])) {
+        return 1;
+    }
+    const int num_features = model.numFeatures();
+
+    // Just past the thresholds of the robot detector's features: aspect
+    // ratio, area, mean and the centroid's relative x and y.
+    const float low[] = {0.f, 0.f, 0.f, 0.f, 0.f};
+    const float high[] = {3.f, 3000.f, 1.f, 1.f, 1.f};
+    if (num_features != (int)(sizeof(low) / sizeof(low[0]))) {
+        fprintf(stderr, "expected the robot detector's %d features, got %d\n",
+                (int)(sizeof(low) / sizeof(low[0])), num_features);
+        return 1;
+    }
+
+    boost::mt19937 rng(42);
+    std::vector<float> features(samples * num_features);
+    for (int s = 0; s < samples; ++s) {
+        for (int f = 0; f < num_features; ++f) {
+            boost::uniform_real<float> range(low[f], high[f]);
+            features[s * num_features + f] = range(rng);
+        }
+    }
+
+    RandomForest generated;
+    std::vector<int> generated_classes(samples);
+    std::vector<float> generated_confidences(samples);
+    std::vector<float> sample(num_features);
+    Timer timer;
+    for (int s = 0; s < samples; ++s) {
+        sample.assign(&features[s * num_features],
+                      &features[(s + 1) * num_features]);
+        generated_classes[s] = generated.classify(sample, generated_confidences[s]);
+    }
+    const float generated_us = timer.elapsed_us();
+
+    std::vector<int> classes(samples);
+    std::vector<float> confidences(samples);
+    timer.restart();
+    model.classify(&features[0], samples, &classes[0], &confidences[0]);
+    const float model_us = timer.elapsed_us();
+
+    int mismatches = 0;
+    for (int s = 0; s < samples; ++s) {
+        if (classes[s] != generated_classes[s] ||
+            confidences[s] != generated_confidences[s]) {
+            ++mismatches;
+        }
+    }
+
+    printf("%d samples\n", samples);
+    printf("generated: %.3f us/sample\n", generated_us / samples);
+    printf("model:     %.3f us/sample\n", model_us / samples);
+    printf("%d mismatches\n", mismatches);
+    return mismatches != 0;
+}
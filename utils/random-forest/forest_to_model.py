@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""
+Writes a random forest in the binary format ForestModel loads, from either a
+pickled scikit-learn RandomForestClassifier or a forest already generated as
+C++, such as robot/perception/vision/detector/RandomForest.cpp.
+
+    forest_to_model.py sklearn forest.pkl robot_forest.model
+    forest_to_model.py cpp RandomForest.cpp robot_forest.model
+
+The format, all little endian:
+
+    num_features(int32), num_classes(int32), num_trees(int32), num_nodes(int32)
+    roots[num_trees](int32)
+    for each node:
+        feature(int32), threshold(float32), left(int32), right(int32)
+    num_leaves(int32)
+    leaf_probabilities[num_leaves * num_classes](float32)
+
+A sample goes left at a split if its feature is <= threshold. A leaf has
+feature -1 and its leaf index in left. Node and leaf indices are global.
+"""
+
+import math
+import re
+import struct
+import sys
+
+
+def float32_at_most(value):
+    """
+    The largest float32 no greater than value. Features are float32, so for
+    any feature x, x <= value exactly when x <= float32_at_most(value), which
+    keeps the generated C++ (comparing against double literals) and the
+    float32 thresholds in the model in agreement.
+    """
+    rounded = struct.unpack('<f', struct.pack('<f', value))[0]
+    if rounded > value:
+        rounded = struct.unpack('<f', struct.pack('<f', math.nextafter(rounded, -math.inf)))[0]
+    return rounded
+
+
+class Forest(object):
+    def __init__(self, num_features, num_classes):
+        self.num_features = num_features
+        self.num_classes = num_classes
+        self.roots = []
+        # (feature, threshold, left, right)
+        self.nodes = []
+        self.leaves = []
+
+    def add_leaf(self, probabilities):
+        self.leaves.append(list(probabilities))
+        self.nodes.append((-1, 0.0, len(self.leaves) - 1, -1))
+        return len(self.nodes) - 1
+
+    def add_split(self, feature, threshold):
+        self.nodes.append((feature, float32_at_most(threshold), -1, -1))
+        return len(self.nodes) - 1
+
+    def set_children(self, node, left, right):
+        feature, threshold, _, _ = self.nodes[node]
+        self.nodes[node] = (feature, threshold, left, right)
+
+    def write(self, path):
+        with open(path, 'wb') as f:
+            f.write(struct.pack('<4i', self.num_features, self.num_classes,
+                                len(self.roots), len(self.nodes)))
+            f.write(struct.pack('<%di' % len(self.roots), *self.roots))
+            for feature, threshold, left, right in self.nodes:
+                f.write(struct.pack('<ifii', feature, threshold, left, right))
+            f.write(struct.pack('<i', len(self.leaves)))
+            for probabilities in self.leaves:
+                f.write(struct.pack('<%df' % self.num_classes, *probabilities))
+
+
+def from_sklearn(path):
+    import pickle
+    with open(path, 'rb') as f:
+        model = pickle.load(f)
+
+    forest = Forest(model.n_features_in_, model.n_classes_)
+    for estimator in model.estimators_:
+        tree = estimator.tree_
+        base = len(forest.nodes)
+        # Nodes keep their sklearn order, so children are at base + index.
+        for i in range(tree.node_count):
+            if tree.children_left[i] == -1:
+                value = tree.value[i][0]
+                forest.add_leaf(value / value.sum())
+            else:
+                forest.add_split(int(tree.feature[i]), float(tree.threshold[i]))
+        for i in range(tree.node_count):
+            if tree.children_left[i] != -1:
+                forest.set_children(base + i, base + tree.children_left[i],
+                                    base + tree.children_right[i])
+        forest.roots.append(base)
+    return forest
+
+
+def from_cpp(path):
+    with open(path) as f:
+        source = f.read()
+
+    leaf_values = {}
+    for name, values in re.findall(r'const float (leafVal\d+)\[\d+\] = \{([^}]*)\};', source):
+        leaf_values[name] = [float(v) for v in values.split(',')]
+    num_classes = len(next(iter(leaf_values.values())))
+    features = [int(i) for i in re.findall(r'histogram\[(\d+)\]', source)]
+
+    forest = Forest(max(features) + 1, num_classes)
+    body = source[source.index('int RandomForest::classify'):]
+    tokens = re.findall(r'if\(histogram\[(\d+)\] <= ([^)]+)\)\{|'
+                        r'(tree\d+) = (leafVal\d+);|(else)|(float classProbs)', body)
+
+    def parse(at):
+        feature, threshold, tree, leaf, _, _ = tokens[at]
+        if leaf:
+            return forest.add_leaf(leaf_values[leaf]), at + 1
+        node = forest.add_split(int(feature), float(threshold))
+        left, at = parse(at + 1)
+        assert tokens[at][4] == 'else'
+        right, at = parse(at + 1)
+        forest.set_children(node, left, right)
+        return node, at
+
+    at = 0
+    while not tokens[at][5]:
+        root, at = parse(at)
+        forest.roots.append(root)
+    return forest
+
+
+def main():
+    if len(sys.argv) != 4 or sys.argv[1] not in ('sklearn', 'cpp'):
+        sys.exit(__doc__)
+    forest = from_sklearn(sys.argv[2]) if sys.argv[1] == 'sklearn' else from_cpp(sys.argv[2])
+    forest.write(sys.argv[3])
+    print('%d trees, %d nodes, %d leaves, %d features, %d classes' %
+          (len(forest.roots), len(forest.nodes), len(forest.leaves),
+           forest.num_features, forest.num_classes))
+
+
+if __name__ == '__main__':
+    main()
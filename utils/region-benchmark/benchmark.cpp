@@ -0,0 +1,219 @@
+/**
+ * Times reading every pixel of regions with RegionI's iterators against its
+ * row views, and checks that both read the same pixels.
+ *
+ *     ./benchmark [repeats]
+ *
+ * The frame is a synthetic field: green with noise, white lines and a few
+ * white blobs, classified by the usual full region foveae. Regions are
+ * subregions of the full regions at the fovea's density, as ROIs are, and
+ * zoomed in copies of them for raw Y access. Iterators are stepped once per
+ * pixel, as detectors do, rather than compared with end_raw(), which is only
+ * right at density 1.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <boost/random.hpp>
+
+#include "perception/vision/Fovea.hpp"
+#include "perception/vision/Region/Region.hpp"
+#include "perception/vision/other/ImagePlanes.hpp"
+#include "types/CombinedFrame.hpp"
+#include "utils/Timer.hpp"
+
+/**
+ * Fills a YUV422 image with green, noise and some white.
+ */
+static void makeImage(int cols, int rows, boost::mt19937& rng,
+                      std::vector<uint8_t>& image) {
+    boost::uniform_int<int> noise(-20, 20);
+    image.resize(cols * rows * 2);
+    for (int y = 0; y < rows; ++y) {
+        for (int x = 0; x < cols; ++x) {
+            const bool line = (x + y / 3) % 97 < 4 || y % 131 < 3;
+            const bool blob = ((x / 40) * 7 + (y / 40) * 3) % 11 == 0;
+            const int luma = (line || blob) ? 210 : 90;
+            uint8_t* pixel = &image[(y * cols + x) * 2];
+            pixel[0] = std::min(std::max(luma + noise(rng), 0), 255);
+            pixel[1] = (x & 1) ? 110 : 100;
+        }
+    }
+}
+
+/**
+ * Counts white pixels, and writes each pixel's colour to an image.
+ */
+struct ColourRows {
+    int* colours;
+    int whites;
+
+    template <class Row>
+    void operator()(int y, const Row& row) {
+        const int cols = row.size();
+        int* out = colours + y * cols;
+        int row_whites = 0;
+        for (int x = 0; x < cols; ++x) {
+            out[x] = row[x];
+            row_whites += row[x] == cWHITE;
+        }
+        whites += row_whites;
+    }
+};
+
+/**
+ * Sums Y values, and writes each pixel's Y to an image.
+ */
+struct YRows {
+    uint8_t* ys;
+    int sum;
+
+    template <class Row>
+    void operator()(int y, const Row& row) {
+        const int cols = row.size();
+        uint8_t* out = ys + y * cols;
+        int row_sum = 0;
+        for (int x = 0; x < cols; ++x) {
+            out[x] = row[x];
+            row_sum += row[x];
+        }
+        sum += row_sum;
+    }
+};
+
+int main(int argc, char* argv[]) {
+    const int repeats = argc > 1 ? atoi(argv[1]) : 200;
+
+    boost::mt19937 rng(42);
+    std::vector<uint8_t> top_image, bot_image;
+    makeImage(TOP_IMAGE_COLS, TOP_IMAGE_ROWS, rng, top_image);
+    makeImage(BOT_IMAGE_COLS, BOT_IMAGE_ROWS, rng, bot_image);
+
+    ImagePlanes top_planes(TOP_IMAGE_COLS, TOP_IMAGE_ROWS);
+    ImagePlanes bot_planes(BOT_IMAGE_COLS, BOT_IMAGE_ROWS);
+    top_planes.build(&top_image[0]);
+    bot_planes.build(&bot_image[0]);
+
+    CameraToRR camera_to_rr;
+    CombinedFrame frame(&top_image[0], &bot_image[0], camera_to_rr,
+                        boost::shared_ptr<CombinedFrame>());
+    frame.top_planes_ = &top_planes;
+    frame.bot_planes_ = &bot_planes;
+
+    Fovea top_fovea(BBox(Point(0, 0), Point(TOP_SALIENCY_COLS, TOP_SALIENCY_ROWS)),
+                    TOP_SALIENCY_DENSITY, true, true);
+    Fovea bot_fovea(BBox(Point(0, 0), Point(BOT_SALIENCY_COLS, BOT_SALIENCY_ROWS)),
+                    BOT_SALIENCY_DENSITY, false, true);
+    top_fovea.generate(frame);
+    bot_fovea.generate(frame);
+    RegionI top_full(BBox(Point(0, 0), Point(TOP_SALIENCY_COLS, TOP_SALIENCY_ROWS)),
+                     true, top_fovea, TOP_SALIENCY_DENSITY);
+    RegionI bot_full(BBox(Point(0, 0), Point(BOT_SALIENCY_COLS, BOT_SALIENCY_ROWS)),
+                     false, bot_fovea, BOT_SALIENCY_DENSITY);
+
+    // ROI sized subregions, and zoomed in copies of them for raw Y
+    std::vector<RegionI> regions;
+    boost::uniform_int<int> size(4, 40);
+    for (int i = 0; i < 64; ++i) {
+        const RegionI& full = (i & 1) ? bot_full : top_full;
+        const int cols = std::min(size(rng), full.getCols());
+        const int rows = std::min(size(rng), full.getRows());
+        boost::uniform_int<int> x(0, full.getCols() - cols);
+        boost::uniform_int<int> y(0, full.getRows() - rows);
+        const Point a(x(rng), y(rng));
+        regions.push_back(full.subRegion(BBox(a, a + Point(cols, rows))));
+    }
+    const int num_foveal = regions.size();
+    for (int i = 0; i < num_foveal; ++i) {
+        regions.push_back(regions[i].zoomIn(regions[i].getDensity(), false));
+    }
+
+    int pixels = 0;
+    for (size_t i = 0; i < regions.size(); ++i) {
+        pixels += regions[i].getCols() * regions[i].getRows();
+    }
+    std::vector<int> colours(pixels), view_colours(pixels);
+    std::vector<uint8_t> ys(pixels), view_ys(pixels);
+
+    // Colour, through iterator_fovea
+    int iterator_whites = 0;
+    Timer timer;
+    for (int r = 0; r < repeats; ++r) {
+        int* out = &colours[0];
+        for (int i = 0; i < num_foveal; ++i) {
+            const int n = regions[i].getCols() * regions[i].getRows();
+            RegionI::iterator_fovea it = regions[i].begin_fovea();
+            for (int p = 0; p < n; ++p, ++it, ++out) {
+                *out = it.colour();
+                iterator_whites += it.colour() == cWHITE;
+            }
+        }
+    }
+    const float iterator_colour_us = timer.elapsed_us();
+
+    // Colour, through the row views
+    ColourRows colour_rows = { NULL, 0 };
+    timer.restart();
+    for (int r = 0; r < repeats; ++r) {
+        colour_rows.colours = &view_colours[0];
+        for (int i = 0; i < num_foveal; ++i) {
+            regions[i].for_each_row_fovea(colour_rows);
+            colour_rows.colours += regions[i].getCols() * regions[i].getRows();
+        }
+    }
+    const float view_colour_us = timer.elapsed_us();
+
+    // Y, through iterator_raw
+    int iterator_sum = 0;
+    timer.restart();
+    for (int r = 0; r < repeats; ++r) {
+        uint8_t* out = &ys[0];
+        for (size_t i = 0; i < regions.size(); ++i) {
+            const int n = regions[i].getCols() * regions[i].getRows();
+            RegionI::iterator_raw it = regions[i].begin_raw();
+            for (int p = 0; p < n; ++p, ++it, ++out) {
+                *out = it.getY();
+                iterator_sum += *out;
+            }
+        }
+    }
+    const float iterator_y_us = timer.elapsed_us();
+
+    // Y, through the row views
+    YRows y_rows = { NULL, 0 };
+    timer.restart();
+    for (int r = 0; r < repeats; ++r) {
+        y_rows.ys = &view_ys[0];
+        for (size_t i = 0; i < regions.size(); ++i) {
+            regions[i].for_each_row_y(y_rows);
+            y_rows.ys += regions[i].getCols() * regions[i].getRows();
+        }
+    }
+    const float view_y_us = timer.elapsed_us();
+
+    int foveal_pixels = 0;
+    for (int i = 0; i < num_foveal; ++i) {
+        foveal_pixels += regions[i].getCols() * regions[i].getRows();
+    }
+    int mismatches = 0;
+    for (int p = 0; p < foveal_pixels; ++p) {
+        mismatches += colours[p] != view_colours[p];
+    }
+    for (int p = 0; p < pixels; ++p) {
+        mismatches += ys[p] != view_ys[p];
+    }
+    mismatches += iterator_whites != colour_rows.whites;
+    mismatches += iterator_sum != y_rows.sum;
+
+    const float colour_reads = (float)foveal_pixels * repeats;
+    const float y_reads = (float)pixels * repeats;
+    printf("%d regions, %d pixels, %d repeats\n", (int)regions.size(), pixels,
+           repeats);
+    printf("colour iterator: %.2f ns/pixel\n", iterator_colour_us * 1000 / colour_reads);
+    printf("colour view:     %.2f ns/pixel\n", view_colour_us * 1000 / colour_reads);
+    printf("y iterator:      %.2f ns/pixel\n", iterator_y_us * 1000 / y_reads);
+    printf("y view:          %.2f ns/pixel\n", view_y_us * 1000 / y_reads);
+    printf("%d mismatches\n", mismatches);
+    return mismatches != 0;
+}
@@ -86,7 +86,7 @@ QImage* regionToSaliencyQImage(VatnaoFrameInfo &frameInfo, FrameRect &r, BallDet
                                bool ATIn, QLineEdit *windowSize, QLineEdit *percentage){
    
     uint8_t const* frame = r.topCamera ? frameInfo.topFrame : frameInfo.botFrame;
-    BallDetector bd = BallDetector();
+    BallDetector bd;
 
     int image_rows = r.height;
     int image_cols = r.width;
@@ -108,7 +108,7 @@ void VatnaoManager::showMetaData(){
     if (checkBoxBallMetaData->isChecked()) {
         VatnaoFrameInfo frameInfo = appAdaptor->getFrameInfo();
 
-        BallDetector bd = BallDetector();
+        BallDetector bd;
 
         VisionInfoOut info_out;
         info_out.cameraToRR = &frameInfo.cameraToRR;
@@ -149,7 +149,7 @@ void VatnaoManager::refreshImages(){
 void VatnaoManager::refreshRegionROIImages() {
     VatnaoFrameInfo frameInfo = appAdaptor->getFrameInfo();
 
-    BallDetector bd = BallDetector();
+    BallDetector bd;
 
     VisionInfoIn info_in;
     info_in.latestAngleX = 0;
@@ -0,0 +1,430 @@
+/**
+ * Replays frames dumped by the camera through Vision, and reports how long
+ * each stage took and how many heap allocations each frame made, as p50, p95
+ * and p99 over the frames.
+ *
+ *     ./vision-replay.bin --replay.frames dump.yuv [--replay.sensors sensors.txt]
+ *                         [--replay.digest digests.txt] [--replay.warmup 5]
+ *                         [--vision.parallelstages 1 ...]
+ *
+ * replay.frames is a file written with vision.dumpframes, or a directory of
+ * them, replayed in name order. Each frame in a dump is the top image then
+ * the bottom image, both YUV422, as Camera::writeFrame writes them. Dumps are
+ * memory mapped, so frames are read straight from the page cache.
+ *
+ * replay.sensors is a text file with a line per frame of the joint angles, in
+ * Joints order, followed by the sensor readings, in Sensors order. The pose of
+ * each frame is worked out from them as motion does, with the kinematics
+ * parameters from the config. The last line is used for any frames after it.
+ * Without it the robot stands with every joint at zero.
+ *
+ * The config is read as on the robot, so vision and kinematics options can be
+ * given on the command line or in runswift.cfg.
+ *
+ * replay.digest is where to write a line per frame with a hash of what Vision
+ * found in it, "-" for standard output. Digests of the same frames before and
+ * after a change differ where the change made Vision see something else.
+ * Positions are hashed to the pixel or millimetre, and angles to the
+ * milliradian, so they do not change with the order floating point
+ * arithmetic is done in.
+ */
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include "perception/kinematics/Kinematics.hpp"
+#include "perception/vision/Vision.hpp"
+#include "perception/vision/camera/CameraToRR.hpp"
+#include "types/CombinedFrame.hpp"
+#include "types/SensorValues.hpp"
+#include "types/VisionInfoIn.hpp"
+#include "types/VisionInfoOut.hpp"
+#include "utils/Logger.hpp"
+#include "utils/options.hpp"
+
+namespace po = boost::program_options;
+
+extern int ADAPTIVE_THRESHOLDING_WINDOW_SIZE_TOP;
+extern int ADAPTIVE_THRESHOLDING_WINDOW_SIZE_BOT;
+extern int ADAPTIVE_THRESHOLDING_WHITE_THRESHOLD_PERCENT_TOP;
+extern int ADAPTIVE_THRESHOLDING_WHITE_THRESHOLD_PERCENT_BOT;
+
+// Bytes in one dumped frame: the top then the bottom image, two bytes a pixel
+#define TOP_FRAME_BYTES (TOP_IMAGE_COLS * TOP_IMAGE_ROWS * 2)
+#define BOT_FRAME_BYTES (BOT_IMAGE_COLS * BOT_IMAGE_ROWS * 2)
+#define FRAME_BYTES (TOP_FRAME_BYTES + BOT_FRAME_BYTES)
+
+/*
+ * Every heap allocation in the process, on any thread, goes through these.
+ */
+static volatile long allocations = 0;
+
+void* operator new(size_t bytes) {
+    __sync_fetch_and_add(&allocations, 1);
+    void* p = malloc(bytes ? bytes : 1);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t bytes) {
+    return operator new(bytes);
+}
+
+void operator delete(void* p) throw() {
+    free(p);
+}
+
+void operator delete[](void* p) throw() {
+    free(p);
+}
+
+/**
+ * A dump mapped into memory.
+ */
+struct Dump {
+    std::string path;
+    const uint8_t* data;
+    size_t bytes;
+    int frames;
+};
+
+static bool mapDump(const std::string& path, std::vector<Dump>& dumps) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path.c_str());
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    Dump dump;
+    dump.path = path;
+    dump.bytes = st.st_size;
+    dump.frames = dump.bytes / FRAME_BYTES;
+    dump.data = NULL;
+    if (dump.frames > 0) {
+        void* data = mmap(NULL, dump.bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            perror(path.c_str());
+            close(fd);
+            return false;
+        }
+        // Frames are read once, front to back.
+        madvise(data, dump.bytes, MADV_SEQUENTIAL);
+        dump.data = static_cast<const uint8_t*>(data);
+    }
+    close(fd);
+    if (dump.bytes % FRAME_BYTES != 0) {
+        fprintf(stderr, "%s: ignoring %d bytes after the last whole frame\n",
+                path.c_str(), (int)(dump.bytes % FRAME_BYTES));
+    }
+    dumps.push_back(dump);
+    return true;
+}
+
+/**
+ * Maps path, or every file in it if it is a directory, in name order.
+ */
+static bool mapDumps(const std::string& path, std::vector<Dump>& dumps) {
+    namespace fs = boost::filesystem;
+    if (!fs::is_directory(path)) {
+        return mapDump(path, dumps);
+    }
+    std::vector<std::string> files;
+    for (fs::directory_iterator it(path); it != fs::directory_iterator(); ++it) {
+        if (fs::is_regular_file(it->status())) {
+            files.push_back(it->path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!mapDump(files[i], dumps)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Reads the next frame's sensor values, leaving sensors as they were at the
+ * end of the stream.
+ */
+static void readSensors(std::ifstream& stream, SensorValues& sensors) {
+    SensorValues next(true);
+    for (int i = 0; i < Joints::NUMBER_OF_JOINTS; ++i) {
+        if (!(stream >> next.joints.angles[i])) {
+            return;
+        }
+    }
+    for (int i = 0; i < Sensors::NUMBER_OF_SENSORS; ++i) {
+        if (!(stream >> next.sensors[i])) {
+            return;
+        }
+    }
+    sensors = next;
+}
+
+/*
+ * 64 bit FNV-1a over what Vision found in a frame.
+ */
+static void hash(uint64_t& h, int64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        h = (h ^ ((value >> (8 * i)) & 0xff)) * 1099511628211ULL;
+    }
+}
+
+static void hash(uint64_t& h, const Point& p) {
+    hash(h, p.x());
+    hash(h, p.y());
+}
+
+static void hash(uint64_t& h, const BBox& box) {
+    hash(h, box.a);
+    hash(h, box.b);
+}
+
+static void hash(uint64_t& h, const RRCoord& rr) {
+    hash(h, lroundf(rr.distance()));
+    hash(h, lroundf(rr.heading() * 1000));
+    hash(h, lroundf(rr.orientation() * 1000));
+}
+
+static uint64_t digest(const VisionInfoOut& out) {
+    uint64_t h = 14695981039346656037ULL;
+    hash(h, out.balls.size());
+    for (size_t i = 0; i < out.balls.size(); ++i) {
+        hash(h, out.balls[i].rr);
+        hash(h, out.balls[i].radius);
+        hash(h, out.balls[i].imageCoords);
+        hash(h, out.balls[i].topCamera);
+    }
+    hash(h, out.boundaries.size());
+    for (size_t i = 0; i < out.boundaries.size(); ++i) {
+        hash(h, out.boundaries[i].imageBoundary.p1);
+        hash(h, out.boundaries[i].imageBoundary.p2);
+    }
+    hash(h, out.features.size());
+    for (size_t i = 0; i < out.features.size(); ++i) {
+        hash(h, out.features[i].type);
+        hash(h, out.features[i].rr);
+    }
+    hash(h, out.robots.size());
+    for (size_t i = 0; i < out.robots.size(); ++i) {
+        hash(h, out.robots[i].type);
+        hash(h, out.robots[i].cameras);
+        hash(h, out.robots[i].rr);
+        // Only the boxes for the cameras the robot was seen in are set.
+        const RobotVisionInfo::Cameras cameras = out.robots[i].cameras;
+        if (cameras == RobotVisionInfo::OLD_DETECTION) {
+            hash(h, out.robots[i].imageCoords);
+        }
+        if (cameras == RobotVisionInfo::TOP_CAMERA ||
+                cameras == RobotVisionInfo::BOTH_CAMERAS) {
+            hash(h, out.robots[i].topImageCoords);
+        }
+        if (cameras == RobotVisionInfo::BOT_CAMERA ||
+                cameras == RobotVisionInfo::BOTH_CAMERAS) {
+            hash(h, out.robots[i].botImageCoords);
+        }
+    }
+    for (int x = 0; x < TOP_IMAGE_COLS; ++x) {
+        hash(h, out.topStartScanCoords[x]);
+    }
+    for (int x = 0; x < BOT_IMAGE_COLS; ++x) {
+        hash(h, out.botStartScanCoords[x]);
+    }
+    hash(h, out.regions.size());
+    for (size_t i = 0; i < out.regions.size(); ++i) {
+        hash(h, out.regions[i].getBoundingBoxRaw());
+        hash(h, out.regions[i].isTopCamera());
+    }
+    return h;
+}
+
+/**
+ * The value at or below which p percent of samples fall.
+ */
+static int percentile(std::vector<int> samples, float p) {
+    if (samples.empty()) {
+        return 0;
+    }
+    std::sort(samples.begin(), samples.end());
+    const int rank = (int)ceilf(p / 100 * samples.size());
+    return samples[std::max(rank, 1) - 1];
+}
+
+static void report(FILE* out, const char* name,
+                   const std::vector<int>& samples) {
+    fprintf(out, "%-16s %10d %10d %10d %10d\n", name, percentile(samples, 50),
+           percentile(samples, 95), percentile(samples, 99),
+           percentile(samples, 100));
+}
+
+int main(int argc, char* argv[]) {
+    po::options_description generic("Replay options");
+    generic.add_options()
+        ("help,h", "print this message")
+        ("replay.frames", po::value<std::string>(),
+         "dump written with vision.dumpframes, or a directory of them")
+        ("replay.sensors", po::value<std::string>(),
+         "joint angles and sensor readings, a line per frame")
+        ("replay.digest", po::value<std::string>(),
+         "where to write each frame's digest, - for standard output")
+        ("replay.warmup", po::value<int>()->default_value(5),
+         "frames to leave out of the timings while Vision's buffers grow");
+
+    po::variables_map config;
+    po::options_description options = store_and_notify(argc, argv, config, &generic);
+    if (config.count("help") || !config.count("replay.frames")) {
+        std::cout << options << std::endl;
+        return config.count("help") ? 0 : 1;
+    }
+
+    Logger::init(config["debug.logpath"].as<std::string>(),
+                 config["debug.log"].as<std::string>(), true,
+                 config["debug.logoutput"].as<std::string>());
+
+    std::vector<Dump> dumps;
+    if (!mapDumps(config["replay.frames"].as<std::string>(), dumps)) {
+        return 1;
+    }
+
+    std::ifstream sensor_stream;
+    if (config.count("replay.sensors")) {
+        sensor_stream.open(config["replay.sensors"].as<std::string>().c_str());
+        if (!sensor_stream) {
+            perror(config["replay.sensors"].as<std::string>().c_str());
+            return 1;
+        }
+    }
+
+    FILE* digests = NULL;
+    if (config.count("replay.digest")) {
+        const std::string path = config["replay.digest"].as<std::string>();
+        digests = path == "-" ? stdout : fopen(path.c_str(), "w");
+        if (digests == NULL) {
+            perror(path.c_str());
+            return 1;
+        }
+    }
+    const int warmup = config["replay.warmup"].as<int>();
+
+    // Set up as VisionAdapter does.
+    Vision vision;
+    ADAPTIVE_THRESHOLDING_WINDOW_SIZE_TOP = config["vision.top.adaptivethresholdingwindow"].as<int>();
+    ADAPTIVE_THRESHOLDING_WINDOW_SIZE_BOT = config["vision.bot.adaptivethresholdingwindow"].as<int>();
+    ADAPTIVE_THRESHOLDING_WHITE_THRESHOLD_PERCENT_TOP = config["vision.top.adaptivethresholdingpercent"].as<int>();
+    ADAPTIVE_THRESHOLDING_WHITE_THRESHOLD_PERCENT_BOT = config["vision.top.adaptivethresholdingpercent"].as<int>();
+    vision.setParallelCameras(config["vision.parallelcameras"].as<bool>());
+    vision.setParallelStages(config["vision.parallelstages"].as<bool>());
+    vision.setRobotEngine(config["vision.robotengine"].as<std::string>());
+    vision.setRobotForest(config["vision.robotforest"].as<bool>());
+    vision.setBallThreads(config["vision.ballthreads"].as<int>());
+    vision.setBallTracking(config["vision.balltracking"].as<int>());
+    vision.setRoiBudget(config["vision.roibudget"].as<int>());
+    vision.setBoundaryWindow(config["vision.boundarywindow"].as<int>());
+    vision.setPyramidFoveae(config["vision.pyramidfoveae"].as<bool>());
+
+    // And motion's kinematics, as KinematicsBlackboard reads them.
+    Kinematics kinematics;
+    kinematics.parameters.cameraYawBottom = config["kinematics.cameraYawBottom"].as<float>();
+    kinematics.parameters.cameraPitchBottom = config["kinematics.cameraPitchBottom"].as<float>();
+    kinematics.parameters.cameraRollBottom = config["kinematics.cameraRollBottom"].as<float>();
+    kinematics.parameters.cameraYawTop = config["kinematics.cameraYawTop"].as<float>();
+    kinematics.parameters.cameraPitchTop = config["kinematics.cameraPitchTop"].as<float>();
+    kinematics.parameters.cameraRollTop = config["kinematics.cameraRollTop"].as<float>();
+    kinematics.parameters.bodyPitch = config["kinematics.bodyPitch"].as<float>();
+
+    SensorValues sensors(true);
+    CameraToRR camera_to_rr;
+    std::vector<std::vector<int> > stage_times;
+    std::vector<int> frame_allocations;
+    int frame = 0;
+
+    for (size_t d = 0; d < dumps.size(); ++d) {
+        for (int f = 0; f < dumps[d].frames; ++f, ++frame) {
+            const uint8_t* top = dumps[d].data + (size_t)f * FRAME_BYTES;
+            const uint8_t* bot = top + TOP_FRAME_BYTES;
+
+            if (sensor_stream.is_open()) {
+                readSensors(sensor_stream, sensors);
+            }
+            kinematics.setSensorValues(sensors);
+            kinematics.updateDHChain();
+
+            // As VisionAdapter::process
+            VisionInfoIn info_in;
+            camera_to_rr.pose = kinematics.getPose();
+            camera_to_rr.updateAngles(sensors);
+            info_in.cameraToRR = camera_to_rr;
+            info_in.pose = camera_to_rr.pose;
+            info_in.latestAngleX = sensors.sensors[Sensors::InertialSensor_AngleX];
+            camera_to_rr.findEndScanValues();
+
+            CombinedFrame combined_frame(top, bot, camera_to_rr,
+                                         boost::shared_ptr<CombinedFrame>());
+            const long allocations_before = allocations;
+            const VisionInfoOut info_out = vision.processFrame(combined_frame, info_in);
+            const int frame_allocs = allocations - allocations_before;
+
+            if (frame >= warmup) {
+                const std::vector<std::pair<std::string, int> >& times =
+                    vision.getFrameTimes();
+                stage_times.resize(times.size());
+                for (size_t s = 0; s < times.size(); ++s) {
+                    stage_times[s].push_back(times[s].second);
+                }
+                frame_allocations.push_back(frame_allocs);
+            }
+            if (digests) {
+                fprintf(digests, "%d %016llx\n", frame,
+                        (unsigned long long)digest(info_out));
+            }
+        }
+    }
+
+    if (digests && digests != stdout) {
+        fclose(digests);
+    }
+    for (size_t d = 0; d < dumps.size(); ++d) {
+        if (dumps[d].data) {
+            munmap(const_cast<uint8_t*>(dumps[d].data), dumps[d].bytes);
+        }
+    }
+
+    // The report goes to standard error when the digests are on standard out.
+    FILE* out = digests == stdout ? stderr : stdout;
+    const int timed = frame_allocations.size();
+    fprintf(out, "%d frames from %d dumps, %d timed after %d warm up\n",
+            frame, (int)dumps.size(), timed, std::min(warmup, frame));
+    if (timed == 0) {
+        return frame == 0 ? 1 : 0;
+    }
+
+    fprintf(out, "%-16s %10s %10s %10s %10s\n", "us", "p50", "p95", "p99", "max");
+    const std::vector<std::pair<std::string, int> >& times = vision.getFrameTimes();
+    for (size_t s = 0; s < times.size(); ++s) {
+        report(out, times[s].first.c_str(), stage_times[s]);
+    }
+    fprintf(out, "\n%-16s %10s %10s %10s %10s\n", "per frame", "p50", "p95", "p99", "max");
+    report(out, "Allocations", frame_allocations);
+    return 0;
+}